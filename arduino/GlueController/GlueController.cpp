@@ -4,21 +4,22 @@
 
 #include "GlueController.h"
 #include <ArduinoJson.h>
-#include <vector>
-#include <algorithm>
 
 // ===== Globals =====
 ControllerConfig config;
 
-// Not hot-path: store rows dynamically here
+// Not hot-path, but preallocated: no heap use after setup()
 struct GunConfigInternal {
-  bool enabled = true;
-  std::vector<GlueRow> rows;
+  bool    enabled = true;
+  GlueRow rows[MAX_ZONES_PER_GUN]; // sorted by 'from', overlaps merged
+  uint8_t rowCount = 0;
 };
 static GunConfigInternal _guns_internal[4];
 GunConfig guns[4]; // placeholder if other code references it
 
 volatile uint32_t encoderCount = 0; // raw (wraps)
+volatile uint32_t encoderLastEdgeUs = 0;
+SpeedEstimator speedEstimator;
 static uint32_t lastEncoderRaw = 0; // for delta
 int64_t positionAccum = 0;          // monotonic
 int64_t currentPosition64 = 0;      // snapshot used in loop
@@ -29,7 +30,29 @@ bool isCalibrating = false;
 unsigned long lastHeartbeat = 0;
 bool lastSensorState = HIGH;
 
-String inputBuffer = "";
+// ===== Serial receive state (resumable across loop() passes) =====
+enum RxState : uint8_t { RX_WAIT_STX = 0, RX_IN_FRAME = 1, RX_OVERFLOW = 2 };
+static char     rxBuffer[SERIAL_RX_BUFFER_SIZE];
+static uint16_t rxLength = 0;
+static RxState  rxState  = RX_WAIT_STX;
+static StaticJsonDocument<JSON_DOC_CAPACITY> rxDoc; // reused for every frame
+
+// Loop timing while a frame is being received/decoded (reported in config_ack)
+static uint32_t uploadMaxLoopUs = 0;
+static bool     configAckPending = false;
+static int      configAckRows = 0;
+static int      configAckDropped = 0;
+
+// Link rate negotiation state
+enum BaudState : uint8_t { BAUD_STABLE = 0, BAUD_PROVISIONAL = 1, BAUD_VERIFIED = 2 };
+static BaudState     baudState = BAUD_STABLE;
+static uint32_t      currentBaud = DEFAULT_BAUD_RATE;
+static uint32_t      fallbackBaud = DEFAULT_BAUD_RATE;
+static unsigned long baudDeadlineMs = 0;
+
+static inline void setGun(uint8_t idx, bool on);
+static void dispatchFrame();
+static void sendError(const char* code);
 
 bool gunStates[4] = {false,false,false,false};
 bool allFiringZonesInserted = false;
@@ -151,11 +174,11 @@ static inline ActiveZone& ring_peek(ZoneRing &r, uint8_t idxFromHead){
 }
 
 // ===== ISR =====
-void encoderISR(){ encoderCount++; }
+void encoderISR(){ encoderCount++; encoderLastEdgeUs = micros(); }
 
 // ===== Setup / Loop =====
 void setup() {
-  Serial.begin(115200);
+  Serial.begin(DEFAULT_BAUD_RATE);
 
   pinMode(ENCODER_PIN_A, INPUT_PULLUP);
   pinMode(SENSOR_PIN,     INPUT_PULLUP);
@@ -165,7 +188,7 @@ void setup() {
 
   attachInterrupt(digitalPinToInterrupt(ENCODER_PIN_A), encoderISR, RISING);
 
-  for (int i=0;i<4;i++){ _guns_internal[i].enabled = true; _guns_internal[i].rows.clear(); }
+  for (int i=0;i<4;i++){ _guns_internal[i].enabled = true; _guns_internal[i].rowCount = 0; }
 
 #if defined(__AVR__)
   initFastADC_AVR();
@@ -179,6 +202,8 @@ void setup() {
 }
 
 void loop() {
+  uint32_t loopStartUs = micros();
+
 #if !defined(__AVR__)
   // soft-timer path needs ticking; hwtimer path doesn't
   #if !((USE_R4_HWTIMER==1) && (defined(ARDUINO_UNOR4_MINIMA) || defined(ARDUINO_UNOR4_WIFI)))
@@ -187,13 +212,15 @@ void loop() {
 #endif
 
   // ===== Wrap-safe encoder to 64-bit monotonic =====
-  noInterrupts(); uint32_t raw = encoderCount; interrupts();
+  noInterrupts(); uint32_t raw = encoderCount; uint32_t edgeUs = encoderLastEdgeUs; interrupts();
   uint32_t delta = raw - lastEncoderRaw;   // unsigned handles wrap
   lastEncoderRaw = raw;
   positionAccum += (int64_t)delta;
   currentPosition64 = positionAccum;
+  speedEstimator.update(raw, edgeUs, micros());
 
   processSerial();
+  checkBaudFallback();
   checkSensor();
 
   // Always run updateGuns so test mode can work even when controller is disabled
@@ -203,53 +230,148 @@ void loop() {
     bool any=false; for(int i=0;i<4;i++){ if(gunStates[i]){ any=true; break; } }
     if (!any) calculateFiringZones();
   }
+
+  // Track worst-case pass time while a plan is being uploaded
+  if (rxState != RX_WAIT_STX || configAckPending) {
+    uint32_t loopUs = micros() - loopStartUs;
+    if (loopUs > uploadMaxLoopUs) uploadMaxLoopUs = loopUs;
+  }
+  if (configAckPending) {
+    sendConfigAck(configAckRows);
+    configAckPending = false;
+    uploadMaxLoopUs = 0;
+  }
 }
 
 // ===== Serial / Protocol =====
+// Consumes at most SERIAL_BYTES_PER_LOOP bytes and decodes at most one frame
+// per call; a partially received frame simply resumes on the next pass.
 void processSerial(){
-  while (Serial.available() > 0) {
-    char c = Serial.read();
-    if (c == STX) { inputBuffer = ""; }
-    else if (c == ETX) {
-      if (inputBuffer.length() > 0) {
-        StaticJsonDocument<1024> doc;
-        DeserializationError err = deserializeJson(doc, inputBuffer);
-        if (!err) {
-          String type = doc["type"] | "";
-          if      (type == "controller_setup" || type == "config") {
-            handleConfig(doc.as<JsonObject>());
-          } else if (type == "test") {
-            handleTest(doc.as<JsonObject>());
-          } else if (type == "calibrate") {
-            initCalibration(doc.as<JsonObject>());
-          } else if (type == "heartbeat") {
-            handleHeartbeat(doc.as<JsonObject>()); // no-op
+  int budget = SERIAL_BYTES_PER_LOOP;
+  while (budget-- > 0 && Serial.available() > 0) {
+    char c = (char)Serial.read();
+    if (c == STX) {                       // (re)start a frame, drop any partial one
+      rxLength = 0;
+      rxState = RX_IN_FRAME;
+      continue;
+    }
+    switch (rxState) {
+      case RX_WAIT_STX:
+        break;                            // noise between frames
+      case RX_IN_FRAME:
+        if (c == ETX) {
+          rxState = RX_WAIT_STX;
+          if (rxLength > 0) {
+            rxBuffer[rxLength] = '\0';
+            dispatchFrame();
+            rxLength = 0;
+            return;                       // one decode per pass keeps the pass bounded
           }
+        } else if (rxLength < SERIAL_RX_BUFFER_SIZE - 1) {
+          rxBuffer[rxLength++] = c;
+        } else {
+          rxState = RX_OVERFLOW;          // discard until the closing ETX
         }
-        inputBuffer = "";
-      }
-    } else { inputBuffer += c; }
+        break;
+      case RX_OVERFLOW:
+        if (c == ETX) {
+          rxState = RX_WAIT_STX;
+          rxLength = 0;
+          sendError("frame_too_large");
+        }
+        break;
+    }
+  }
+}
+
+static void dispatchFrame(){
+  // Zero-copy: strings in rxDoc point into rxBuffer, which stays untouched until the next frame
+  DeserializationError err = deserializeJson(rxDoc, rxBuffer, rxLength);
+  if (err) {
+    sendError(err == DeserializationError::NoMemory ? "json_no_memory" : "json_invalid");
+    return;
+  }
+  JsonObject obj = rxDoc.as<JsonObject>();
+  const char* type = obj["type"] | "";
+  if      (strcmp(type, "controller_setup") == 0 || strcmp(type, "config") == 0) {
+    handleConfig(obj);
+  } else if (strcmp(type, "test") == 0) {
+    handleTest(obj);
+  } else if (strcmp(type, "calibrate") == 0) {
+    initCalibration(obj);
+  } else if (strcmp(type, "heartbeat") == 0) {
+    handleHeartbeat(obj); // no-op
+  } else if (strcmp(type, "hello") == 0) {
+    handleHello(obj);
+  } else if (strcmp(type, "set_baud") == 0) {
+    handleSetBaud(obj);
+  } else if (strcmp(type, "baud_verify") == 0) {
+    handleBaudVerify(obj);
+  } else if (strcmp(type, "baud_commit") == 0) {
+    handleBaudCommit(obj);
+  }
+}
+
+static ControllerType parseControllerType(const char* s){
+  // PC sends "line"; older configs used "lines"
+  if (strcmp(s, "line") == 0 || strcmp(s, "lines") == 0) return CONTROLLER_LINES;
+  return CONTROLLER_DOTS;
+}
+
+static DotSize parseDotSize(const char* s){
+  if (strcmp(s, "small") == 0) return DOT_SMALL;
+  if (strcmp(s, "large") == 0) return DOT_LARGE;
+  return DOT_MEDIUM;
+}
+
+// Insert keeping rows sorted by 'from'; returns false when the gun is full
+static bool insertRowSorted(GunConfigInternal &g, const GlueRow &r){
+  if (g.rowCount >= MAX_ZONES_PER_GUN) return false;
+  uint8_t i = g.rowCount;
+  while (i > 0 && g.rows[i-1].from > r.from) { g.rows[i] = g.rows[i-1]; i--; }
+  g.rows[i] = r;
+  g.rowCount++;
+  return true;
+}
+
+// Merge overlapping rows in place (rows already sorted)
+static void mergeRows(GunConfigInternal &g){
+  if (g.rowCount < 2) return;
+  uint8_t out = 0;
+  for (uint8_t i = 1; i < g.rowCount; i++) {
+    if (g.rows[out].to >= g.rows[i].from) {
+      if (g.rows[i].to > g.rows[out].to) g.rows[out].to = g.rows[i].to;
+    } else {
+      g.rows[++out] = g.rows[i];
+    }
   }
+  g.rowCount = (uint8_t)(out + 1);
 }
 
 void handleConfig(const JsonObject &json){
-  config.type = json["controllerType"] | "dots";
+  // Schema 1+: gunId is 1-based and the start duration is sent as startDurationMS.
+  // Unversioned (legacy) senders keep the original 0-based gunId / startDuration layout.
+  int schema = json["v"] | 0;
+
+  config.type = parseControllerType(json["controllerType"] | "dots");
   config.enabled = json["enabled"] | false;
   config.encoderPulsesPerMm = json["encoder"] | 1.0;
   config.sensorOffset = json["sensorOffset"] | 10;
   config.startCurrent = json["startCurrent"] | 1.0;
   // startDuration is specified in milliseconds
-  config.startDuration = json["startDuration"] | 500;
+  if (schema >= 1) config.startDuration = json["startDurationMS"] | 500.0;
+  else             config.startDuration = json["startDuration"] | 500;
   config.holdCurrent = json["holdCurrent"] | 0.5;
   config.minimumSpeed = json["minimumSpeed"] | 0.0; // mm/s (0 disables gating)
-  config.dotSize = json["dotSize"] | "medium";
+  config.dotSize = parseDotSize(json["dotSize"] | "medium");
+  config.valveOnDelayMs  = json["valveOnDelayMs"]  | 0.0;
+  config.valveOffDelayMs = json["valveOffDelayMs"] | 0.0;
 
   config.sensorOffsetInPulses = (int)(config.sensorOffset * config.encoderPulsesPerMm);
 
-  double thrA = 0.0;
-  if (config.dotSize == "small")       thrA = SMALL_DOT_THRESHOLD;
-  else if (config.dotSize == "medium") thrA = MEDIUM_DOT_THRESHOLD;
-  else if (config.dotSize == "large")  thrA = LARGE_DOT_THRESHOLD;
+  double thrA = MEDIUM_DOT_THRESHOLD;
+  if (config.dotSize == DOT_SMALL)      thrA = SMALL_DOT_THRESHOLD;
+  else if (config.dotSize == DOT_LARGE) thrA = LARGE_DOT_THRESHOLD;
 
   // Scale to ADC counts using ADC_MAX
   currentThreshold = (int)((thrA * 0.8 + 2.5) * (double)ADC_MAX / 5.0);
@@ -260,41 +382,42 @@ void handleConfig(const JsonObject &json){
 
   digitalWrite(STATUS_LED, config.enabled ? HIGH : LOW);
 
+  int totalRows = 0;
+  int dropped = 0;
   if (json.containsKey("guns")) {
     JsonArray gunsArray = json["guns"];
     for (JsonObject gunConfig : gunsArray) {
       int gunId = gunConfig["gunId"] | -1;
+      if (schema >= 1) gunId -= 1;
       if (gunId >= 0 && gunId < 4) {
         auto &g = _guns_internal[gunId];
         g.enabled = gunConfig["enabled"] | true;
-        g.rows.clear();
+        g.rowCount = 0;
 
         if (gunConfig.containsKey("rows")) {
           JsonArray rows = gunConfig["rows"];
-          std::vector<GlueRow> tmp;
           for (JsonObject row : rows) {
             GlueRow r = {
               .from  = (int)(row["from"].as<float>()  * config.encoderPulsesPerMm) + config.sensorOffsetInPulses,
               .to    = (int)(row["to"].as<float>()    * config.encoderPulsesPerMm) + config.sensorOffsetInPulses,
               .space = (int)(row["space"].as<float>() * config.encoderPulsesPerMm)
             };
-            tmp.push_back(r);
-          }
-          std::sort(tmp.begin(), tmp.end(), [](const GlueRow&a,const GlueRow&b){ return a.from < b.from; });
-          for (const GlueRow &r : tmp) {
-            if (!g.rows.empty() && g.rows.back().to >= r.from) {
-              g.rows.back().to = std::max(g.rows.back().to, r.to);
-            } else {
-              g.rows.push_back(r);
-            }
+            if (!insertRowSorted(g, r)) dropped++;
           }
+          mergeRows(g);
         }
+        totalRows += g.rowCount;
       }
     }
   }
 
   allFiringZonesInserted = false;
   for (int i=0;i<4;i++){ firingZones[i].head=firingZones[i].tail=firingZones[i].count=0; }
+
+  // Ack is sent from loop() so the reported max includes this decode pass
+  configAckRows = totalRows;
+  configAckDropped = dropped;
+  configAckPending = true;
 }
 
 
@@ -304,8 +427,72 @@ void initCalibration(const JsonObject &json){
   shutdownAllGuns();
 }
 
+// ===== Link rate negotiation =====
+static bool isSupportedBaud(uint32_t baud){
+  static const uint32_t rates[] = {115200UL, 230400UL, 250000UL, 460800UL, 500000UL, 921600UL, 1000000UL, 2000000UL};
+  if (baud > MAX_BAUD_RATE) return false;
+  for (uint8_t i = 0; i < sizeof(rates)/sizeof(rates[0]); i++) if (rates[i] == baud) return true;
+  return false;
+}
+
+static void switchBaud(uint32_t baud){
+  Serial.flush();               // let the reply at the old rate drain first
+  Serial.end();
+  Serial.begin(baud);
+  currentBaud = baud;
+  rxState = RX_WAIT_STX;        // bytes around the switch are garbage
+  rxLength = 0;
+}
+
+void handleSetBaud(const JsonObject &json){
+  uint32_t baud = json["baud"] | 0UL;
+  if (!isSupportedBaud(baud)) { sendError("baud_unsupported"); return; }
+
+  StaticJsonDocument<64> doc;
+  doc["type"]="baud_ack"; doc["baud"]=baud;
+  Serial.print(STX); serializeJson(doc, Serial); Serial.println(ETX);
+
+  fallbackBaud = (baudState == BAUD_STABLE) ? currentBaud : fallbackBaud;
+  switchBaud(baud);
+  baudState = BAUD_PROVISIONAL;
+  baudDeadlineMs = millis() + BAUD_VERIFY_TIMEOUT_MS;
+}
+
+void handleBaudVerify(const JsonObject &json){
+  if (baudState == BAUD_STABLE) return;
+  const char* p = json["pattern"] | "";
+  const char* ref = BAUD_VERIFY_PATTERN;
+  const size_t refLen = sizeof(BAUD_VERIFY_PATTERN) - 1;
+  size_t n = strlen(p);
+  if (n == 0) return;
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] != ref[i % refLen]) return;  // corrupted: let the deadline revert
+  }
+  baudState = BAUD_VERIFIED;
+
+  // Echo straight from the receive buffer (p points into rxBuffer)
+  Serial.print(STX);
+  Serial.print(F("{\"type\":\"baud_verify\",\"pattern\":\""));
+  Serial.print(p);
+  Serial.print(F("\"}"));
+  Serial.println(ETX);
+}
+
+void handleBaudCommit(const JsonObject &json){
+  uint32_t baud = json["baud"] | 0UL;
+  if (baudState == BAUD_VERIFIED && baud == currentBaud) baudState = BAUD_STABLE;
+}
+
+void checkBaudFallback(){
+  if (baudState == BAUD_STABLE) return;
+  if ((long)(millis() - baudDeadlineMs) >= 0) {
+    switchBaud(fallbackBaud);
+    baudState = BAUD_STABLE;
+  }
+}
+
 void handleCalibrationSensorStateChange(bool sensorState){
-  if (sensorState == LOW) { noInterrupts(); encoderCount = 0; interrupts(); lastEncoderRaw = 0; positionAccum = 0; }
+  if (sensorState == LOW) { noInterrupts(); encoderCount = 0; interrupts(); lastEncoderRaw = 0; positionAccum = 0; speedEstimator.reset(); }
   else {
     uint32_t raw; noInterrupts(); raw = encoderCount; interrupts();
     uint32_t delta = raw - lastEncoderRaw;
@@ -319,12 +506,25 @@ void handleCalibrationSensorStateChange(bool sensorState){
 
 void handleHeartbeat(const JsonObject &){ /* no-op (status removed) */ }
 
+void handleHello(const JsonObject &){
+  StaticJsonDocument<256> doc;
+  doc["type"] = "capabilities";
+  doc["v"] = PROTOCOL_SCHEMA_VERSION;
+  doc["fw"] = FIRMWARE_VERSION;
+  doc["adcBits"] = ADC_BITS;
+  doc["maxZones"] = MAX_ZONES_PER_GUN;
+  doc["rxBuffer"] = SERIAL_RX_BUFFER_SIZE;
+  doc["maxBaud"] = MAX_BAUD_RATE;
+  JsonArray enc = doc.createNestedArray("encodings");
+  enc.add("json");
+  Serial.print(STX); serializeJson(doc, Serial); Serial.println(ETX);
+}
+
 void handleTest(const JsonObject &json){
   // Expected: {"type":"test","gun":1..4|0,"state":"on|off"}
   // gun: 1..4 targets specific gun; 0 (or missing) applies to all guns
-  const char* s_c = json["state"] | "";
-  String s = String(s_c); s.toLowerCase();
-  bool on = (s == "on" || s == "true" || s == "1");
+  const char* s = json["state"] | "";
+  bool on = (strcasecmp(s, "on") == 0 || strcasecmp(s, "true") == 0 || strcmp(s, "1") == 0);
 
   auto apply = [&](int idx, bool val){
     if (idx < 0 || idx >= 4) return;
@@ -354,12 +554,24 @@ void handleTest(const JsonObject &json){
   }
 }
 
-// Small, infrequent
+// Small, infrequent; serialized straight to the UART (no String)
 void sendCalibrationResult(int pulses){
   StaticJsonDocument<128> doc;
   doc["type"]="calibration_result"; doc["pulsesPerPage"]=pulses;
-  String out; serializeJson(doc,out);
-  Serial.print(STX); Serial.print(out); Serial.println(ETX);
+  Serial.print(STX); serializeJson(doc, Serial); Serial.println(ETX);
+}
+
+void sendConfigAck(int rows){
+  StaticJsonDocument<128> doc;
+  doc["type"]="config_ack"; doc["v"]=PROTOCOL_SCHEMA_VERSION; doc["rows"]=rows; doc["dropped"]=configAckDropped;
+  doc["maxLoopUs"]=uploadMaxLoopUs;
+  Serial.print(STX); serializeJson(doc, Serial); Serial.println(ETX);
+}
+
+static void sendError(const char* code){
+  StaticJsonDocument<96> doc;
+  doc["type"]="error"; doc["code"]=code;
+  Serial.print(STX); serializeJson(doc, Serial); Serial.println(ETX);
 }
 
 // ===== IO =====
@@ -387,7 +599,8 @@ void calculateFiringZones(){
   for (int i=0;i<4;i++){
     const auto &g = _guns_internal[i];
     if (!g.enabled) continue;
-    for (const GlueRow &row : g.rows){
+    for (uint8_t r = 0; r < g.rowCount; r++){
+      const GlueRow &row = g.rows[r];
       ActiveZone z;
       z.from  = firingBasePosition + (int64_t)row.from;
       z.to    = firingBasePosition + (int64_t)row.to;
@@ -442,7 +655,7 @@ void updateGuns(){
   }
 
   if (anyTestActive) {
-    if (config.type == "dots") {
+    if (config.type == CONTROLLER_DOTS) {
       // 50 Hz dot train per active channel with threshold cut
       unsigned long now = millis();
       const unsigned long periodMs = 20;
@@ -489,24 +702,14 @@ void updateGuns(){
   }
 
   if (!config.enabled) { shutdownAllGuns(); return; }
-  // --- Compute carriage speed (mm/s), update ~every 10ms ---
-  static unsigned long spLastUs = 0;
-  static int64_t       spLastPos = 0;
-  static double        speedMmPerSec = 0.0;
-  unsigned long nowUs = micros();
-  if (spLastUs == 0) { spLastUs = nowUs; spLastPos = currentPosition64; }
-  else {
-    unsigned long du = nowUs - spLastUs;
-    if (du >= 10000UL) {
-      int64_t dp = currentPosition64 - spLastPos; // pulses
-      double  sec = (double)du / 1000000.0;
-      double  pps = dp / sec; // pulses per second
-      speedMmPerSec = pps / (config.encoderPulsesPerMm > 0 ? config.encoderPulsesPerMm : 1.0);
-      spLastUs = nowUs; spLastPos = currentPosition64;
-    }
-  }
-
-  bool isLinesMode = (config.type == "lines");
+  // --- Carriage speed (filtered, from encoder edge times) and valve lead ---
+  float  pps = speedEstimator.pulsesPerSec;
+  double speedMmPerSec = pps / (config.encoderPulsesPerMm > 0 ? config.encoderPulsesPerMm : 1.0);
+  // Fire early by the distance travelled while the valve responds
+  int64_t onPos  = currentPosition64 + leadPulses((float)config.valveOnDelayMs,  pps);
+  int64_t offPos = currentPosition64 + leadPulses((float)config.valveOffDelayMs, pps);
+
+  bool isLinesMode = (config.type == CONTROLLER_LINES);
   bool speedTooLow = isLinesMode && (config.minimumSpeed > 0.0) && (speedMmPerSec < config.minimumSpeed);
 
   if (isLinesMode) {
@@ -517,11 +720,11 @@ void updateGuns(){
       if (firingZones[i].count){
         ActiveZone &zone = ring_peek(firingZones[i], 0);
 
-        if (currentPosition64 > zone.to) {
+        if (offPos > zone.to) {
           ring_pop(firingZones[i]);
           setGun(i,false);
           lineActive[i] = false; lineInHold[i] = false; linePWMon[i] = false;
-        } else if (currentPosition64 >= zone.from) {
+        } else if (onPos >= zone.from) {
           if (!lineActive[i]){
             lineActive[i] = true; lineInHold[i] = false; linePhaseMs[i] = millis();
           }
@@ -556,7 +759,7 @@ void updateGuns(){
     return; // lines mode handled
   }
 
-  // --- Dots mode (existing logic) ---
+  // --- Dots mode (existing logic; the dot is cut by current, so only the on delay applies) ---
   const int adcMid = (ADC_MAX / 2);
   const int deadband = INITIATION_DEADBAND_COUNTS;
 
@@ -569,15 +772,15 @@ void updateGuns(){
     if (firingZones[i].count){
       ActiveZone &zone = ring_peek(firingZones[i], 0);
 
-      if (currentPosition64 > zone.to) {
+      if (onPos > zone.to) {
         ring_pop(firingZones[i]);
-      } else if (currentPosition64 >= zone.from) {
+      } else if (onPos >= zone.from) {
         if (zone.space > 0) {
-          if (currentPosition64 >= zone.next) {
+          if (onPos >= zone.next) {
             int adcNow = getCurrentRaw(i);                   // 0..ADC_MAX
             if (abs(adcNow - adcMid) < deadband) gunStates[i] = true;
 
-            int64_t diff  = currentPosition64 - zone.next;
+            int64_t diff  = onPos - zone.next;
             int64_t steps = (diff >= 0) ? (diff / zone.space + 1) : 1;
             zone.next += steps * (int64_t)zone.space;
             if (zone.next > zone.to) zone.next = zone.to + 1;
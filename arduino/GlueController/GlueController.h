@@ -3,11 +3,30 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include "SpeedCompensation.h"
 
 // ===== Protocol =====
 const char STX = 0x02;
 const char ETX = 0x03;
 
+// Reported in the capabilities reply to "hello"
+#define FIRMWARE_VERSION        "1.3.0"
+#define PROTOCOL_SCHEMA_VERSION 1
+// Link rate negotiation: start at the default rate; a switched rate that is not
+// committed by the PC within BAUD_VERIFY_TIMEOUT_MS falls back to the default.
+#define DEFAULT_BAUD_RATE       115200UL
+#define BAUD_VERIFY_TIMEOUT_MS  2000UL
+// Repeated to build the baud_verify payload; must match ArduinoProtocol::kBaudVerifyPattern
+#define BAUD_VERIFY_PATTERN "UUUU0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!#$%&()*+,-./:;<=>?@[]^_{|}~"
+
+#if defined(__AVR__)
+  #define ADC_BITS       10
+  #define MAX_BAUD_RATE  500000UL   // exact divisor at 16 MHz
+#else
+  #define ADC_BITS       12
+  #define MAX_BAUD_RATE  2000000UL
+#endif
+
 // ===== Pins =====
 const int ENCODER_PIN_A = 2;
 const int SENSOR_PIN    = 4;
@@ -36,6 +55,20 @@ const double LARGE_DOT_THRESHOLD  = 1.1;
 // ===== Limits =====
 #define MAX_ZONES_PER_GUN 32
 
+// ===== Serial receive (fixed memory, no heap) =====
+// One frame (STX..ETX) is collected into a static buffer and decoded in place.
+// The R3 only has 2 KB of SRAM, so it gets a much smaller frame limit.
+#if defined(__AVR__)
+  #define SERIAL_RX_BUFFER_SIZE 384
+  #define JSON_DOC_CAPACITY     512
+#else
+  #define SERIAL_RX_BUFFER_SIZE 6144
+  #define JSON_DOC_CAPACITY     8192
+#endif
+// Upper bound of bytes consumed from the UART per loop() pass, so a long
+// plan upload is spread over many passes instead of stalling updateGuns().
+#define SERIAL_BYTES_PER_LOOP 48
+
 // ===== Data =====
 struct GlueRow {
   int from;   // pulses (with sensor offset baked-in)
@@ -45,8 +78,11 @@ struct GlueRow {
 
 struct GunConfig { bool enabled = true; };
 
+enum ControllerType : uint8_t { CONTROLLER_DOTS = 0, CONTROLLER_LINES = 1 };
+enum DotSize : uint8_t { DOT_SMALL = 0, DOT_MEDIUM = 1, DOT_LARGE = 2 };
+
 struct ControllerConfig {
-  String type = "dots";
+  ControllerType type = CONTROLLER_DOTS;
   bool   enabled = false;
   double encoderPulsesPerMm = 1.0;
   int    sensorOffset = 10;            // mm
@@ -55,7 +91,9 @@ struct ControllerConfig {
   double startDuration = 500;          // ms
   double holdCurrent  = 0.5;           // A
   double minimumSpeed = 0.0;           // mm/s (0 = disabled)
-  String dotSize = "medium";           // "small"|"medium"|"large"
+  DotSize dotSize = DOT_MEDIUM;        // "small"|"medium"|"large"
+  double valveOnDelayMs  = 0.0;        // command-to-glue delay when opening
+  double valveOffDelayMs = 0.0;        // command-to-stop delay when closing
 };
 
 struct ActiveZone {
@@ -71,8 +109,10 @@ struct ZoneRing {
 extern ControllerConfig config;
 extern GunConfig guns[4];
 
-extern volatile long encoderCount;
-extern int currentPosition;
+extern volatile uint32_t encoderCount;
+extern volatile uint32_t encoderLastEdgeUs;   // micros() of the latest encoder edge
+extern SpeedEstimator speedEstimator;
+extern int64_t currentPosition64;
 
 extern int pageLength;
 extern bool isCalibrating;
@@ -80,7 +120,7 @@ extern unsigned long lastHeartbeat;
 
 extern bool gunStates[4];
 extern bool allFiringZonesInserted;
-extern int  firingBasePosition;
+extern int64_t firingBasePosition;
 extern int  currentThreshold;        // 0..ADC_MAX
 
 extern ZoneRing firingZones[4];
@@ -102,8 +142,14 @@ void handleTest(const JsonObject& json);
 void initCalibration(const JsonObject& json);
 void handleCalibrationSensorStateChange(bool sensorState);
 void handleHeartbeat(const JsonObject& json); // no-op
+void handleHello(const JsonObject& json);
+void handleSetBaud(const JsonObject& json);
+void handleBaudVerify(const JsonObject& json);
+void handleBaudCommit(const JsonObject& json);
+void checkBaudFallback();
 
 void sendCalibrationResult(int pulses);
+void sendConfigAck(int rows);
 
 void updateGuns();
 void calculateFiringZones();
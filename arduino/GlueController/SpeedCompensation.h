@@ -0,0 +1,64 @@
+#ifndef SPEEDCOMPENSATION_H
+#define SPEEDCOMPENSATION_H
+
+// Line speed estimate and valve delay compensation.
+// Plain C++ (no Arduino.h) so it can be compiled and driven from a PC program.
+
+#include <stdint.h>
+
+// Minimum time between two edges used for one speed sample (limits jitter at high speed)
+#define SPEED_SAMPLE_MIN_US 2000UL
+// No edge for this long => line stopped
+#define SPEED_STALL_US      100000UL
+// Clamp for the lead so a bad estimate can't pull a zone far forward
+#define MAX_LEAD_PULSES     4000
+
+// Speed from encoder edge timestamps, smoothed with a first-order (EMA) filter.
+// Feed it the ISR edge count and the micros() of the latest edge; dividing by the
+// time between real edges avoids the +-1 pulse quantization of fixed-window counting.
+struct SpeedEstimator {
+  uint32_t lastCount    = 0;
+  uint32_t lastEdgeUs   = 0;
+  bool     primed       = false;
+  float    pulsesPerSec = 0.0f;   // filtered estimate
+  float    alpha        = 0.25f;  // weight of a new sample (0..1]
+
+  void reset() { primed = false; pulsesPerSec = 0.0f; }
+
+  void update(uint32_t count, uint32_t edgeUs, uint32_t nowUs) {
+    if (!primed) { lastCount = count; lastEdgeUs = edgeUs; primed = true; return; }
+
+    uint32_t idleUs = nowUs - edgeUs;  // time since the latest edge
+    if (idleUs >= SPEED_STALL_US) {
+      pulsesPerSec = 0.0f;
+      lastCount = count; lastEdgeUs = edgeUs;
+      return;
+    }
+    // True speed is below one pulse per idle time
+    if (idleUs > 0) {
+      float bound = 1000000.0f / (float)idleUs;
+      if (pulsesPerSec > bound) pulsesPerSec = bound;
+    }
+
+    uint32_t dn = count - lastCount;   // unsigned handles wrap
+    if (dn == 0) return;
+    uint32_t dt = edgeUs - lastEdgeUs;
+    if (dt < SPEED_SAMPLE_MIN_US) return; // keep accumulating edges
+
+    float sample = (float)dn * 1000000.0f / (float)dt;
+    if (pulsesPerSec == 0.0f) pulsesPerSec = sample;   // start from first real sample
+    else                      pulsesPerSec += alpha * (sample - pulsesPerSec);
+    lastCount  = count;
+    lastEdgeUs = edgeUs;
+  }
+};
+
+// Pulses the web travels during a valve delay: delay x speed, rounded and clamped.
+static inline int32_t leadPulses(float delayMs, float pulsesPerSec) {
+  if (delayMs <= 0.0f || pulsesPerSec <= 0.0f) return 0;
+  float p = delayMs * pulsesPerSec / 1000.0f;
+  if (p > (float)MAX_LEAD_PULSES) return MAX_LEAD_PULSES;
+  return (int32_t)(p + 0.5f);
+}
+
+#endif // SPEEDCOMPENSATION_H
@@ -79,6 +79,47 @@ public:
     int getNumberOfMachineCells() const;           // size of per-port vectors and GUI rows
     int getBarcodeChannelsToShow() const;          // how many communication channels to display in GUI
 
+    // Production scan history settings
+    void ensureDefaultHistorySettings();
+    nlohmann::json getHistorySettings() const;
+
+    // Shift report settings (online production counters and exporter)
+    void ensureDefaultReportSettings();
+    nlohmann::json getReportSettings() const;
+
+    // Prometheus metrics endpoint settings
+    void ensureDefaultMetricsSettings();
+    nlohmann::json getMetricsSettings() const;
+
+    // Local control API (line controller / MES) settings
+    void ensureDefaultApiSettings();
+    nlohmann::json getApiSettings() const;
+
+    // Shared memory state segment for local HMIs
+    void ensureDefaultSharedStateSettings();
+    nlohmann::json getSharedStateSettings() const;
+
+    // Separate engine process and GUI attach settings
+    void ensureDefaultEngineSettings();
+    nlohmann::json getEngineSettings() const;
+
+    // IO capture (logic-analyzer view) settings
+    void ensureDefaultCaptureSettings();
+    nlohmann::json getCaptureSettings() const;
+
+    // Long-term IO edge journal settings
+    void ensureDefaultEdgeJournalSettings();
+    nlohmann::json getEdgeJournalSettings() const;
+
+    // Modbus/TCP remote IO settings (io.modbus, used when io.device is "ModbusTCP")
+    void ensureDefaultModbusIoSettings();
+    nlohmann::json getModbusIoSettings() const;
+
+    // Whole configuration, e.g. to hand to the engine process
+    nlohmann::json toJson() const;
+    // Replace the whole configuration in memory (not saved)
+    void replaceAll(const nlohmann::json& settings);
+
     // Loads the configuration from a file after construction
 
 
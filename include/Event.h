@@ -4,6 +4,8 @@
 #include <unordered_map>
 #include <variant>
 #include <string>
+#include <vector>
+#include <functional>
 #include "io/IOChannel.h"
 
 // Event for IO state changes
@@ -66,7 +68,43 @@ struct TimerEvent {
 // Event for termination/shutdown signal.
 struct TerminationEvent {};
 
+// #### CONTROL API START ####
+
+// Typed commands from the local control API (see api/ControlServer.h)
+struct SetJobCommand {
+    std::string jobName;
+    std::string referenceFile; // optional: load as master reference file
+};
+
+struct LoadReferenceFileCommand {
+    std::vector<std::string> paths; // merged into one reference
+    int startIndex = 0;
+    int length = 0;            // 0 = to end of line
+    std::string match;         // exact, prefix, range or numeric; "" = tests.fileMatch
+};
+
+struct GetStateCommand {};
+
+// Treat a message as if it was received on a communication port
+struct InjectScanCommand {
+    std::string communicationName;
+    std::string message;
+};
+
+// Answered by the logic thread with an empty result (measures queue round trips)
+struct PingCommand {};
+
+using ControlCommand = std::variant<SetJobCommand, LoadReferenceFileCommand, GetStateCommand, InjectScanCommand, PingCommand>;
+
+// Executed on the logic thread; 'reply' is called exactly once there with the
+// result as JSON text (or an error message when ok is false).
+struct ControlEvent {
+    ControlCommand command;
+    std::function<void(bool ok, const std::string& result)> reply;
+};
+// #### CONTROL API END ####
+
 // Define a generic event type that can hold any of these event types
-using EventVariant = std::variant<IOEvent, CommEvent, GuiEvent, TimerEvent, TerminationEvent>;
+using EventVariant = std::variant<IOEvent, CommEvent, GuiEvent, TimerEvent, TerminationEvent, ControlEvent>;
 
 #endif // EVENT_H
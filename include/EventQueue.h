@@ -3,6 +3,8 @@
 
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <cstddef>
 #include <condition_variable>
 #include "Event.h"
 
@@ -12,6 +14,7 @@ public:
     void push(const T& event) {
         std::lock_guard<std::mutex> lock(mutex_);
         queue_.push(event);
+        size_.store(queue_.size(), std::memory_order_relaxed);
         condition_.notify_one();
     }
 
@@ -20,6 +23,7 @@ public:
         if (queue_.empty()) return false;
         event = queue_.front();
         queue_.pop();
+        size_.store(queue_.size(), std::memory_order_relaxed);
         return true;
     }
 
@@ -28,12 +32,17 @@ public:
         condition_.wait(lock, [this] { return !queue_.empty(); });
         event = queue_.front();
         queue_.pop();
+        size_.store(queue_.size(), std::memory_order_relaxed);
     }
 
+    // Number of queued events; lock-free, may be momentarily stale
+    std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
 private:
     std::queue<T> queue_;
     std::mutex mutex_;
     std::condition_variable condition_;
+    std::atomic<std::size_t> size_{0};
 };
 
 #endif // EVENT_QUEUE_H
@@ -8,7 +8,8 @@
 #include <optional>
 #include <chrono>
 #include <unordered_set>
-#include "io/PCI7248IO.h"
+#include <vector>
+#include "io/IOInterface.h"
 #include "EventQueue.h"
 #include "Event.h"
 #include "Config.h"
@@ -17,8 +18,21 @@
 #include <QStringList>
 #include "Timer.h"
 #include "communication/RS232Communication.h"
+#include "communication/ArduinoProtocol.h"
 #include "machine/MachineCore.h"
 #include "machine/DefaultMachineCoreFactory.h"
+#include "history/ScanHistory.h"
+#include "machine/DuplicateDetector.h"
+#include "machine/ReferenceIndex.h"
+#include "stats/ProductionStats.h"
+#include "stats/ShiftReportExporter.h"
+#include "stats/MetricsRegistry.h"
+#include "stats/MetricsHttpServer.h"
+#include "api/ControlServer.h"
+#include "shm/SharedStateWriter.h"
+
+Q_DECLARE_METATYPE(ArduinoProtocol::Capabilities)
+Q_DECLARE_METATYPE(IOCapture::Result)
 
 class Logic : public QObject {
     Q_OBJECT
@@ -37,6 +51,10 @@ signals:
     void calibrationResponse(int pulsesPerPage, const std::string& controllerName);
     // Emitted after each logic cycle to update the barcode grid in the GUI
     void barcodeStoreUpdated(const QMap<QString, QStringList>& store);
+    // Emitted when a glue controller answers hello with its capabilities
+    void controllerCapabilitiesChanged(const std::string& commName, const ArduinoProtocol::Capabilities& caps);
+    // Emitted when an IO capture (GuiEvent "IOCapture") has finished
+    void ioCaptureReady(const IOCapture::Result& result);
     
 public slots:
     // Initialize components that require GUI to be ready
@@ -59,6 +77,12 @@ public slots:
     
     // Get a reference to the active communication ports map
     const std::unordered_map<std::string, RS232Communication>& getActiveCommPorts() const;
+
+    // Production scan history (nullptr when disabled in settings)
+    ScanHistory* getScanHistory() const { return history_.get(); }
+
+    // Online production counters (safe to snapshot from any thread)
+    const ProductionStats& getProductionStats() const { return *stats_; }
     
 private:
     // Central logic cycle function - called after state changes from any event
@@ -70,23 +94,60 @@ private:
     void handleEvent(const GuiEvent& event);
     void handleEvent(const TimerEvent& event);
     void handleEvent(const TerminationEvent& event);
+    void handleEvent(const ControlEvent& event);
+    void handleCaptureEvent(const GuiEvent& event);
     
     // Helper functions
     void writeOutputs();
+    void emitBarcodeStore();
     void writeGUIOoutputs();
     
     // Timer control functions
-    void startTimer(const std::string& timerName);
+    void startTimer(const std::string& timerName, bool periodic = false);
+    void startTimerAt(const std::string& timerName, std::int64_t atMs); // wall clock ms since epoch
+    // Single cycle wakeup at the core's earliest deadline (CycleEffects::wakeupAtUs)
+    void scheduleWakeup(const std::optional<std::int64_t>& atUs);
     void stopTimer(const std::string& timerName);
     bool initTimers();
     
-    // Build/refresh the master file reference set from tests settings and apply to core
-    void refreshMasterFileReferenceSet();
+    // Build/refresh the master file reference index from tests settings and apply to core
+    void refreshMasterFileReference();
+    // Open/close the duplicate check from tests settings and apply to core
+    void refreshDuplicateCheck();
+    // Compile the per-port format checks from tests.validators
+    void refreshValidators();
+    // Compile communication.<port>.format patterns and hand the tests their fields
+    void refreshFormats();
+    // Load reference files into the core and enable the in-file check; false (core unchanged) if any is unreadable.
+    // 'match' is exact, prefix, range or numeric; "" = tests.fileMatch
+    bool loadMasterFileReference(const std::vector<std::string>& paths, int startIndex, int length,
+                                 const std::string& match, std::size_t& entries);
+
+    // Start the local control API if enabled in settings
+    void initControlServer();
+
+    // Open the shared memory state segment if enabled in settings
+    void initSharedState();
+
+    // Ask every glue controller on an active port for its capabilities
+    void sendControllerHello();
+
+    // Link rate negotiation with glue controllers (see ArduinoProtocol)
+    void startBaudNegotiation(const std::string& commName, const ArduinoProtocol::Capabilities& caps);
+    void handleBaudReply(const std::string& commName, const std::string& type, const nlohmann::json& msg);
+    void handleBaudTimeout(const std::string& commName);
+    void finishBaudNegotiation(const std::string& commName, bool success, const std::string& reason);
+    void armBaudTimer(const std::string& commName, int timeoutMs);
+    bool isBaudNegotiating(const std::string& commName) const;
+    void resetBaudNegotiations();
+
+    // Register metric series/collectors and start the endpoint if enabled
+    void initMetrics();
 
     // Core dependencies
     EventQueue<EventVariant> &eventQueue_;
     const Config& config_;
-    PCI7248IO io_;
+    std::unique_ptr<IOInterface> io_; // backend chosen by io.device
 
     
     // State tracking
@@ -96,6 +157,33 @@ private:
     
     // Map of active communication ports (only includes initialized/active ports)
     std::unordered_map<std::string, RS232Communication> activeCommPorts_;
+
+    // Glue controller capabilities by communication port (legacy until a reply arrives)
+    std::unordered_map<std::string, ArduinoProtocol::Capabilities> controllerCaps_;
+
+    // Per-port link rate negotiation state
+    struct BaudNegotiation {
+      enum class Stage { Idle, AwaitAck, Switching, AwaitVerify };
+      Stage stage{Stage::Idle};
+      int targetBaud{0};
+      int fallbackBaud{ArduinoProtocol::kDefaultBaudRate};
+      std::size_t verifyLength{0};
+      std::size_t verifyBytes{0};
+      std::chrono::steady_clock::time_point verifySentAt{};
+      std::vector<std::string> deferredSends; // held while the rate is changing
+    };
+    std::unordered_map<std::string, BaudNegotiation> baudNegotiations_;
+    std::unordered_map<std::string, Timer> baudTimers_;
+    Timer cycleWakeup_;
+    std::int64_t wakeupAtUs_{0}; // steady us of the scheduled wakeup, 0 = none
+
+    // Measured effective throughput per link (from the baud_verify round trip)
+    struct LinkStats {
+      int baudRate{0};
+      double throughputBytesPerSec{0.0};
+      double roundTripMs{0.0};
+    };
+    std::unordered_map<std::string, LinkStats> linkStats_;
     
     // Flags for tracking which systems have updates
     bool inputsUpdated_{false};
@@ -119,6 +207,36 @@ private:
     // Machine logic core (pluggable)
     std::unique_ptr<MachineCore> core_;
 
+    // Job-wide duplicate check on master scans (nullptr when disabled); the core holds a raw pointer
+    std::unique_ptr<DuplicateDetector> duplicates_;
+    bool duplicatesFullReported_{false};
+
+    // Compiled format checks per communication port; run on each scan before the cycle
+    std::unordered_map<std::string, ScanValidator> validators_;
+    // Compiled format patterns per communication port; the core holds pointers into this map
+    std::unordered_map<std::string, PayloadPattern> formats_;
+
+    // Every stored scan is appended here (background writer)
+    std::unique_ptr<ScanHistory> history_;
+
+    // Online shift counters (updated in oneLogicCycle) and their report writer
+    std::unique_ptr<ProductionStats> stats_;
+    std::unique_ptr<ShiftReportExporter> reportExporter_;
+
+    // Metrics for the optional Prometheus endpoint (server declared last: stopped first)
+    MetricsRegistry metrics_;
+    MetricsRegistry::Counter* outputWritesMetric_{nullptr};
+    MetricsRegistry::Counter* outputWriteErrorsMetric_{nullptr};
+    std::unordered_map<std::string, MetricsRegistry::Counter*> commFrameMetrics_; // logic thread only
+    std::unique_ptr<MetricsHttpServer> metricsServer_;
+
+    // Local control API for the line controller, and the job it last selected
+    std::unique_ptr<ControlServer> controlServer_;
+    std::string jobName_;
+
+    // Live state for HMIs on this machine (written at the end of every logic cycle)
+    std::unique_ptr<SharedStateWriter> sharedState_;
+
     // Throttle GUI barcode updates to avoid excessive work on the GUI thread
     std::chrono::steady_clock::time_point lastBarcodeEmit_{std::chrono::steady_clock::time_point::min()};
     int barcodeEmitIntervalMs_{50}; // minimum interval between GUI updates
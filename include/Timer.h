@@ -6,8 +6,10 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <cstdint>
 #include <mutex>
 #include "io/IOChannel.h"
+#include "stats/LatencyHistogram.h"
 
 class Timer
 {
@@ -31,33 +33,69 @@ public:
     template <typename Duration>
     void start(Duration duration, Callback cb)
     {
-        // Cancel any previous timer.
-        cancel();
-        // If a previous thread is still active, join it.
-        if (worker_.joinable())
-        {
-            worker_.join();
-        }
-        cancelled_.store(false);
-        // Launch a new thread.
-        worker_ = std::thread([this, duration, cb]()
+        startAt(std::chrono::steady_clock::now() + duration, std::move(cb));
+    }
+
+    // One shot at an absolute steady_clock deadline
+    void startAt(std::chrono::steady_clock::time_point deadline, Callback cb)
+    {
+        stopWorker();
+        worker_ = std::thread([this, deadline, cb]()
                               {
-        std::unique_lock<std::mutex> lock(mutex_);
-        // Wait until either the duration elapses or we are cancelled.
-        if (cv_.wait_for(lock, duration, [this]() { return cancelled_.load(); })) {
-            // Timer was cancelled.
-            return;
-        }
-        // Timer elapsed normally, execute the callback.
+        if (!waitUntil(deadline)) return; // cancelled
+        recordLateness(deadline);
         cb(); });
     }
 
+    // One shot at a wall clock time. The deadline is converted to steady_clock once,
+    // so later clock adjustments do not move it.
+    void startAt(std::chrono::system_clock::time_point when, Callback cb)
+    {
+        const auto delay = when - std::chrono::system_clock::now();
+        startAt(std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay),
+                std::move(cb));
+    }
+
+    // Auto-reload: fires every period until cancelled. Deadlines are absolute
+    // (first = now + period, then += period), so the period does not drift with
+    // callback or scheduling delays. Periods missed entirely (the thread woke
+    // more than a period late) are skipped and counted, not fired in a burst.
+    template <typename Duration>
+    void startPeriodic(Duration period, Callback cb)
+    {
+        const auto step = std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        if (step <= std::chrono::steady_clock::duration::zero()) return;
+        stopWorker();
+        worker_ = std::thread([this, step, cb]()
+                              {
+        auto deadline = std::chrono::steady_clock::now() + step;
+        while (waitUntil(deadline)) {
+            recordLateness(deadline);
+            cb();
+            deadline += step;
+            const auto now = std::chrono::steady_clock::now();
+            if (deadline <= now) {
+                const auto behind = (now - deadline) / step + 1;
+                missedPeriods_.fetch_add(static_cast<std::uint64_t>(behind), std::memory_order_relaxed);
+                deadline += behind * step;
+            }
+        } });
+    }
+
     // Cancel the timer: signals the waiting thread to wake up and exit early.
     void cancel()
     {
-        cancelled_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_.store(true);
+        }
         cv_.notify_all();
     }
+
+    // Lateness of each firing (actual - deadline, us) and skipped periodic deadlines
+    const LatencyHistogram& jitter() const { return jitter_; }
+    std::uint64_t missedPeriods() const { return missedPeriods_.load(std::memory_order_relaxed); }
     
     // State management methods
     void setName(const std::string& name) { name_ = name; }
@@ -81,10 +119,39 @@ public:
     
 
 private:
+    // Cancel and join the running worker so a new one can start
+    void stopWorker()
+    {
+        cancel();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+        cancelled_.store(false);
+    }
+
+    // Sleep until the deadline; false if cancelled first
+    bool waitUntil(std::chrono::steady_clock::time_point deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return !cv_.wait_until(lock, deadline, [this]() { return cancelled_.load(); });
+    }
+
+    void recordLateness(std::chrono::steady_clock::time_point deadline)
+    {
+        const auto late = std::chrono::steady_clock::now() - deadline;
+        jitter_.record(late.count() > 0
+                           ? static_cast<std::uint64_t>(
+                                 std::chrono::duration_cast<std::chrono::microseconds>(late).count())
+                           : 0);
+    }
+
     std::atomic<bool> cancelled_; // Flag to indicate if the timer is cancelled.
     std::mutex mutex_;            // Mutex for the condition variable.
     std::condition_variable cv_;  // Condition variable for waiting.
     std::thread worker_;          // The timer's worker thread.
+    LatencyHistogram jitter_;     // Firing lateness in microseconds
+    std::atomic<std::uint64_t> missedPeriods_{0};
     
     // State management variables
     std::string name_;            // Timer name (e.g., "timer1", "timer2")
@@ -112,6 +179,9 @@ int main() {
     // Simulate doing other work.
     std::this_thread::sleep_for(std::chrono::seconds(1));
 
+    // Or fire every 500 ms on absolute deadlines until cancelled:
+    // timer.startPeriodic(std::chrono::milliseconds(500), [] { std::cout << "tick" << std::endl; });
+
     // Uncomment the next line to cancel the timer before it elapses.
     // timer.cancel();
 
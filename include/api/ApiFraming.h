@@ -0,0 +1,110 @@
+#ifndef APIFRAMING_H
+#define APIFRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Message framing of the local control API. Every message is one JSON object:
+//  - JsonLines:      the compact JSON text followed by '\n'
+//  - LengthPrefixed: a 4-byte big-endian payload length followed by the JSON text
+// Shared by the server and the tools so both ends agree on the wire format.
+namespace ApiFraming {
+
+enum class Mode { JsonLines, LengthPrefixed };
+
+constexpr std::size_t kMaxFrameBytes = 1024 * 1024;
+
+// "json-lines" / "length-prefixed"
+inline bool parseMode(const std::string& name, Mode& mode) {
+    if (name == "json-lines") {
+        mode = Mode::JsonLines;
+        return true;
+    }
+    if (name == "length-prefixed") {
+        mode = Mode::LengthPrefixed;
+        return true;
+    }
+    return false;
+}
+
+inline const char* modeName(Mode mode) {
+    return mode == Mode::JsonLines ? "json-lines" : "length-prefixed";
+}
+
+// Appends one framed message; JSON from nlohmann::json::dump() never contains a raw newline
+inline void appendFrame(std::string& out, Mode mode, const std::string& payload) {
+    if (mode == Mode::JsonLines) {
+        out += payload;
+        out += '\n';
+        return;
+    }
+    const auto n = static_cast<std::uint32_t>(payload.size());
+    out += static_cast<char>((n >> 24) & 0xFF);
+    out += static_cast<char>((n >> 16) & 0xFF);
+    out += static_cast<char>((n >> 8) & 0xFF);
+    out += static_cast<char>(n & 0xFF);
+    out += payload;
+}
+
+// Incremental decoder for a byte stream; frames larger than kMaxFrameBytes are a protocol error
+class Decoder {
+public:
+    explicit Decoder(Mode mode) : mode_(mode) {}
+
+    void feed(const char* data, std::size_t size) { buffer_.append(data, size); }
+
+    // Extracts the next complete frame; false when more bytes are needed or after an error
+    bool next(std::string& frame) {
+        if (error_) return false;
+        if (mode_ == Mode::JsonLines) {
+            const std::size_t eol = buffer_.find('\n', consumed_);
+            if (eol == std::string::npos) {
+                error_ = buffer_.size() - consumed_ > kMaxFrameBytes;
+                compact();
+                return false;
+            }
+            std::size_t end = eol;
+            if (end > consumed_ && buffer_[end - 1] == '\r') --end;
+            frame.assign(buffer_, consumed_, end - consumed_);
+            consumed_ = eol + 1;
+            return true;
+        }
+        if (buffer_.size() - consumed_ < 4) {
+            compact();
+            return false;
+        }
+        const auto* p = reinterpret_cast<const unsigned char*>(buffer_.data() + consumed_);
+        const std::size_t n = (std::size_t(p[0]) << 24) | (std::size_t(p[1]) << 16) |
+                              (std::size_t(p[2]) << 8) | std::size_t(p[3]);
+        if (n > kMaxFrameBytes) {
+            error_ = true;
+            return false;
+        }
+        if (buffer_.size() - consumed_ - 4 < n) {
+            compact();
+            return false;
+        }
+        frame.assign(buffer_, consumed_ + 4, n);
+        consumed_ += 4 + n;
+        return true;
+    }
+
+    bool error() const { return error_; }
+
+private:
+    void compact() {
+        if (consumed_ == 0) return;
+        buffer_.erase(0, consumed_);
+        consumed_ = 0;
+    }
+
+    Mode mode_;
+    std::string buffer_;
+    std::size_t consumed_{0};
+    bool error_{false};
+};
+
+} // namespace ApiFraming
+
+#endif // APIFRAMING_H
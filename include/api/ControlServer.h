@@ -0,0 +1,117 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "EventQueue.h"
+#include "Event.h"
+#include "api/ApiFraming.h"
+#include "machine/MachineCore.h"
+#include "stats/ProductionStats.h"
+
+// Local TCP API for a line controller / MES.
+//
+// Requests are JSON objects {"id": <any>, "cmd": "<name>", ...}; each gets exactly
+// one response {"id", "ok", "result"|"error"} on the same connection, in order of
+// completion. Commands that change machine state are pushed as typed ControlEvents
+// and answered from the logic thread; counters are read directly from lock-free
+// ProductionStats snapshots.
+//
+// After {"cmd":"subscribe"} a client also receives result frames
+// {"type":"results","seq","items":[...]}: every scan published by the logic thread
+// within one batch interval goes out as a single frame that is serialized once and
+// shared by all subscribers, so socket work grows with the number of frames, not
+// the product rate. A subscriber that does not keep up has frames dropped and is
+// told with {"type":"dropped","frames":n}.
+//
+// One thread polls the listener and all clients; nothing blocks the logic thread.
+class ControlServer {
+public:
+    struct Options {
+        std::string bindAddress{"127.0.0.1"};
+        int port{5020};
+        ApiFraming::Mode framing{ApiFraming::Mode::JsonLines};
+        int batchIntervalMs{50};
+        int maxClients{8};
+        int requestTimeoutMs{5000};                       // logic thread must answer within this
+        std::size_t maxPendingResults{100000};            // scans held between two batches
+        std::size_t maxClientBufferBytes{4 * 1024 * 1024}; // unsent bytes before frames are dropped
+        bool allowInjectScan{false};                      // testing only: feed scans without a reader
+    };
+
+    ControlServer(EventQueue<EventVariant>& eventQueue, const ProductionStats& stats, Options options);
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool start();
+    void stop();
+
+    // Logic thread: queue scans for the next result frame (never blocks on sockets)
+    void publishResults(const std::vector<ScanRecord>& scans, std::int64_t timeMs, const std::string& job);
+
+    // Port actually bound (useful with port 0)
+    int boundPort() const { return boundPort_; }
+
+private:
+    struct Listener;
+    struct Client;
+    struct Replies;
+
+    // Request forwarded to the logic thread, waiting for its reply
+    struct PendingRequest {
+        std::uint64_t clientId;
+        nlohmann::json id;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    struct PendingResult {
+        std::int64_t timeMs;
+        std::string job;
+        ScanRecord scan;
+    };
+
+    void run();
+    void acceptClients();
+    bool readClient(Client& client);
+    bool writeClient(Client& client);
+    void handleRequest(Client& client, const std::string& text);
+    void forwardToLogic(Client& client, const nlohmann::json& id, ControlCommand command);
+    void sendMessage(Client& client, const std::string& json);
+    Client* findClient(std::uint64_t clientId);
+    void deliverReplies();
+    void expireRequests();
+    void publishBatch();
+
+    EventQueue<EventVariant>& eventQueue_;
+    const ProductionStats& stats_;
+    Options options_;
+
+    std::unique_ptr<Listener> listener_;
+    std::vector<std::unique_ptr<Client>> clients_; // server thread only
+    std::uint64_t nextClientId_{1};
+    std::uint64_t nextRequestSeq_{1};
+    std::uint64_t batchSeq_{0};
+    std::unordered_map<std::uint64_t, PendingRequest> pendingRequests_; // by request sequence number
+    std::shared_ptr<Replies> replies_; // outlives the server for late logic-thread replies
+    std::atomic<int> subscribers_{0};
+
+    std::mutex resultsMutex_;
+    std::vector<PendingResult> pendingResults_;
+    std::uint64_t droppedResults_{0};
+
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+    int boundPort_{0};
+};
+
+#endif // CONTROLSERVER_H
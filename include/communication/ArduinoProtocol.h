@@ -16,14 +16,46 @@
  * - Calibration: {"type": "calibrate", "pageLength": 100}
  * - Control: {"type": "run"} / {"type": "stop"}
  * - Heartbeat: {"type": "heartbeat"}
+ * - Hello: {"type": "hello", "v": 1} -> {"type": "capabilities", "v": 1, "fw": "...", ...}
+ * - Link rate: set_baud -> baud_ack, both switch, baud_verify echo, then baud_commit
+ *
+ * Schema versioning: messages to a controller that answered hello carry "v". Controllers
+ * that never answer are treated as legacy (schema 0) and get the unversioned messages.
  */
 class ArduinoProtocol {
 public:
+    // Schema version spoken by this PC build
+    static constexpr int kSchemaVersion = 1;
+
+    // Line rate every link starts (and falls back) at
+    static constexpr int kDefaultBaudRate = 115200;
+
+    // Repeated to build the baud_verify payload; same string in the firmware.
+    // 'U' (0x55) alternates every bit; the rest covers the printable range.
+    static constexpr const char* kBaudVerifyPattern =
+        "UUUU0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!#$%&()*+,-./:;<=>?@[]^_{|}~";
+
     struct GlueRow {
         int from;
         int to;
         double space;
     };
+
+    /**
+     * @brief What a controller reported in its capabilities reply
+     *
+     * Default-constructed values describe a legacy controller (no hello support).
+     */
+    struct Capabilities {
+        bool legacy = true;
+        int schemaVersion = 0;
+        std::string firmwareVersion = "unknown";
+        int adcBits = 10;
+        int maxZones = 32;
+        int rxBuffer = 0;            // largest frame the controller accepts (0 = unknown)
+        std::vector<std::string> encodings{"json"};
+        int maxBaud = 115200;
+    };
     
     /**
      * @brief Create config message for Arduino
@@ -46,6 +78,9 @@ public:
      * @param encoderResolution Encoder resolution in pulses per mm
      * @param sensorOffset Sensor offset in mm
      * @param guns Vector of gun configurations with enable state and rows
+     * @param valveOnDelayMs Valve opening delay; firmware fires earlier by delay x speed
+     * @param valveOffDelayMs Valve closing delay; firmware stops earlier by delay x speed
+     * @param schemaVersion Peer schema from its capabilities; 0 keeps the legacy message layout
      * @return JSON string for controller setup message
      */
     static std::string createControllerSetupMessage(const std::string& controllerType,
@@ -56,7 +91,10 @@ public:
                                                    double startCurrent = 1.0,
                                                    double startDurationMS = 0.5,
                                                    double holdCurrent = 0.5,
-                                                   const std::string& dotSize = "medium");
+                                                   const std::string& dotSize = "medium",
+                                                   double valveOnDelayMs = 0.0,
+                                                   double valveOffDelayMs = 0.0,
+                                                   int schemaVersion = 0);
     
     /**
      * @brief Create calibration message for Arduino
@@ -71,6 +109,59 @@ public:
      */
     static std::string createHeartbeatMessage();
 
+    /**
+     * @brief Create hello message asking the controller for its capabilities
+     * @return JSON string, e.g. {"type":"hello","v":1}
+     */
+    static std::string createHelloMessage();
+
+    /**
+     * @brief Parse a capabilities reply
+     * @param response Parsed JSON message from the controller
+     * @param caps Output capabilities (unchanged on failure)
+     * @return true if the message is a valid capabilities reply
+     */
+    static bool parseCapabilities(const nlohmann::json& response, Capabilities& caps);
+
+    /**
+     * @brief Pick the most efficient payload encoding both sides support
+     * @return Encoding name; "json" is always available
+     */
+    static std::string selectEncoding(const Capabilities& caps);
+
+    /**
+     * @brief Pick the link baud rate: the highest rate both sides allow
+     * @param caps Controller capabilities
+     * @param hostMaxBaud Highest rate allowed on the PC side for this port
+     */
+    static int selectBaudRate(const Capabilities& caps, int hostMaxBaud);
+
+    /**
+     * @brief Ask the controller to switch its line rate; it answers baud_ack at the current rate
+     */
+    static std::string createSetBaudMessage(int baudRate);
+
+    /**
+     * @brief Test pattern sent right after switching; the controller echoes it back
+     * @param payloadLength Number of pattern characters to send
+     */
+    static std::string createBaudVerifyMessage(std::size_t payloadLength);
+
+    /**
+     * @brief Confirm the new rate; without it the controller reverts on its own
+     */
+    static std::string createBaudCommitMessage(int baudRate);
+
+    /**
+     * @brief Check that a received pattern is an intact repetition of kBaudVerifyPattern
+     */
+    static bool isValidBaudVerifyPattern(const std::string& pattern, std::size_t expectedLength);
+
+    /**
+     * @brief Wrap a message in STX/ETX framing as expected by the controller
+     */
+    static std::string frame(const std::string& message);
+
     /**
      * @brief Create test message for Arduino to toggle a gun in test mode
      * @param gunIndex 1..4 for specific gun; if 0 or negative, this targets all guns
@@ -34,6 +34,11 @@ public:
     virtual void startReceiving() override;
     virtual void close() override;
 
+    // Change the line rate of an open port (used by link rate negotiation).
+    // Pending input is purged because bytes around the switch are garbage.
+    bool setBaudRate(unsigned long baudRate);
+    unsigned long getBaudRate() const { return baudRate_; }
+
 private:
     std::string communicationName_;
     std::string port_; // Previously portName_
@@ -0,0 +1,59 @@
+#ifndef ENGINEHOST_H
+#define ENGINEHOST_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QMetaObject>
+#include "Config.h"
+#include "EventQueue.h"
+#include "Event.h"
+#include "json.hpp"
+#include "shm/IpcChannel.h"
+
+class Logic;
+
+// Engine side of the GUI link (see engine/EngineProtocol.h).
+//
+// Logic's GUI signals are connected directly (they run on the logic thread)
+// and encoded into the event ring; when no GUI reads it, messages are dropped
+// instead of stalling the logic thread. Commands from the GUI are decoded on
+// a separate thread and pushed to the event queue like any other event, so the
+// GUI never executes engine code.
+class EngineHost {
+public:
+    EngineHost(Logic& logic, EventQueue<EventVariant>& eventQueue, Config& config,
+               std::string channelName = IpcChannel::kDefaultName);
+    ~EngineHost();
+
+    EngineHost(const EngineHost&) = delete;
+    EngineHost& operator=(const EngineHost&) = delete;
+
+    // Create the channel and start serving; false if it cannot be created
+    bool start();
+    void stop();
+
+private:
+    void connectSignals();
+    void commandLoop();
+    void handleCommand(const nlohmann::json& message);
+    // Thread-safe (logic thread and command thread both send)
+    void post(const nlohmann::json& message);
+
+    Logic& logic_;
+    EventQueue<EventVariant>& eventQueue_;
+    Config& config_;
+    IpcChannel channel_;
+
+    std::mutex sendMutex_;
+    std::uint64_t dropped_{0}; // guarded by sendMutex_
+
+    std::vector<QMetaObject::Connection> connections_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+#endif // ENGINEHOST_H
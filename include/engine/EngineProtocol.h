@@ -0,0 +1,61 @@
+#ifndef ENGINEPROTOCOL_H
+#define ENGINEPROTOCOL_H
+
+#include <string>
+#include "json.hpp"
+#include "Event.h"
+#include "communication/ArduinoProtocol.h"
+
+// JSON messages exchanged over the IpcChannel between the engine process
+// (EngineHost) and an attached GUI (EngineLink). Every message has a "t" field.
+//
+// GUI -> engine:
+//   {"t":"hello"}                                   attach; engine resends all GUI state
+//   {"t":"gui", keyword, target, data, intValue}    a GuiEvent for Logic
+//   {"t":"gui", ..., "config":{...}}                ParameterChange with the GUI's settings
+//   {"t":"ping","id":n}                             answered by the logic thread
+// engine -> GUI:
+//   {"t":"message","text","id"}   {"t":"inputs","states":{name:state}}
+//   {"t":"barcodes","store":{port:[cells]}}   {"t":"calibration","pulsesPerPage","controller"}
+//   {"t":"capabilities","comm","caps":{...}}   {"t":"pong","id":n}
+//   {"t":"capture","result":{...}}   a finished IO capture (IOCapture::encodeResult)
+//   {"t":"dropped","count":n}     messages lost because the GUI ring was full
+namespace EngineProtocol {
+
+inline nlohmann::json encodeGuiEvent(const GuiEvent& event) {
+    return {{"t", "gui"}, {"keyword", event.keyword}, {"target", event.target},
+            {"data", event.data}, {"intValue", event.intValue}};
+}
+
+inline GuiEvent decodeGuiEvent(const nlohmann::json& message) {
+    GuiEvent event;
+    event.keyword = message.value("keyword", std::string());
+    event.target = message.value("target", std::string());
+    event.data = message.value("data", std::string());
+    event.intValue = message.value("intValue", 0);
+    return event;
+}
+
+inline nlohmann::json encodeCapabilities(const ArduinoProtocol::Capabilities& caps) {
+    return {{"legacy", caps.legacy}, {"schemaVersion", caps.schemaVersion},
+            {"firmwareVersion", caps.firmwareVersion}, {"adcBits", caps.adcBits},
+            {"maxZones", caps.maxZones}, {"rxBuffer", caps.rxBuffer},
+            {"encodings", caps.encodings}, {"maxBaud", caps.maxBaud}};
+}
+
+inline ArduinoProtocol::Capabilities decodeCapabilities(const nlohmann::json& json) {
+    ArduinoProtocol::Capabilities caps;
+    caps.legacy = json.value("legacy", caps.legacy);
+    caps.schemaVersion = json.value("schemaVersion", caps.schemaVersion);
+    caps.firmwareVersion = json.value("firmwareVersion", caps.firmwareVersion);
+    caps.adcBits = json.value("adcBits", caps.adcBits);
+    caps.maxZones = json.value("maxZones", caps.maxZones);
+    caps.rxBuffer = json.value("rxBuffer", caps.rxBuffer);
+    caps.encodings = json.value("encodings", caps.encodings);
+    caps.maxBaud = json.value("maxBaud", caps.maxBaud);
+    return caps;
+}
+
+} // namespace EngineProtocol
+
+#endif // ENGINEPROTOCOL_H
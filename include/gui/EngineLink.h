@@ -0,0 +1,72 @@
+#ifndef ENGINELINK_H
+#define ENGINELINK_H
+
+#include <QObject>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "Config.h"
+#include "EventQueue.h"
+#include "Event.h"
+#include "json.hpp"
+#include "communication/ArduinoProtocol.h"
+#include "io/IOCapture.h"
+#include "shm/IpcChannel.h"
+
+// GUI side of a split deployment: stands in for Logic when the GUI runs
+// attached to a separate engine process (machineControllerEngine).
+//
+// It has Logic's GUI signals and slots, so MainWindow and SettingsWindow are
+// wired the same way. GuiEvents pushed to the local event queue are forwarded
+// to the engine's command ring; engine messages are turned back into signals.
+// When the engine heartbeat stops the link reports it and keeps re-attaching,
+// and on every attach it measures the command round trip (engine.rttSamples).
+class EngineLink : public QObject {
+    Q_OBJECT
+public:
+    EngineLink(EventQueue<EventVariant>& eventQueue, const Config& config, QObject* parent = nullptr);
+    ~EngineLink();
+
+    void start();
+    void stop();
+
+signals:
+    void guiMessage(const QString& msg, const QString& identifier);
+    void inputStatesChanged(const std::unordered_map<std::string, IOChannel>& inputs);
+    void calibrationResponse(int pulsesPerPage, const std::string& controllerName);
+    void barcodeStoreUpdated(const QMap<QString, QStringList>& store);
+    void controllerCapabilitiesChanged(const std::string& commName, const ArduinoProtocol::Capabilities& caps);
+    void ioCaptureReady(const IOCapture::Result& result);
+
+public slots:
+    void handleOutputOverrideStateChanged(bool enabled);
+    void handleOutputStateChanged(const std::unordered_map<std::string, IOChannel>& outputs);
+
+private:
+    void forwardLoop();  // local event queue -> engine
+    void receiveLoop();  // engine -> signals; attach/re-attach
+    bool attach();
+    void measureRoundTrip(int samples);
+    void dispatch(const nlohmann::json& message);
+    bool send(const nlohmann::json& message);
+
+    EventQueue<EventVariant>& eventQueue_;
+    const Config& config_;
+    IpcChannel channel_;
+    std::mutex channelMutex_; // send(), open() and close(); receive() stays on the receive thread
+
+    std::int64_t attachedStartMs_{0};
+    bool engineLost_{false};
+    std::uint64_t nextPingId_{1};
+    std::atomic<bool> running_{false};
+    std::thread forwardThread_;
+    std::thread receiveThread_;
+};
+
+#endif // ENGINELINK_H
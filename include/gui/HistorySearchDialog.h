@@ -0,0 +1,30 @@
+#ifndef HISTORYSEARCHDIALOG_H
+#define HISTORYSEARCHDIALOG_H
+
+#include <QDialog>
+
+class QLineEdit;
+class QPushButton;
+class QTableWidget;
+class QLabel;
+class ScanHistory;
+
+// Looks up a barcode in the production scan history
+class HistorySearchDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit HistorySearchDialog(QWidget* parent, ScanHistory* history);
+
+private slots:
+    void onSearch();
+
+private:
+    ScanHistory* history_;
+    QLineEdit* barcodeEdit_;
+    QPushButton* searchButton_;
+    QTableWidget* resultTable_;
+    QLabel* statusLabel_;
+};
+
+#endif // HISTORYSEARCHDIALOG_H
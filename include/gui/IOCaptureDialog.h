@@ -0,0 +1,106 @@
+#ifndef IOCAPTUREDIALOG_H
+#define IOCAPTUREDIALOG_H
+
+#include <QDialog>
+#include <QWidget>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Config.h"
+#include "Event.h"
+#include "EventQueue.h"
+#include "io/IOCapture.h"
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+
+// Waveform of a finished IO capture, one row per named pin.
+// Wheel zooms around the mouse, dragging pans, a click places cursor A and a
+// right click cursor B; double click shows the whole capture. Each pixel
+// column is drawn from a binary search of the row's edges, so the cost
+// depends on the width, not on the number of edges.
+class WaveformView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit WaveformView(QWidget* parent = nullptr);
+
+    void setResult(const IOCapture::Result& result);
+    bool hasCursors() const { return cursorA_ != kNoCursor && cursorB_ != kNoCursor; }
+    // Cursor times relative to the trigger, in ns
+    std::int64_t cursorA() const { return cursorA_; }
+    std::int64_t cursorB() const { return cursorB_; }
+
+signals:
+    void cursorsMoved();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+private:
+    static constexpr std::int64_t kNoCursor = std::numeric_limits<std::int64_t>::min();
+
+    struct Row {
+        QString name;
+        bool initial{false};
+        std::vector<std::int64_t> edges;   // ns relative to the trigger
+    };
+
+    int plotLeft() const;
+    double toX(std::int64_t timeNs) const;
+    std::int64_t toTime(double x) const;
+    void fitAll();
+
+    std::vector<Row> rows_;
+    std::int64_t firstNs_{0};   // capture window relative to the trigger
+    std::int64_t lastNs_{0};
+    double viewStartNs_{0};
+    double nsPerPixel_{1};
+    std::int64_t cursorA_{kNoCursor};
+    std::int64_t cursorB_{kNoCursor};
+    QPoint pressPos_;
+    double pressViewStart_{0};
+    bool dragging_{false};
+};
+
+// Arms IO captures on the engine (GuiEvent "IOCapture") and shows the result
+class IOCaptureDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    IOCaptureDialog(QWidget* parent, EventQueue<EventVariant>& eventQueue, const Config& config);
+
+    void setResult(const IOCapture::Result& result);
+
+private slots:
+    void onArm();
+    void onTriggerTypeChanged(int index);
+    void updateStatus();
+
+private:
+    void send(const std::string& target, const std::string& data = std::string());
+
+    EventQueue<EventVariant>& eventQueue_;
+    QComboBox* triggerCombo_;
+    QComboBox* channelCombo_;
+    QComboBox* edgeCombo_;
+    QLineEdit* patternEdit_;
+    QSpinBox* preSpin_;
+    QSpinBox* postSpin_;
+    QPushButton* armButton_;
+    QPushButton* triggerButton_;
+    QPushButton* disarmButton_;
+    WaveformView* view_;
+    QLabel* statusLabel_;
+    QString summary_;
+};
+
+#endif // IOCAPTUREDIALOG_H
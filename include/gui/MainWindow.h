@@ -11,6 +11,11 @@
 #include "EventQueue.h"
 #include "gui/SettingsWindow.h"
 #include "Config.h"
+#include "io/IOCapture.h"
+
+class ScanHistory;
+class HistorySearchDialog;
+class IOCaptureDialog;
 
 namespace Ui {
     class MainWindow;
@@ -35,9 +40,14 @@ public:
     // Add a message to the message area
     void addMessage(const QString& message, const QString& identifier = "");
 
+    // Production scan history used by the History dialog (may be nullptr)
+    void setScanHistory(ScanHistory* history) { scanHistory_ = history; }
+
 public slots:
     // Render barcode table when core store updates
     void onBarcodeStoreUpdated(const QMap<QString, QStringList>& store);
+    // Show a finished IO capture in the waveform viewer
+    void onIOCaptureReady(const IOCapture::Result& result);
 
 private slots:
     void on_selectDataFileButton_clicked();
@@ -48,12 +58,17 @@ private slots:
     void on_settingsButton_clicked();
     void on_clearMessageAreaButton_clicked();
     void on_testButton_clicked();
+    void on_historySearchButton_clicked();
+    void on_ioCaptureButton_clicked();
 
 private:
     Ui::MainWindow *ui;
     EventQueue<EventVariant> &eventQueue_;
     SettingsWindow *settingsWindow_;
     const Config* config_;
+    ScanHistory* scanHistory_{nullptr};
+    HistorySearchDialog* historySearchDialog_{nullptr};
+    IOCaptureDialog* ioCaptureDialog_{nullptr};
 
     // Build and populate the right-side glue test table
     void buildGlueTestTable();
@@ -61,6 +76,9 @@ private:
     // Helper to (re)build barcode table with index + selected channels
     void renderBarcodeTable(const QMap<QString, QStringList>& store);
 
+    // Pre-flight check of a selected data file (tests.verifyDataFile); true to use the file
+    bool verifyDataFile(const QString& filePath);
+
 };
 
 #endif // MAINWINDOW_H
@@ -120,6 +120,7 @@ private slots:
     void on_glueCalibrateButton_clicked();
     void on_glueControllerEnabledCheckBox_stateChanged(int state);
     void onGlueEncoderCalibrationResponse(int pulsesPerPage, const std::string& controllerName);
+    void onControllerCapabilities(const std::string& commName, const ArduinoProtocol::Capabilities& caps);
     void onGluePlanSelectorChanged(int index);
     void on_addGluePlanButton_clicked();
     void on_removeGluePlanButton_clicked();
@@ -132,6 +133,8 @@ private slots:
     void on_glueStartDurationSpinBox_valueChanged(double value);
     void on_glueHoldCurrentSpinBox_valueChanged(double value);
     void on_glueDotSizeComboBox_currentIndexChanged(int index);
+    void on_glueValveOnDelaySpinBox_valueChanged(double value);
+    void on_glueValveOffDelaySpinBox_valueChanged(double value);
 
     // Tests tab slots
     void on_testsMasterDirectionComboBox_currentIndexChanged(int index);
@@ -208,6 +211,9 @@ private:
     QSet<QWidget*> changedWidgets_; // Set of widgets that have been changed
     bool initialLoadComplete_{false}; // Flag to prevent events during initial load
 
+    // Capabilities reported by glue controllers, by communication port
+    std::unordered_map<std::string, ArduinoProtocol::Capabilities> controllerCaps_;
+
 };
 
 #endif // SETTINGSWINDOW_H
@@ -0,0 +1,131 @@
+#ifndef EDGEJOURNAL_H
+#define EDGEJOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Long-term journal of every digital IO edge, for post-mortem analysis.
+//
+// The polling thread hands record() the IO word (bit = pin) of every poll; a
+// change is pushed to a lock-free single-producer ring, so the poll never
+// waits on disk. A background writer turns word changes into per-channel
+// edges and writes them in blocks: per channel, the edge times as varint
+// deltas in microseconds (2-3 bytes per edge at typical rates). Each block
+// starts with the full word, so states are known without earlier blocks.
+//
+// Files are time partitioned: edges-<startMs>.dat holds the blocks and
+// edges-<startMs>.idx one fixed entry per block (time range and offset), so
+// reading a window is a binary search plus the blocks it covers.
+// channels.txt names the bits.
+class EdgeJournal {
+public:
+    struct Options {
+        std::string directory{"edges"};
+        int partitionHours{1};          // one file pair per this many hours
+        int retentionDays{30};          // older files are deleted (0 = keep all)
+        std::size_t blockEdges{4096};   // a block is written at this many edges...
+        int flushSeconds{5};            // ...or when its first edge is this old
+        std::size_t queueSamples{65536}; // word changes buffered between the poll and the writer
+    };
+
+    struct Edge {
+        std::int64_t timeUs;  // wall clock, us since epoch
+        std::uint8_t channel; // bit = pin
+        std::uint8_t state;   // level after the edge
+    };
+
+    explicit EdgeJournal(Options options);
+    ~EdgeJournal();
+
+    EdgeJournal(const EdgeJournal&) = delete;
+    EdgeJournal& operator=(const EdgeJournal&) = delete;
+
+    // Create the directory, write the channel names (name per bit) and start the writer
+    bool start(const std::vector<std::string>& channels);
+    // Write out everything queued and stop the writer
+    void stop();
+
+    // Polling thread only. steadyNs is steady_clock time; cheap when the word is unchanged.
+    void record(std::int64_t steadyNs, std::uint32_t word) {
+        if (word == lastWord_ && primed_) return;
+        lastWord_ = word;
+        primed_ = true;
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= ring_.size()) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring_[head & mask_] = Sample{steadyNs, word};
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    std::uint64_t edgeCount() const { return edges_.load(); }
+    std::uint64_t bytesWritten() const { return bytes_.load(); }
+    std::uint64_t droppedCount() const { return dropped_.load(); }
+
+    // Edges with fromUs <= time < toUs from a journal directory, ordered by time.
+    // 'initialWord' (optional) gets the word at fromUs. Safe while a writer runs.
+    static bool read(const std::string& directory, std::int64_t fromUs, std::int64_t toUs,
+                     std::vector<Edge>& edges, std::uint32_t* initialWord = nullptr);
+    // Channel names (name per bit) of a journal directory
+    static std::vector<std::string> readChannels(const std::string& directory);
+
+private:
+    struct Sample {
+        std::int64_t steadyNs;
+        std::uint32_t word;
+    };
+
+    void writerLoop();
+    void drain();
+    void addEdges(std::int64_t timeUs, std::uint32_t word);
+    void writeBlock();
+    bool openPartition(std::int64_t startMs);
+    void closePartition();
+    void applyRetention(std::int64_t nowMs);
+    std::int64_t partitionStart(std::int64_t timeMs) const;
+
+    Options options_;
+
+    // Producer side (polling thread)
+    std::uint32_t lastWord_{0};
+    bool primed_{false};
+
+    // Ring: head written by the producer, tail by the writer
+    std::vector<Sample> ring_;
+    std::uint64_t mask_{0};
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+
+    // Writer thread
+    std::thread writer_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    bool stopping_{false};
+
+    bool haveWord_{false};
+    std::uint32_t word_{0};                          // IO word after the last edge
+    std::uint32_t blockStartWord_{0};
+    std::int64_t blockFirstUs_{0};
+    std::int64_t blockLastUs_{0};
+    std::size_t blockCount_{0};
+    std::vector<std::vector<std::int64_t>> blockTimes_; // per channel
+    std::vector<std::uint8_t> buffer_;
+    std::int64_t partitionStartMs_{-1};
+    std::FILE* data_{nullptr};
+    std::FILE* index_{nullptr};
+    std::uint64_t dataSize_{0};
+    std::int64_t lastRetentionCheckMs_{0};
+
+    std::atomic<std::uint64_t> edges_{0};
+    std::atomic<std::uint64_t> bytes_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+#endif // EDGEJOURNAL_H
@@ -0,0 +1,110 @@
+#ifndef SCANHISTORY_H
+#define SCANHISTORY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "machine/MachineCore.h"
+
+// Production history of every scan, stored on disk as time-partitioned segments.
+//
+// Each segment is a directory of memory-mapped column files (time, port, cell,
+// verdict, payload id) plus a payload dictionary with an open-addressing hash
+// index. Rows with the same payload are chained newest-to-oldest, so a lookup is
+// one hash probe per segment plus one step per hit. Only the segment being
+// written and a few recently queried segments stay mapped.
+//
+// record() only queues; a background thread appends to the store so the logic
+// cycle never waits for disk.
+class ScanHistory {
+public:
+    struct Options {
+        std::string directory{"history"};
+        int partitionHours{24};         // one segment per this many hours
+        int retentionDays{90};          // older segments are deleted (0 = keep all)
+        std::size_t maxOpenSegments{4}; // mapped read-only segments kept for queries
+        std::size_t maxPending{100000}; // queued records beyond this are dropped
+    };
+
+    struct Hit {
+        std::int64_t timeMs{0};   // wall clock, ms since epoch
+        std::string commName;
+        int cell{0};
+        std::uint32_t verdict{0}; // ScanVerdict bits
+    };
+
+    struct Row : Hit {
+        std::string payload;
+    };
+
+    explicit ScanHistory(Options options);
+    ~ScanHistory();
+
+    ScanHistory(const ScanHistory&) = delete;
+    ScanHistory& operator=(const ScanHistory&) = delete;
+
+    // Create the store directory and start the writer thread
+    bool start();
+    // Write out queued records and stop the writer thread
+    void stop();
+
+    // Queue a scan, stamped with the current time. Never blocks on disk.
+    void record(const ScanRecord& scan);
+
+    // All rows whose payload equals 'payload', newest first (at most maxHits)
+    std::vector<Hit> findPayload(const std::string& payload, std::size_t maxHits = 1000);
+
+    // Rows with fromMs <= time < toMs, oldest first (at most maxRows). Works
+    // without start(), e.g. from a tool reading another process's store.
+    std::vector<Row> readRange(std::int64_t fromMs, std::int64_t toMs, std::size_t maxRows = 1000000);
+
+    std::uint64_t recordCount() const { return written_.load(); }
+    std::uint64_t droppedCount() const { return dropped_.load(); }
+
+private:
+    class Segment;
+
+    struct Pending {
+        std::int64_t timeMs;
+        ScanRecord scan;
+    };
+
+    void writerLoop();
+    void appendLocked(const Pending& p);
+    bool rotateLocked(std::int64_t partitionStartMs);
+    void applyRetentionLocked(std::int64_t nowMs);
+    std::uint16_t portIdLocked(const std::string& commName);
+    void loadPortsLocked();
+    std::vector<std::int64_t> listSegmentsLocked() const;
+    Segment* readSegmentLocked(std::int64_t startMs);
+    std::string segmentPath(std::int64_t startMs) const;
+    std::int64_t partitionStart(std::int64_t timeMs) const;
+
+    Options options_;
+
+    // Writer queue
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<Pending> queue_;
+    bool stopping_{false};
+    std::thread writer_;
+
+    // Store state (writer thread and queries)
+    std::mutex storeMutex_;
+    std::unique_ptr<Segment> current_;
+    std::list<std::unique_ptr<Segment>> readCache_; // most recently used first
+    std::vector<std::string> ports_;
+    std::int64_t lastRetentionCheckMs_{0};
+
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+#endif // SCANHISTORY_H
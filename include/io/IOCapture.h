@@ -0,0 +1,150 @@
+#ifndef IOCAPTURE_H
+#define IOCAPTURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Logic-analyzer style capture of the raw IO word, fed by the polling thread.
+//
+// Every poll hands record() a timestamp and a 24-bit word (one bit per pin).
+// While armed, each sample is stored in a preallocated power-of-two ring and
+// compared with the trigger; after the trigger, 'post' more samples are kept
+// and the capture stops. The ring keeps up to 'pre' samples before the
+// trigger. When idle, record() only checks two flags. Arm, trigger and collect
+// are called from one other thread (the logic thread); they never block the
+// recorder.
+class IOCapture {
+public:
+    enum class Trigger { Edge, Pattern, Software };
+    enum class Edge { Rising, Falling, Any };
+    enum class State { Idle, Armed, Triggered, Done };
+
+    struct Sample {
+        std::int64_t timeNs;
+        std::uint32_t word;
+    };
+
+    struct Settings {
+        Trigger trigger{Trigger::Software};
+        int bit{0};                    // Edge: pin number
+        Edge edge{Edge::Rising};
+        std::uint32_t mask{0};         // Pattern: fires when (word & mask) becomes value
+        std::uint32_t value{0};
+        std::size_t pre{1000};         // samples kept before the trigger
+        std::size_t post{10000};       // samples recorded after it
+    };
+
+    // Captured window, reduced to the samples where the word changed
+    struct Result {
+        std::vector<std::string> channels;   // name per bit, empty if the pin is unused
+        std::vector<Sample> transitions;     // first sample, then every change
+        std::int64_t startNs{0};
+        std::int64_t endNs{0};
+        std::int64_t triggerNs{0};
+        std::uint64_t samples{0};
+        double meanIntervalUs{0};
+        double maxIntervalUs{0};
+        std::string trigger;                 // description, e.g. "rising Sensor1"
+        bool truncated{false};               // transitions were cut to fit a message
+    };
+
+    // 'capacity' is rounded up to a power of two; memory is 16 bytes per sample
+    explicit IOCapture(std::size_t capacity = 262144);
+
+    IOCapture(const IOCapture&) = delete;
+    IOCapture& operator=(const IOCapture&) = delete;
+
+    // Called by the polling thread for every sample. Returns true on the
+    // sample that completes a capture, which is then ready to collect().
+    bool record(std::int64_t timeNs, std::uint32_t word) {
+        if (commandPending_.load(std::memory_order_acquire)) applyCommands(word);
+        if (phase_ == State::Idle || phase_ == State::Done) return false;
+        ring_[head_ & mask_] = Sample{timeNs, word};
+        ++head_;
+        const std::uint32_t previous = previous_;
+        previous_ = word;
+        if (phase_ == State::Armed) {
+            if (!softwareTrigger_ && !matches(previous, word)) return false;
+            triggerIndex_ = head_ - 1;
+            remaining_ = settings_.post;
+            setPhase(State::Triggered);
+            if (remaining_ != 0) return false;
+        } else if (--remaining_ != 0) {
+            return false;
+        }
+        setPhase(State::Done);
+        return true;
+    }
+
+    // Start waiting for the trigger; a running capture is discarded
+    void arm(const Settings& settings);
+    // Fire the trigger now (any trigger type) if armed
+    void trigger();
+    void disarm();
+
+    State state() const { return state_.load(std::memory_order_acquire); }
+    std::size_t capacity() const { return ring_.size(); }
+
+    // Copy out a finished capture; false if none is Done. 'channels' names the bits.
+    bool collect(Result& result, const std::vector<std::string>& channels, std::size_t maxTransitions = 20000) const;
+
+    // Settings from the GUI's JSON: {"trigger":"edge|pattern|software","channel":name,
+    // "edge":"rising|falling|any","pattern":{name:0|1},"pre":n,"post":n}.
+    // Channel names are resolved with 'channels' (name per bit).
+    static bool parseSettings(const nlohmann::json& json, const std::vector<std::string>& channels,
+                              Settings& settings, std::string& error);
+    static std::string describe(const Settings& settings, const std::vector<std::string>& channels);
+
+    // For the engine -> GUI message
+    static nlohmann::json encodeResult(const Result& result);
+    static Result decodeResult(const nlohmann::json& json);
+
+    static const char* stateName(State state);
+
+private:
+    // Bits of pendingCommands_
+    enum Command : int { CommandArm = 1, CommandFire = 2, CommandStop = 4 };
+
+    bool matches(std::uint32_t previous, std::uint32_t word) const {
+        if (settings_.trigger == Trigger::Pattern) {
+            return (word & settings_.mask) == settings_.value && (previous & settings_.mask) != settings_.value;
+        }
+        if (settings_.trigger != Trigger::Edge) return false;
+        const std::uint32_t bit = std::uint32_t(1) << settings_.bit;
+        if (!((previous ^ word) & bit)) return false;
+        if (settings_.edge == Edge::Any) return true;
+        return ((word & bit) != 0) == (settings_.edge == Edge::Rising);
+    }
+    void setPhase(State phase) {
+        phase_ = phase;
+        state_.store(phase, std::memory_order_release);
+    }
+    void applyCommands(std::uint32_t word);
+
+    // Recorder thread only
+    std::vector<Sample> ring_;
+    std::uint64_t mask_{0};
+    std::uint64_t head_{0};           // samples written since the last arm
+    std::uint64_t triggerIndex_{0};
+    std::size_t remaining_{0};
+    std::uint32_t previous_{0};
+    bool softwareTrigger_{false};
+    State phase_{State::Idle};
+    Settings settings_;
+
+    // Shared
+    std::atomic<bool> commandPending_{false};
+    std::atomic<State> state_{State::Idle};
+    std::atomic<std::uint64_t> generation_{0}; // bumped on every arm; collect() fails if it moves
+    mutable std::mutex pendingMutex_;  // taken by the recorder only while applying commands
+    int pendingCommands_{0};
+    Settings pending_;
+    Settings active_;                  // settings of the last capture, for collect()
+};
+
+#endif // IOCAPTURE_H
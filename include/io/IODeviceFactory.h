@@ -0,0 +1,11 @@
+#pragma once
+
+#include <memory>
+#include "Config.h"
+#include "Event.h"
+#include "EventQueue.h"
+#include "io/IOInterface.h"
+
+// IO backend named by io.device: "PCI7248" (local card) or "ModbusTCP" (remote IO, io.modbus).
+// Unknown names fall back to the PCI7248 with an error in the log.
+std::unique_ptr<IOInterface> createIODevice(EventQueue<EventVariant>& eventQueue, const Config& config);
@@ -3,13 +3,17 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "IOChannel.h"  // Defines the IOChannel structure
+#include "io/IOCapture.h"
+#include "stats/LatencyHistogram.h"
 
 // Define a type for IO state (can be adapted as needed)
 typedef int IOState;
 
 
 // Abstract interface for IO modules reflecting the new design.
+// The backend is chosen by io.device (see createIODevice in io/IODeviceFactory.h).
 class IOInterface {
 public:
     virtual ~IOInterface() {}
@@ -17,15 +21,31 @@ public:
     // Initialize hardware and configuration.
     virtual bool initialize() = 0;
 
+    // Signal the polling to stop before shutdown.
+    virtual void stopPolling() = 0;
+
     // Write outputs: accepts a unordered_map of updated output channels.
     // Any output not provided in the unordered_map is driven low.
     virtual bool writeOutputs(const std::unordered_map<std::string, IOChannel>& newOutputsState) = 0;
 
+    // Drive every configured output low.
+    virtual bool resetConfiguredOutputPorts() = 0;
+
     // Retrieve a snapshot of the current input channels.
     virtual std::unordered_map<std::string, IOChannel> getInputChannelsSnapshot() const = 0;
 
     //retreve a pointer to the output channels
     virtual const std::unordered_map<std::string, IOChannel>& getOutputChannels() const = 0;
+
+    // Time between input polls (us); safe to snapshot from any thread.
+    virtual const LatencyHistogram& getPollIntervalHistogram() const = 0;
+    // Remote IO only: duration of a full input scan and of one request round trip (us)
+    virtual const LatencyHistogram* getScanTimeHistogram() const { return nullptr; }
+    virtual const LatencyHistogram* getRoundTripHistogram() const { return nullptr; }
+
+    // Logic-analyzer capture of the polled word and the channel name per bit
+    virtual IOCapture& capture() = 0;
+    virtual std::vector<std::string> captureChannels() const = 0;
 };
 
 #endif // IO_INTERFACE_H
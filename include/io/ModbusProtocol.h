@@ -0,0 +1,133 @@
+#ifndef MODBUSPROTOCOL_H
+#define MODBUSPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Modbus/TCP framing (MBAP header + PDU), shared by the remote IO client, the
+// embedded server and the tools so every end agrees on the wire format.
+//   ADU = transaction(2) protocol 0(2) length(2) unit(1) | function(1) body
+// All 16-bit fields are big-endian; bit tables are packed LSB first.
+namespace Modbus {
+
+enum Function : std::uint8_t {
+    ReadCoils = 1,
+    ReadDiscreteInputs = 2,
+    ReadHoldingRegisters = 3,
+    ReadInputRegisters = 4,
+    WriteSingleCoil = 5,
+    WriteSingleRegister = 6,
+    WriteMultipleCoils = 15,
+    WriteMultipleRegisters = 16,
+};
+
+enum Exception : std::uint8_t {
+    IllegalFunction = 1,
+    IllegalDataAddress = 2,
+    IllegalDataValue = 3,
+    ServerDeviceFailure = 4,
+};
+
+constexpr std::size_t kHeaderBytes = 7;     // MBAP header including the unit id
+constexpr std::size_t kMaxFrameBytes = 260; // largest ADU
+constexpr std::uint16_t kMaxReadBits = 2000;
+constexpr std::uint16_t kMaxWriteBits = 1968;
+constexpr std::uint16_t kMaxReadRegisters = 125;
+constexpr std::uint16_t kMaxWriteRegisters = 123;
+
+inline void put16(std::string& out, std::uint16_t value) {
+    out += static_cast<char>(value >> 8);
+    out += static_cast<char>(value & 0xFF);
+}
+
+inline std::uint16_t get16(const unsigned char* p) {
+    return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline bool getBit(const unsigned char* packed, std::size_t index) {
+    return (packed[index / 8] >> (index % 8)) & 1u;
+}
+
+// Packs 0/1 values, LSB first
+inline std::string packBits(const std::vector<std::uint8_t>& bits, std::size_t first, std::size_t count) {
+    std::string packed((count + 7) / 8, '\0');
+    for (std::size_t i = 0; i < count; ++i) {
+        if (bits[first + i]) packed[i / 8] = static_cast<char>(packed[i / 8] | (1u << (i % 8)));
+    }
+    return packed;
+}
+
+// Appends one ADU; 'body' is the PDU after the function code
+inline void appendFrame(std::string& out, std::uint16_t transaction, std::uint8_t unit, std::uint8_t function,
+                        const std::string& body) {
+    put16(out, transaction);
+    put16(out, 0);
+    put16(out, static_cast<std::uint16_t>(body.size() + 2));
+    out += static_cast<char>(unit);
+    out += static_cast<char>(function);
+    out += body;
+}
+
+// Body of a read request (functions 1-4)
+inline std::string readBody(std::uint16_t start, std::uint16_t count) {
+    std::string body;
+    put16(body, start);
+    put16(body, count);
+    return body;
+}
+
+// Body of a Write Multiple Coils request for bits[first, first + count)
+inline std::string writeCoilsBody(std::uint16_t start, const std::vector<std::uint8_t>& bits, std::size_t first,
+                                  std::uint16_t count) {
+    std::string body;
+    put16(body, start);
+    put16(body, count);
+    const std::string packed = packBits(bits, first, count);
+    body += static_cast<char>(packed.size());
+    body += packed;
+    return body;
+}
+
+inline std::string exceptionBody(std::uint8_t code) { return std::string(1, static_cast<char>(code)); }
+
+struct Frame {
+    std::uint16_t transaction{0};
+    std::uint8_t unit{0};
+    std::uint8_t function{0};     // bit 7 set = exception response
+    const unsigned char* body{nullptr};
+    std::size_t bodySize{0};
+};
+
+// Parses the ADU at the start of 'data'. Returns its size, 0 if more bytes are
+// needed, or -1 if the stream is not Modbus/TCP (the connection should be dropped).
+inline long parseFrame(const char* data, std::size_t size, Frame& frame) {
+    if (size < kHeaderBytes + 1) return 0;
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    const std::uint16_t protocol = get16(p + 2);
+    const std::uint16_t length = get16(p + 4);
+    if (protocol != 0 || length < 2 || length + 6u > kMaxFrameBytes) return -1;
+    const std::size_t total = 6u + length;
+    if (size < total) return 0;
+    frame.transaction = get16(p);
+    frame.unit = p[6];
+    frame.function = p[7];
+    frame.body = p + 8;
+    frame.bodySize = total - 8;
+    return static_cast<long>(total);
+}
+
+inline const char* exceptionName(std::uint8_t code) {
+    switch (code) {
+    case IllegalFunction: return "illegal function";
+    case IllegalDataAddress: return "illegal data address";
+    case IllegalDataValue: return "illegal data value";
+    case ServerDeviceFailure: return "server device failure";
+    default: return "exception";
+    }
+}
+
+} // namespace Modbus
+
+#endif // MODBUSPROTOCOL_H
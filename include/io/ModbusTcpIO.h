@@ -0,0 +1,159 @@
+#pragma once
+
+#include "utils/SocketCompat.h" // must precede headers that include windows.h
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Config.h"
+#include "Event.h"
+#include "EventQueue.h"
+#include "IOChannel.h"
+#include "IOInterface.h"
+#include "history/EdgeJournal.h"
+#include "io/IOCapture.h"
+#include "stats/LatencyHistogram.h"
+
+// Remote digital IO over Modbus/TCP (io.device = "ModbusTCP", settings in io.modbus).
+//
+// The channel 'pin' is the Modbus address: inputs are discrete inputs (or coils,
+// io.modbus.inputTable), outputs are coils. Every scanMs the IO thread reads all
+// inputs with as few PDUs as possible (sorted addresses merged into ranges of up
+// to 2000 bits while gaps stay below maxGap) and pipelines them with up to
+// maxOutstanding transactions in flight, matched by transaction id. A finished
+// scan detects edges and pushes an IOEvent like PCI7248IO. Output writes are
+// queued to the IO thread and sent as Write Multiple Coils per contiguous run
+// of mapped coils (gaps are never written). A lost connection is retried every
+// reconnectMs; outputs are rewritten after reconnecting.
+class ModbusTcpIO : public IOInterface {
+public:
+    struct Options {
+        std::string host{"127.0.0.1"};
+        int port{502};
+        int unitId{1};
+        int scanMs{10};                        // input scan period
+        int timeoutMs{1000};                   // a request older than this drops the connection
+        int reconnectMs{2000};
+        int maxOutstanding{4};                 // pipelined requests in flight
+        int maxGap{32};                        // unmapped bits read rather than starting a new PDU
+        std::string inputTable{"discreteInputs"}; // or "coils"
+    };
+
+    ModbusTcpIO(EventQueue<EventVariant>& eventQueue, const Config& config);
+    ~ModbusTcpIO() override;
+
+    ModbusTcpIO(const ModbusTcpIO&) = delete;
+    ModbusTcpIO& operator=(const ModbusTcpIO&) = delete;
+
+    bool initialize() override;
+    void stopPolling() override;
+    bool writeOutputs(const std::unordered_map<std::string, IOChannel>& newOutputsState) override;
+    bool resetConfiguredOutputPorts() override;
+    std::unordered_map<std::string, IOChannel> getInputChannelsSnapshot() const override;
+    const std::unordered_map<std::string, IOChannel>& getOutputChannels() const override;
+
+    const LatencyHistogram& getPollIntervalHistogram() const override { return scanInterval_; }
+    const LatencyHistogram* getScanTimeHistogram() const override { return &scanTime_; }
+    const LatencyHistogram* getRoundTripHistogram() const override { return &roundTrip_; }
+
+    // Capture bits: inputs by address, then outputs by address (first 32 channels)
+    IOCapture& capture() override { return capture_; }
+    std::vector<std::string> captureChannels() const override;
+
+    bool isConnected() const { return connected_.load(); }
+
+private:
+    struct Range {
+        std::uint16_t start;
+        std::uint16_t count;
+    };
+    struct Mapped {
+        std::string name;
+        std::uint16_t address;
+        std::size_t range;  // index into the read or write ranges
+    };
+    struct Request {
+        bool write;
+        std::size_t range;
+    };
+    struct Pending {
+        std::uint16_t transaction;
+        Request request;
+        std::int64_t sentNs;
+    };
+
+    static std::vector<Range> buildRanges(std::vector<Mapped>& channels, int maxGap, std::uint16_t maxBits);
+
+    void ioLoop();
+    bool connectSocket();
+    void disconnect(const std::string& reason);
+    void queueOutputs();
+    void sendRequests(std::int64_t nowNs);
+    bool flushSend();
+    bool receive(std::int64_t nowNs);
+    void handleFrame(const char* data, std::size_t size, std::int64_t nowNs);
+    void finishScan(std::int64_t nowNs);
+    void pushStateEvent();
+    void logStats(std::int64_t nowNs);
+
+    EventQueue<EventVariant>& eventQueue_;
+    const Config& config_;
+    Options options_;
+
+    std::unordered_map<std::string, IOChannel> inputChannels_;
+    std::unordered_map<std::string, IOChannel> outputChannels_;
+    mutable std::mutex inputMutex_;
+
+    // Address maps, fixed after initialize()
+    std::vector<Mapped> inputs_;   // sorted by address
+    std::vector<Mapped> outputs_;  // sorted by address
+    std::vector<Range> readRanges_;
+    std::vector<Range> writeRanges_;
+    std::vector<std::vector<std::uint8_t>> readBits_; // per read range, 0/1 per address
+
+    // Outputs requested by writeOutputs(), sent by the IO thread
+    std::mutex outputMutex_;
+    std::vector<std::uint8_t> desiredCoils_; // per outputs_ entry
+    std::atomic<bool> outputsDirty_{false};
+    std::atomic<std::uint32_t> outputWord_{0};
+
+    // IO thread
+    SocketRuntime runtime_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> scanning_{true};  // cleared by stopPolling(); outputs are still written
+    std::atomic<bool> connected_{false};
+    std::atomic<int> writesPending_{0}; // queued or in flight, for the flush on shutdown
+    bool connectFailureLogged_{false};
+    socket_t socket_{kInvalidSocket};
+    std::string receiveBuffer_;
+    std::string sendBuffer_;
+    std::vector<Request> queue_;       // not yet sent
+    std::vector<Pending> pending_;     // sent, waiting for the response
+    std::uint16_t nextTransaction_{1};
+    std::size_t scanRemaining_{0};     // read responses missing for the current scan
+    std::int64_t scanStartNs_{0};
+    std::int64_t lastScanStartNs_{0};
+    bool primed_{false};               // first scan done (no edges from it)
+    std::uint32_t inputWord_{0};
+
+    // Statistics
+    LatencyHistogram scanInterval_;
+    LatencyHistogram scanTime_;
+    LatencyHistogram roundTrip_;
+    std::atomic<std::uint64_t> scans_{0};
+    std::atomic<std::uint64_t> overruns_{0};   // scan due while the previous one was still running
+    std::atomic<std::uint64_t> exceptions_{0};
+    std::atomic<std::uint64_t> reconnects_{0};
+    std::int64_t statsStartNs_{0};
+    LatencyHistogram::Snapshot statsScanTime_;
+    LatencyHistogram::Snapshot statsRoundTrip_;
+
+    IOCapture capture_;
+    std::unique_ptr<EdgeJournal> journal_;
+};
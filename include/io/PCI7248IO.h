@@ -10,7 +10,12 @@
 #include "Config.h"      // Provides full definition for Config.
 #include "Event.h"       // Provides full definitions for EventVariant and (if defined there) IOEventType.
 #include "IOChannel.h"   // Provides full definition for IOChannel and possibly IOEventType if not in Event.h.
+#include "IOInterface.h" // Common interface of the IO backends
 #include "EventQueue.h"  // Provides full definition for EventQueue.
+#include "stats/LatencyHistogram.h" // Poll interval distribution for metrics
+#include "io/IOCapture.h"              // Logic-analyzer capture of the raw port words
+#include "history/EdgeJournal.h"       // Long-term journal of every IO edge
+#include <memory>
 
 // Forward declaration for the event queue template (Good practice)
 template <typename T>
@@ -23,39 +28,49 @@ class EventQueue;
 // Define DASK types if not universally available or for clarity
 // typedef short I16; // Example if I16 is used for card_
 
-class PCI7248IO {
+class PCI7248IO : public IOInterface {
 public:
     // --- Constructor & Destructor ---
     PCI7248IO(EventQueue<EventVariant>& eventQueue, const Config& config);
-    ~PCI7248IO();
+    ~PCI7248IO() override;
 
     // --- Public Interface ---
 
     // Initialize the card, configure ports, and start the polling timer.
     // Returns true on success, false otherwise.
-    bool initialize();
+    bool initialize() override;
 
     // Signal the polling mechanism to stop processing and prepare for shutdown.
     // Actual resource release happens in the destructor.
-    void stopPolling();
+    void stopPolling() override;
 
     // Write the desired state to configured output channels.
     // The map should contain entries for channels intended to be ON.
     // Channels configured as output but not in the map (or with state 0) will be turned OFF.
     // Returns true on success, false if any hardware write fails.
     // This operation is thread-safe.
-    bool writeOutputs(const std::unordered_map<std::string, IOChannel>& newOutputsState);
+    bool writeOutputs(const std::unordered_map<std::string, IOChannel>& newOutputsState) override;
 
     // Reset all configured output ports to their OFF state.
     // Returns true on success, false otherwise.
     // This operation is thread-safe.
-    bool resetConfiguredOutputPorts();
+    bool resetConfiguredOutputPorts() override;
 
     // Get a thread-safe snapshot (copy) of the current input channel states.
-    std::unordered_map<std::string, IOChannel> getInputChannelsSnapshot() const;
+    std::unordered_map<std::string, IOChannel> getInputChannelsSnapshot() const override;
 
     // Get read-only access to the map defining the configured output channels.
-    const std::unordered_map<std::string, IOChannel>& getOutputChannels() const;
+    const std::unordered_map<std::string, IOChannel>& getOutputChannels() const override;
+
+    // Distribution of the time between polling iterations (jitter), in microseconds.
+    // Recorded by the polling thread; safe to snapshot from any thread.
+    const LatencyHistogram& getPollIntervalHistogram() const override { return pollInterval_; }
+
+    // Capture of every polled sample (inputs and last written outputs, bit = pin).
+    // A finished capture is announced with GuiEvent{"IOCapture", "collect"}.
+    IOCapture& capture() override { return capture_; }
+    // Channel name per capture bit, empty for unused pins
+    std::vector<std::string> captureChannels() const override;
 
     // --- Deleted Functions ---
     // Prevent copying and assignment as this class manages unique hardware resources
@@ -114,4 +129,11 @@ private:
     int iterationCount;
     int delaysOver5ms;
     const std::chrono::seconds statsInterval{10};
+    LatencyHistogram pollInterval_;
+
+    // Capture
+    std::uint32_t inputWord_{0};                // input pins of the last poll (polling thread)
+    std::atomic<std::uint32_t> outputWord_{0};  // output pins as last written
+    IOCapture capture_;
+    std::unique_ptr<EdgeJournal> journal_;      // edgeJournal.enabled; started by initialize()
 };
\ No newline at end of file
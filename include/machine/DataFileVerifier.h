@@ -0,0 +1,70 @@
+#ifndef DATAFILEVERIFIER_H
+#define DATAFILEVERIFIER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Pre-flight check of a job data file, run when the file is selected.
+//
+// The file is memory mapped and cut into line-aligned chunks that all cores
+// read in parallel: the key slice of each line (tests.fileStartIndex /
+// fileLength) is checked for length and format, consecutive keys for the
+// sequence, and every key is hashed into one of several partitions. Chunk
+// edges are stitched afterwards, then each partition is sorted on its own
+// thread to find duplicates. About 16 bytes of memory per line.
+class DataFileVerifier {
+public:
+    enum class Sequence { None, Ascending, Descending };
+
+    struct Options {
+        int startIndex{0};
+        int length{0};                  // 0 = to end of line
+        bool numeric{false};            // keys must be digits
+        Sequence sequence{Sequence::None};
+        unsigned threads{0};            // 0 = all cores
+        std::size_t maxExamples{10};    // kept per kind of issue
+    };
+
+    struct Issue {
+        enum class Kind { ShortLine, Malformed, Duplicate, SequenceBreak };
+        Kind kind;
+        std::uint64_t line; // 1-based
+        std::string text;
+    };
+
+    struct Report {
+        bool opened{false};
+        bool cancelled{false};
+        std::uint64_t bytes{0};
+        std::uint64_t lines{0};          // non-empty lines
+        std::uint64_t shortLines{0};     // no key at the slice, or shorter than fileLength
+        std::uint64_t malformed{0};      // control bytes, or not a number where one is needed
+        std::uint64_t duplicates{0};     // repeats beyond the first occurrence
+        std::uint64_t sequenceBreaks{0};
+        std::size_t minKeyLength{0};
+        std::size_t maxKeyLength{0};
+        double seconds{0};
+        std::vector<Issue> examples;     // sorted by line
+
+        bool ok() const {
+            return opened && !cancelled && shortLines == 0 && malformed == 0 && duplicates == 0 && sequenceBreaks == 0;
+        }
+        // One line for the message area
+        std::string summary() const;
+    };
+
+    // phase is "Reading" or "Duplicates"; fraction of that phase in [0, 1]
+    using Progress = std::function<void(const char* phase, double fraction)>;
+
+    // Blocks until done; progress is called on the calling thread about every 50 ms
+    static Report verify(const std::string& path, const Options& options, const Progress& progress = {},
+                         const std::atomic<bool>* cancel = nullptr);
+
+    static const char* kindName(Issue::Kind kind);
+};
+
+#endif // DATAFILEVERIFIER_H
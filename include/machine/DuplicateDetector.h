@@ -0,0 +1,85 @@
+#ifndef DUPLICATEDETECTOR_H
+#define DUPLICATEDETECTOR_H
+
+#include <cstdint>
+#include <string>
+#include "utils/MappedFile.h"
+
+// Detects a code that was already scanned earlier in the job, across restarts.
+//
+// A cuckoo filter (4 slots of 16-bit fingerprints per bucket) answers "new"
+// for almost every scan with two bucket reads. A filter hit is confirmed
+// against an append-only key log: log records are chained per group of 8
+// buckets, newest first, and carry the full 64-bit hash, so confirming walks
+// about 30 records and compares key bytes only on a hash match. Filter and
+// log are memory-mapped files, so the state survives restarts and only the
+// pages in use stay in RAM. Memory is fixed by the capacity: about 2.6 bytes
+// of filter per expected code (1 GB for 400 million).
+//
+// When the filter cannot place another fingerprint it is full: scans are still
+// checked against everything stored, but new codes are no longer recorded.
+class DuplicateDetector {
+public:
+    struct Options {
+        std::string directory{"duplicates"};
+        std::uint64_t capacity{20000000}; // expected codes per job
+        int startIndex{0};                // key slice, as tests.fileStartIndex/fileLength
+        int length{0};                    // 0 = to end of the scan
+    };
+
+    enum class Result {
+        New,       // first time; recorded
+        Duplicate, // scanned before (confirmed exactly)
+        NoKey,     // the scan is shorter than startIndex
+        Full,      // not seen before, but the filter is full so it was not recorded
+    };
+
+    DuplicateDetector() = default;
+    ~DuplicateDetector();
+
+    DuplicateDetector(const DuplicateDetector&) = delete;
+    DuplicateDetector& operator=(const DuplicateDetector&) = delete;
+
+    // Open the stored state in options.directory, or create it
+    bool open(const Options& options);
+    void close();
+    bool isOpen() const { return filter_.isOpen(); }
+
+    // Test a scan and record its key if it is new
+    Result checkAndInsert(const std::string& scan);
+    // Same for a key taken from the scan by the caller (options slice ignored)
+    Result checkAndInsertKey(const std::string& key);
+
+    // Forget every code (new job)
+    bool clear();
+
+    // Write mapped pages back to disk
+    bool flush();
+
+    std::uint64_t count() const;
+    bool isFull() const;
+    const Options& options() const { return options_; }
+
+private:
+    struct FilterHeader;
+    struct LogHeader;
+
+    bool openFiles(std::uint64_t bucketCount);
+    FilterHeader* filterHeader();
+    const FilterHeader* filterHeader() const;
+    std::uint16_t* buckets();
+    std::uint64_t* chainHeads();
+    LogHeader* logHeader();
+
+    bool containsFingerprint(std::uint16_t fingerprint, std::uint64_t i1, std::uint64_t i2);
+    bool confirm(const std::string& key, std::uint64_t hash, std::uint64_t group);
+    bool appendKey(const std::string& key, std::uint64_t hash, std::uint64_t group);
+    bool insertFingerprint(std::uint16_t fingerprint, std::uint64_t i1, std::uint64_t i2);
+
+    Options options_;
+    MappedFile filter_;
+    MappedFile log_;
+    std::uint64_t bucketMask_{0};
+};
+
+#endif // DUPLICATEDETECTOR_H
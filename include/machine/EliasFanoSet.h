@@ -0,0 +1,47 @@
+#ifndef ELIASFANOSET_H
+#define ELIASFANOSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sorted set of 64-bit numbers in Elias-Fano form: each value keeps its low
+// bits verbatim (about log2(universe / count) of them) in a packed array and
+// its high bits as a unary-coded bit vector, about 2 bits per value. With a
+// select-zero sample every 256 buckets, a lookup jumps to the value's bucket
+// and compares the few low parts in it.
+//
+// 50M random 13-digit serials take about 2.5 bytes each.
+class EliasFanoSet {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // 'values' must be sorted ascending without duplicates
+    void build(const std::vector<std::uint64_t>& values);
+
+    // Rank of the value (its index in the sorted input), npos if absent
+    std::size_t find(std::uint64_t value) const;
+    bool contains(std::uint64_t value) const { return find(value) != npos; }
+
+    // First 'count' values, decoded in order
+    std::vector<std::uint64_t> head(std::size_t count) const;
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    std::size_t memoryBytes() const;
+
+private:
+    std::uint64_t lowPart(std::size_t rank) const;
+    bool highBit(std::size_t position) const { return (high_[position / 64] >> (position % 64)) & 1u; }
+    // Position in high_ of the zero with this rank (0-based)
+    std::size_t selectZero(std::size_t rank) const;
+
+    std::size_t count_{0};
+    std::uint64_t last_{0};
+    unsigned lowWidth_{0};
+    std::vector<std::uint64_t> low_;          // lowWidth_ bits per value, packed
+    std::vector<std::uint64_t> high_;         // value i sets bit (value >> lowWidth_) + i
+    std::vector<std::uint64_t> zeroSamples_;  // position of every kZeroSample-th zero of high_
+};
+
+#endif // ELIASFANOSET_H
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// PLC function blocks (IEC 61131-3 style) evaluated inside the logic cycle.
+//
+// Blocks are created once (setup) and addressed by the returned ID; each holds a
+// fixed-size state in one flat array, so thousands of them cost a few bytes each
+// and no threads. Evaluate every block once per cycle with the cycle's monotonic
+// time (CycleInputs::nowUs). Timers do not fire by themselves: a running timer
+// keeps a deadline and nextDeadlineUs() returns the earliest one, which the core
+// hands to Logic (CycleEffects::wakeupAtUs) so a cycle runs when it expires.
+//
+//   TON  on-delay:  Q rises preset after IN rises, falls with IN
+//   TOF  off-delay: Q rises with IN, falls preset after IN falls
+//   TP   pulse:     a rising IN starts a Q pulse of exactly preset
+//   R_TRIG/F_TRIG:  Q for one evaluation on a rising/falling CLK
+//   CTU/CTD:        count rising inputs up/down; Q at >= preset / <= 0
+//   SR/RS:          set- and reset-dominant flip-flops
+class FunctionBlocks {
+public:
+  using Id = std::uint32_t;
+  static constexpr std::int64_t kNoDeadline = std::numeric_limits<std::int64_t>::max();
+
+  enum class Kind : std::uint8_t { Ton, Tof, Tp, RTrig, FTrig, Ctu, Ctd, Sr, Rs };
+
+  // Setup. 'name' is optional and only used by find().
+  Id addTon(std::int64_t presetUs, const std::string& name = std::string());
+  Id addTof(std::int64_t presetUs, const std::string& name = std::string());
+  Id addTp(std::int64_t presetUs, const std::string& name = std::string());
+  Id addRTrig(const std::string& name = std::string());
+  Id addFTrig(const std::string& name = std::string());
+  Id addCtu(std::int32_t preset, const std::string& name = std::string());
+  Id addCtd(std::int32_t preset, const std::string& name = std::string());
+  Id addSr(const std::string& name = std::string());
+  Id addRs(const std::string& name = std::string());
+  std::optional<Id> find(const std::string& name) const;
+
+  // Evaluation; each returns Q. An ID of another kind (or unknown) returns false.
+  bool ton(Id id, bool in, std::int64_t nowUs);
+  bool tof(Id id, bool in, std::int64_t nowUs);
+  bool tp(Id id, bool in, std::int64_t nowUs);
+  bool rTrig(Id id, bool clk);
+  bool fTrig(Id id, bool clk);
+  bool ctu(Id id, bool cu, bool reset);
+  bool ctd(Id id, bool cd, bool load);
+  bool sr(Id id, bool set, bool reset);
+  bool rs(Id id, bool set, bool reset);
+
+  // Outputs of the last evaluation
+  bool q(Id id) const { return id < blocks_.size() && blocks_[id].q; }
+  std::int32_t count(Id id) const { return id < blocks_.size() ? blocks_[id].count : 0; }
+  // Elapsed time of a timer (ET), clamped to its preset
+  std::int64_t elapsedUs(Id id, std::int64_t nowUs) const;
+
+  // Earliest deadline of all running timers, kNoDeadline if none
+  std::int64_t nextDeadlineUs() const;
+
+  void setPreset(Id id, std::int64_t preset);
+  // Every block back to its initial state (presets kept)
+  void resetAll();
+  std::size_t size() const { return blocks_.size(); }
+
+private:
+  struct Block {
+    std::int64_t preset{0};  // us for timers, count for counters
+    std::int64_t startUs{0}; // timers: when timing started
+    std::int32_t count{0};   // counters; TP keeps its previous IN here
+    Kind kind{Kind::Ton};
+    bool q{false};
+    bool last{false};        // previous input (edges) or "timing" (TOF/TP)
+  };
+
+  Id add(Kind kind, std::int64_t preset, const std::string& name);
+  Block* get(Id id, Kind kind) { return id < blocks_.size() && blocks_[id].kind == kind ? &blocks_[id] : nullptr; }
+
+  std::vector<Block> blocks_;
+  std::vector<std::int64_t> deadlines_; // per block, kNoDeadline when not timing
+  std::unordered_map<std::string, Id> names_;
+};
@@ -5,15 +5,25 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
+#include <memory>
 #include <cstddef>
+#include <cstdint>
 #include "io/IOChannel.h"
+#include "machine/ScanValidator.h"
+#include "machine/PayloadPattern.h"
 #include "json.hpp"
 
+class DuplicateDetector;
+class ReferenceIndex;
+class SequenceScheduler;
+
 struct CommCellMessage {
   std::string commName;
   int offset{0};
   std::string raw;
   std::optional<nlohmann::json> parsed; // present if JSON parsing succeeded
+  std::optional<ScanValidation> validation; // present if the port has format checks (tests.validators)
+  std::optional<PatternMatch> format;       // present if the port has a format pattern (communication.<port>.format)
 };
 
 struct TimerEdge {
@@ -34,12 +44,16 @@ struct CycleInputs {
   std::unordered_map<std::string, TimerSnapshot> timersSnapshot; // snapshot of timers
   std::optional<CommCellMessage> newCommMsg; // message received this cycle (if any)
   bool blinkLed0{false};                                  // example machine flag
+  std::int64_t nowUs{0}; // monotonic cycle time (steady_clock, us), fixed for the whole cycle
 };
 
 struct TimerCmd {
-  enum Type { Start, Stop } type{Start};
+  // Start: one shot after the duration. StartPeriodic: every duration on absolute
+  // deadlines until Stop. StartAt: one shot at atMs (wall clock, ms since epoch).
+  enum Type { Start, Stop, StartPeriodic, StartAt } type{Start};
   std::string name;
   std::optional<int> durationMs; // if empty, reuse existing timer duration
+  std::optional<std::int64_t> atMs; // StartAt only
 };
 
 struct CommSend {
@@ -52,6 +66,45 @@ struct CalibrationResult {
   std::string commName;
 };
 
+// Format fields the tests read instead of their startIndex/length slices (tests.*Field).
+// Patterns are owned by Logic and stay valid until the next setTestFields call.
+struct TestFields {
+  const PayloadPattern* master{nullptr}; // format of the master port
+  const PayloadPattern* reader{nullptr}; // format of the match reader port
+  int sequence{-1};    // field index in 'master'; -1 = use the slice
+  int matchMaster{-1};
+  int matchReader{-1}; // field index in 'reader'
+  int inFile{-1};
+  int duplicate{-1};
+};
+
+// Verdict flags recorded with each scan in the production history
+enum ScanVerdict : std::uint32_t {
+  ScanSequenceChecked = 1u << 0,
+  ScanSequenceFailed  = 1u << 1,
+  ScanInFileChecked   = 1u << 2,
+  ScanInFileFailed    = 1u << 3,
+  ScanMatchChecked    = 1u << 4,
+  ScanMatchFailed     = 1u << 5,
+  ScanDuplicateChecked = 1u << 6,
+  ScanDuplicateFailed  = 1u << 7,
+  ScanFormatChecked    = 1u << 8,
+  ScanFormatFailed     = 1u << 9,
+};
+
+// Any test failed => the product is a reject
+constexpr std::uint32_t kScanFailedMask = ScanSequenceFailed | ScanInFileFailed | ScanMatchFailed | ScanDuplicateFailed |
+                                         ScanFormatFailed;
+
+// One message stored into a machine cell this cycle
+struct ScanRecord {
+  std::string commName;
+  int cell{0};
+  std::string payload;
+  std::uint32_t verdict{0}; // ScanVerdict bits
+  bool fromMasterReader{false}; // one master scan per product
+};
+
 struct CycleEffects {
   std::vector<std::pair<std::string,int>> outputChanges; // name -> state
   std::vector<TimerCmd> timerCmds;
@@ -59,6 +112,11 @@ struct CycleEffects {
   // Set to true if the machine core modified its barcode/message store in this cycle
   bool barcodeStoreChanged{false};
   std::optional<CalibrationResult> calibration;
+  // Scans stored this cycle (appended to the production history by Logic)
+  std::vector<ScanRecord> scans;
+  // Run a cycle at this steady time (us) even if no event arrives, e.g. the
+  // earliest FunctionBlocks deadline. Logic keeps a single wakeup for it.
+  std::optional<std::int64_t> wakeupAtUs;
 };
 
 class MachineCore {
@@ -69,6 +127,10 @@ public:
   virtual void setBlinkLed(bool) {}
 
   // Tests (optional hooks; default no-ops)
+  // Communication port whose messages the master tests apply to
+  virtual void setMasterReader(const std::string&) {}
+  // Communication port compared against the master by the match test
+  virtual void setMatchReader(const std::string&) {}
   // Configure master sequence check options
   virtual void setMasterSequenceEnabled(bool) {}
   virtual void setMasterSequenceConfig(int /*startIndex*/, int /*length*/, const std::string& /*direction*/) {}
@@ -86,10 +148,22 @@ public:
   // Master-in-File check (optional hooks; default no-ops)
   virtual void setMasterInFileCheckEnabled(bool) {}
   virtual void setMasterInFileExtraction(int /*startIndex*/, int /*length*/) {}
-  virtual void setMasterFileReferenceSet(const std::unordered_set<std::string>& /*set*/) {}
+  // Reference data of the check; shared so a reload can swap it in while the old one drains (nullptr = none)
+  virtual void setMasterFileReference(std::shared_ptr<const ReferenceIndex> /*index*/) {}
+  // Reference entries scanned are tracked per job; with seenOnce an entry passes only the first time
+  virtual void setMasterInFileSeenOnce(bool) {}
+  virtual void resetMasterInFileSeen() {}
+  // {entries seen, reference entries}
+  virtual std::pair<std::size_t, std::size_t> getMasterInFileProgress() const { return {0, 0}; }
   // Applies in-file test to a text message based on current extraction settings
   virtual bool testMasterInFile(const std::string& /*text*/) { return true; }
 
+  // Duplicate check on master scans; the detector is owned by the caller (nullptr = off)
+  virtual void setDuplicateDetector(DuplicateDetector*) {}
+
+  // Format fields replacing the tests' slices (default: slices only)
+  virtual void setTestFields(const TestFields&) {}
+
   // Barcode grid support (optional; default no-ops)
   // Configure the maximum number of machine cells (rows) maintained per channel
   virtual void setStoreCapacity(std::size_t) {}
@@ -97,4 +171,6 @@ public:
   virtual std::size_t getStoreCapacity() const { return 0; }
   // Snapshot of per-port message storage; vectors should be sized to capacity
   virtual std::unordered_map<std::string, std::vector<std::string>> getBarcodeStoreSnapshot() const { return {}; }
+  // Coroutine sequences run by the core (nullptr if it has none); logic thread only
+  virtual const SequenceScheduler* getSequences() const { return nullptr; }
 };
@@ -0,0 +1,71 @@
+#ifndef PAYLOADPATTERN_H
+#define PAYLOADPATTERN_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Result of matching a payload; field spans are byte offsets into the payload
+struct PatternMatch {
+    static constexpr int kMaxFields = 8;
+    bool matched{false};
+    std::array<std::uint32_t, kMaxFields> begin{};
+    std::array<std::uint32_t, kMaxFields> end{};
+
+    // Text of a field; false when the payload did not match
+    bool field(int index, std::string_view payload, std::string_view& out) const;
+};
+
+// Code format of a communication port (communication.<port>.format), e.g.
+//
+//     'AB' {serial: d10} {lot: L2}
+//
+// Items, separated by spaces or commas, must cover the whole payload in order:
+//   'text'        literal (\' and \\ escape)
+//   d L l A a x p digit, upper, lower, letter, alphanumeric, hex, printable
+//   .             any byte
+//   [A-F0-9_]     byte set, [^...] negated
+// A class may be followed by a count: 10, 2-4, ?, * or +.
+//   {name: ...}   named field, used by tests instead of startIndex/length
+//
+// The pattern is compiled once into a DFA over byte classes, so matching is
+// one table lookup per byte with no allocation. A byte's field is a property
+// of the DFA state it leads to; patterns where that is not unique (a variable
+// count next to a field boundary with overlapping classes, like "d1-4
+// {x: d2}") are rejected when compiled.
+class PayloadPattern {
+public:
+    bool compile(const std::string& pattern, std::string* error = nullptr);
+
+    // Validate and extract fields in one pass
+    PatternMatch match(std::string_view payload) const;
+    // Validate only
+    bool matches(std::string_view payload) const;
+
+    // Index of a named field, -1 if the pattern has none by that name
+    int fieldIndex(const std::string& name) const;
+
+    bool empty() const { return transitions_.empty(); }
+    const std::string& source() const { return source_; }
+    std::size_t stateCount() const { return stateCount_; }
+
+    static constexpr std::size_t kMaxStates = 4096;
+
+private:
+    static constexpr std::uint8_t kNoField = PatternMatch::kMaxFields;
+
+    std::array<std::uint8_t, 256> byteClass_{};
+    std::uint32_t classCount_{0};
+    // Row of a state = state * classCount_; transitions_[row + class] is the next row.
+    // State 0 is dead, state 1 the start.
+    std::vector<std::uint32_t> transitions_;
+    std::vector<std::uint8_t> accepting_;  // at [row]
+    std::vector<std::uint8_t> stateField_; // at [row]: field of the byte that entered the state, kNoField if none
+    std::size_t stateCount_{0};
+    std::vector<std::string> fieldNames_;
+    std::string source_;
+};
+
+#endif // PAYLOADPATTERN_H
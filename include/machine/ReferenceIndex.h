@@ -0,0 +1,110 @@
+#ifndef REFERENCEINDEX_H
+#define REFERENCEINDEX_H
+
+#include "machine/EliasFanoSet.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Master-in-file reference data merged from one or more data files.
+//
+// Keys are stored sorted and de-duplicated back to back in one byte array
+// with 32-bit offsets, plus a sparse table holding the first 8 bytes of every
+// 32nd key and a small top table over that. A lookup searches the top table
+// (cache resident), one 256-byte window of the sparse table, and then the single
+// block of keys it points to, which is prefetched as a whole. About key length
+// + 4.5 bytes per entry, against roughly 80 for a hash set of strings.
+//
+// Modes (tests.fileMatch):
+//   exact  - the scan key is a line of a file
+//   prefix - some line of a file is a prefix of the scan key
+//   range  - lines are numbers or "low-high" ranges; the scan key is a number
+//            inside one of them (overlapping ranges are merged)
+//   numeric - key slices are numbers (leading zeros ignored, other lines
+//            skipped), kept in an EliasFanoSet at 2-3 bytes per entry
+// Exact data whose keys are all digits of one length (up to 19) is stored
+// the numeric way too, since that is lossless.
+// Each file is read and sorted on its own thread, then the files are merged.
+//
+// Every entry has an index (find), so callers can track which were seen.
+class ReferenceIndex {
+public:
+    enum class Mode { Exact, Prefix, Range, Numeric };
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    struct Options {
+        Mode mode{Mode::Exact};
+        int startIndex{0}; // key slice of each line (exact/prefix); range lines are read whole
+        int length{0};     // 0 = to end of line
+    };
+
+    struct FileReport {
+        std::string path;
+        bool ok{false};
+        std::size_t lines{0};
+        std::size_t entries{0}; // keys or ranges taken from the file
+        std::size_t skipped{0}; // lines without a usable key
+    };
+
+    struct MemoryReport {
+        std::size_t entries{0};
+        std::size_t keyBytes{0};
+        std::size_t offsetBytes{0};
+        std::size_t sparseBytes{0};
+        std::size_t rangeBytes{0};
+        std::size_t numericBytes{0};
+        std::size_t total() const { return keyBytes + offsetBytes + sparseBytes + rangeBytes + numericBytes; }
+    };
+
+    static bool parseMode(const std::string& text, Mode& mode);
+    static const char* modeName(Mode mode);
+
+    // Replace the contents with the merged files; false (index left empty) if any file cannot be read
+    bool load(const std::vector<std::string>& paths, const Options& options, std::vector<FileReport>* reports = nullptr);
+
+    // Look up a scan key according to the mode
+    bool contains(std::string_view key) const { return find(key) != npos; }
+    // Index (below size()) of the entry matching the key, npos if none
+    std::size_t find(std::string_view key) const;
+
+    Mode mode() const { return mode_; }
+    // Keys held as numbers (numeric mode, or all-digit exact data)
+    bool numeric() const { return numeric_; }
+    std::size_t size() const { return mode_ == Mode::Range ? ranges_.size() : numeric_ ? numbers_.size() : keyCount(); }
+    bool empty() const { return size() == 0; }
+    MemoryReport memory() const;
+
+    // First entries, for the log
+    std::string sample(std::size_t count) const;
+
+private:
+    std::size_t keyCount() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+    std::string_view key(std::size_t i) const {
+        return std::string_view(keys_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+    std::size_t lowerBound(std::string_view key) const;
+    std::size_t findExact(std::string_view key) const;
+    std::size_t findPrefixOf(std::string_view key) const;
+    std::size_t findRange(std::uint64_t value) const;
+    std::size_t findNumber(std::string_view key) const;
+
+    Mode mode_{Mode::Exact};
+    bool numeric_{false};
+    std::size_t numericLength_{0};             // digits of every key for exact data, 0 = any (numeric mode)
+    EliasFanoSet numbers_;
+    std::string keys_;                         // sorted keys back to back
+    std::vector<std::uint32_t> offsets_;       // key i is [offsets_[i], offsets_[i + 1])
+    struct Block {
+        std::uint64_t prefix;  // first 8 bytes (big-endian) of the block's first key
+        std::uint32_t keyByte; // where the block's keys start in keys_
+    };
+    std::vector<Block> sparse_;                // one per kStride keys, plus an end marker
+    std::vector<std::uint64_t> top_;           // prefix of every kTopStride-th block
+    std::vector<std::size_t> lengths_;         // distinct key lengths, for prefix lookups
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges_; // sorted, merged [low, high]
+};
+
+#endif // REFERENCEINDEX_H
@@ -0,0 +1,78 @@
+#ifndef SCANVALIDATOR_H
+#define SCANVALIDATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json.hpp"
+
+// Symbology checks a scan can fail, one bit per rule type
+enum ValidationCheck : std::uint32_t {
+    ValidateLength  = 1u << 0, // slice length within [min, max]
+    ValidateCharset = 1u << 1, // every byte in the allowed set
+    ValidateMod10   = 1u << 2, // GS1 mod-10 check digit (EAN/UPC/GTIN/SSCC)
+    ValidateLuhn    = 1u << 3, // Luhn check digit
+    ValidateGs1     = 1u << 4, // GS1 element string: known AIs, lengths, check digits
+};
+
+// Structured result of one port's checks, passed to the core with the scan
+struct ScanValidation {
+    std::uint32_t checked{0}; // ValidationCheck bits of the rules that ran
+    std::uint32_t failed{0};  // ValidationCheck bits of the rules that failed
+    int failedRule{-1};       // index of the first failing rule in the port's list
+    bool passed() const { return failed == 0; }
+};
+
+// Format checks for the scans of one communication port (tests.validators).
+//
+// Rules are compiled once into a flat chain: each step gets its tables
+// precomputed and a function chosen for its kind, so validating a scan is a
+// walk over a few steps without allocation. The charset step tests 16 bytes
+// at a time with SSE2 when the set is a handful of byte ranges, check digits
+// are summed from lookup tables without data-dependent branches, and GS1
+// application identifiers are resolved through a prefix-indexed table.
+//
+// Rule objects: {"type": "length", "min": 13, "max": 13}, {"type": "charset",
+// "chars": "digits" | "alphanumeric" | "gs1" | "0-9A-F"}, {"type": "mod10"},
+// {"type": "luhn"}, {"type": "gs1"}. Each may add "startIndex"/"length"
+// (0 = to end) to check a slice of the scan.
+class ScanValidator {
+public:
+    // Build the chain from a JSON array of rules; false with a reason if a rule is invalid
+    bool compile(const nlohmann::json& rules, std::string* error = nullptr);
+
+    ScanValidation validate(std::string_view scan) const;
+
+    bool empty() const { return steps_.empty(); }
+
+    struct Gs1Element {
+        std::string_view ai;
+        std::string_view data;
+    };
+    // Parse a GS1 element string (optional "]C1"-style symbology prefix, GS as FNC1).
+    // Elements are appended to 'elements' when given.
+    static bool parseGs1(std::string_view text, std::vector<Gs1Element>* elements = nullptr);
+
+    static constexpr int kMaxSimdRanges = 6;
+
+    struct Step {
+        bool (*run)(const Step& step, std::string_view slice){nullptr};
+        ValidationCheck check{ValidateLength};
+        std::size_t start{0};
+        std::size_t length{0}; // 0 = to end
+        std::size_t minLength{0};
+        std::size_t maxLength{0};
+        std::array<std::uint64_t, 4> charset{}; // bit per byte value
+        int rangeCount{0};                      // ranges of the charset; > kMaxSimdRanges = bitmap only
+        std::array<std::uint8_t, kMaxSimdRanges> rangeLow{};
+        std::array<std::uint8_t, kMaxSimdRanges> rangeSpan{}; // high - low
+    };
+
+private:
+    std::vector<Step> steps_;
+};
+
+#endif // SCANVALIDATOR_H
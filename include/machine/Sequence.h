@@ -0,0 +1,198 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#include "machine/MachineCore.h"
+
+// Sequential machine programs written as C++20 coroutines, run by the machine
+// core inside the logic cycle (no threads).
+//
+//   Sequence feeder(SequenceScheduler& s) {
+//     for (;;) {
+//       co_await s.rising("i8");
+//       s.setOutput("o3", 1);
+//       const bool ready = co_await s.rising("i9", 2000000); // false after 2 s
+//       s.setOutput("o3", 0);
+//       if (!ready) continue;
+//       s.send("communication1", "T");
+//       if (auto scan = co_await s.scan("communication1", 500000)) { ... scan->verdict ... }
+//     }
+//   }
+//   scheduler.spawn("feeder", feeder(scheduler));
+//
+// SequenceScheduler::run() is called once per step(): every sequence whose wait
+// is satisfied by this cycle (edge, message, scan, deadline) resumes once and
+// runs to its next co_await, so one edge is never seen twice. Deadlines feed
+// wakeupAtUs(), which the core returns as CycleEffects::wakeupAtUs.
+// Coroutine frames come from a per-thread pool of fixed size classes; once the
+// pool has grown to the working set, starting a sequence does no heap allocation.
+
+// Free lists of coroutine frames by size class. Used only by the thread that
+// runs the sequences (the logic thread).
+class SequenceFramePool {
+public:
+  static constexpr std::size_t kClasses = 6;   // 128 B .. 4 KiB
+  static constexpr std::size_t kChunkFrames = 16;
+
+  static void* allocate(std::size_t bytes);
+  static void release(void* frame, std::size_t bytes);
+
+  struct Stats {
+    std::size_t pooledBytes{0};     // reserved by the pool
+    std::size_t framesInUse{0};
+    std::uint64_t heapFallbacks{0}; // frames larger than the biggest class
+  };
+  static Stats stats();
+};
+
+class Sequence {
+public:
+  enum class WaitKind : std::uint8_t { Start, Rising, Falling, Message, Scan, Delay };
+
+  struct promise_type {
+    WaitKind wait{WaitKind::Start};
+    std::string channel;   // input or communication port ("" = any port)
+    std::int64_t deadlineUs{std::numeric_limits<std::int64_t>::max()};
+    std::int64_t timeoutUs{-1};  // relative, turned into deadlineUs when the wait starts
+    bool timedOut{false};
+    std::optional<CommCellMessage> message;
+    std::optional<ScanRecord> scan;
+    std::exception_ptr error;
+
+    Sequence get_return_object() { return Sequence(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { error = std::current_exception(); }
+
+    static void* operator new(std::size_t bytes) { return SequenceFramePool::allocate(bytes); }
+    static void operator delete(void* frame, std::size_t bytes) { SequenceFramePool::release(frame, bytes); }
+  };
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Sequence() = default;
+  explicit Sequence(Handle handle) : handle_(handle) {}
+  Sequence(Sequence&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+  Sequence& operator=(Sequence&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = other.handle_;
+      other.handle_ = nullptr;
+    }
+    return *this;
+  }
+  Sequence(const Sequence&) = delete;
+  Sequence& operator=(const Sequence&) = delete;
+  ~Sequence() {
+    if (handle_) handle_.destroy();
+  }
+
+  Handle handle() const { return handle_; }
+
+private:
+  Handle handle_{};
+};
+
+class SequenceScheduler {
+public:
+  // Awaitables. A timeout (us, < 0 = none) ends the wait with false / nullopt.
+  struct Wait {
+    Sequence::WaitKind kind;
+    std::string channel;
+    std::int64_t timeoutUs;
+    Sequence::promise_type* promise{nullptr}; // set when the sequence suspends
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Sequence::Handle handle) {
+      auto& p = handle.promise();
+      p.wait = kind;
+      p.channel = channel;
+      p.timeoutUs = timeoutUs;
+      p.timedOut = false;
+      p.message.reset();
+      p.scan.reset();
+      promise = &p;
+    }
+  };
+  struct EdgeWait : Wait {
+    bool await_resume() const { return !promise->timedOut; }
+  };
+  struct DelayWait : Wait {
+    void await_resume() const {}
+  };
+  struct MessageWait : Wait {
+    std::optional<CommCellMessage> await_resume() { return std::move(promise->message); }
+  };
+  struct ScanWait : Wait {
+    std::optional<ScanRecord> await_resume() { return std::move(promise->scan); }
+  };
+
+  EdgeWait rising(const std::string& input, std::int64_t timeoutUs = -1) {
+    return {{Sequence::WaitKind::Rising, input, timeoutUs, nullptr}};
+  }
+  EdgeWait falling(const std::string& input, std::int64_t timeoutUs = -1) {
+    return {{Sequence::WaitKind::Falling, input, timeoutUs, nullptr}};
+  }
+  // Resumes in the first cycle at or after now + us (0 = next cycle)
+  DelayWait delay(std::int64_t us) { return {{Sequence::WaitKind::Delay, std::string(), us < 0 ? 0 : us, nullptr}}; }
+  // Next message received on a port ("" = any)
+  MessageWait message(const std::string& commName = std::string(), std::int64_t timeoutUs = -1) {
+    return {{Sequence::WaitKind::Message, commName, timeoutUs, nullptr}};
+  }
+  // Next scan stored from a port ("" = any), with its test verdict
+  ScanWait scan(const std::string& commName = std::string(), std::int64_t timeoutUs = -1) {
+    return {{Sequence::WaitKind::Scan, commName, timeoutUs, nullptr}};
+  }
+
+  // Actions, valid while a sequence runs; applied with the cycle's other effects
+  void setOutput(const std::string& name, int state);
+  void send(const std::string& commName, const std::string& data);
+  // Cycle time of the running resume
+  std::int64_t nowUs() const { return in_ ? in_->nowUs : 0; }
+  // Input level in the current cycle (0 if unknown)
+  int input(const std::string& name) const;
+
+  // Add a sequence; it starts in the next run()
+  void spawn(const std::string& name, Sequence sequence);
+  // Drop a sequence by name (destroys its frame); false if not found
+  bool cancel(const std::string& name);
+  void cancelAll();
+
+  // Resume every ready sequence once; call at the end of step()
+  void run(const CycleInputs& in, CycleEffects& fx);
+  // Earliest deadline of a waiting sequence, nullopt if none
+  std::optional<std::int64_t> wakeupAtUs() const;
+
+  struct Stats {
+    std::size_t live{0};
+    std::uint64_t resumes{0};
+    std::uint64_t finished{0};
+    std::uint64_t failed{0};            // ended by an exception
+    std::uint64_t resumeNsTotal{0};
+    std::uint64_t resumeNsMax{0};
+    std::string lastError;
+  };
+  Stats stats() const;
+  // "name (wait channel), ..." for the state report
+  std::string describe() const;
+
+private:
+  struct Entry {
+    std::string name;
+    Sequence sequence;
+    bool cancelled{false}; // finished or cancelled; removed at the end of run()
+  };
+
+  bool ready(Sequence::promise_type& p, const CycleInputs& in, const CycleEffects& fx) const;
+
+  std::vector<Entry> entries_;
+  const CycleInputs* in_{nullptr};
+  CycleEffects* fx_{nullptr};
+  Stats stats_;
+};
@@ -0,0 +1,62 @@
+#ifndef IPCCHANNEL_H
+#define IPCCHANNEL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "shm/SpscByteRing.h"
+
+// Message channel between the engine process and an attached GUI process.
+//
+// One shared memory segment holds two SPSC rings (commands GUI -> engine,
+// events engine -> GUI) and a small header with the engine heartbeat and the
+// pid of the attached GUI. Each direction has a named wake-up signal so the
+// receiver sleeps instead of polling. send() never blocks: when the other side
+// stops reading, messages are dropped rather than stalling the sender.
+//
+// The engine creates the channel; a GUI opens it and claims it (only one GUI
+// may be attached because each ring has a single producer).
+class IpcChannel {
+public:
+    enum class Role { Engine, Gui };
+
+    static constexpr const char* kDefaultName = "MachineControllerIpc";
+    static constexpr std::uint64_t kRingBytes = 1u << 20;
+
+    IpcChannel(Role role, std::string name = kDefaultName);
+    ~IpcChannel();
+
+    IpcChannel(const IpcChannel&) = delete;
+    IpcChannel& operator=(const IpcChannel&) = delete;
+
+    // Engine: create (or take over) the segment. GUI: open it and claim it.
+    bool open();
+    void close();
+    bool isOpen() const { return segment_ != nullptr; }
+
+    // To the other side; false if its ring is full
+    bool send(const std::string& message);
+    // Next message from the other side, waiting up to timeoutMs
+    bool receive(std::string& message, int timeoutMs);
+
+    // Engine: refresh the heartbeat the GUI watches
+    void heartbeat();
+    // GUI: engine wall clock of its last heartbeat, and a value that changes when an engine restarts
+    std::int64_t engineHeartbeatMs() const;
+    std::int64_t engineStartMs() const;
+
+private:
+    struct Segment;
+    struct Platform;
+
+    std::string objectName(const char* suffix) const;
+
+    Role role_;
+    std::string name_;
+    std::unique_ptr<Platform> platform_;
+    Segment* segment_{nullptr};
+    SpscByteRing outbox_;
+    SpscByteRing inbox_;
+};
+
+#endif // IPCCHANNEL_H
@@ -0,0 +1,76 @@
+#ifndef SHAREDSTATEWRITER_H
+#define SHAREDSTATEWRITER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "io/IOChannel.h"
+#include "machine/MachineCore.h"
+#include "stats/ProductionStats.h"
+#include "shm/mc_state.h"
+
+// Producer of the shared state segment described in shm/mc_state.h.
+//
+// Owned and called by the logic thread only. publish() rewrites the parts of
+// the segment it is given inside one seqlock update; it never blocks and never
+// waits for readers. Channels, timers and ports get slots in name order; the
+// slot tables are only rewritten (and layoutVersion bumped) when the set of
+// names changes.
+class SharedStateWriter {
+public:
+    using ChannelMap = std::unordered_map<std::string, IOChannel>;
+    using TimerMap = std::unordered_map<std::string, TimerSnapshot>;
+    using BarcodeMap = std::unordered_map<std::string, std::vector<std::string>>;
+
+    // What one logic cycle publishes; null members keep their previous contents
+    struct Update {
+        const ChannelMap* inputs{nullptr};
+        const ChannelMap* outputs{nullptr};
+        const TimerMap* timers{nullptr};
+        const ProductionStats::Totals* counters{nullptr};
+        const BarcodeMap* barcodes{nullptr};
+    };
+
+    // Empty name = MC_STATE_DEFAULT_NAME
+    explicit SharedStateWriter(std::string name = {});
+    ~SharedStateWriter();
+
+    SharedStateWriter(const SharedStateWriter&) = delete;
+    SharedStateWriter& operator=(const SharedStateWriter&) = delete;
+
+    bool open();
+    void close();
+    bool isOpen() const { return segment_ != nullptr; }
+
+    void publish(const Update& update);
+
+    // True until the barcode grid has been published once
+    bool needsBarcodes() const { return !barcodesPublished_; }
+
+    const std::string& name() const { return name_; }
+
+private:
+    struct Mapping;
+
+    void beginWrite();
+    void endWrite();
+    bool writeChannels(const ChannelMap& channels, std::vector<std::string>& slots,
+                       char (*names)[MC_STATE_NAME_BYTES], std::uint32_t& count, std::uint64_t& word);
+    bool writeTimers(const TimerMap& timers);
+    bool writeBarcodes(const BarcodeMap& barcodes);
+
+    std::string name_;
+    std::unique_ptr<Mapping> mapping_;
+    mc_state_segment* segment_{nullptr};
+    std::uint64_t sequence_{0};
+
+    // Names in slot order (sorted)
+    std::vector<std::string> inputSlots_;
+    std::vector<std::string> outputSlots_;
+    std::vector<std::string> timerSlots_;
+    std::vector<std::string> portSlots_;
+    bool barcodesPublished_{false};
+};
+
+#endif // SHAREDSTATEWRITER_H
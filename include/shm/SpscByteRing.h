@@ -0,0 +1,106 @@
+#ifndef SPSCBYTERING_H
+#define SPSCBYTERING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Positions of a single-producer/single-consumer ring living in shared memory.
+// Both counters only grow (bytes ever written/consumed); each sits on its own
+// cache line so producer and consumer do not false-share.
+struct SpscRingHeader {
+    alignas(64) std::atomic<std::uint64_t> head; // consumer position
+    alignas(64) std::atomic<std::uint64_t> tail; // producer position
+    alignas(64) std::uint64_t capacity;          // data bytes, power of two
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ring positions must be lock-free across processes");
+
+// Variable-length records in a byte ring: [u32 length][payload], padded to 8
+// bytes. A record never wraps; when it does not fit before the end a skip
+// marker sends the consumer back to the start. Exactly one producer and one
+// consumer; neither ever blocks or takes a lock.
+class SpscByteRing {
+public:
+    static constexpr std::uint32_t kSkipMarker = 0xFFFFFFFFu;
+
+    SpscByteRing() = default;
+    SpscByteRing(SpscRingHeader* header, unsigned char* data) : header_(header), data_(data) {}
+
+    static void initialize(SpscRingHeader* header, std::uint64_t capacity) {
+        header->head.store(0, std::memory_order_relaxed);
+        header->tail.store(0, std::memory_order_relaxed);
+        header->capacity = capacity;
+    }
+
+    // Largest payload accepted by tryPush
+    std::uint64_t maxRecord() const { return header_->capacity / 2 - sizeof(std::uint32_t); }
+
+    // Producer: false when the ring is full or the record is too large
+    bool tryPush(const void* payload, std::size_t size) {
+        if (size > maxRecord()) return false;
+        const std::uint64_t capacity = header_->capacity;
+        const std::uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = header_->head.load(std::memory_order_acquire);
+        const std::uint64_t need = recordBytes(size);
+        const std::uint64_t offset = tail & (capacity - 1);
+        const std::uint64_t untilEnd = capacity - offset;
+        const std::uint64_t skip = need > untilEnd ? untilEnd : 0;
+        if (capacity - (tail - head) < skip + need) return false;
+
+        std::uint64_t at = tail;
+        if (skip) {
+            const std::uint32_t marker = kSkipMarker;
+            std::memcpy(data_ + offset, &marker, sizeof(marker));
+            at += skip;
+        }
+        const auto length = static_cast<std::uint32_t>(size);
+        unsigned char* record = data_ + (at & (capacity - 1));
+        std::memcpy(record, &length, sizeof(length));
+        std::memcpy(record + sizeof(length), payload, size);
+        header_->tail.store(at + need, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false when empty
+    bool tryPop(std::string& payload) {
+        const std::uint64_t capacity = header_->capacity;
+        std::uint64_t head = header_->head.load(std::memory_order_relaxed);
+        const std::uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        while (head != tail) {
+            const std::uint64_t offset = head & (capacity - 1);
+            std::uint32_t length = 0;
+            std::memcpy(&length, data_ + offset, sizeof(length));
+            if (length == kSkipMarker) {
+                head += capacity - offset;
+                continue;
+            }
+            if (length > maxRecord() || head + recordBytes(length) > tail) {
+                // Corrupt (e.g. producer restarted underneath us): drop everything queued
+                header_->head.store(tail, std::memory_order_release);
+                return false;
+            }
+            payload.assign(reinterpret_cast<const char*>(data_ + offset + sizeof(length)), length);
+            header_->head.store(head + recordBytes(length), std::memory_order_release);
+            return true;
+        }
+        header_->head.store(head, std::memory_order_release);
+        return false;
+    }
+
+    // Consumer: discard everything queued
+    void clear() { header_->head.store(header_->tail.load(std::memory_order_acquire), std::memory_order_release); }
+
+    bool empty() const {
+        return header_->head.load(std::memory_order_acquire) == header_->tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static std::uint64_t recordBytes(std::size_t size) { return (sizeof(std::uint32_t) + size + 7) & ~std::uint64_t(7); }
+
+    SpscRingHeader* header_{nullptr};
+    unsigned char* data_{nullptr};
+};
+
+#endif // SPSCBYTERING_H
@@ -0,0 +1,165 @@
+/*
+ * MachineController live state in shared memory (C interface for HMIs and loggers).
+ *
+ * The machine publishes one fixed-layout segment, named "Local\MachineControllerState"
+ * on Windows (CreateFileMapping) and "/MachineControllerState" elsewhere (shm_open).
+ * The logic thread rewrites it after every logic cycle under a sequence lock:
+ * 'sequence' is odd while an update is in progress and grows by two per update.
+ * Readers copy what they need and retry if the sequence changed meanwhile, so
+ * reading takes no lock and no system call and never slows the producer down.
+ *
+ * Use mc_state_open()/mc_state_read*() from mc_state_reader.c rather than
+ * touching the segment directly. Layout rules:
+ *  - major version changes when existing fields move or change meaning
+ *  - minor version changes when fields are appended (segmentSize grows)
+ * All integers are little-endian and naturally aligned; strings are
+ * NUL-terminated and truncated to their field size.
+ */
+#ifndef MC_STATE_H
+#define MC_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MC_STATE_MAGIC          0x5453434Du /* "MCST" */
+#define MC_STATE_VERSION_MAJOR  2
+#define MC_STATE_VERSION_MINOR  0
+
+#ifdef _WIN32
+#define MC_STATE_DEFAULT_NAME   "Local\\MachineControllerState"
+#else
+#define MC_STATE_DEFAULT_NAME   "/MachineControllerState"
+#endif
+
+#define MC_STATE_NAME_BYTES     32
+#define MC_STATE_MAX_CHANNELS   64  /* bit i of the IO words is channel slot i */
+#define MC_STATE_MAX_TIMERS     32
+#define MC_STATE_MAX_PORTS      8
+#define MC_STATE_MAX_CELLS      128
+#define MC_STATE_CELL_BYTES     64
+#define MC_STATE_MAX_TESTS      8   /* sequence, match, masterInFile, duplicate, format; rest spare */
+
+/* producerState */
+#define MC_STATE_PRODUCER_STOPPED 0u
+#define MC_STATE_PRODUCER_RUNNING 1u
+
+typedef struct mc_state_timer {
+    char name[MC_STATE_NAME_BYTES];
+    int32_t state;       /* 0 = inactive, 1 = active */
+    int32_t durationMs;
+} mc_state_timer;
+
+typedef struct mc_state_test_counters {
+    uint64_t passed;
+    uint64_t failed;
+} mc_state_test_counters;
+
+typedef struct mc_state_counters {
+    uint64_t cycles;
+    uint64_t scans;
+    uint64_t products;
+    uint64_t rejects;
+    mc_state_test_counters tests[MC_STATE_MAX_TESTS];
+} mc_state_counters;
+
+typedef struct mc_state_port {
+    char name[MC_STATE_NAME_BYTES]; /* communication port, e.g. "communication1" */
+    uint32_t cellCount;             /* valid rows in cells[port] */
+    uint32_t truncatedCells;        /* rows longer than MC_STATE_CELL_BYTES - 1 */
+} mc_state_port;
+
+typedef struct mc_state_segment {
+    /* Header: fixed for the life of the segment, except sequence and producerState */
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    uint32_t segmentSize;           /* sizeof(mc_state_segment) of the producer */
+    uint32_t producerState;
+    uint64_t sequence;              /* seqlock: odd while the producer writes */
+
+    /* Body: consistent only when read under the sequence lock */
+    uint64_t publishCount;
+    int64_t updatedMs;              /* producer wall clock, ms since the Unix epoch */
+    uint32_t layoutVersion;         /* bumped when any name table below changes */
+    uint32_t inputCount;
+    uint32_t outputCount;
+    uint32_t timerCount;
+    uint32_t portCount;
+    uint32_t reserved;
+    uint64_t inputWord;             /* bit i = state of inputNames[i] */
+    uint64_t outputWord;            /* bit i = state of outputNames[i] */
+    mc_state_counters counters;
+    char inputNames[MC_STATE_MAX_CHANNELS][MC_STATE_NAME_BYTES];
+    char outputNames[MC_STATE_MAX_CHANNELS][MC_STATE_NAME_BYTES];
+    mc_state_timer timers[MC_STATE_MAX_TIMERS];
+    mc_state_port ports[MC_STATE_MAX_PORTS];
+    char cells[MC_STATE_MAX_PORTS][MC_STATE_MAX_CELLS][MC_STATE_CELL_BYTES];
+} mc_state_segment;
+
+/* Reader API (mc_state_reader.c) */
+
+typedef struct mc_state_reader mc_state_reader;
+
+#define MC_STATE_OK            0
+#define MC_STATE_NOT_FOUND    -1  /* no producer has created the segment */
+#define MC_STATE_INCOMPATIBLE -2  /* wrong magic or major version */
+#define MC_STATE_BUSY         -3  /* producer kept writing during every retry */
+#define MC_STATE_INVALID      -4  /* bad arguments */
+
+/* Maps the segment read-only; name may be NULL for MC_STATE_DEFAULT_NAME. Returns NULL on failure. */
+mc_state_reader* mc_state_open(const char* name, int* error);
+void mc_state_close(mc_state_reader* reader);
+
+/* Current sequence number; compare with a previous value to skip reads when nothing changed */
+uint64_t mc_state_sequence(const mc_state_reader* reader);
+
+/* Consistent copy of 'size' bytes at 'offset' (use offsetof(mc_state_segment, ...)) */
+int mc_state_read_range(const mc_state_reader* reader, size_t offset, size_t size, void* out, uint64_t* sequence);
+
+/* Consistent copy of the whole segment */
+int mc_state_read(const mc_state_reader* reader, mc_state_segment* out);
+
+/* IO words only: the cheapest consistent read */
+int mc_state_read_io(const mc_state_reader* reader, uint64_t* inputWord, uint64_t* outputWord, uint64_t* sequence);
+
+/* Sequence lock primitives shared by the producer and the reader */
+#if defined(_MSC_VER)
+#if defined(_M_ARM64)
+#define MC_STATE_FENCE() __dmb(_ARM64_BARRIER_ISH)
+#else
+#define MC_STATE_FENCE() _ReadWriteBarrier() /* x86/x64: loads and stores are not reordered with each other */
+#endif
+static __inline uint64_t mc_state_load_sequence(const volatile uint64_t* p) {
+    uint64_t v = *p;
+    MC_STATE_FENCE();
+    return v;
+}
+static __inline void mc_state_store_sequence(volatile uint64_t* p, uint64_t v) {
+    MC_STATE_FENCE();
+    *p = v;
+}
+#define mc_state_acquire_fence() MC_STATE_FENCE()
+#define mc_state_release_fence() MC_STATE_FENCE()
+#else
+static inline uint64_t mc_state_load_sequence(const volatile uint64_t* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void mc_state_store_sequence(volatile uint64_t* p, uint64_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+#define mc_state_acquire_fence() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define mc_state_release_fence() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MC_STATE_H */
@@ -0,0 +1,108 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Log-bucketed histogram of durations in microseconds.
+// Values 0..3 have exact buckets; above that every power of two is split into four
+// buckets (<= 25% relative error) up to about 70 minutes. record() is one relaxed
+// atomic add per field, so any thread can record and any thread can snapshot.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kBuckets = 128;
+
+    struct Snapshot {
+        std::array<std::uint64_t, kBuckets> counts{};
+        std::uint64_t count{0};
+        std::uint64_t sumUs{0};
+        std::uint64_t maxUs{0};
+
+        // Upper bound (us) below which a fraction q (0..1) of the samples lie
+        std::uint64_t percentile(double q) const {
+            if (count == 0) return 0;
+            if (q < 0.0) q = 0.0;
+            if (q > 1.0) q = 1.0;
+            std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(count));
+            if (rank == 0) rank = 1;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < kBuckets; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    const std::uint64_t upper = bucketUpperBound(i);
+                    return upper < maxUs ? upper : maxUs;
+                }
+            }
+            return maxUs;
+        }
+
+        double meanUs() const { return count ? static_cast<double>(sumUs) / static_cast<double>(count) : 0.0; }
+
+        // Samples recorded after 'earlier' was taken (max is not subtractable and is kept)
+        Snapshot since(const Snapshot& earlier) const {
+            Snapshot d = *this;
+            for (std::size_t i = 0; i < kBuckets; ++i) d.counts[i] -= earlier.counts[i];
+            d.count -= earlier.count;
+            d.sumUs -= earlier.sumUs;
+            return d;
+        }
+    };
+
+    void record(std::uint64_t us) {
+        counts_[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sumUs_.fetch_add(us, std::memory_order_relaxed);
+        std::uint64_t prev = maxUs_.load(std::memory_order_relaxed);
+        while (us > prev && !maxUs_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (std::size_t i = 0; i < kBuckets; ++i) s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        s.count = count_.load(std::memory_order_relaxed);
+        s.sumUs = sumUs_.load(std::memory_order_relaxed);
+        s.maxUs = maxUs_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static std::size_t bucketIndex(std::uint64_t us) {
+        if (us < 4) return static_cast<std::size_t>(us);
+        const unsigned msb = highestBit(us);
+        const std::size_t sub = static_cast<std::size_t>((us >> (msb - 2)) & 3u);
+        const std::size_t index = (msb - 1) * 4 + sub;
+        return index < kBuckets ? index : kBuckets - 1;
+    }
+
+    // Exclusive upper bound of a bucket in microseconds
+    static std::uint64_t bucketUpperBound(std::size_t index) {
+        if (index < 4) return index + 1;
+        const unsigned msb = static_cast<unsigned>(index / 4 + 1);
+        const std::uint64_t sub = index % 4;
+        return (5 + sub) << (msb - 2);
+    }
+
+private:
+    static unsigned highestBit(std::uint64_t v) {
+#ifdef _MSC_VER
+        unsigned long idx = 0;
+        _BitScanReverse64(&idx, v);
+        return static_cast<unsigned>(idx);
+#else
+        return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#endif
+    }
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sumUs_{0};
+    std::atomic<std::uint64_t> maxUs_{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,49 @@
+#ifndef METRICSHTTPSERVER_H
+#define METRICSHTTPSERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include "stats/MetricsRegistry.h"
+
+// Tiny HTTP/1.0 server answering GET /metrics with the registry in Prometheus
+// text format. One thread serves one connection at a time; intended to be
+// bound to the loopback interface and scraped by a local agent.
+class MetricsHttpServer {
+public:
+    struct Options {
+        std::string bindAddress{"127.0.0.1"};
+        int port{9464};
+        std::size_t maxResponseBytes{256 * 1024};
+    };
+
+    MetricsHttpServer(const MetricsRegistry& registry, Options options);
+    ~MetricsHttpServer();
+
+    MetricsHttpServer(const MetricsHttpServer&) = delete;
+    MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+    bool start();
+    void stop();
+
+    // Port actually bound (useful with port 0)
+    int boundPort() const { return boundPort_; }
+
+private:
+    struct Listener;
+
+    void run();
+    void serveClient(std::intptr_t clientFd);
+
+    const MetricsRegistry& registry_;
+    Options options_;
+    std::unique_ptr<Listener> listener_;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+    int boundPort_{0};
+};
+
+#endif // METRICSHTTPSERVER_H
@@ -0,0 +1,103 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "stats/LatencyHistogram.h"
+
+// Appends Prometheus text exposition lines into a buffer of bounded size.
+// Once the limit would be exceeded nothing more is written and truncated() is set.
+class MetricsWriter {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    explicit MetricsWriter(std::size_t maxBytes);
+
+    void family(const std::string& name, const std::string& help, const char* type);
+    void sample(const std::string& name, const Labels& labels, double value);
+    void sample(const std::string& name, const Labels& labels, std::uint64_t value);
+    // Histogram of microsecond samples exposed in seconds, with power-of-two buckets
+    void histogram(const std::string& name, const Labels& labels, const LatencyHistogram::Snapshot& snapshot);
+
+    bool truncated() const { return truncated_; }
+    std::string take();
+
+private:
+    void line(const std::string& text);
+    static std::string formatLabels(const Labels& labels, const char* extraKey = nullptr, const std::string& extraValue = {});
+
+    std::string out_;
+    std::size_t maxBytes_;
+    bool truncated_{false};
+};
+
+// Named counters, gauges and histograms exposed by the metrics endpoint.
+//
+// Updating a metric is a relaxed atomic operation and never takes a lock. The
+// registry lock is only held to register a new series and while rendering, so
+// the logic thread only contends with a scrape when it creates a series.
+class MetricsRegistry {
+public:
+    using Labels = MetricsWriter::Labels;
+
+    class Counter {
+    public:
+        void inc(std::uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+        std::uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<std::uint64_t> value_{0};
+    };
+
+    class Gauge {
+    public:
+        void set(double v) { value_.store(v, std::memory_order_relaxed); }
+        double value() const { return value_.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<double> value_{0.0};
+    };
+
+    // Computes extra samples from snapshots at render time
+    using Collector = std::function<void(MetricsWriter&)>;
+
+    // Returns the existing series if name and labels were registered before
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    // The histogram is owned by the caller and must outlive the registry
+    void histogram(const std::string& name, const std::string& help, const LatencyHistogram& source, const Labels& labels = {});
+    void addCollector(Collector collector);
+
+    // Prometheus text format (version 0.0.4), at most maxBytes long
+    std::string render(std::size_t maxBytes) const;
+
+private:
+    enum class Kind { Counter, Gauge, Histogram };
+
+    struct Series {
+        Labels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        const LatencyHistogram* histogram{nullptr};
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::deque<Series> series;
+    };
+
+    Series& seriesFor(const std::string& name, const std::string& help, Kind kind, const Labels& labels);
+
+    mutable std::mutex mutex_;
+    std::deque<Family> families_;
+    std::vector<Collector> collectors_;
+};
+
+#endif // METRICSREGISTRY_H
@@ -0,0 +1,123 @@
+#ifndef PRODUCTIONSTATS_H
+#define PRODUCTIONSTATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "machine/MachineCore.h"
+#include "stats/LatencyHistogram.h"
+
+// Running production counters kept online by the logic thread.
+//
+// Updates are O(1) relaxed atomic adds; snapshot() can be called from any thread
+// without locking and without stopping the logic thread. Counters only grow, so a
+// report for any interval is the difference of two snapshots (see since()).
+class ProductionStats {
+public:
+    static constexpr std::size_t kMaxPorts = 16;
+    static constexpr std::size_t kTimeBuckets = 96; // ring of recent buckets (one day at 15 min)
+
+    enum Test { TestSequence = 0, TestMatch, TestInFile, TestDuplicate, TestFormat, kTestCount };
+    static const char* testName(std::size_t test);
+
+    struct PortSnapshot {
+        std::string name;
+        std::uint64_t scans{0};
+        std::uint64_t rejects{0};
+    };
+
+    struct TestSnapshot {
+        std::uint64_t passed{0};
+        std::uint64_t failed{0};
+    };
+
+    struct BucketSnapshot {
+        std::int64_t startMs{0};
+        std::uint64_t products{0};
+        std::uint64_t rejects{0};
+        std::uint64_t scans{0};
+    };
+
+    struct Snapshot {
+        std::int64_t takenMs{0};
+        std::int64_t bucketMs{0};
+        std::uint64_t cycles{0};
+        std::uint64_t scans{0};
+        std::uint64_t products{0};
+        std::uint64_t rejects{0};
+        std::vector<PortSnapshot> ports;
+        std::array<TestSnapshot, kTestCount> tests{};
+        LatencyHistogram::Snapshot cycleTime;       // logic cycle duration (us)
+        LatencyHistogram::Snapshot productInterval; // time between products (us)
+        std::vector<BucketSnapshot> buckets;        // oldest first
+
+        // Counters accumulated after 'earlier' was taken; buckets before it are dropped
+        Snapshot since(const Snapshot& earlier) const;
+    };
+
+    // Lifetime totals only: no allocation, cheap enough to take every cycle
+    struct Totals {
+        std::uint64_t cycles{0};
+        std::uint64_t scans{0};
+        std::uint64_t products{0};
+        std::uint64_t rejects{0};
+        std::array<TestSnapshot, kTestCount> tests{};
+    };
+
+    explicit ProductionStats(int bucketMinutes = 15);
+
+    // Writer side (logic thread)
+    void recordCycle(std::uint64_t durationUs);
+    void recordScan(const ScanRecord& scan, std::int64_t nowMs);
+
+    // Reader side (any thread)
+    Snapshot snapshot() const;
+    Totals totals() const;
+    std::int64_t bucketMs() const { return bucketMs_; }
+
+private:
+    struct PortCounters {
+        std::string name; // written once before the slot is published
+        std::atomic<std::uint64_t> scans{0};
+        std::atomic<std::uint64_t> rejects{0};
+    };
+
+    struct TestCounters {
+        std::atomic<std::uint64_t> passed{0};
+        std::atomic<std::uint64_t> failed{0};
+    };
+
+    // A bucket is reused when its slot comes round again; epoch tells readers
+    // which interval the counters belong to (-1 while being reset).
+    struct TimeBucket {
+        std::atomic<std::int64_t> epoch{-1};
+        std::atomic<std::uint64_t> products{0};
+        std::atomic<std::uint64_t> rejects{0};
+        std::atomic<std::uint64_t> scans{0};
+    };
+
+    PortCounters* portFor(const std::string& name);
+    TimeBucket& bucketFor(std::int64_t nowMs);
+    void countTest(Test test, std::uint32_t verdict, std::uint32_t checked, std::uint32_t failed);
+
+    std::int64_t bucketMs_;
+
+    std::atomic<std::uint64_t> cycles_{0};
+    std::atomic<std::uint64_t> scans_{0};
+    std::atomic<std::uint64_t> products_{0};
+    std::atomic<std::uint64_t> rejects_{0};
+
+    std::array<PortCounters, kMaxPorts> ports_;
+    std::atomic<std::size_t> portCount_{0};
+
+    std::array<TestCounters, kTestCount> tests_;
+    std::array<TimeBucket, kTimeBuckets> buckets_;
+
+    LatencyHistogram cycleTime_;
+    LatencyHistogram productInterval_;
+    std::int64_t lastProductMs_{-1}; // writer only
+};
+
+#endif // PRODUCTIONSTATS_H
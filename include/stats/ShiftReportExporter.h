@@ -0,0 +1,56 @@
+#ifndef SHIFTREPORTEXPORTER_H
+#define SHIFTREPORTEXPORTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "json.hpp"
+#include "stats/ProductionStats.h"
+
+// Writes shift reports from ProductionStats snapshots on a background thread.
+//
+// Every rollingIntervalSeconds the running shift is written to current_shift.json.
+// At each shift boundary the finished shift is written to
+// shift-YYYYMMDD-HHMM.json and appended as one row to shifts.csv.
+class ShiftReportExporter {
+public:
+    struct Options {
+        std::string directory{"reports"};
+        std::vector<int> shiftStartMinutes{6 * 60, 14 * 60, 22 * 60}; // local time, minutes after midnight
+        int rollingIntervalSeconds{60};
+    };
+
+    ShiftReportExporter(const ProductionStats& stats, Options options);
+    ~ShiftReportExporter();
+
+    ShiftReportExporter(const ShiftReportExporter&) = delete;
+    ShiftReportExporter& operator=(const ShiftReportExporter&) = delete;
+
+    bool start();
+    // Writes the running shift one last time and stops the thread
+    void stop();
+
+    // "HH:MM" -> minutes after midnight, -1 if invalid
+    static int parseShiftStart(const std::string& text);
+
+    static nlohmann::json toJson(const ProductionStats::Snapshot& shift, std::int64_t startMs, std::int64_t endMs);
+
+private:
+    void run();
+    std::int64_t nextBoundaryMs(std::int64_t nowMs) const;
+    void writeRolling(const ProductionStats::Snapshot& shift, std::int64_t startMs, std::int64_t nowMs);
+    void writeShift(const ProductionStats::Snapshot& shift, std::int64_t startMs, std::int64_t endMs);
+
+    const ProductionStats& stats_;
+    Options options_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+    std::thread thread_;
+};
+
+#endif // SHIFTREPORTEXPORTER_H
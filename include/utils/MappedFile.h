@@ -0,0 +1,57 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Memory-mapped file (CreateFileMapping on Windows, mmap elsewhere).
+// Writable mappings can be grown with resize(); the file is extended and remapped,
+// so pointers returned by data() are invalid after a resize.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Open (and create if writable) a file. A writable file smaller than minSize is extended.
+    bool open(const std::string& path, bool writable, std::size_t minSize = 0);
+    void close();
+
+    // Extend a writable file to newSize bytes and remap it (never shrinks)
+    bool resize(std::size_t newSize);
+
+    // Write dirty pages back to the file
+    bool flush();
+
+    bool isOpen() const { return open_; }
+    bool isWritable() const { return writable_; }
+    std::size_t size() const { return size_; }
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    const std::string& path() const { return path_; }
+
+private:
+    bool map();
+    void unmap();
+
+    std::string path_;
+    bool open_{false};
+    bool writable_{false};
+    std::size_t size_{0};
+    char* data_{nullptr};
+
+#ifdef _WIN32
+    HANDLE file_{INVALID_HANDLE_VALUE};
+    HANDLE mapping_{nullptr};
+#else
+    int fd_{-1};
+#endif
+};
+
+#endif // MAPPEDFILE_H
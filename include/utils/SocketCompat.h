@@ -0,0 +1,89 @@
+#pragma once
+
+// Minimal BSD-socket compatibility layer (Winsock2 on Windows, POSIX elsewhere).
+// Include this before any header that pulls in <windows.h> so that winsock2.h
+// wins over the legacy winsock.h.
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+
+    using socket_t = SOCKET;
+    constexpr socket_t kInvalidSocket = INVALID_SOCKET;
+
+    inline int closeSocket(socket_t s) { return closesocket(s); }
+    inline int pollSockets(pollfd* fds, std::size_t count, int timeoutMs) {
+        return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+    }
+    inline int lastSocketError() { return WSAGetLastError(); }
+    inline bool isWouldBlock(int error) { return error == WSAEWOULDBLOCK; }
+    inline bool isConnectPending(int error) { return error == WSAEWOULDBLOCK; }
+    // Result of a non-blocking connect once the socket is writable (0 = connected)
+    inline int pendingSocketError(socket_t s) {
+        int error = 0;
+        int length = sizeof(error);
+        if (getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) != 0) return WSAGetLastError();
+        return error;
+    }
+    inline bool setNonBlocking(socket_t s) {
+        u_long mode = 1;
+        return ioctlsocket(s, FIONBIO, &mode) == 0;
+    }
+
+    // WSAStartup/WSACleanup for the lifetime of the owning object
+    class SocketRuntime {
+    public:
+        SocketRuntime() { WSADATA data; ok_ = WSAStartup(MAKEWORD(2, 2), &data) == 0; }
+        ~SocketRuntime() { if (ok_) WSACleanup(); }
+        bool ok() const { return ok_; }
+    private:
+        bool ok_{false};
+    };
+#else
+    #include <arpa/inet.h>
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+
+    using socket_t = int;
+    constexpr socket_t kInvalidSocket = -1;
+
+    inline int closeSocket(socket_t s) { return ::close(s); }
+    inline int pollSockets(pollfd* fds, std::size_t count, int timeoutMs) {
+        return ::poll(fds, static_cast<nfds_t>(count), timeoutMs);
+    }
+    inline int lastSocketError() { return errno; }
+    inline bool isWouldBlock(int error) { return error == EAGAIN || error == EWOULDBLOCK; }
+    inline bool isConnectPending(int error) { return error == EINPROGRESS; }
+    inline int pendingSocketError(socket_t s) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(s, SOL_SOCKET, SO_ERROR, &error, &length) != 0) return errno;
+        return error;
+    }
+    inline bool setNonBlocking(socket_t s) {
+        const int flags = fcntl(s, F_GETFL, 0);
+        return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    class SocketRuntime {
+    public:
+        bool ok() const { return true; }
+    };
+#endif
+
+// True for 127.0.0.0/8 and "localhost"
+inline bool isLoopbackAddress(const std::string& address) {
+    return address == "localhost" || address.rfind("127.", 0) == 0;
+}
@@ -35,6 +35,13 @@ void Config::ensureDefaultTestsSettings()
         if (!tests.contains("matchWithReader2")) tests["matchWithReader2"] = false;
         if (!tests.contains("masterInFileCheck")) tests["masterInFileCheck"] = false;
         if (!tests.contains("filePath")) tests["filePath"] = "";
+        // More reference files merged with filePath, and how a scan matches them: exact, prefix, range or numeric
+        if (!tests.contains("filePaths")) tests["filePaths"] = nlohmann::json::array();
+        if (!tests.contains("fileMatch")) tests["fileMatch"] = "exact";
+        // Check a data file for short/malformed lines, duplicates and sequence breaks when it is selected
+        if (!tests.contains("verifyDataFile")) tests["verifyDataFile"] = true;
+        // A reference entry passes only the first time it is scanned in a job
+        if (!tests.contains("fileSeenOnce")) tests["fileSeenOnce"] = false;
 
         // New defaults for enhanced Tests tab
         if (!tests.contains("masterSequenceEnabled")) tests["masterSequenceEnabled"] = false;
@@ -46,6 +53,22 @@ void Config::ensureDefaultTestsSettings()
         if (!tests.contains("fileStartIndex")) tests["fileStartIndex"] = 0;
         if (!tests.contains("fileLength")) tests["fileLength"] = 1;
 
+        // Job-wide duplicate check on master scans (key slice like fileStartIndex/fileLength, 0 = to end)
+        if (!tests.contains("duplicateCheck")) tests["duplicateCheck"] = false;
+        if (!tests.contains("duplicateStartIndex")) tests["duplicateStartIndex"] = 0;
+        if (!tests.contains("duplicateLength")) tests["duplicateLength"] = 0;
+        if (!tests.contains("duplicateCapacity")) tests["duplicateCapacity"] = 20000000; // codes per job; ~2.6 bytes each
+        if (!tests.contains("duplicateDirectory")) tests["duplicateDirectory"] = "duplicates";
+
+        // Named fields of the port formats (communication.<port>.format) used instead of the slices; "" = slice
+        if (!tests.contains("sequenceField")) tests["sequenceField"] = "";
+        if (!tests.contains("matchField")) tests["matchField"] = "";
+        if (!tests.contains("fileField")) tests["fileField"] = "";
+        if (!tests.contains("duplicateField")) tests["duplicateField"] = "";
+
+        // Per-port format checks: port name -> list of rules (see ScanValidator)
+        if (!tests.contains("validators")) tests["validators"] = nlohmann::json::object();
+
         getLogger()->debug("Default tests settings ensured");
     } catch (const std::exception& e) {
         getLogger()->error("Error ensuring default tests settings: {}", e.what());
@@ -103,6 +126,245 @@ int Config::getBarcodeChannelsToShow() const
     return machine.value("barcodeChannelsToShow", 2);
 }
 
+void Config::ensureDefaultHistorySettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("history") || !configJson_["history"].is_object()) {
+            configJson_["history"] = nlohmann::json::object();
+        }
+
+        auto& history = configJson_["history"];
+        if (!history.contains("enabled")) history["enabled"] = true;
+        if (!history.contains("directory")) history["directory"] = "history";
+        if (!history.contains("partitionHours")) history["partitionHours"] = 24;  // one segment per day
+        if (!history.contains("retentionDays")) history["retentionDays"] = 90;    // 0 = keep everything
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default history settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getHistorySettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("history", nlohmann::json::object());
+}
+
+void Config::ensureDefaultReportSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("reports") || !configJson_["reports"].is_object()) {
+            configJson_["reports"] = nlohmann::json::object();
+        }
+
+        auto& reports = configJson_["reports"];
+        if (!reports.contains("enabled")) reports["enabled"] = true;
+        if (!reports.contains("directory")) reports["directory"] = "reports";
+        if (!reports.contains("shiftStarts")) reports["shiftStarts"] = {"06:00", "14:00", "22:00"}; // local time
+        if (!reports.contains("rollingIntervalSeconds")) reports["rollingIntervalSeconds"] = 60;
+        if (!reports.contains("bucketMinutes")) reports["bucketMinutes"] = 15;
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default report settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getReportSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("reports", nlohmann::json::object());
+}
+
+void Config::ensureDefaultMetricsSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("metrics") || !configJson_["metrics"].is_object()) {
+            configJson_["metrics"] = nlohmann::json::object();
+        }
+
+        auto& metrics = configJson_["metrics"];
+        if (!metrics.contains("enabled")) metrics["enabled"] = false;
+        if (!metrics.contains("bindAddress")) metrics["bindAddress"] = "127.0.0.1"; // loopback only
+        if (!metrics.contains("port")) metrics["port"] = 9464;
+        if (!metrics.contains("maxResponseBytes")) metrics["maxResponseBytes"] = 262144;
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default metrics settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getMetricsSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("metrics", nlohmann::json::object());
+}
+
+void Config::ensureDefaultApiSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("api") || !configJson_["api"].is_object()) {
+            configJson_["api"] = nlohmann::json::object();
+        }
+
+        auto& api = configJson_["api"];
+        if (!api.contains("enabled")) api["enabled"] = false;
+        if (!api.contains("bindAddress")) api["bindAddress"] = "127.0.0.1"; // loopback only
+        if (!api.contains("port")) api["port"] = 5020;
+        if (!api.contains("framing")) api["framing"] = "json-lines"; // or "length-prefixed"
+        if (!api.contains("batchIntervalMs")) api["batchIntervalMs"] = 50;
+        if (!api.contains("maxClients")) api["maxClients"] = 8;
+        if (!api.contains("allowInjectScan")) api["allowInjectScan"] = false;
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default api settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getApiSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("api", nlohmann::json::object());
+}
+
+void Config::ensureDefaultSharedStateSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("sharedState") || !configJson_["sharedState"].is_object()) {
+            configJson_["sharedState"] = nlohmann::json::object();
+        }
+
+        auto& shared = configJson_["sharedState"];
+        if (!shared.contains("enabled")) shared["enabled"] = true;
+        if (!shared.contains("name")) shared["name"] = ""; // empty = MC_STATE_DEFAULT_NAME
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default shared state settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getSharedStateSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("sharedState", nlohmann::json::object());
+}
+
+void Config::ensureDefaultEngineSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("engine") || !configJson_["engine"].is_object()) {
+            configJson_["engine"] = nlohmann::json::object();
+        }
+
+        auto& engine = configJson_["engine"];
+        if (!engine.contains("ipcName")) engine["ipcName"] = "MachineControllerIpc";
+        if (!engine.contains("priority")) engine["priority"] = "high"; // normal, high or realtime
+        if (!engine.contains("rttSamples")) engine["rttSamples"] = 200; // pings measured on attach, 0 = off
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default engine settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getEngineSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("engine", nlohmann::json::object());
+}
+
+void Config::ensureDefaultCaptureSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("capture") || !configJson_["capture"].is_object()) {
+            configJson_["capture"] = nlohmann::json::object();
+        }
+
+        auto& capture = configJson_["capture"];
+        if (!capture.contains("samples")) capture["samples"] = 262144; // ring size, 16 bytes per sample
+        if (!capture.contains("pre")) capture["pre"] = 1000;          // dialog defaults
+        if (!capture.contains("post")) capture["post"] = 10000;
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default capture settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getCaptureSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("capture", nlohmann::json::object());
+}
+
+void Config::ensureDefaultEdgeJournalSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("edgeJournal") || !configJson_["edgeJournal"].is_object()) {
+            configJson_["edgeJournal"] = nlohmann::json::object();
+        }
+
+        auto& journal = configJson_["edgeJournal"];
+        if (!journal.contains("enabled")) journal["enabled"] = true;
+        if (!journal.contains("directory")) journal["directory"] = "edges";
+        if (!journal.contains("partitionHours")) journal["partitionHours"] = 1;
+        if (!journal.contains("retentionDays")) journal["retentionDays"] = 30; // 0 = keep everything
+        if (!journal.contains("blockEdges")) journal["blockEdges"] = 4096;
+        if (!journal.contains("flushSeconds")) journal["flushSeconds"] = 5;   // a partial block reaches disk after this
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default edge journal settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getEdgeJournalSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("edgeJournal", nlohmann::json::object());
+}
+
+void Config::ensureDefaultModbusIoSettings()
+{
+    try {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        if (!configJson_.contains("io") || !configJson_["io"].is_object()) {
+            configJson_["io"] = nlohmann::json::object();
+        }
+        auto& io = configJson_["io"];
+        if (!io.contains("modbus") || !io["modbus"].is_object()) {
+            io["modbus"] = nlohmann::json::object();
+        }
+
+        auto& modbus = io["modbus"];
+        if (!modbus.contains("host")) modbus["host"] = "127.0.0.1";
+        if (!modbus.contains("port")) modbus["port"] = 502;
+        if (!modbus.contains("unitId")) modbus["unitId"] = 1;
+        if (!modbus.contains("scanMs")) modbus["scanMs"] = 10;
+        if (!modbus.contains("timeoutMs")) modbus["timeoutMs"] = 1000;
+        if (!modbus.contains("reconnectMs")) modbus["reconnectMs"] = 2000;
+        if (!modbus.contains("maxOutstanding")) modbus["maxOutstanding"] = 4; // pipelined requests
+        if (!modbus.contains("maxGap")) modbus["maxGap"] = 32;                // unmapped bits read to save a request
+        if (!modbus.contains("inputTable")) modbus["inputTable"] = "discreteInputs"; // or "coils"
+    } catch (const std::exception& e) {
+        getLogger()->error("Error ensuring default Modbus IO settings: {}", e.what());
+    }
+}
+
+nlohmann::json Config::getModbusIoSettings() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_.value("io", nlohmann::json::object()).value("modbus", nlohmann::json::object());
+}
+
+nlohmann::json Config::toJson() const
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return configJson_;
+}
+
+void Config::replaceAll(const nlohmann::json& settings)
+{
+    std::lock_guard<std::mutex> lock(configMutex_);
+    configJson_ = settings;
+}
+
 Config::DataFileSettings Config::getDataFileSettings() const
 {
     std::lock_guard<std::mutex> lock(configMutex_);
@@ -133,6 +395,15 @@ Config::Config(const std::string &filePath)
         ensureDefaultGlueSettings();
         ensureDefaultTestsSettings();
         ensureDefaultMachineSettings();
+        ensureDefaultHistorySettings();
+        ensureDefaultReportSettings();
+        ensureDefaultMetricsSettings();
+        ensureDefaultApiSettings();
+        ensureDefaultSharedStateSettings();
+        ensureDefaultEngineSettings();
+        ensureDefaultCaptureSettings();
+        ensureDefaultEdgeJournalSettings();
+        ensureDefaultModbusIoSettings();
         filePath_ = filePath;
         return;
     }
@@ -144,6 +415,15 @@ Config::Config(const std::string &filePath)
         ensureDefaultTimerSettings();
         ensureDefaultGlueSettings();
         ensureDefaultTestsSettings();
+        ensureDefaultHistorySettings();
+        ensureDefaultReportSettings();
+        ensureDefaultMetricsSettings();
+        ensureDefaultApiSettings();
+        ensureDefaultSharedStateSettings();
+        ensureDefaultEngineSettings();
+        ensureDefaultCaptureSettings();
+        ensureDefaultEdgeJournalSettings();
+        ensureDefaultModbusIoSettings();
     } catch (const std::exception& e) {
         getLogger()->warn("[Config] Failed to parse configuration file: {}", e.what());
         // If parsing fails, set defaults
@@ -152,6 +432,15 @@ Config::Config(const std::string &filePath)
         ensureDefaultGlueSettings();
         ensureDefaultTestsSettings();
         ensureDefaultMachineSettings();
+        ensureDefaultHistorySettings();
+        ensureDefaultReportSettings();
+        ensureDefaultMetricsSettings();
+        ensureDefaultApiSettings();
+        ensureDefaultSharedStateSettings();
+        ensureDefaultEngineSettings();
+        ensureDefaultCaptureSettings();
+        ensureDefaultEdgeJournalSettings();
+        ensureDefaultModbusIoSettings();
         filePath_ = filePath;
     }
 }
@@ -336,6 +625,7 @@ void Config::ensureDefaultCommunicationSettings()
         if (!comm1.contains("etx")) comm1["etx"] = 3;
         if (!comm1.contains("trigger")) comm1["trigger"] = "t";
         if (!comm1.contains("offset")) comm1["offset"] = 0;
+        if (!comm1.contains("format")) comm1["format"] = ""; // PayloadPattern; "" = no format check
         
         // Ensure communication2 settings exist with defaults
         if (!configJson_["communication"].contains("communication2") || !configJson_["communication"]["communication2"].is_object()) {
@@ -353,6 +643,7 @@ void Config::ensureDefaultCommunicationSettings()
         if (!comm2.contains("etx")) comm2["etx"] = 3;
         if (!comm2.contains("trigger")) comm2["trigger"] = "t";
         if (!comm2.contains("offset")) comm2["offset"] = 0;
+        if (!comm2.contains("format")) comm2["format"] = "";
         
         getLogger()->debug("Default communication settings ensured");
     } catch (const std::exception& e) {
@@ -1,21 +1,34 @@
 #include "Logic.h"
 #include "Logger.h"
 #include "communication/RS232Communication.h"
+#include "io/IODeviceFactory.h"
+#include "machine/Sequence.h"
 #include "utils/CompilerMacros.h" // Add cross-platform function name macro
 #include "json.hpp"
 #include <iostream>
 #include <tuple>
+#include <algorithm>
 #include <fstream>
 
+namespace {
+// TimerEvent names for link rate negotiation are this prefix + communication name
+const std::string kBaudTimerPrefix = "baudNegotiation:";
+const std::string kCycleWakeupTimer = "cycleWakeup";
+constexpr int kBaudAckTimeoutMs = 1000;
+constexpr int kBaudSwitchSettleMs = 50;   // give the controller time to reopen its UART
+constexpr int kBaudVerifyTimeoutMs = 1000;
+constexpr std::size_t kBaudVerifyMaxLength = 512;
+}
+
 Logic::Logic(EventQueue<EventVariant> &eventQueue, const Config &config)
-    : eventQueue_(eventQueue), config_(config), io_(eventQueue_, config) {
-  if (!io_.initialize()) {
-    std::cerr << "Failed to initialize PCI7248IO." << std::endl;
-    getLogger()->error("[{}] Failed to initialize PCI7248IO.", FUNCTION_NAME);
+    : eventQueue_(eventQueue), config_(config), io_(createIODevice(eventQueue_, config)) {
+  if (!io_->initialize()) {
+    std::cerr << "Failed to initialize IO device " << config.getIODevice() << "." << std::endl;
+    getLogger()->error("[{}] Failed to initialize IO device {}.", FUNCTION_NAME, config.getIODevice());
   } else {
     // Get initial input states and emit signal to update the SettingsWindow
     // This ensures the IO tab shows the correct states when first opened
-    auto initialInputs = io_.getInputChannelsSnapshot();
+    auto initialInputs = io_->getInputChannelsSnapshot();
     emit inputStatesChanged(initialInputs);
 
     std::cout << "Initial input states sent to SettingsWindow." << std::endl;
@@ -35,6 +48,8 @@ Logic::Logic(EventQueue<EventVariant> &eventQueue, const Config &config)
     // Configure Tests: master sequence settings from config (defaults match GUI)
     try {
       auto tests = config_.getTestsSettings();
+      core_->setMasterReader(tests.value("masterReader", std::string("communication1")));
+      core_->setMatchReader(tests.value("reader2", std::string("communication2")));
       bool enabled = tests.value("masterSequenceEnabled", false);
       int startIndex = tests.value("masterStartIndex", 0);
       int length = tests.value("masterLength", 1);
@@ -59,15 +74,81 @@ Logic::Logic(EventQueue<EventVariant> &eventQueue, const Config &config)
       // Use very large length if 0 or negative to mean 'to end of line'
       core_->setMasterInFileExtraction(fileStartIndex, (fileLength > 0 ? fileLength : 1000000));
       if (mifEnabled) {
-        refreshMasterFileReferenceSet();
+        refreshMasterFileReference();
       }
     } catch (...) {
       // Ignore configuration errors; use core defaults
     }
+    refreshDuplicateCheck();
+    refreshValidators();
+    refreshFormats();
+  }
+
+  // Production scan history
+  try {
+    auto history = config_.getHistorySettings();
+    if (history.value("enabled", true)) {
+      ScanHistory::Options options;
+      options.directory = history.value("directory", options.directory);
+      options.partitionHours = history.value("partitionHours", options.partitionHours);
+      options.retentionDays = history.value("retentionDays", options.retentionDays);
+      history_ = std::make_unique<ScanHistory>(options);
+      if (!history_->start()) {
+        getLogger()->error("[{}] Failed to start scan history in '{}'", FUNCTION_NAME, options.directory);
+        history_.reset();
+      }
+    }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid history settings: {}", FUNCTION_NAME, e.what());
+    history_.reset();
+  }
+
+  // Shift counters are always kept; the report exporter is optional
+  nlohmann::json reports;
+  try {
+    reports = config_.getReportSettings();
+  } catch (...) {
+    reports = nlohmann::json::object();
+  }
+  stats_ = std::make_unique<ProductionStats>(reports.value("bucketMinutes", 15));
+  try {
+    if (reports.value("enabled", true)) {
+      ShiftReportExporter::Options options;
+      options.directory = reports.value("directory", options.directory);
+      options.rollingIntervalSeconds = reports.value("rollingIntervalSeconds", options.rollingIntervalSeconds);
+      if (reports.contains("shiftStarts") && reports["shiftStarts"].is_array()) {
+        options.shiftStartMinutes.clear();
+        for (const auto& entry : reports["shiftStarts"]) {
+          int minutes = entry.is_string() ? ShiftReportExporter::parseShiftStart(entry.get<std::string>()) : -1;
+          if (minutes < 0) {
+            getLogger()->warn("[{}] Ignoring invalid shift start {}", FUNCTION_NAME, entry.dump());
+            continue;
+          }
+          options.shiftStartMinutes.push_back(minutes);
+        }
+      }
+      reportExporter_ = std::make_unique<ShiftReportExporter>(*stats_, options);
+      if (!reportExporter_->start()) {
+        reportExporter_.reset();
+      }
+    }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid report settings: {}", FUNCTION_NAME, e.what());
+    reportExporter_.reset();
   }
+
+  initMetrics();
+  initControlServer();
+  initSharedState();
 }
 
 Logic::~Logic() {
+    // The metrics collectors read Logic members; stop serving before anything is released
+    if (controlServer_) controlServer_->stop();
+    if (metricsServer_) metricsServer_->stop();
+    // Write out queued scans before the history is released
+    if (history_) history_->stop();
+    if (reportExporter_) reportExporter_->stop();
     // The map's destructor will handle calling RS232Communication destructors.
     // RS232Communication destructor calls close(), which has checks for multiple calls.
      getLogger()->debug("Logic destructor finished."); // Add log to confirm destructor completes
@@ -105,7 +186,7 @@ void Logic::run() {
   // Initialize timers and communication ports within the Logic thread
   this->initialize();
   
-  outputChannels_ = io_.getOutputChannels();
+  outputChannels_ = io_->getOutputChannels();
 
   // Run the event loop indefinitely until a TerminationEvent is received
   while (true) {
@@ -131,7 +212,7 @@ void Logic::stop() {
     // Push termination event to stop the event loop
     eventQueue_.push(TerminationEvent{});
     // Stop IO polling
-    io_.stopPolling();
+    io_->stopPolling();
   });
 }
 
@@ -172,6 +253,15 @@ void Logic::handleEvent(const IOEvent &event) {
 void Logic::handleEvent(const CommEvent &event) {
   getLogger()->debug("[{}] Received communication from {}: {}", FUNCTION_NAME, event.communicationName,
              event.message);
+
+  // Per-port frame counter (series created on the first frame from a port)
+  auto frameMetric = commFrameMetrics_.find(event.communicationName);
+  if (frameMetric == commFrameMetrics_.end()) {
+    MetricsRegistry::Counter& counter = metrics_.counter(
+        "mc_comm_frames_total", "Frames received per communication port", {{"port", event.communicationName}});
+    frameMetric = commFrameMetrics_.emplace(event.communicationName, &counter).first;
+  }
+  frameMetric->second->inc();
   std::cout << "[Communication] Received from " << event.communicationName << ": "
             << event.message << std::endl;
 
@@ -192,6 +282,74 @@ void Logic::handleEvent(const CommEvent &event) {
   } catch (...) {
     // ignore parse errors; keep raw only
   }
+
+  // Glue controller status replies are not barcode data: report them and stop here
+  if (cm.parsed && cm.parsed->contains("type") && (*cm.parsed)["type"].is_string()) {
+    const std::string type = (*cm.parsed)["type"].get<std::string>();
+    if (type == "config_ack") {
+      int rows = cm.parsed->value("rows", 0);
+      int dropped = cm.parsed->value("dropped", 0);
+      long long maxLoopUs = cm.parsed->value("maxLoopUs", 0LL);
+      getLogger()->info("[{}] {} accepted setup: rows={}, dropped={}, max loop during upload={}us",
+                        FUNCTION_NAME, event.communicationName, rows, dropped, maxLoopUs);
+      emit guiMessage(QString("Controller on %1 accepted setup: %2 rows, max loop %3 us")
+                          .arg(QString::fromStdString(event.communicationName))
+                          .arg(rows)
+                          .arg(maxLoopUs),
+                      "info");
+      if (dropped > 0) {
+        emit guiMessage(QString("Controller on %1 dropped %2 rows (zone limit reached)")
+                            .arg(QString::fromStdString(event.communicationName))
+                            .arg(dropped),
+                        "warning");
+      }
+      return;
+    }
+    if (type == "capabilities") {
+      ArduinoProtocol::Capabilities caps;
+      if (ArduinoProtocol::parseCapabilities(*cm.parsed, caps)) {
+        controllerCaps_[event.communicationName] = caps;
+        getLogger()->info("[{}] {} capabilities: fw={}, schema={}, adcBits={}, maxZones={}, maxBaud={}, encoding={}",
+                          FUNCTION_NAME, event.communicationName, caps.firmwareVersion, caps.schemaVersion,
+                          caps.adcBits, caps.maxZones, caps.maxBaud, ArduinoProtocol::selectEncoding(caps));
+        emit guiMessage(QString("Controller on %1: firmware %2, schema v%3")
+                            .arg(QString::fromStdString(event.communicationName))
+                            .arg(QString::fromStdString(caps.firmwareVersion))
+                            .arg(caps.schemaVersion),
+                        "info");
+        emit controllerCapabilitiesChanged(event.communicationName, caps);
+        startBaudNegotiation(event.communicationName, caps);
+      }
+      return;
+    }
+    if (type == "baud_ack" || type == "baud_verify") {
+      handleBaudReply(event.communicationName, type, *cm.parsed);
+      return;
+    }
+    if (type == "error") {
+      std::string code = cm.parsed->value("code", std::string("unknown"));
+      if (isBaudNegotiating(event.communicationName)) {
+        finishBaudNegotiation(event.communicationName, false, "controller error: " + code);
+      }
+      getLogger()->error("[{}] {} reported error: {}", FUNCTION_NAME, event.communicationName, code);
+      emit guiMessage(QString("Controller on %1 reported error: %2")
+                          .arg(QString::fromStdString(event.communicationName))
+                          .arg(QString::fromStdString(code)),
+                      "error");
+      return;
+    }
+  }
+
+  // Format checks configured for this port; the core records the verdict with the scan
+  auto validator = validators_.find(event.communicationName);
+  if (validator != validators_.end()) {
+    cm.validation = validator->second.validate(cm.raw);
+  }
+  auto format = formats_.find(event.communicationName);
+  if (format != formats_.end()) {
+    cm.format = format->second.match(cm.raw);
+  }
+
   pendingCommMsg_ = std::move(cm);
 
   // Run the central logic cycle
@@ -222,14 +380,11 @@ void Logic::handleEvent(const GuiEvent &event) {
       getLogger()->debug("[{}] LED blinking {}", FUNCTION_NAME, blinkLed0_ ? "enabled" : "disabled");
       if (core_) { core_->setBlinkLed(blinkLed0_); }
       
+      // One periodic timer drives the blink; the core no longer restarts it every edge
       if (blinkLed0_) {
-        timers_["timer1"].start(
-            std::chrono::milliseconds(timers_["timer1"].getDuration()), [this]() {
-              // Push the event to the queue
-              eventQueue_.push(TimerEvent{"timer1"});
-            });
+        startTimer("timer1", true);
       } else {
-        timers_["timer1"].cancel();
+        stopTimer("timer1");
       }
     }
     runLogicCycle = true;
@@ -248,6 +403,7 @@ void Logic::handleEvent(const GuiEvent &event) {
           emit guiMessage("Failed to reinitialize communication ports after parameter change", "error");
         }
         initializingComms_ = false;
+        refreshFormats();
       } else {
         getLogger()->debug("[{}] Communication initialization already in progress, skipping", FUNCTION_NAME);
       }
@@ -268,7 +424,15 @@ void Logic::handleEvent(const GuiEvent &event) {
     
     // Refresh master-in-file set when tests settings change or legacy datafile event occurs
     if (event.target == "tests" || event.target == "datafile") {
-      refreshMasterFileReferenceSet();
+      refreshMasterFileReference();
+      refreshDuplicateCheck();
+      refreshValidators();
+      refreshFormats();
+      if (core_) {
+        auto tests = config_.getTestsSettings();
+        core_->setMasterReader(tests.value("masterReader", std::string("communication1")));
+        core_->setMatchReader(tests.value("reader2", std::string("communication2")));
+      }
     }
     
     runLogicCycle = true;
@@ -276,10 +440,41 @@ void Logic::handleEvent(const GuiEvent &event) {
     // Display a message in the GUI
     emit guiMessage(QString::fromStdString(event.data),
                     QString::fromStdString(event.target));
+  } else if (event.keyword == "ResyncGui") {
+    // A GUI (re)attached to a running engine: send it everything it displays
+    emit inputStatesChanged(inputChannels_);
+    emitBarcodeStore();
+    for (const auto& [commName, caps] : controllerCaps_) {
+      if (!caps.legacy) emit controllerCapabilitiesChanged(commName, caps);
+    }
+  } else if (event.keyword == "OutputOverride") {
+    // SettingsWindow override toggle, forwarded by a GUI in another process
+    handleOutputOverrideStateChanged(event.intValue != 0);
+  } else if (event.keyword == "OutputOverrideStates") {
+    // data: {"outputName": state, ...} from a GUI in another process
+    try {
+      std::unordered_map<std::string, IOChannel> outputs;
+      for (const auto& [name, state] : nlohmann::json::parse(event.data).items()) {
+        auto it = outputChannels_.find(name);
+        if (it == outputChannels_.end()) continue;
+        IOChannel channel = it->second;
+        channel.state = state.get<int>();
+        outputs[name] = channel;
+      }
+      handleOutputStateChanged(outputs);
+    } catch (const std::exception& e) {
+      getLogger()->warn("[{}] Invalid output override states: {}", FUNCTION_NAME, e.what());
+    }
+  } else if (event.keyword == "IOCapture") {
+    handleCaptureEvent(event);
   } else if (event.keyword == "SendCommunicationMessage") {
     // Send a message to a communication port
     auto commPortIt = activeCommPorts_.find(event.target);
-    if (commPortIt != activeCommPorts_.end()) {
+    if (commPortIt != activeCommPorts_.end() && isBaudNegotiating(event.target)) {
+      // The line rate is changing; send once the link is verified or has fallen back
+      baudNegotiations_[event.target].deferredSends.push_back(event.data);
+      getLogger()->debug("[{}] Deferred message to {} during link rate negotiation", FUNCTION_NAME, event.target);
+    } else if (commPortIt != activeCommPorts_.end()) {
       if (!commPortIt->second.send(event.data)) {
         getLogger()->error("[{}] Failed to send message to {}", FUNCTION_NAME, event.target);
       } else {
@@ -314,7 +509,55 @@ void Logic::handleEvent(const GuiEvent &event) {
   }
 }
 
+// IO capture control from the GUI; target is arm (data: trigger JSON), trigger,
+// disarm, or collect (pushed by the polling thread when a capture finishes).
+void Logic::handleCaptureEvent(const GuiEvent &event) {
+  IOCapture& capture = io_->capture();
+  if (event.target == "arm") {
+    const auto channels = io_->captureChannels();
+    IOCapture::Settings settings;
+    std::string error;
+    nlohmann::json json = nlohmann::json::parse(event.data, nullptr, false);
+    if (json.is_discarded() || !IOCapture::parseSettings(json, channels, settings, error)) {
+      if (error.empty()) error = "invalid JSON";
+      getLogger()->warn("[{}] IO capture not armed: {}", FUNCTION_NAME, error);
+      emit guiMessage(QString("IO capture not armed: %1").arg(QString::fromStdString(error)), "error");
+      return;
+    }
+    capture.arm(settings);
+    getLogger()->info("[{}] IO capture armed: {} (pre {}, post {} samples)", FUNCTION_NAME,
+                      IOCapture::describe(settings, channels), settings.pre, settings.post);
+    emit guiMessage(QString("IO capture armed: %1").arg(QString::fromStdString(IOCapture::describe(settings, channels))), "info");
+  } else if (event.target == "trigger") {
+    capture.trigger();
+  } else if (event.target == "disarm") {
+    capture.disarm();
+    emit guiMessage("IO capture disarmed", "info");
+  } else if (event.target == "collect") {
+    IOCapture::Result result;
+    if (!capture.collect(result, io_->captureChannels())) {
+      getLogger()->debug("[{}] No IO capture to collect", FUNCTION_NAME);
+      return;
+    }
+    getLogger()->info("[{}] IO capture done: {} samples over {:.3f} ms, {} transitions, mean interval {:.1f} us, max {:.1f} us",
+                      FUNCTION_NAME, result.samples, (result.endNs - result.startNs) / 1e6, result.transitions.size(),
+                      result.meanIntervalUs, result.maxIntervalUs);
+    emit ioCaptureReady(result);
+  } else {
+    getLogger()->warn("[{}] Unknown IO capture command '{}'", FUNCTION_NAME, event.target);
+  }
+}
+
 void Logic::handleEvent(const TimerEvent &event) {
+  if (event.timerName.rfind(kBaudTimerPrefix, 0) == 0) {
+    handleBaudTimeout(event.timerName.substr(kBaudTimerPrefix.size()));
+    return;
+  }
+  if (event.timerName == kCycleWakeupTimer) {
+    wakeupAtUs_ = 0;
+    oneLogicCycle();
+    return;
+  }
   getLogger()->debug("[Timer Event] Timer: " + event.timerName + " triggered.");
   timers_[event.timerName].state_ = 1;
   timers_[event.timerName].eventType_ = IOEventType::Rising;
@@ -349,7 +592,7 @@ void Logic::handleOutputStateChanged(
     outputsUpdated_ = true;
 
     // Forward the output states to the IO module
-    if (io_.writeOutputs(outputs)) {
+    if (io_->writeOutputs(outputs)) {
       getLogger()->debug("[{}] Output states updated successfully", FUNCTION_NAME);
     } else {
       getLogger()->error("[{}] Failed to update output states", FUNCTION_NAME);
@@ -369,19 +612,119 @@ void Logic::handleEvent(const TerminationEvent &event) {
   // TerminationEvent directly
 }
 
+void Logic::handleEvent(const ControlEvent &event) {
+  bool ok = true;
+  std::string error;
+  nlohmann::json result = nlohmann::json::object();
+
+  try {
+    if (const auto* cmd = std::get_if<SetJobCommand>(&event.command)) {
+      jobName_ = cmd->jobName;
+      // A new job starts a new production run
+      if (core_) {
+        core_->resetMasterSequence();
+        core_->resetMatchTest();
+        core_->resetMasterInFileSeen();
+      }
+      if (duplicates_ && !duplicates_->clear()) {
+        core_->setDuplicateDetector(nullptr);
+        duplicates_.reset();
+        emit guiMessage("Duplicate check stopped: its store could not be recreated", "error");
+      }
+      duplicatesFullReported_ = false;
+      result["job"] = jobName_;
+      if (!cmd->referenceFile.empty()) {
+        auto tests = config_.getTestsSettings();
+        std::size_t entries = 0;
+        if (!loadMasterFileReference({cmd->referenceFile}, tests.value("fileStartIndex", 0),
+                                     tests.value("fileLength", 0), std::string(), entries)) {
+          throw std::runtime_error("cannot read reference file '" + cmd->referenceFile + "'");
+        }
+        result["referenceEntries"] = entries;
+      }
+      getLogger()->info("[{}] Job set to '{}' by control API", FUNCTION_NAME, jobName_);
+      emit guiMessage(QString("Job set to '%1' by line controller").arg(QString::fromStdString(jobName_)), "info");
+    } else if (const auto* cmd = std::get_if<LoadReferenceFileCommand>(&event.command)) {
+      std::size_t entries = 0;
+      if (!loadMasterFileReference(cmd->paths, cmd->startIndex, cmd->length, cmd->match, entries)) {
+        throw std::runtime_error("cannot load reference files (see log)");
+      }
+      result["paths"] = cmd->paths;
+      result["entries"] = entries;
+      emit guiMessage(QString("Reference files loaded by line controller (%1 file(s), %2 entries)")
+                          .arg(static_cast<qulonglong>(cmd->paths.size()))
+                          .arg(static_cast<qulonglong>(entries)),
+                      "info");
+    } else if (std::holds_alternative<GetStateCommand>(event.command)) {
+      result["job"] = jobName_;
+      result["inputs"] = nlohmann::json::object();
+      for (const auto& [name, channel] : inputChannels_) result["inputs"][name] = channel.state;
+      result["outputs"] = nlohmann::json::object();
+      for (const auto& [name, channel] : outputChannels_) result["outputs"][name] = channel.state;
+      result["timers"] = nlohmann::json::object();
+      for (const auto& [name, timer] : timers_) result["timers"][name] = timer.getState();
+      result["timerJitter"] = nlohmann::json::object();
+      for (const auto& [name, timer] : timers_) {
+        const auto jitter = timer.jitter().snapshot();
+        result["timerJitter"][name] = {{"firings", jitter.count},
+                                       {"meanUs", jitter.meanUs()},
+                                       {"p99Us", jitter.percentile(0.99)},
+                                       {"maxUs", jitter.maxUs},
+                                       {"missedPeriods", timer.missedPeriods()}};
+      }
+      result["commPorts"] = nlohmann::json::array();
+      for (const auto& [name, port] : activeCommPorts_) result["commPorts"].push_back(name);
+      result["barcodes"] = core_ ? nlohmann::json(core_->getBarcodeStoreSnapshot()) : nlohmann::json::object();
+      if (core_) {
+        const auto [seen, entries] = core_->getMasterInFileProgress();
+        result["reference"] = {{"entries", entries}, {"seen", seen}};
+      }
+      if (const SequenceScheduler* sequences = core_ ? core_->getSequences() : nullptr) {
+        const auto s = sequences->stats();
+        const auto pool = SequenceFramePool::stats();
+        result["sequences"] = {{"live", s.live},
+                               {"waiting", sequences->describe()},
+                               {"resumes", s.resumes},
+                               {"finished", s.finished},
+                               {"failed", s.failed},
+                               {"lastError", s.lastError},
+                               {"resumeNsMean", s.resumes ? s.resumeNsTotal / s.resumes : 0},
+                               {"resumeNsMax", s.resumeNsMax},
+                               {"framePoolBytes", pool.pooledBytes},
+                               {"framesInUse", pool.framesInUse},
+                               {"frameHeapFallbacks", pool.heapFallbacks}};
+      }
+    } else if (const auto* cmd = std::get_if<InjectScanCommand>(&event.command)) {
+      handleEvent(CommEvent{cmd->communicationName, cmd->message});
+    } else if (std::holds_alternative<PingCommand>(event.command)) {
+      // Nothing to do: the reply itself is the answer
+    }
+  } catch (const std::exception& e) {
+    ok = false;
+    error = e.what();
+    getLogger()->warn("[{}] Control command failed: {}", FUNCTION_NAME, error);
+  }
+
+  if (event.reply) {
+    event.reply(ok, ok ? result.dump() : error);
+  }
+}
+
 void Logic::writeOutputs() {
-  if (!io_.writeOutputs(outputChannels_)) {
+  outputWritesMetric_->inc();
+  if (!io_->writeOutputs(outputChannels_)) {
+    outputWriteErrorsMetric_->inc();
     getLogger()->error("[{}] Failed to write output states", FUNCTION_NAME);
   }
 }
 
 void Logic::writeGUIOoutputs() {
   // Direct hardware access logic here - bypasses override check
-  io_.writeOutputs(outputChannels_);
+  io_->writeOutputs(outputChannels_);
 }
 
 
-void Logic::emergencyShutdown() { io_.resetConfiguredOutputPorts(); }
+void Logic::emergencyShutdown() { io_->resetConfiguredOutputPorts(); }
 
 bool Logic::initializeCommunicationPorts() {
   try {
@@ -393,6 +736,9 @@ bool Logic::initializeCommunicationPorts() {
     
     getLogger()->debug("[{}] Initializing communication ports...", FUNCTION_NAME);
     
+    // Ports reopen at their configured rate, so any negotiated rate is gone
+    resetBaudNegotiations();
+
     // Close existing communication ports if they're open
     for (auto &pair : activeCommPorts_) {
       pair.second.close();
@@ -492,6 +838,8 @@ bool Logic::initializeCommunicationPorts() {
       emit guiMessage(QString::fromStdString(successMsg), "info");
     }
     
+    sendControllerHello();
+
     return !activeCommPorts_.empty(); // Return true if at least one port initialized successfully
   } catch (const std::exception &e) {
     const std::string errorMsg = "Error initializing communication ports: " + std::string(e.what());
@@ -501,6 +849,219 @@ bool Logic::initializeCommunicationPorts() {
   }
 }
 
+void Logic::sendControllerHello() {
+  try {
+    nlohmann::json glueSettings = config_.getGlueSettings();
+    if (!glueSettings.contains("controllers") || !glueSettings["controllers"].is_object()) {
+      return;
+    }
+
+    const std::string hello = ArduinoProtocol::frame(ArduinoProtocol::createHelloMessage());
+    for (const auto& [controllerName, controller] : glueSettings["controllers"].items()) {
+      std::string commName = controller.value("communication", std::string());
+      auto portIt = activeCommPorts_.find(commName);
+      if (portIt == activeCommPorts_.end()) {
+        continue;
+      }
+      // Reopened port: assume legacy until this controller answers again.
+      // Old firmware ignores unknown message types, so no reply simply keeps the legacy schema.
+      controllerCaps_[commName] = ArduinoProtocol::Capabilities{};
+      if (!portIt->second.send(hello)) {
+        getLogger()->warn("[{}] Failed to send hello to controller '{}' on {}", FUNCTION_NAME, controllerName, commName);
+      } else {
+        getLogger()->debug("[{}] Sent hello to controller '{}' on {}", FUNCTION_NAME, controllerName, commName);
+      }
+    }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Exception: {}", FUNCTION_NAME, e.what());
+  }
+}
+
+void Logic::startBaudNegotiation(const std::string& commName, const ArduinoProtocol::Capabilities& caps) {
+  try {
+    auto portIt = activeCommPorts_.find(commName);
+    if (portIt == activeCommPorts_.end() || caps.legacy || isBaudNegotiating(commName)) {
+      return;
+    }
+
+    nlohmann::json commSettings = config_.getCommunicationSettings();
+    nlohmann::json portSettings = commSettings.value(commName, nlohmann::json::object());
+    if (!portSettings.value("autoBaud", false)) {
+      return;
+    }
+
+    int currentBaud = static_cast<int>(portIt->second.getBaudRate());
+    int hostMaxBaud = portSettings.value("maxBaudRate", currentBaud);
+    int targetBaud = ArduinoProtocol::selectBaudRate(caps, hostMaxBaud);
+    if (targetBaud <= currentBaud) {
+      getLogger()->debug("[{}] {} stays at {} baud (controller max {}, host max {})",
+                         FUNCTION_NAME, commName, currentBaud, caps.maxBaud, hostMaxBaud);
+      return;
+    }
+
+    BaudNegotiation& neg = baudNegotiations_[commName];
+    neg = BaudNegotiation{};
+    neg.stage = BaudNegotiation::Stage::AwaitAck;
+    neg.targetBaud = targetBaud;
+    neg.fallbackBaud = currentBaud;
+    // Keep the pattern well inside the controller's frame buffer
+    std::size_t limit = caps.rxBuffer > 0 ? static_cast<std::size_t>(caps.rxBuffer) / 2 : 128;
+    neg.verifyLength = std::min(limit, kBaudVerifyMaxLength);
+
+    if (!portIt->second.send(ArduinoProtocol::frame(ArduinoProtocol::createSetBaudMessage(targetBaud)))) {
+      finishBaudNegotiation(commName, false, "failed to send set_baud");
+      return;
+    }
+    armBaudTimer(commName, kBaudAckTimeoutMs);
+    getLogger()->info("[{}] {} requesting {} baud (from {})", FUNCTION_NAME, commName, targetBaud, currentBaud);
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Exception: {}", FUNCTION_NAME, e.what());
+  }
+}
+
+void Logic::handleBaudReply(const std::string& commName, const std::string& type, const nlohmann::json& msg) {
+  auto negIt = baudNegotiations_.find(commName);
+  auto portIt = activeCommPorts_.find(commName);
+  if (negIt == baudNegotiations_.end() || portIt == activeCommPorts_.end()) {
+    getLogger()->debug("[{}] Ignoring unexpected {} from {}", FUNCTION_NAME, type, commName);
+    return;
+  }
+  BaudNegotiation& neg = negIt->second;
+
+  if (type == "baud_ack" && neg.stage == BaudNegotiation::Stage::AwaitAck) {
+    if (msg.value("baud", 0) != neg.targetBaud) {
+      finishBaudNegotiation(commName, false, "controller acknowledged a different rate");
+      return;
+    }
+    if (!portIt->second.setBaudRate(static_cast<unsigned long>(neg.targetBaud))) {
+      finishBaudNegotiation(commName, false, "failed to switch host port");
+      return;
+    }
+    neg.stage = BaudNegotiation::Stage::Switching;
+    armBaudTimer(commName, kBaudSwitchSettleMs);
+    return;
+  }
+
+  if (type == "baud_verify" && neg.stage == BaudNegotiation::Stage::AwaitVerify) {
+    baudTimers_[commName].cancel();
+    auto rtt = std::chrono::steady_clock::now() - neg.verifySentAt;
+    if (!ArduinoProtocol::isValidBaudVerifyPattern(msg.value("pattern", std::string()), neg.verifyLength)) {
+      finishBaudNegotiation(commName, false, "test pattern corrupted");
+      return;
+    }
+    if (!portIt->second.send(ArduinoProtocol::frame(ArduinoProtocol::createBaudCommitMessage(neg.targetBaud)))) {
+      finishBaudNegotiation(commName, false, "failed to send baud_commit");
+      return;
+    }
+
+    // Pattern went out and came back: bytes on the wire both ways over the round trip
+    LinkStats stats;
+    stats.baudRate = neg.targetBaud;
+    stats.roundTripMs = std::chrono::duration<double, std::milli>(rtt).count();
+    if (stats.roundTripMs > 0.0) {
+      stats.throughputBytesPerSec = (2.0 * static_cast<double>(neg.verifyBytes)) / (stats.roundTripMs / 1000.0);
+    }
+    linkStats_[commName] = stats;
+    finishBaudNegotiation(commName, true, "");
+    return;
+  }
+
+  getLogger()->debug("[{}] Ignoring {} from {} in current negotiation stage", FUNCTION_NAME, type, commName);
+}
+
+void Logic::handleBaudTimeout(const std::string& commName) {
+  auto negIt = baudNegotiations_.find(commName);
+  auto portIt = activeCommPorts_.find(commName);
+  if (negIt == baudNegotiations_.end() || portIt == activeCommPorts_.end()) {
+    return;
+  }
+  BaudNegotiation& neg = negIt->second;
+
+  switch (neg.stage) {
+    case BaudNegotiation::Stage::AwaitAck:
+      finishBaudNegotiation(commName, false, "no baud_ack");
+      break;
+    case BaudNegotiation::Stage::Switching: {
+      std::string verify = ArduinoProtocol::frame(ArduinoProtocol::createBaudVerifyMessage(neg.verifyLength));
+      neg.verifyBytes = verify.size();
+      neg.verifySentAt = std::chrono::steady_clock::now();
+      neg.stage = BaudNegotiation::Stage::AwaitVerify;
+      if (!portIt->second.send(verify)) {
+        finishBaudNegotiation(commName, false, "failed to send test pattern");
+        return;
+      }
+      armBaudTimer(commName, kBaudVerifyTimeoutMs);
+      break;
+    }
+    case BaudNegotiation::Stage::AwaitVerify:
+      finishBaudNegotiation(commName, false, "no test pattern echo");
+      break;
+    case BaudNegotiation::Stage::Idle:
+      break;
+  }
+}
+
+void Logic::finishBaudNegotiation(const std::string& commName, bool success, const std::string& reason) {
+  auto negIt = baudNegotiations_.find(commName);
+  if (negIt == baudNegotiations_.end()) {
+    return;
+  }
+  BaudNegotiation neg = std::move(negIt->second);
+  baudNegotiations_.erase(negIt);
+  baudTimers_[commName].cancel();
+
+  auto portIt = activeCommPorts_.find(commName);
+  if (portIt == activeCommPorts_.end()) {
+    return;
+  }
+
+  if (success) {
+    const LinkStats& stats = linkStats_[commName];
+    getLogger()->info("[{}] {} running at {} baud: round trip {:.1f} ms, effective {:.0f} B/s",
+                      FUNCTION_NAME, commName, stats.baudRate, stats.roundTripMs, stats.throughputBytesPerSec);
+    emit guiMessage(QString("Link %1 switched to %2 baud (%3 kB/s measured)")
+                        .arg(QString::fromStdString(commName))
+                        .arg(stats.baudRate)
+                        .arg(stats.throughputBytesPerSec / 1000.0, 0, 'f', 1),
+                    "info");
+  } else {
+    // Controller reverts on its own when no baud_commit arrives
+    portIt->second.setBaudRate(static_cast<unsigned long>(neg.fallbackBaud));
+    getLogger()->warn("[{}] {} rate negotiation to {} failed ({}), staying at {} baud",
+                      FUNCTION_NAME, commName, neg.targetBaud, reason, neg.fallbackBaud);
+    emit guiMessage(QString("Link %1 stays at %2 baud: %3")
+                        .arg(QString::fromStdString(commName))
+                        .arg(neg.fallbackBaud)
+                        .arg(QString::fromStdString(reason)),
+                    "warning");
+  }
+
+  for (const auto& message : neg.deferredSends) {
+    if (!portIt->second.send(message)) {
+      getLogger()->error("[{}] Failed to send deferred message to {}", FUNCTION_NAME, commName);
+    }
+  }
+}
+
+void Logic::armBaudTimer(const std::string& commName, int timeoutMs) {
+  const std::string timerName = kBaudTimerPrefix + commName;
+  baudTimers_[commName].start(std::chrono::milliseconds(timeoutMs), [this, timerName]() {
+    eventQueue_.push(TimerEvent{timerName});
+  });
+}
+
+bool Logic::isBaudNegotiating(const std::string& commName) const {
+  return baudNegotiations_.find(commName) != baudNegotiations_.end();
+}
+
+void Logic::resetBaudNegotiations() {
+  for (auto& [name, timer] : baudTimers_) {
+    timer.cancel();
+  }
+  baudNegotiations_.clear();
+  linkStats_.clear();
+}
+
 void Logic::closeAllPorts() {
     getLogger()->debug("[{}] Closing all active communication ports...", FUNCTION_NAME);
     for (auto &pair : activeCommPorts_) {
@@ -600,9 +1161,12 @@ bool Logic::initTimers() {
 }
 
 void Logic::oneLogicCycle() {
+  const auto cycleStart = std::chrono::steady_clock::now();
+
   // Build CycleInputs for the core
   CycleInputs in{inputChannels_};
   in.blinkLed0 = blinkLed0_;
+  in.nowUs = std::chrono::duration_cast<std::chrono::microseconds>(cycleStart.time_since_epoch()).count();
 
   // Collect timer edges for this cycle (Option A)
   for (auto& [name, t] : timers_) {
@@ -634,6 +1198,13 @@ void Logic::oneLogicCycle() {
     fx = core_->step(in);
   }
 
+  if (duplicates_ && !duplicatesFullReported_ && duplicates_->isFull()) {
+    duplicatesFullReported_ = true;
+    emit guiMessage(QString("Duplicate check is full after %1 codes; new codes are no longer recorded. Raise tests.duplicateCapacity.")
+                        .arg(static_cast<qulonglong>(duplicates_->count())),
+                    "error");
+  }
+
   // This cycle has consumed the pending comm message (if any)
   pendingCommMsg_ = std::nullopt;
 
@@ -645,16 +1216,26 @@ void Logic::oneLogicCycle() {
     outputsUpdated_ = true;
   }
 
+  scheduleWakeup(fx.wakeupAtUs);
+
   // Apply timer commands
   for (const auto& cmd : fx.timerCmds) {
-    if (cmd.type == TimerCmd::Start) {
-      // update duration if provided
-      if (cmd.durationMs) {
-        timers_[cmd.name].setDuration(*cmd.durationMs);
+    if (cmd.type == TimerCmd::Stop) {
+      stopTimer(cmd.name);
+      continue;
+    }
+    // update duration if provided
+    if (cmd.durationMs) {
+      timers_[cmd.name].setDuration(*cmd.durationMs);
+    }
+    if (cmd.type == TimerCmd::StartAt) {
+      if (cmd.atMs) {
+        startTimerAt(cmd.name, *cmd.atMs);
+      } else {
+        getLogger()->warn("[{}] StartAt for timer '{}' without a time", FUNCTION_NAME, cmd.name);
       }
-      startTimer(cmd.name);
     } else {
-      stopTimer(cmd.name);
+      startTimer(cmd.name, cmd.type == TimerCmd::StartPeriodic);
     }
   }
 
@@ -668,6 +1249,17 @@ void Logic::oneLogicCycle() {
     }
   }
 
+  // Queue stored scans for the production history (never blocks the cycle)
+  if (history_) {
+    for (const auto& scan : fx.scans) history_->record(scan);
+  }
+  if (!fx.scans.empty()) {
+    const std::int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (const auto& scan : fx.scans) stats_->recordScan(scan, nowMs);
+    if (controlServer_) controlServer_->publishResults(fx.scans, nowMs, jobName_);
+  }
+
   // Handle calibration results
   if (fx.calibration) {
     emit calibrationResponse(fx.calibration->pulsesPerPage, fx.calibration->commName);
@@ -724,23 +1316,47 @@ void Logic::oneLogicCycle() {
     }
 
     if (shouldPublish) {
-      auto snap = core_->getBarcodeStoreSnapshot();
-      QMap<QString, QStringList> out;
-      for (const auto& kv : snap) {
-        const std::string& port = kv.first;
-        const auto& vec = kv.second;
-        QStringList list;
-        list.reserve(static_cast<int>(vec.size()));
-        for (const auto& s : vec) list.push_back(QString::fromStdString(s));
-        out.insert(QString::fromStdString(port), list);
-      }
-      emit barcodeStoreUpdated(out);
+      emitBarcodeStore();
       lastBarcodeEmit_ = now;
     }
   }
+
+  stats_->recordCycle(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - cycleStart).count()));
+
+  // Publish the cycle's result for shared memory readers (grid only when it changed)
+  if (sharedState_) {
+    const ProductionStats::Totals totals = stats_->totals();
+    SharedStateWriter::Update update;
+    update.inputs = &inputChannels_;
+    update.outputs = &outputChannels_;
+    update.timers = &in.timersSnapshot;
+    update.counters = &totals;
+    std::unordered_map<std::string, std::vector<std::string>> barcodes;
+    if (core_ && (fx.barcodeStoreChanged || sharedState_->needsBarcodes())) {
+      barcodes = core_->getBarcodeStoreSnapshot();
+      update.barcodes = &barcodes;
+    }
+    sharedState_->publish(update);
+  }
+}
+
+void Logic::emitBarcodeStore() {
+  if (!core_) return;
+  auto snap = core_->getBarcodeStoreSnapshot();
+  QMap<QString, QStringList> out;
+  for (const auto& kv : snap) {
+    const std::string& port = kv.first;
+    const auto& vec = kv.second;
+    QStringList list;
+    list.reserve(static_cast<int>(vec.size()));
+    for (const auto& s : vec) list.push_back(QString::fromStdString(s));
+    out.insert(QString::fromStdString(port), list);
+  }
+  emit barcodeStoreUpdated(out);
 }
 
-void Logic::startTimer(const std::string& timerName) {
+void Logic::startTimer(const std::string& timerName, bool periodic) {
   auto it = timers_.find(timerName);
   if (it == timers_.end()) {
     getLogger()->warn("[{}] startTimer: timer '{}' not found", FUNCTION_NAME, timerName);
@@ -748,79 +1364,358 @@ void Logic::startTimer(const std::string& timerName) {
   }
   int dur = it->second.getDuration();
   if (dur <= 0) return;
-  it->second.start(std::chrono::milliseconds(dur), [this, timerName]() {
-    eventQueue_.push(TimerEvent{timerName});
-  });
+  auto fire = [this, timerName]() { eventQueue_.push(TimerEvent{timerName}); };
+  if (periodic) {
+    it->second.startPeriodic(std::chrono::milliseconds(dur), fire);
+  } else {
+    it->second.start(std::chrono::milliseconds(dur), fire);
+  }
+}
+
+void Logic::startTimerAt(const std::string& timerName, std::int64_t atMs) {
+  auto it = timers_.find(timerName);
+  if (it == timers_.end()) {
+    getLogger()->warn("[{}] startTimerAt: timer '{}' not found", FUNCTION_NAME, timerName);
+    return;
+  }
+  it->second.startAt(std::chrono::system_clock::time_point(std::chrono::milliseconds(atMs)),
+                     [this, timerName]() { eventQueue_.push(TimerEvent{timerName}); });
+}
+
+// Only re-arms when the deadline moves, so cycles with an unchanged deadline cost nothing
+void Logic::scheduleWakeup(const std::optional<std::int64_t>& atUs) {
+  if (!atUs) {
+    if (wakeupAtUs_ != 0) {
+      cycleWakeup_.cancel();
+      wakeupAtUs_ = 0;
+    }
+    return;
+  }
+  if (*atUs == wakeupAtUs_) return;
+  wakeupAtUs_ = *atUs;
+  cycleWakeup_.startAt(std::chrono::steady_clock::time_point(std::chrono::microseconds(*atUs)),
+                       [this]() { eventQueue_.push(TimerEvent{kCycleWakeupTimer}); });
 }
 
 void Logic::stopTimer(const std::string& timerName) {
   auto it = timers_.find(timerName);
   if (it == timers_.end()) return;
   it->second.cancel();
+  const auto jitter = it->second.jitter().snapshot();
+  if (jitter.count > 0) {
+    getLogger()->debug("[{}] Timer '{}' stopped: {} firings, lateness mean {:.0f}us p99 {}us max {}us, {} missed periods",
+                       FUNCTION_NAME, timerName, jitter.count, jitter.meanUs(), jitter.percentile(0.99),
+                       jitter.maxUs, it->second.missedPeriods());
+  }
+}
+
+void Logic::initMetrics() {
+  outputWritesMetric_ = &metrics_.counter("mc_output_writes_total", "Output writes issued to the IO card");
+  outputWriteErrorsMetric_ = &metrics_.counter("mc_output_write_errors_total", "Output writes the IO card rejected");
+  metrics_.histogram("mc_io_poll_interval_seconds", "Time between IO polling iterations (poll jitter)",
+                     io_->getPollIntervalHistogram());
+  if (const LatencyHistogram* scan = io_->getScanTimeHistogram()) {
+    metrics_.histogram("mc_io_scan_duration_seconds", "Time to read every remote input once", *scan);
+  }
+  if (const LatencyHistogram* roundTrip = io_->getRoundTripHistogram()) {
+    metrics_.histogram("mc_io_request_round_trip_seconds", "Round trip of one remote IO request", *roundTrip);
+  }
+
+  // Values computed at scrape time from lock-free snapshots; nothing here runs on the logic thread
+  metrics_.addCollector([this](MetricsWriter& w) {
+    w.family("mc_event_queue_depth", "Events waiting for the logic thread", "gauge");
+    w.sample("mc_event_queue_depth", {}, static_cast<std::uint64_t>(eventQueue_.size()));
+
+    const ProductionStats::Snapshot s = stats_->snapshot();
+    w.family("mc_logic_cycle_duration_seconds", "Duration of one logic cycle", "histogram");
+    w.histogram("mc_logic_cycle_duration_seconds", {}, s.cycleTime);
+    w.family("mc_product_interval_seconds", "Time between consecutive products on the master reader", "histogram");
+    w.histogram("mc_product_interval_seconds", {}, s.productInterval);
+
+    w.family("mc_products_total", "Products seen by the master reader", "counter");
+    w.sample("mc_products_total", {}, s.products);
+    w.family("mc_rejects_total", "Scans that failed at least one test", "counter");
+    w.sample("mc_rejects_total", {}, s.rejects);
+
+    w.family("mc_scans_total", "Scans stored per communication port", "counter");
+    for (const auto& p : s.ports) w.sample("mc_scans_total", {{"port", p.name}}, p.scans);
+    w.family("mc_scan_rejects_total", "Rejected scans per communication port", "counter");
+    for (const auto& p : s.ports) w.sample("mc_scan_rejects_total", {{"port", p.name}}, p.rejects);
+
+    w.family("mc_test_results_total", "Test verdicts by test and result", "counter");
+    for (std::size_t t = 0; t < ProductionStats::kTestCount; ++t) {
+      const std::string test = ProductionStats::testName(t);
+      w.sample("mc_test_results_total", {{"test", test}, {"result", "pass"}}, s.tests[t].passed);
+      w.sample("mc_test_results_total", {{"test", test}, {"result", "fail"}}, s.tests[t].failed);
+    }
+  });
+
+  try {
+    auto settings = config_.getMetricsSettings();
+    if (!settings.value("enabled", false)) return;
+    MetricsHttpServer::Options options;
+    options.bindAddress = settings.value("bindAddress", options.bindAddress);
+    options.port = settings.value("port", options.port);
+    options.maxResponseBytes = settings.value("maxResponseBytes", options.maxResponseBytes);
+    metricsServer_ = std::make_unique<MetricsHttpServer>(metrics_, options);
+    if (!metricsServer_->start()) {
+      getLogger()->error("[{}] Metrics endpoint could not be started", FUNCTION_NAME);
+      metricsServer_.reset();
+    }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid metrics settings: {}", FUNCTION_NAME, e.what());
+    metricsServer_.reset();
+  }
+}
+
+// Open, reopen or close the duplicate detector from tests settings and apply to the core
+void Logic::refreshDuplicateCheck() {
+  if (!core_) return;
+  try {
+    auto tests = config_.getTestsSettings();
+    if (!tests.value("duplicateCheck", false)) {
+      core_->setDuplicateDetector(nullptr);
+      duplicates_.reset();
+      return;
+    }
+
+    DuplicateDetector::Options options;
+    options.directory = tests.value("duplicateDirectory", options.directory);
+    options.capacity = tests.value("duplicateCapacity", options.capacity);
+    options.startIndex = tests.value("duplicateStartIndex", options.startIndex);
+    options.length = tests.value("duplicateLength", options.length);
+    if (duplicates_) {
+      const auto& current = duplicates_->options();
+      if (current.directory == options.directory && current.capacity == options.capacity &&
+          current.startIndex == options.startIndex && current.length == options.length) {
+        return;
+      }
+      if (current.startIndex != options.startIndex || current.length != options.length) {
+        getLogger()->warn("[{}] Duplicate key slice changed; codes stored earlier in this job used the old slice", FUNCTION_NAME);
+      }
+    }
+
+    core_->setDuplicateDetector(nullptr);
+    duplicates_.reset();
+    auto detector = std::make_unique<DuplicateDetector>();
+    if (!detector->open(options)) {
+      emit guiMessage(QString("Duplicate check could not open its store in '%1'")
+                          .arg(QString::fromStdString(options.directory)),
+                      "error");
+      return;
+    }
+    duplicates_ = std::move(detector);
+    duplicatesFullReported_ = false;
+    core_->setDuplicateDetector(duplicates_.get());
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid duplicate check settings: {}", FUNCTION_NAME, e.what());
+  }
+}
+
+// Compile tests.validators; a port with an invalid rule list is reported and left unchecked
+void Logic::refreshValidators() {
+  validators_.clear();
+  try {
+    auto rules = config_.getTestsSettings().value("validators", nlohmann::json::object());
+    for (const auto& [port, portRules] : rules.items()) {
+      ScanValidator validator;
+      std::string error;
+      if (!validator.compile(portRules, &error)) {
+        getLogger()->error("[{}] Invalid validators for {}: {}", FUNCTION_NAME, port, error);
+        emit guiMessage(QString("Format checks for %1 are disabled: %2")
+                            .arg(QString::fromStdString(port))
+                            .arg(QString::fromStdString(error)),
+                        "error");
+        continue;
+      }
+      if (!validator.empty()) validators_.emplace(port, std::move(validator));
+    }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid validators settings: {}", FUNCTION_NAME, e.what());
+  }
 }
 
-// Build/refresh the master file reference set from tests settings and apply to the core
-void Logic::refreshMasterFileReferenceSet() {
+// Compile the port formats and resolve tests.*Field against them; a test whose field is
+// missing keeps its startIndex/length slice
+void Logic::refreshFormats() {
+  if (core_) core_->setTestFields(TestFields{}); // before the patterns it points at go away
+  formats_.clear();
+  try {
+    for (const auto& [port, settings] : config_.getCommunicationSettings().items()) {
+      const std::string pattern = settings.is_object() ? settings.value("format", std::string()) : std::string();
+      if (pattern.empty()) continue;
+      PayloadPattern compiled;
+      std::string error;
+      if (!compiled.compile(pattern, &error)) {
+        getLogger()->error("[{}] Invalid format for {}: {}", FUNCTION_NAME, port, error);
+        emit guiMessage(QString("Format of %1 is invalid and not checked: %2")
+                            .arg(QString::fromStdString(port))
+                            .arg(QString::fromStdString(error)),
+                        "error");
+        continue;
+      }
+      getLogger()->debug("[{}] {} format compiled to {} states", FUNCTION_NAME, port, compiled.stateCount());
+      formats_.emplace(port, std::move(compiled));
+    }
+    if (!core_) return;
+
+    auto tests = config_.getTestsSettings();
+    TestFields fields;
+    auto master = formats_.find(tests.value("masterReader", std::string("communication1")));
+    auto reader = formats_.find(tests.value("reader2", std::string("communication2")));
+    fields.master = master != formats_.end() ? &master->second : nullptr;
+    fields.reader = reader != formats_.end() ? &reader->second : nullptr;
+
+    auto resolve = [&](const char* key, const PayloadPattern* pattern) {
+      const std::string name = tests.value(key, std::string());
+      if (name.empty()) return -1;
+      const int index = pattern ? pattern->fieldIndex(name) : -1;
+      if (index < 0) {
+        getLogger()->warn("[{}] tests.{} '{}' is not a field of the port format; using the slice", FUNCTION_NAME, key, name);
+        emit guiMessage(QString("Field '%1' (tests.%2) is not in the port format; the test uses its start index/length")
+                            .arg(QString::fromStdString(name))
+                            .arg(key),
+                        "warning");
+      }
+      return index;
+    };
+    fields.sequence = resolve("sequenceField", fields.master);
+    fields.inFile = resolve("fileField", fields.master);
+    fields.duplicate = resolve("duplicateField", fields.master);
+    fields.matchMaster = resolve("matchField", fields.master);
+    fields.matchReader = resolve("matchField", fields.reader);
+    core_->setTestFields(fields);
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid format settings: {}", FUNCTION_NAME, e.what());
+  }
+}
+
+// Build/refresh the master file reference index from tests settings and apply to the core
+void Logic::refreshMasterFileReference() {
   try {
     auto tests = config_.getTestsSettings();
     bool enabled = tests.value("masterInFileCheck", false);
     int startIndex = tests.value("fileStartIndex", 0);
     int length = tests.value("fileLength", 0);
+    // tests.filePath (single file, edited in the settings window) plus tests.filePaths
+    std::vector<std::string> paths;
     std::string path = tests.value("filePath", std::string(""));
+    if (!path.empty()) paths.push_back(path);
+    for (const auto& extra : tests.value("filePaths", nlohmann::json::array())) {
+      if (extra.is_string() && !extra.get<std::string>().empty()) paths.push_back(extra.get<std::string>());
+    }
 
     if (!core_) return;
 
     // Always push the latest flags to the core
     core_->setMasterInFileCheckEnabled(enabled);
+    core_->setMasterInFileSeenOnce(tests.value("fileSeenOnce", false));
     // If length <= 0, treat as to end-of-line by using a large sentinel
     core_->setMasterInFileExtraction(startIndex, (length > 0 ? length : 1000000));
 
     if (!enabled) {
       getLogger()->debug("[{}] Master-in-File check disabled; skipping file load", FUNCTION_NAME);
-      core_->setMasterFileReferenceSet({});
+      core_->setMasterFileReference(nullptr);
       return;
     }
 
-    if (path.empty()) {
+    if (paths.empty()) {
       getLogger()->warn("[{}] Master-in-File enabled but testsFilePath is empty", FUNCTION_NAME);
-      core_->setMasterFileReferenceSet({});
+      core_->setMasterFileReference(nullptr);
       return;
     }
 
-    std::ifstream f(path);
-    if (!f.is_open()) {
-      getLogger()->warn("[{}] Failed to open testsFilePath: {}", FUNCTION_NAME, path);
-      core_->setMasterFileReferenceSet({});
+    std::size_t entries = 0;
+    if (!loadMasterFileReference(paths, startIndex, length, std::string(), entries)) {
+      getLogger()->warn("[{}] Failed to load reference files", FUNCTION_NAME);
+      core_->setMasterFileReference(nullptr);
       return;
     }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Exception refreshing master file reference: {}", FUNCTION_NAME, e.what());
+  }
+}
 
-    std::unordered_set<std::string> refSet;
-    std::string line;
-    while (std::getline(f, line)) {
-      if (line.empty()) continue;
-      if (startIndex < 0) startIndex = 0;
-      if (static_cast<size_t>(startIndex) >= line.size()) continue;
-      size_t avail = line.size() - static_cast<size_t>(startIndex);
-      size_t take = (length > 0) ? static_cast<size_t>(length) : avail;
-      if (take > avail) take = avail;
-      std::string token = line.substr(static_cast<size_t>(startIndex), take);
-      if (!token.empty()) refSet.insert(std::move(token));
-    }
-
-    // Compose a small sample of entries for debugging
-    std::string sample;
-    int count = 0;
-    for (const auto& s : refSet) {
-      if (count++ >= 5) break;
-      if (!sample.empty()) sample += ", ";
-      // Truncate long tokens for log readability
-      if (s.size() > 32) sample += s.substr(0, 32) + "..."; else sample += s;
-    }
-    getLogger()->info("[{}] Master file reference set loaded: {} unique entries from '{}' | sample: [{}]",
-                      FUNCTION_NAME, refSet.size(), path, sample);
-    core_->setMasterFileReferenceSet(refSet);
+bool Logic::loadMasterFileReference(const std::vector<std::string>& paths, int startIndex, int length,
+                                    const std::string& match, std::size_t& entries) {
+  if (!core_) return false;
+
+  ReferenceIndex::Options options;
+  const std::string mode = match.empty() ? config_.getTestsSettings().value("fileMatch", std::string("exact")) : match;
+  if (!ReferenceIndex::parseMode(mode, options.mode)) {
+    getLogger()->error("[{}] Unknown reference match mode '{}' (exact, prefix, range or numeric)", FUNCTION_NAME, mode);
+    return false;
+  }
+  options.startIndex = std::max(0, startIndex);
+  options.length = length;
+
+  auto index = std::make_shared<ReferenceIndex>();
+  std::vector<ReferenceIndex::FileReport> reports;
+  const auto started = std::chrono::steady_clock::now();
+  const bool ok = index->load(paths, options, &reports);
+  const auto elapsedMs =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+  for (const auto& report : reports) {
+    if (report.ok) {
+      getLogger()->info("[{}] Reference file '{}': {} lines, {} entries, {} skipped", FUNCTION_NAME, report.path,
+                        report.lines, report.entries, report.skipped);
+    }
+  }
+  if (!ok) return false;
+
+  const auto memory = index->memory();
+  getLogger()->info("[{}] Master file reference loaded ({}{}): {} unique entries from {} file(s) in {} ms | "
+                    "{:.1f} MB (keys {:.1f}, offsets {:.1f}, index {:.1f}, ranges {:.1f}, numbers {:.1f}) | sample: [{}]",
+                    FUNCTION_NAME, ReferenceIndex::modeName(options.mode),
+                    index->numeric() && options.mode != ReferenceIndex::Mode::Numeric ? ", stored as numbers" : "",
+                    memory.entries, paths.size(), elapsedMs, memory.total() / 1e6, memory.keyBytes / 1e6,
+                    memory.offsetBytes / 1e6, memory.sparseBytes / 1e6, memory.rangeBytes / 1e6,
+                    memory.numericBytes / 1e6, index->sample(5));
+
+  entries = memory.entries;
+  core_->setMasterInFileExtraction(options.startIndex, (length > 0 ? length : 1000000));
+  core_->setMasterInFileCheckEnabled(true);
+  core_->setMasterFileReference(std::move(index));
+  return true;
+}
+
+void Logic::initSharedState() {
+  try {
+    auto settings = config_.getSharedStateSettings();
+    if (!settings.value("enabled", true)) return;
+    sharedState_ = std::make_unique<SharedStateWriter>(settings.value("name", std::string()));
+    if (!sharedState_->open()) {
+      getLogger()->error("[{}] Shared state segment could not be created", FUNCTION_NAME);
+      sharedState_.reset();
+    }
+  } catch (const std::exception& e) {
+    getLogger()->error("[{}] Invalid sharedState settings: {}", FUNCTION_NAME, e.what());
+    sharedState_.reset();
+  }
+}
+
+void Logic::initControlServer() {
+  try {
+    auto settings = config_.getApiSettings();
+    if (!settings.value("enabled", false)) return;
+    ControlServer::Options options;
+    options.bindAddress = settings.value("bindAddress", options.bindAddress);
+    options.port = settings.value("port", options.port);
+    const std::string framing = settings.value("framing", std::string("json-lines"));
+    if (!ApiFraming::parseMode(framing, options.framing)) {
+      getLogger()->warn("[{}] Unknown api framing '{}', using json-lines", FUNCTION_NAME, framing);
+    }
+    options.batchIntervalMs = settings.value("batchIntervalMs", options.batchIntervalMs);
+    options.maxClients = settings.value("maxClients", options.maxClients);
+    options.allowInjectScan = settings.value("allowInjectScan", options.allowInjectScan);
+    controlServer_ = std::make_unique<ControlServer>(eventQueue_, *stats_, options);
+    if (!controlServer_->start()) {
+      getLogger()->error("[{}] Control API could not be started", FUNCTION_NAME);
+      controlServer_.reset();
+    }
   } catch (const std::exception& e) {
-    getLogger()->error("[{}] Exception refreshing master file reference set: {}", FUNCTION_NAME, e.what());
+    getLogger()->error("[{}] Invalid api settings: {}", FUNCTION_NAME, e.what());
+    controlServer_.reset();
   }
 }
 
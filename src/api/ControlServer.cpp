@@ -0,0 +1,493 @@
+#include "utils/SocketCompat.h" // must precede headers that include windows.h
+#include "api/ControlServer.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int kReplyPollMs = 2;               // poll period while logic-thread replies are outstanding
+constexpr int kMaxInFlightPerClient = 256;    // forwarded requests waiting for the logic thread
+constexpr std::size_t kReadChunk = 16 * 1024;
+
+int sendFlags() {
+#ifdef MSG_NOSIGNAL
+    return MSG_NOSIGNAL; // a client that went away must not raise SIGPIPE
+#else
+    return 0;
+#endif
+}
+
+// Closes the socket when it goes out of scope
+struct ScopedSocket {
+    socket_t fd{kInvalidSocket};
+    ~ScopedSocket() {
+        if (fd != kInvalidSocket) closeSocket(fd);
+    }
+};
+
+std::int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+nlohmann::json latencyJson(const LatencyHistogram::Snapshot& s) {
+    return {{"count", s.count}, {"p50", s.percentile(0.50)}, {"p99", s.percentile(0.99)}, {"max", s.maxUs}};
+}
+
+nlohmann::json countersJson(const ProductionStats::Snapshot& s) {
+    nlohmann::json j;
+    j["timeMs"] = s.takenMs;
+    j["cycles"] = s.cycles;
+    j["scans"] = s.scans;
+    j["products"] = s.products;
+    j["rejects"] = s.rejects;
+    j["ports"] = nlohmann::json::array();
+    for (const auto& p : s.ports) {
+        j["ports"].push_back({{"name", p.name}, {"scans", p.scans}, {"rejects", p.rejects}});
+    }
+    j["tests"] = nlohmann::json::object();
+    for (std::size_t t = 0; t < ProductionStats::kTestCount; ++t) {
+        j["tests"][ProductionStats::testName(t)] = {{"passed", s.tests[t].passed}, {"failed", s.tests[t].failed}};
+    }
+    j["cycleTimeUs"] = latencyJson(s.cycleTime);
+    j["productIntervalUs"] = latencyJson(s.productInterval);
+    return j;
+}
+
+std::string okResponse(const nlohmann::json& id, const std::string& resultJson) {
+    return "{\"id\":" + id.dump() + ",\"ok\":true,\"result\":" + (resultJson.empty() ? "null" : resultJson) + "}";
+}
+
+std::string errorResponse(const nlohmann::json& id, const std::string& error) {
+    return nlohmann::json{{"id", id}, {"ok", false}, {"error", error}}.dump();
+}
+
+} // namespace
+
+struct ControlServer::Listener {
+    SocketRuntime runtime; // keeps Winsock initialized while the server socket lives
+    ScopedSocket socket;
+};
+
+struct ControlServer::Client {
+    explicit Client(ApiFraming::Mode mode) : decoder(mode) {}
+
+    std::uint64_t id{0};
+    ScopedSocket socket;
+    ApiFraming::Decoder decoder;
+    std::string out;            // framed bytes not yet sent, starting at outSent
+    std::size_t outSent{0};
+    bool subscribed{false};
+    bool closing{false};        // close once 'out' is flushed
+    bool closed{false};
+    int inFlight{0};
+    std::uint64_t droppedFrames{0};
+
+    std::size_t unsent() const { return out.size() - outSent; }
+};
+
+// Filled by the logic thread from ControlEvent::reply, drained by the server thread
+struct ControlServer::Replies {
+    struct Reply {
+        std::uint64_t seq;
+        bool ok;
+        std::string result;
+    };
+    std::mutex mutex;
+    std::vector<Reply> ready;
+};
+
+ControlServer::ControlServer(EventQueue<EventVariant>& eventQueue, const ProductionStats& stats, Options options)
+    : eventQueue_(eventQueue), stats_(stats), options_(std::move(options)), replies_(std::make_shared<Replies>()) {
+    if (options_.batchIntervalMs < 1) options_.batchIntervalMs = 1;
+    if (options_.maxClients < 1) options_.maxClients = 1;
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+bool ControlServer::start() {
+    if (thread_.joinable()) return true;
+
+    auto listener = std::make_unique<Listener>();
+    if (!listener->runtime.ok()) {
+        getLogger()->error("[ControlServer] Socket runtime initialization failed");
+        return false;
+    }
+
+    const std::string address = options_.bindAddress == "localhost" ? "127.0.0.1" : options_.bindAddress;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<unsigned short>(options_.port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        getLogger()->error("[ControlServer] Invalid bind address '{}'", options_.bindAddress);
+        return false;
+    }
+    if (!isLoopbackAddress(options_.bindAddress)) {
+        getLogger()->warn("[ControlServer] Binding to non-loopback address {}; the machine can be commanded from the network",
+                          options_.bindAddress);
+    }
+
+    listener->socket.fd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener->socket.fd == kInvalidSocket) {
+        getLogger()->error("[ControlServer] socket() failed (error {})", lastSocketError());
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listener->socket.fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (::bind(listener->socket.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener->socket.fd, 16) != 0) {
+        getLogger()->error("[ControlServer] Failed to listen on {}:{} (error {})",
+                           options_.bindAddress, options_.port, lastSocketError());
+        return false;
+    }
+    setNonBlocking(listener->socket.fd);
+
+    sockaddr_in bound{};
+    socklen_t boundLen = sizeof(bound);
+    if (getsockname(listener->socket.fd, reinterpret_cast<sockaddr*>(&bound), &boundLen) == 0) {
+        boundPort_ = ntohs(bound.sin_port);
+    }
+
+    listener_ = std::move(listener);
+    stopping_ = false;
+    thread_ = std::thread(&ControlServer::run, this);
+    getLogger()->info("[ControlServer] Control API on {}:{} ({} framing, results every {} ms)", options_.bindAddress,
+                      boundPort_, ApiFraming::modeName(options_.framing), options_.batchIntervalMs);
+    return true;
+}
+
+void ControlServer::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+    clients_.clear();
+    pendingRequests_.clear();
+    subscribers_ = 0;
+    listener_.reset();
+}
+
+void ControlServer::publishResults(const std::vector<ScanRecord>& scans, std::int64_t timeMs, const std::string& job) {
+    if (scans.empty() || subscribers_.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<std::mutex> lock(resultsMutex_);
+    for (const auto& scan : scans) {
+        if (pendingResults_.size() >= options_.maxPendingResults) {
+            ++droppedResults_;
+            continue;
+        }
+        pendingResults_.push_back(PendingResult{timeMs, job, scan});
+    }
+}
+
+void ControlServer::run() {
+    const auto batchInterval = std::chrono::milliseconds(options_.batchIntervalMs);
+    auto nextBatch = std::chrono::steady_clock::now() + batchInterval;
+    std::vector<pollfd> fds;
+
+    while (!stopping_) {
+        fds.clear();
+        pollfd listenFd{};
+        listenFd.fd = listener_->socket.fd;
+        listenFd.events = POLLIN;
+        fds.push_back(listenFd);
+        for (const auto& client : clients_) {
+            pollfd pfd{};
+            pfd.fd = client->socket.fd;
+            pfd.events = static_cast<short>((client->closing ? 0 : POLLIN) | (client->unsent() ? POLLOUT : 0));
+            fds.push_back(pfd);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        int timeoutMs = static_cast<int>(std::max<std::int64_t>(
+            0, std::chrono::duration_cast<std::chrono::milliseconds>(nextBatch - now).count()));
+        if (!pendingRequests_.empty()) timeoutMs = std::min(timeoutMs, kReplyPollMs);
+
+        if (pollSockets(fds.data(), fds.size(), timeoutMs) < 0) {
+            getLogger()->error("[ControlServer] poll failed (error {})", lastSocketError());
+            std::this_thread::sleep_for(std::chrono::milliseconds(kReplyPollMs));
+            continue;
+        }
+
+        // Clients accepted below are not in 'fds' yet; only walk the ones that were polled
+        const std::size_t polled = fds.size() - 1;
+        for (std::size_t i = 0; i < polled; ++i) {
+            Client& client = *clients_[i];
+            const short revents = fds[i + 1].revents;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                if (!readClient(client)) client.closed = true;
+            }
+        }
+        if (fds[0].revents & POLLIN) acceptClients();
+
+        deliverReplies();
+        expireRequests();
+        if (std::chrono::steady_clock::now() >= nextBatch) {
+            publishBatch();
+            nextBatch += batchInterval;
+            if (nextBatch < std::chrono::steady_clock::now()) nextBatch = std::chrono::steady_clock::now() + batchInterval;
+        }
+
+        // Write whatever is queued now rather than waiting one poll round for POLLOUT
+        for (auto& client : clients_) {
+            if (!client->closed && client->unsent() && !writeClient(*client)) client->closed = true;
+            if (client->closing && !client->unsent()) client->closed = true;
+        }
+
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [this](const std::unique_ptr<Client>& c) {
+            if (!c->closed) return false;
+            if (c->subscribed) --subscribers_;
+            getLogger()->debug("[ControlServer] Client {} disconnected", c->id);
+            return true;
+        }), clients_.end());
+    }
+}
+
+void ControlServer::acceptClients() {
+    while (true) {
+        ScopedSocket accepted;
+        accepted.fd = ::accept(listener_->socket.fd, nullptr, nullptr);
+        if (accepted.fd == kInvalidSocket) return;
+        if (static_cast<int>(clients_.size()) >= options_.maxClients) {
+            getLogger()->warn("[ControlServer] Refusing connection: {} clients already connected", clients_.size());
+            continue; // closed by ScopedSocket
+        }
+        setNonBlocking(accepted.fd);
+        int noDelay = 1;
+        setsockopt(accepted.fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        auto client = std::make_unique<Client>(options_.framing);
+        client->id = nextClientId_++;
+        client->socket.fd = accepted.fd;
+        accepted.fd = kInvalidSocket;
+        getLogger()->info("[ControlServer] Client {} connected", client->id);
+        clients_.push_back(std::move(client));
+    }
+}
+
+bool ControlServer::readClient(Client& client) {
+    if (client.closing) return true;
+    char buf[kReadChunk];
+    while (true) {
+        const int n = ::recv(client.socket.fd, buf, static_cast<int>(sizeof(buf)), 0);
+        if (n == 0) return false;
+        if (n < 0) {
+            if (isWouldBlock(lastSocketError())) break;
+            return false;
+        }
+        client.decoder.feed(buf, static_cast<std::size_t>(n));
+        if (static_cast<std::size_t>(n) < sizeof(buf)) break;
+    }
+
+    std::string frame;
+    while (!client.closing && client.decoder.next(frame)) {
+        if (frame.empty()) continue;
+        handleRequest(client, frame);
+    }
+    if (client.decoder.error()) {
+        getLogger()->warn("[ControlServer] Client {} sent an oversized frame; closing", client.id);
+        sendMessage(client, errorResponse(nullptr, "frame too large"));
+        client.closing = true;
+    }
+    return true;
+}
+
+bool ControlServer::writeClient(Client& client) {
+    while (client.unsent()) {
+        const int n = ::send(client.socket.fd, client.out.data() + client.outSent,
+                             static_cast<int>(client.unsent()), sendFlags());
+        if (n < 0) return isWouldBlock(lastSocketError());
+        client.outSent += static_cast<std::size_t>(n);
+    }
+    client.out.clear();
+    client.outSent = 0;
+    return true;
+}
+
+void ControlServer::sendMessage(Client& client, const std::string& json) {
+    // Responses are never dropped; a client that stops reading them altogether is disconnected
+    if (client.unsent() > 2 * options_.maxClientBufferBytes) {
+        getLogger()->warn("[ControlServer] Client {} is not reading responses; disconnecting", client.id);
+        client.closed = true;
+        return;
+    }
+    if (client.outSent > 0 && client.outSent >= client.out.size() / 2) {
+        client.out.erase(0, client.outSent);
+        client.outSent = 0;
+    }
+    ApiFraming::appendFrame(client.out, options_.framing, json);
+}
+
+ControlServer::Client* ControlServer::findClient(std::uint64_t clientId) {
+    for (auto& client : clients_) {
+        if (client->id == clientId && !client->closed) return client.get();
+    }
+    return nullptr;
+}
+
+void ControlServer::handleRequest(Client& client, const std::string& text) {
+    nlohmann::json request;
+    try {
+        request = nlohmann::json::parse(text);
+    } catch (const std::exception&) {
+        sendMessage(client, errorResponse(nullptr, "invalid JSON"));
+        return;
+    }
+    if (!request.is_object()) {
+        sendMessage(client, errorResponse(nullptr, "request must be a JSON object"));
+        return;
+    }
+    const nlohmann::json id = request.contains("id") ? request["id"] : nlohmann::json();
+
+    try {
+        const std::string cmd = request.value("cmd", std::string());
+        if (cmd == "ping") {
+            sendMessage(client, okResponse(id, nlohmann::json{{"timeMs", wallClockMs()}}.dump()));
+        } else if (cmd == "getCounters") {
+            sendMessage(client, okResponse(id, countersJson(stats_.snapshot()).dump()));
+        } else if (cmd == "subscribe") {
+            if (!client.subscribed) {
+                client.subscribed = true;
+                ++subscribers_;
+            }
+            sendMessage(client, okResponse(id, nlohmann::json{{"topics", {"results"}},
+                                                             {"batchIntervalMs", options_.batchIntervalMs}}.dump()));
+        } else if (cmd == "unsubscribe") {
+            if (client.subscribed) {
+                client.subscribed = false;
+                --subscribers_;
+            }
+            sendMessage(client, okResponse(id, "{}"));
+        } else if (cmd == "getState") {
+            forwardToLogic(client, id, GetStateCommand{});
+        } else if (cmd == "setJob") {
+            SetJobCommand command;
+            command.jobName = request.at("job").get<std::string>();
+            command.referenceFile = request.value("referenceFile", std::string());
+            forwardToLogic(client, id, command);
+        } else if (cmd == "loadReferenceFile") {
+            LoadReferenceFileCommand command;
+            // "path" for one file, "paths" to merge several
+            if (request.contains("paths")) command.paths = request.at("paths").get<std::vector<std::string>>();
+            else command.paths.push_back(request.at("path").get<std::string>());
+            command.startIndex = request.value("startIndex", 0);
+            command.length = request.value("length", 0);
+            command.match = request.value("match", std::string());
+            forwardToLogic(client, id, command);
+        } else if (cmd == "injectScan") {
+            if (!options_.allowInjectScan) {
+                sendMessage(client, errorResponse(id, "injectScan is disabled (api.allowInjectScan)"));
+                return;
+            }
+            InjectScanCommand command;
+            command.communicationName = request.at("port").get<std::string>();
+            command.message = request.at("message").get<std::string>();
+            forwardToLogic(client, id, command);
+        } else {
+            sendMessage(client, errorResponse(id, "unknown command '" + cmd + "'"));
+        }
+    } catch (const std::exception& e) {
+        // Missing or mistyped parameters
+        sendMessage(client, errorResponse(id, std::string("invalid parameters: ") + e.what()));
+    }
+}
+
+void ControlServer::forwardToLogic(Client& client, const nlohmann::json& id, ControlCommand command) {
+    if (client.inFlight >= kMaxInFlightPerClient) {
+        sendMessage(client, errorResponse(id, "too many requests in flight"));
+        return;
+    }
+    const std::uint64_t seq = nextRequestSeq_++;
+    pendingRequests_[seq] = PendingRequest{client.id, id,
+                                           std::chrono::steady_clock::now() +
+                                               std::chrono::milliseconds(options_.requestTimeoutMs)};
+    ++client.inFlight;
+
+    std::shared_ptr<Replies> replies = replies_;
+    ControlEvent event;
+    event.command = std::move(command);
+    event.reply = [replies, seq](bool ok, const std::string& result) {
+        std::lock_guard<std::mutex> lock(replies->mutex);
+        replies->ready.push_back(Replies::Reply{seq, ok, result});
+    };
+    eventQueue_.push(std::move(event));
+}
+
+void ControlServer::deliverReplies() {
+    std::vector<Replies::Reply> ready;
+    {
+        std::lock_guard<std::mutex> lock(replies_->mutex);
+        ready.swap(replies_->ready);
+    }
+    for (auto& reply : ready) {
+        auto it = pendingRequests_.find(reply.seq);
+        if (it == pendingRequests_.end()) continue; // already timed out
+        if (Client* client = findClient(it->second.clientId)) {
+            --client->inFlight;
+            sendMessage(*client, reply.ok ? okResponse(it->second.id, reply.result)
+                                          : errorResponse(it->second.id, reply.result));
+        }
+        pendingRequests_.erase(it);
+    }
+}
+
+void ControlServer::expireRequests() {
+    if (pendingRequests_.empty()) return;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = pendingRequests_.begin(); it != pendingRequests_.end();) {
+        if (it->second.deadline > now) {
+            ++it;
+            continue;
+        }
+        if (Client* client = findClient(it->second.clientId)) {
+            --client->inFlight;
+            sendMessage(*client, errorResponse(it->second.id, "timed out waiting for the logic thread"));
+        }
+        it = pendingRequests_.erase(it);
+    }
+}
+
+void ControlServer::publishBatch() {
+    std::vector<PendingResult> batch;
+    std::uint64_t overflow = 0;
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex_);
+        batch.swap(pendingResults_);
+        overflow = droppedResults_;
+        droppedResults_ = 0;
+    }
+    if (batch.empty() && overflow == 0) return;
+
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& r : batch) {
+        items.push_back({{"t", r.timeMs},
+                         {"job", r.job},
+                         {"port", r.scan.commName},
+                         {"cell", r.scan.cell},
+                         {"payload", r.scan.payload},
+                         {"verdict", r.scan.verdict},
+                         {"reject", (r.scan.verdict & kScanFailedMask) != 0},
+                         {"master", r.scan.fromMasterReader}});
+    }
+    nlohmann::json frame{{"type", "results"}, {"seq", ++batchSeq_}, {"items", std::move(items)}};
+    if (overflow) frame["overflow"] = overflow; // scans lost because no batch went out in time
+
+    // Serialize and frame once; every subscriber gets the same bytes
+    std::string encoded;
+    ApiFraming::appendFrame(encoded, options_.framing, frame.dump());
+    for (auto& client : clients_) {
+        if (!client->subscribed || client->closed) continue;
+        if (client->unsent() > options_.maxClientBufferBytes) {
+            ++client->droppedFrames;
+            continue;
+        }
+        if (client->droppedFrames) {
+            sendMessage(*client, nlohmann::json{{"type", "dropped"}, {"frames", client->droppedFrames}}.dump());
+            client->droppedFrames = 0;
+        }
+        if (client->outSent > 0 && client->outSent >= client->out.size() / 2) {
+            client->out.erase(0, client->outSent);
+            client->outSent = 0;
+        }
+        client->out += encoded;
+    }
+}
@@ -1,5 +1,14 @@
 #include "communication/ArduinoProtocol.h"
 #include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Encodings this PC build can speak, most efficient first
+const std::vector<std::string> kHostEncodings = {"json"};
+constexpr char kStx = 0x02;
+constexpr char kEtx = 0x03;
+}
 
 std::string ArduinoProtocol::createConfigMessage(double encoderResolution, int sensorOffset) {
     try {
@@ -49,10 +58,16 @@ std::string ArduinoProtocol::createControllerSetupMessage(const std::string& con
                                                         double startCurrent,
                                                         double startDurationMS,
                                                         double holdCurrent,
-                                                        const std::string& dotSize) {
+                                                        const std::string& dotSize,
+                                                        double valveOnDelayMs,
+                                                        double valveOffDelayMs,
+                                                        int schemaVersion) {
     try {
         nlohmann::json setupMsg;
         setupMsg["type"] = "controller_setup";
+        if (schemaVersion > 0) {
+            setupMsg["v"] = std::min(schemaVersion, kSchemaVersion);
+        }
         setupMsg["controllerType"] = controllerType;
         setupMsg["enabled"] = controllerEnabled;
         setupMsg["encoder"] = encoderResolution;
@@ -63,6 +78,8 @@ std::string ArduinoProtocol::createControllerSetupMessage(const std::string& con
         setupMsg["startDurationMS"] = startDurationMS;
         setupMsg["holdCurrent"] = holdCurrent;
         setupMsg["dotSize"] = dotSize;
+        setupMsg["valveOnDelayMs"] = valveOnDelayMs;
+        setupMsg["valveOffDelayMs"] = valveOffDelayMs;
         
         setupMsg["guns"] = nlohmann::json::array();
         
@@ -115,6 +132,134 @@ std::string ArduinoProtocol::createHeartbeatMessage() {
     }
 }
 
+std::string ArduinoProtocol::createHelloMessage() {
+    try {
+        nlohmann::json helloMsg;
+        helloMsg["type"] = "hello";
+        helloMsg["v"] = kSchemaVersion;
+        
+        return helloMsg.dump();
+    } catch (const std::exception& e) {
+        getLogger()->error("[ArduinoProtocol::createHelloMessage] Exception: {}", e.what());
+        return "";
+    }
+}
+
+bool ArduinoProtocol::parseCapabilities(const nlohmann::json& response, Capabilities& caps) {
+    try {
+        if (!response.is_object() || response.value("type", std::string()) != "capabilities") {
+            return false;
+        }
+        
+        Capabilities parsed;
+        parsed.legacy = false;
+        parsed.schemaVersion = response.value("v", 1);
+        parsed.firmwareVersion = response.value("fw", std::string("unknown"));
+        parsed.adcBits = response.value("adcBits", parsed.adcBits);
+        parsed.maxZones = response.value("maxZones", parsed.maxZones);
+        parsed.maxBaud = response.value("maxBaud", parsed.maxBaud);
+        parsed.rxBuffer = response.value("rxBuffer", parsed.rxBuffer);
+        if (response.contains("encodings") && response["encodings"].is_array()) {
+            parsed.encodings.clear();
+            for (const auto& e : response["encodings"]) {
+                if (e.is_string()) parsed.encodings.push_back(e.get<std::string>());
+            }
+            if (parsed.encodings.empty()) parsed.encodings.push_back("json");
+        }
+        
+        caps = parsed;
+        return true;
+    } catch (const std::exception& e) {
+        getLogger()->error("[ArduinoProtocol::parseCapabilities] Exception: {}", e.what());
+        return false;
+    }
+}
+
+std::string ArduinoProtocol::selectEncoding(const Capabilities& caps) {
+    for (const auto& enc : kHostEncodings) {
+        if (std::find(caps.encodings.begin(), caps.encodings.end(), enc) != caps.encodings.end()) {
+            return enc;
+        }
+    }
+    return "json";
+}
+
+int ArduinoProtocol::selectBaudRate(const Capabilities& caps, int hostMaxBaud) {
+    if (caps.legacy) {
+        return 115200; // legacy firmware is fixed at 115200
+    }
+    return std::max(9600, std::min(caps.maxBaud, hostMaxBaud));
+}
+
+std::string ArduinoProtocol::createSetBaudMessage(int baudRate) {
+    try {
+        nlohmann::json msg;
+        msg["type"] = "set_baud";
+        msg["v"] = kSchemaVersion;
+        msg["baud"] = baudRate;
+        
+        return msg.dump();
+    } catch (const std::exception& e) {
+        getLogger()->error("[ArduinoProtocol::createSetBaudMessage] Exception: {}", e.what());
+        return "";
+    }
+}
+
+std::string ArduinoProtocol::createBaudVerifyMessage(std::size_t payloadLength) {
+    try {
+        const std::size_t patternLength = std::strlen(kBaudVerifyPattern);
+        std::string payload;
+        payload.reserve(payloadLength);
+        for (std::size_t i = 0; i < payloadLength; ++i) {
+            payload.push_back(kBaudVerifyPattern[i % patternLength]);
+        }
+        
+        nlohmann::json msg;
+        msg["type"] = "baud_verify";
+        msg["pattern"] = payload;
+        
+        return msg.dump();
+    } catch (const std::exception& e) {
+        getLogger()->error("[ArduinoProtocol::createBaudVerifyMessage] Exception: {}", e.what());
+        return "";
+    }
+}
+
+std::string ArduinoProtocol::createBaudCommitMessage(int baudRate) {
+    try {
+        nlohmann::json msg;
+        msg["type"] = "baud_commit";
+        msg["baud"] = baudRate;
+        
+        return msg.dump();
+    } catch (const std::exception& e) {
+        getLogger()->error("[ArduinoProtocol::createBaudCommitMessage] Exception: {}", e.what());
+        return "";
+    }
+}
+
+bool ArduinoProtocol::isValidBaudVerifyPattern(const std::string& pattern, std::size_t expectedLength) {
+    if (pattern.size() != expectedLength) {
+        return false;
+    }
+    const std::size_t patternLength = std::strlen(kBaudVerifyPattern);
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] != kBaudVerifyPattern[i % patternLength]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string ArduinoProtocol::frame(const std::string& message) {
+    std::string framed;
+    framed.reserve(message.size() + 2);
+    framed.push_back(kStx);
+    framed.append(message);
+    framed.push_back(kEtx);
+    return framed;
+}
+
 std::string ArduinoProtocol::createTestMessage(int gunIndex, bool on) {
     try {
         nlohmann::json testMsg;
@@ -166,7 +311,7 @@ void ArduinoProtocol::sendMessage(EventQueue<EventVariant>& eventQueue,
         
         GuiEvent event;
         event.keyword = "SendCommunicationMessage";
-        event.data = message;
+        event.data = frame(message);
         event.target = communicationName;
         eventQueue.push(event);
         
@@ -344,6 +344,39 @@ bool RS232Communication::send(const std::string &message)
     return bytesWritten == message.size();
 }
 
+bool RS232Communication::setBaudRate(unsigned long baudRate)
+{
+    if (hSerial_ == INVALID_HANDLE_VALUE) {
+        getLogger()->error("[setBaudRate] Invalid serial handle for port {}", port_);
+        return false;
+    }
+    if (baudRate < 9600) {
+        getLogger()->warn("[setBaudRate] Baud rate ({}) is too low for port {}", baudRate, port_);
+        return false;
+    }
+
+    DCB dcbSerialParams = {0};
+    dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
+    if (!GetCommState(hSerial_, &dcbSerialParams)) {
+        getLogger()->error("[setBaudRate] GetCommState failed on port {}: {}", port_, GetLastError());
+        return false;
+    }
+    dcbSerialParams.BaudRate = baudRate;
+    if (!SetCommState(hSerial_, &dcbSerialParams)) {
+        getLogger()->error("[setBaudRate] SetCommState({}) failed on port {}: {}", baudRate, port_, GetLastError());
+        return false;
+    }
+
+    PurgeComm(hSerial_, PURGE_RXCLEAR | PURGE_TXCLEAR);
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        receiveBuffer_.clear();
+    }
+    baudRate_ = baudRate;
+    getLogger()->info("[setBaudRate] Port {} ({}) now at {} baud", port_, communicationName_, baudRate_);
+    return true;
+}
+
 void RS232Communication::close()
 {
     getLogger()->debug("[{}] RS232Communication close() started for '{}'", static_cast<void*>(this), communicationName_);
@@ -0,0 +1,120 @@
+#include "engine/EngineHost.h"
+#include "engine/EngineProtocol.h"
+#include "Logic.h"
+#include "Logger.h"
+#include <chrono>
+
+namespace {
+constexpr int kHeartbeatMs = 200;
+}
+
+EngineHost::EngineHost(Logic& logic, EventQueue<EventVariant>& eventQueue, Config& config, std::string channelName)
+    : logic_(logic), eventQueue_(eventQueue), config_(config), channel_(IpcChannel::Role::Engine, std::move(channelName)) {}
+
+EngineHost::~EngineHost() {
+    stop();
+}
+
+bool EngineHost::start() {
+    if (running_) return true;
+    if (!channel_.open()) return false;
+    connectSignals();
+    running_ = true;
+    thread_ = std::thread(&EngineHost::commandLoop, this);
+    getLogger()->info("[EngineHost] Waiting for a GUI to attach");
+    return true;
+}
+
+void EngineHost::stop() {
+    for (auto& connection : connections_) QObject::disconnect(connection);
+    connections_.clear();
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    channel_.close();
+}
+
+void EngineHost::connectSignals() {
+    // Lambdas without a context object are direct connections: they run on the emitting (logic) thread
+    connections_.push_back(QObject::connect(&logic_, &Logic::guiMessage, [this](const QString& text, const QString& id) {
+        post({{"t", "message"}, {"text", text.toStdString()}, {"id", id.toStdString()}});
+    }));
+    connections_.push_back(QObject::connect(&logic_, &Logic::inputStatesChanged,
+                                            [this](const std::unordered_map<std::string, IOChannel>& inputs) {
+        nlohmann::json states = nlohmann::json::object();
+        for (const auto& [name, channel] : inputs) states[name] = channel.state;
+        post({{"t", "inputs"}, {"states", std::move(states)}});
+    }));
+    connections_.push_back(QObject::connect(&logic_, &Logic::barcodeStoreUpdated,
+                                            [this](const QMap<QString, QStringList>& store) {
+        nlohmann::json ports = nlohmann::json::object();
+        for (auto it = store.cbegin(); it != store.cend(); ++it) {
+            nlohmann::json cells = nlohmann::json::array();
+            for (const auto& cell : it.value()) cells.push_back(cell.toStdString());
+            ports[it.key().toStdString()] = std::move(cells);
+        }
+        post({{"t", "barcodes"}, {"store", std::move(ports)}});
+    }));
+    connections_.push_back(QObject::connect(&logic_, &Logic::calibrationResponse,
+                                            [this](int pulsesPerPage, const std::string& controller) {
+        post({{"t", "calibration"}, {"pulsesPerPage", pulsesPerPage}, {"controller", controller}});
+    }));
+    connections_.push_back(QObject::connect(&logic_, &Logic::controllerCapabilitiesChanged,
+                                            [this](const std::string& commName, const ArduinoProtocol::Capabilities& caps) {
+        post({{"t", "capabilities"}, {"comm", commName}, {"caps", EngineProtocol::encodeCapabilities(caps)}});
+    }));
+    connections_.push_back(QObject::connect(&logic_, &Logic::ioCaptureReady, [this](const IOCapture::Result& result) {
+        post({{"t", "capture"}, {"result", IOCapture::encodeResult(result)}});
+    }));
+}
+
+void EngineHost::post(const nlohmann::json& message) {
+    const std::string text = message.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    if (dropped_ > 0 && channel_.send(nlohmann::json{{"t", "dropped"}, {"count", dropped_}}.dump())) {
+        dropped_ = 0;
+    }
+    if (!channel_.send(text)) ++dropped_;
+}
+
+void EngineHost::commandLoop() {
+    auto lastHeartbeat = std::chrono::steady_clock::time_point{};
+    std::string text;
+    while (running_) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastHeartbeat >= std::chrono::milliseconds(kHeartbeatMs)) {
+            channel_.heartbeat();
+            lastHeartbeat = now;
+        }
+        if (!channel_.receive(text, kHeartbeatMs / 2)) continue;
+        try {
+            handleCommand(nlohmann::json::parse(text));
+        } catch (const std::exception& e) {
+            getLogger()->warn("[EngineHost] Ignoring malformed GUI command: {}", e.what());
+        }
+    }
+}
+
+void EngineHost::handleCommand(const nlohmann::json& message) {
+    const std::string type = message.value("t", std::string());
+    if (type == "gui") {
+        GuiEvent event = EngineProtocol::decodeGuiEvent(message);
+        // The GUI edits and saves its own copy of the settings; adopt it before Logic re-reads them
+        if (event.keyword == "ParameterChange" && message.contains("config") && message["config"].is_object()) {
+            config_.replaceAll(message["config"]);
+        }
+        eventQueue_.push(std::move(event));
+    } else if (type == "ping") {
+        const auto id = message.value("id", std::uint64_t{0});
+        eventQueue_.push(ControlEvent{PingCommand{}, [this, id](bool, const std::string&) {
+            post({{"t", "pong"}, {"id", id}});
+        }});
+    } else if (type == "hello") {
+        getLogger()->info("[EngineHost] GUI attached");
+        GuiEvent resync;
+        resync.keyword = "ResyncGui";
+        eventQueue_.push(std::move(resync));
+    } else {
+        getLogger()->warn("[EngineHost] Unknown GUI command '{}'", type);
+    }
+}
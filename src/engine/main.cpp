@@ -0,0 +1,92 @@
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+
+#include "Logic.h"
+#include "Logger.h"
+#include "engine/EngineHost.h"
+#include "utils/CompilerMacros.h"
+#include <thread>
+
+// Machine engine without a GUI: Logic, IO and communication run here, a GUI
+// started with --attach connects over shared memory and may come and go
+// while the line keeps running.
+
+Logic* g_Logic = nullptr;
+
+BOOL WINAPI ConsoleHandler(DWORD signal) {
+    switch (signal) {
+        case CTRL_C_EVENT:
+        case CTRL_BREAK_EVENT:
+        case CTRL_CLOSE_EVENT:
+        case CTRL_SHUTDOWN_EVENT:
+            if (g_Logic) g_Logic->stop();
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+// Process priority class from engine.priority; the logic thread runs time-critical unless "normal"
+static bool applyProcessPriority(const std::string& priority) {
+    DWORD priorityClass = NORMAL_PRIORITY_CLASS;
+    if (priority == "high") {
+        priorityClass = HIGH_PRIORITY_CLASS;
+    } else if (priority == "realtime") {
+        priorityClass = REALTIME_PRIORITY_CLASS; // silently becomes HIGH without the privilege
+    } else if (priority != "normal") {
+        getLogger()->warn("[{}] Unknown engine priority '{}', using normal", FUNCTION_NAME, priority);
+        return false;
+    }
+    if (!SetPriorityClass(GetCurrentProcess(), priorityClass)) {
+        getLogger()->warn("[{}] SetPriorityClass failed (error {})", FUNCTION_NAME, GetLastError());
+        return false;
+    }
+    return priorityClass != NORMAL_PRIORITY_CLASS;
+}
+
+int main(int argc, char* argv[]) {
+    spdlog::set_level(spdlog::level::debug);
+    getLogger()->info("Engine starting...");
+
+    timeBeginPeriod(1);
+
+    Config config("config/settings.json");
+    const auto engineSettings = config.getEngineSettings();
+    const bool elevated = applyProcessPriority(engineSettings.value("priority", std::string("high")));
+
+    EventQueue<EventVariant> eventQueue;
+    Logic logic(eventQueue, config);
+    g_Logic = &logic;
+
+    EngineHost host(logic, eventQueue, config, engineSettings.value("ipcName", std::string(IpcChannel::kDefaultName)));
+    if (!host.start()) {
+        getLogger()->error("[{}] Cannot create the GUI channel; is another engine running?", FUNCTION_NAME);
+        g_Logic = nullptr;
+        timeEndPeriod(1);
+        return 1;
+    }
+
+    if (!SetConsoleCtrlHandler(ConsoleHandler, TRUE)) {
+        getLogger()->error("[{}] Could not set control handler", FUNCTION_NAME);
+    }
+
+    std::thread logicThread([&logic, elevated]() {
+        if (elevated && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+            getLogger()->warn("[{}] SetThreadPriority failed (error {})", FUNCTION_NAME, GetLastError());
+        }
+        logic.run();
+    });
+    getLogger()->info("Engine running; press Ctrl+C to stop");
+
+    if (logicThread.joinable())
+        logicThread.join();
+
+    // Logic's signals may still post to the channel until its thread has finished
+    host.stop();
+    g_Logic = nullptr;
+
+    timeEndPeriod(1);
+    getLogger()->info("Engine stopped");
+    return 0;
+}
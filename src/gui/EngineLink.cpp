@@ -0,0 +1,235 @@
+#include "gui/EngineLink.h"
+#include "engine/EngineProtocol.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+constexpr std::int64_t kEngineStaleMs = 2000; // engine heartbeats every 200 ms
+constexpr auto kAttachRetry = std::chrono::seconds(1);
+constexpr auto kPingTimeout = std::chrono::seconds(1);
+constexpr int kReceiveWaitMs = 100;
+
+std::int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+EngineLink::EngineLink(EventQueue<EventVariant>& eventQueue, const Config& config, QObject* parent)
+    : QObject(parent),
+      eventQueue_(eventQueue),
+      config_(config),
+      channel_(IpcChannel::Role::Gui,
+               config.getEngineSettings().value("ipcName", std::string(IpcChannel::kDefaultName))) {}
+
+EngineLink::~EngineLink() {
+    stop();
+}
+
+void EngineLink::start() {
+    if (running_) return;
+    running_ = true;
+    forwardThread_ = std::thread(&EngineLink::forwardLoop, this);
+    receiveThread_ = std::thread(&EngineLink::receiveLoop, this);
+}
+
+void EngineLink::stop() {
+    if (!running_) return;
+    running_ = false;
+    eventQueue_.push(TerminationEvent{});
+    if (forwardThread_.joinable()) forwardThread_.join();
+    if (receiveThread_.joinable()) receiveThread_.join();
+    std::lock_guard<std::mutex> lock(channelMutex_);
+    channel_.close();
+}
+
+void EngineLink::handleOutputOverrideStateChanged(bool enabled) {
+    GuiEvent event;
+    event.keyword = "OutputOverride";
+    event.intValue = enabled ? 1 : 0;
+    send(EngineProtocol::encodeGuiEvent(event));
+}
+
+void EngineLink::handleOutputStateChanged(const std::unordered_map<std::string, IOChannel>& outputs) {
+    nlohmann::json states = nlohmann::json::object();
+    for (const auto& [name, channel] : outputs) states[name] = channel.state;
+    GuiEvent event;
+    event.keyword = "OutputOverrideStates";
+    event.data = states.dump();
+    send(EngineProtocol::encodeGuiEvent(event));
+}
+
+bool EngineLink::send(const nlohmann::json& message) {
+    std::lock_guard<std::mutex> lock(channelMutex_);
+    return channel_.send(message.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+}
+
+void EngineLink::forwardLoop() {
+    EventVariant event;
+    while (true) {
+        eventQueue_.wait_and_pop(event);
+        if (std::holds_alternative<TerminationEvent>(event)) break;
+        const auto* guiEvent = std::get_if<GuiEvent>(&event);
+        if (!guiEvent) continue;
+
+        nlohmann::json message = EngineProtocol::encodeGuiEvent(*guiEvent);
+        if (guiEvent->keyword == "ParameterChange") {
+            // The engine has its own copy of the settings
+            message["config"] = config_.toJson();
+        }
+        if (!send(message)) {
+            getLogger()->warn("[EngineLink] Engine not attached, dropped GUI command '{}'", guiEvent->keyword);
+        }
+    }
+}
+
+bool EngineLink::attach() {
+    {
+        std::lock_guard<std::mutex> lock(channelMutex_);
+        if (!channel_.open()) return false;
+        // A segment left behind by an engine that is gone
+        if (wallClockMs() - channel_.engineHeartbeatMs() > kEngineStaleMs) {
+            channel_.close();
+            return false;
+        }
+    }
+    attachedStartMs_ = channel_.engineStartMs();
+    send({{"t", "hello"}});
+    getLogger()->info("[EngineLink] Attached to engine");
+    emit guiMessage(engineLost_ ? "Reattached to engine" : "Attached to engine", "info");
+    engineLost_ = false;
+    measureRoundTrip(config_.getEngineSettings().value("rttSamples", 200));
+    return true;
+}
+
+void EngineLink::receiveLoop() {
+    auto lastAttempt = std::chrono::steady_clock::time_point{};
+    bool reportedWaiting = false;
+    std::string text;
+    while (running_) {
+        if (!channel_.isOpen()) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastAttempt < kAttachRetry) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(kReceiveWaitMs));
+                continue;
+            }
+            lastAttempt = now;
+            if (!attach()) {
+                if (!reportedWaiting && !engineLost_) {
+                    emit guiMessage("Engine is not running; waiting for it to start", "warning");
+                    reportedWaiting = true;
+                }
+                continue;
+            }
+            reportedWaiting = false;
+        }
+
+        if (channel_.receive(text, kReceiveWaitMs)) {
+            try {
+                dispatch(nlohmann::json::parse(text));
+            } catch (const std::exception& e) {
+                getLogger()->warn("[EngineLink] Ignoring malformed engine message: {}", e.what());
+            }
+        }
+
+        if (wallClockMs() - channel_.engineHeartbeatMs() > kEngineStaleMs) {
+            getLogger()->error("[EngineLink] Engine heartbeat lost");
+            emit guiMessage("Engine not responding; reconnecting", "error");
+            engineLost_ = true;
+            std::lock_guard<std::mutex> lock(channelMutex_);
+            channel_.close();
+        } else if (channel_.engineStartMs() != attachedStartMs_) {
+            // Engine restarted under our mapping: it has fresh rings and no GUI state
+            attachedStartMs_ = channel_.engineStartMs();
+            send({{"t", "hello"}});
+            emit guiMessage("Engine restarted", "warning");
+        }
+    }
+}
+
+void EngineLink::measureRoundTrip(int samples) {
+    if (samples <= 0) return;
+    std::vector<double> roundTripsUs;
+    roundTripsUs.reserve(static_cast<std::size_t>(samples));
+    std::string text;
+    for (int i = 0; i < samples && running_; ++i) {
+        const std::uint64_t id = nextPingId_++;
+        const auto sent = std::chrono::steady_clock::now();
+        if (!send({{"t", "ping"}, {"id", id}})) break;
+        bool answered = false;
+        while (!answered && std::chrono::steady_clock::now() - sent < kPingTimeout) {
+            if (!channel_.receive(text, kReceiveWaitMs)) continue;
+            try {
+                const auto message = nlohmann::json::parse(text);
+                if (message.value("t", std::string()) == "pong" && message.value("id", std::uint64_t{0}) == id) {
+                    roundTripsUs.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - sent).count());
+                    answered = true;
+                } else {
+                    dispatch(message);
+                }
+            } catch (const std::exception&) {
+            }
+        }
+        if (!answered) break;
+    }
+    if (roundTripsUs.empty()) {
+        getLogger()->warn("[EngineLink] Engine did not answer round trip pings");
+        return;
+    }
+
+    std::sort(roundTripsUs.begin(), roundTripsUs.end());
+    const std::size_t n = roundTripsUs.size();
+    const double p50 = roundTripsUs[n / 2];
+    const double p99 = roundTripsUs[std::min(n - 1, n * 99 / 100)];
+    const double max = roundTripsUs.back();
+    getLogger()->info("[EngineLink] Command round trip over {} pings: p50 {:.0f} us, p99 {:.0f} us, max {:.0f} us",
+                      n, p50, p99, max);
+    emit guiMessage(QString("Engine command round trip: p50 %1 us, p99 %2 us, max %3 us (%4 pings)")
+                        .arg(p50, 0, 'f', 0)
+                        .arg(p99, 0, 'f', 0)
+                        .arg(max, 0, 'f', 0)
+                        .arg(static_cast<qulonglong>(n)),
+                    "info");
+}
+
+void EngineLink::dispatch(const nlohmann::json& message) {
+    const std::string type = message.value("t", std::string());
+    if (type == "message") {
+        emit guiMessage(QString::fromStdString(message.value("text", std::string())),
+                        QString::fromStdString(message.value("id", std::string())));
+    } else if (type == "inputs") {
+        std::unordered_map<std::string, IOChannel> inputs;
+        for (const auto& [name, state] : message.value("states", nlohmann::json::object()).items()) {
+            IOChannel channel{};
+            channel.name = name;
+            channel.type = IOType::Input;
+            channel.state = state.get<int>();
+            channel.eventType = IOEventType::None;
+            inputs[name] = channel;
+        }
+        emit inputStatesChanged(inputs);
+    } else if (type == "barcodes") {
+        QMap<QString, QStringList> store;
+        for (const auto& [port, cells] : message.value("store", nlohmann::json::object()).items()) {
+            QStringList list;
+            list.reserve(static_cast<int>(cells.size()));
+            for (const auto& cell : cells) list.push_back(QString::fromStdString(cell.get<std::string>()));
+            store.insert(QString::fromStdString(port), list);
+        }
+        emit barcodeStoreUpdated(store);
+    } else if (type == "calibration") {
+        emit calibrationResponse(message.value("pulsesPerPage", 0), message.value("controller", std::string()));
+    } else if (type == "capabilities") {
+        emit controllerCapabilitiesChanged(message.value("comm", std::string()),
+                                           EngineProtocol::decodeCapabilities(message.value("caps", nlohmann::json::object())));
+    } else if (type == "capture") {
+        emit ioCaptureReady(IOCapture::decodeResult(message.value("result", nlohmann::json::object())));
+    } else if (type == "dropped") {
+        emit guiMessage(QString("%1 engine updates were dropped while the GUI was not reading")
+                            .arg(static_cast<qulonglong>(message.value("count", std::uint64_t{0}))),
+                        "warning");
+    }
+}
@@ -0,0 +1,93 @@
+#include "gui/HistorySearchDialog.h"
+#include "history/ScanHistory.h"
+#include "Logger.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+constexpr std::size_t kMaxHits = 1000;
+
+QString verdictText(std::uint32_t verdict, std::uint32_t checked, std::uint32_t failed) {
+    if (!(verdict & checked)) return "-";
+    return (verdict & failed) ? "FAIL" : "OK";
+}
+}
+
+HistorySearchDialog::HistorySearchDialog(QWidget* parent, ScanHistory* history)
+    : QDialog(parent), history_(history) {
+    setWindowTitle("Scan History");
+    resize(700, 450);
+
+    auto* layout = new QVBoxLayout(this);
+
+    auto* searchLayout = new QHBoxLayout();
+    searchLayout->addWidget(new QLabel("Barcode:", this));
+    barcodeEdit_ = new QLineEdit(this);
+    barcodeEdit_->setPlaceholderText("Exact scanned text");
+    searchLayout->addWidget(barcodeEdit_);
+    searchButton_ = new QPushButton("Search", this);
+    searchButton_->setDefault(true);
+    searchLayout->addWidget(searchButton_);
+    layout->addLayout(searchLayout);
+
+    resultTable_ = new QTableWidget(0, 8, this);
+    resultTable_->setHorizontalHeaderLabels({"Time", "Port", "Cell", "Sequence", "In File", "Match", "Duplicate", "Format"});
+    resultTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    resultTable_->verticalHeader()->setVisible(false);
+    resultTable_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    layout->addWidget(resultTable_);
+
+    statusLabel_ = new QLabel(this);
+    layout->addWidget(statusLabel_);
+
+    if (!history_) {
+        barcodeEdit_->setEnabled(false);
+        searchButton_->setEnabled(false);
+        statusLabel_->setText("Scan history is disabled in settings (history.enabled).");
+    }
+
+    connect(searchButton_, &QPushButton::clicked, this, &HistorySearchDialog::onSearch);
+    connect(barcodeEdit_, &QLineEdit::returnPressed, this, &HistorySearchDialog::onSearch);
+}
+
+void HistorySearchDialog::onSearch() {
+    if (!history_) return;
+    const std::string barcode = barcodeEdit_->text().toStdString();
+    if (barcode.empty()) return;
+
+    try {
+        QElapsedTimer timer;
+        timer.start();
+        const auto hits = history_->findPayload(barcode, kMaxHits);
+        const qint64 elapsedMs = timer.elapsed();
+
+        resultTable_->setRowCount(static_cast<int>(hits.size()));
+        for (int row = 0; row < static_cast<int>(hits.size()); ++row) {
+            const auto& hit = hits[static_cast<std::size_t>(row)];
+            const QString time = QDateTime::fromMSecsSinceEpoch(hit.timeMs).toString("yyyy-MM-dd HH:mm:ss.zzz");
+            resultTable_->setItem(row, 0, new QTableWidgetItem(time));
+            resultTable_->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(hit.commName)));
+            resultTable_->setItem(row, 2, new QTableWidgetItem(QString::number(hit.cell)));
+            resultTable_->setItem(row, 3, new QTableWidgetItem(verdictText(hit.verdict, ScanSequenceChecked, ScanSequenceFailed)));
+            resultTable_->setItem(row, 4, new QTableWidgetItem(verdictText(hit.verdict, ScanInFileChecked, ScanInFileFailed)));
+            resultTable_->setItem(row, 5, new QTableWidgetItem(verdictText(hit.verdict, ScanMatchChecked, ScanMatchFailed)));
+            resultTable_->setItem(row, 6, new QTableWidgetItem(verdictText(hit.verdict, ScanDuplicateChecked, ScanDuplicateFailed)));
+            resultTable_->setItem(row, 7, new QTableWidgetItem(verdictText(hit.verdict, ScanFormatChecked, ScanFormatFailed)));
+        }
+
+        QString status = QString("%1 scan(s) found in %2 ms").arg(hits.size()).arg(elapsedMs);
+        if (hits.size() >= kMaxHits) status += QString(" (showing newest %1)").arg(kMaxHits);
+        statusLabel_->setText(status);
+    } catch (const std::exception& e) {
+        getLogger()->error("[HistorySearchDialog] Search failed: {}", e.what());
+        statusLabel_->setText("Search failed; see log.");
+    }
+}
@@ -0,0 +1,355 @@
+#include "gui/IOCaptureDialog.h"
+#include "json.hpp"
+#include <QComboBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QVBoxLayout>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int kRowHeight = 26;
+constexpr int kAxisHeight = 22;
+constexpr int kLabelWidth = 130;
+
+QString formatDuration(double ns) {
+    const double magnitude = std::fabs(ns);
+    if (magnitude >= 1e9) return QString::number(ns / 1e9, 'f', 3) + " s";
+    if (magnitude >= 1e6) return QString::number(ns / 1e6, 'f', 3) + " ms";
+    if (magnitude >= 1e3) return QString::number(ns / 1e3, 'f', 1) + " us";
+    return QString::number(ns, 'f', 0) + " ns";
+}
+
+// Smallest 1-2-5 step that is at least 'minimum'
+double niceStep(double minimum) {
+    double step = std::pow(10.0, std::floor(std::log10(std::max(minimum, 1.0))));
+    for (double factor : {1.0, 2.0, 5.0, 10.0}) {
+        if (step * factor >= minimum) return step * factor;
+    }
+    return step * 10.0;
+}
+}
+
+WaveformView::WaveformView(QWidget* parent) : QWidget(parent) {
+    setMinimumHeight(kAxisHeight + 4 * kRowHeight);
+    setMouseTracking(false);
+    setBackgroundRole(QPalette::Base);
+    setAutoFillBackground(true);
+}
+
+void WaveformView::setResult(const IOCapture::Result& result) {
+    rows_.clear();
+    cursorA_ = kNoCursor;
+    cursorB_ = kNoCursor;
+    firstNs_ = result.startNs - result.triggerNs;
+    lastNs_ = result.endNs - result.triggerNs;
+
+    for (std::size_t bit = 0; bit < result.channels.size() && bit < 32; ++bit) {
+        if (result.channels[bit].empty()) continue;
+        const std::uint32_t mask = std::uint32_t(1) << bit;
+        Row row;
+        row.name = QString::fromStdString(result.channels[bit]);
+        if (!result.transitions.empty()) {
+            bool level = (result.transitions.front().word & mask) != 0;
+            row.initial = level;
+            for (std::size_t i = 1; i < result.transitions.size(); ++i) {
+                const bool next = (result.transitions[i].word & mask) != 0;
+                if (next == level) continue;
+                row.edges.push_back(result.transitions[i].timeNs - result.triggerNs);
+                level = next;
+            }
+        }
+        rows_.push_back(std::move(row));
+    }
+    setMinimumHeight(kAxisHeight + std::max<int>(4, static_cast<int>(rows_.size())) * kRowHeight);
+    fitAll();
+    emit cursorsMoved();
+}
+
+int WaveformView::plotLeft() const {
+    return kLabelWidth;
+}
+
+double WaveformView::toX(std::int64_t timeNs) const {
+    return plotLeft() + (static_cast<double>(timeNs) - viewStartNs_) / nsPerPixel_;
+}
+
+std::int64_t WaveformView::toTime(double x) const {
+    return static_cast<std::int64_t>(std::llround(viewStartNs_ + (x - plotLeft()) * nsPerPixel_));
+}
+
+void WaveformView::fitAll() {
+    const int width = std::max(1, this->width() - plotLeft() - 4);
+    viewStartNs_ = static_cast<double>(firstNs_);
+    nsPerPixel_ = std::max(1e-3, static_cast<double>(lastNs_ - firstNs_) / width);
+    update();
+}
+
+void WaveformView::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+    const int left = plotLeft();
+    const int right = width() - 1;
+    const QColor gridColor = palette().color(QPalette::Mid);
+    const QColor traceColor(0, 140, 60);
+
+    if (rows_.empty()) {
+        painter.drawText(rect(), Qt::AlignCenter, "No capture yet");
+        return;
+    }
+
+    // Time axis and grid, 0 = trigger
+    const double step = niceStep(nsPerPixel_ * 90.0);
+    painter.setPen(gridColor);
+    for (double t = std::ceil(viewStartNs_ / step) * step; toX(static_cast<std::int64_t>(t)) <= right; t += step) {
+        const int x = static_cast<int>(toX(static_cast<std::int64_t>(t)));
+        painter.drawLine(x, kAxisHeight - 4, x, height());
+        painter.drawText(x + 3, kAxisHeight - 8, formatDuration(t));
+    }
+
+    painter.setClipRect(0, kAxisHeight, width(), height() - kAxisHeight);
+    const std::int64_t viewEnd = toTime(right + 1);
+    for (std::size_t index = 0; index < rows_.size(); ++index) {
+        const Row& row = rows_[index];
+        const int top = kAxisHeight + static_cast<int>(index) * kRowHeight;
+        const int high = top + 5;
+        const int low = top + kRowHeight - 5;
+
+        painter.setClipping(false);
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(QRect(4, top, left - 8, kRowHeight), Qt::AlignVCenter | Qt::AlignLeft, row.name);
+        painter.setClipRect(left, kAxisHeight, right - left + 1, height() - kAxisHeight);
+        painter.setPen(QPen(traceColor, 1.5));
+
+        // Level at the left edge, then one step per pixel column that has edges:
+        // a single edge is drawn as a step, several as a full-height bar
+        const std::int64_t captureStart = std::max<std::int64_t>(firstNs_, toTime(left));
+        auto it = std::upper_bound(row.edges.begin(), row.edges.end(), captureStart);
+        bool level = row.initial ^ ((it - row.edges.begin()) & 1);
+        double x = std::max<double>(left, toX(firstNs_));
+        const double captureEndX = std::min<double>(right, toX(lastNs_));
+        while (it != row.edges.end() && *it <= viewEnd) {
+            const double edgeX = std::floor(toX(*it));
+            auto columnEnd = std::lower_bound(it, row.edges.end(), toTime(edgeX + 1));
+            if (columnEnd == it) ++columnEnd;  // rounding at the column boundary
+            const auto count = columnEnd - it;
+            painter.drawLine(QPointF(x, level ? high : low), QPointF(edgeX, level ? high : low));
+            if (count > 1) {
+                painter.fillRect(QRectF(edgeX, high, 1.0, low - high), traceColor);
+            } else {
+                painter.drawLine(QPointF(edgeX, high), QPointF(edgeX, low));
+            }
+            level ^= (count & 1) != 0;
+            x = edgeX + (count > 1 ? 1.0 : 0.0);
+            it = columnEnd;
+        }
+        if (captureEndX > x) painter.drawLine(QPointF(x, level ? high : low), QPointF(captureEndX, level ? high : low));
+
+        painter.setPen(gridColor);
+        painter.drawLine(left, top + kRowHeight - 1, right, top + kRowHeight - 1);
+    }
+
+    // Trigger and cursors
+    painter.setClipRect(left, 0, right - left + 1, height());
+    painter.setPen(QPen(Qt::red, 1, Qt::DashLine));
+    painter.drawLine(QPointF(toX(0), 0), QPointF(toX(0), height()));
+    const struct { std::int64_t time; const char* name; QColor color; } cursors[] = {
+        {cursorA_, "A", QColor(0, 90, 220)}, {cursorB_, "B", QColor(200, 120, 0)}};
+    for (const auto& cursor : cursors) {
+        if (cursor.time == kNoCursor) continue;
+        const double cx = toX(cursor.time);
+        painter.setPen(QPen(cursor.color, 1));
+        painter.drawLine(QPointF(cx, 0), QPointF(cx, height()));
+        painter.drawText(QPointF(cx + 3, 12), cursor.name);
+    }
+}
+
+void WaveformView::wheelEvent(QWheelEvent* event) {
+    const double x = event->position().x();
+    const double anchor = viewStartNs_ + (x - plotLeft()) * nsPerPixel_;
+    const double factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    nsPerPixel_ = std::clamp(nsPerPixel_ * factor, 1e-3, 1e12);
+    viewStartNs_ = anchor - (x - plotLeft()) * nsPerPixel_;
+    update();
+    event->accept();
+}
+
+void WaveformView::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::RightButton) {
+        cursorB_ = toTime(event->position().x());
+        update();
+        emit cursorsMoved();
+        return;
+    }
+    pressPos_ = event->pos();
+    pressViewStart_ = viewStartNs_;
+    dragging_ = false;
+}
+
+void WaveformView::mouseMoveEvent(QMouseEvent* event) {
+    if (!(event->buttons() & Qt::LeftButton)) return;
+    const int dx = event->pos().x() - pressPos_.x();
+    if (!dragging_ && std::abs(dx) < 4) return;
+    dragging_ = true;
+    viewStartNs_ = pressViewStart_ - dx * nsPerPixel_;
+    update();
+}
+
+void WaveformView::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) return;
+    if (!dragging_ && event->pos().x() >= plotLeft()) {
+        cursorA_ = toTime(event->position().x());
+        update();
+        emit cursorsMoved();
+    }
+    dragging_ = false;
+}
+
+void WaveformView::mouseDoubleClickEvent(QMouseEvent*) {
+    fitAll();
+}
+
+IOCaptureDialog::IOCaptureDialog(QWidget* parent, EventQueue<EventVariant>& eventQueue, const Config& config)
+    : QDialog(parent), eventQueue_(eventQueue) {
+    setWindowTitle("IO Capture");
+    resize(1000, 560);
+
+    QStringList names;
+    for (const auto& [name, channel] : config.getInputs()) names << QString::fromStdString(name);
+    for (const auto& [name, channel] : config.getOutputs()) names << QString::fromStdString(name);
+    names.sort();
+
+    const auto capture = config.getCaptureSettings();
+    const int maxSamples = std::max(1, capture.value("samples", 262144) - 1);
+
+    auto* layout = new QVBoxLayout(this);
+    auto* controls = new QHBoxLayout();
+    auto* form = new QFormLayout();
+
+    triggerCombo_ = new QComboBox(this);
+    triggerCombo_->addItems({"Edge", "Pattern", "Software"});
+    form->addRow("Trigger:", triggerCombo_);
+
+    auto* edgeLayout = new QHBoxLayout();
+    channelCombo_ = new QComboBox(this);
+    channelCombo_->addItems(names);
+    edgeCombo_ = new QComboBox(this);
+    edgeCombo_->addItems({"Rising", "Falling", "Any"});
+    edgeLayout->addWidget(channelCombo_);
+    edgeLayout->addWidget(edgeCombo_);
+    form->addRow("Edge:", edgeLayout);
+
+    patternEdit_ = new QLineEdit(this);
+    patternEdit_->setPlaceholderText("e.g. Sensor1=1 Sensor2=0");
+    form->addRow("Pattern:", patternEdit_);
+    controls->addLayout(form);
+
+    auto* depthForm = new QFormLayout();
+    preSpin_ = new QSpinBox(this);
+    preSpin_->setRange(0, maxSamples);
+    preSpin_->setValue(capture.value("pre", 1000));
+    preSpin_->setSuffix(" samples");
+    depthForm->addRow("Pre-trigger:", preSpin_);
+    postSpin_ = new QSpinBox(this);
+    postSpin_->setRange(0, maxSamples);
+    postSpin_->setValue(capture.value("post", 10000));
+    postSpin_->setSuffix(" samples");
+    depthForm->addRow("Post-trigger:", postSpin_);
+    controls->addLayout(depthForm);
+
+    auto* buttons = new QVBoxLayout();
+    armButton_ = new QPushButton("Arm", this);
+    armButton_->setDefault(true);
+    triggerButton_ = new QPushButton("Trigger now", this);
+    disarmButton_ = new QPushButton("Disarm", this);
+    buttons->addWidget(armButton_);
+    buttons->addWidget(triggerButton_);
+    buttons->addWidget(disarmButton_);
+    buttons->addStretch();
+    controls->addLayout(buttons);
+    controls->addStretch();
+    layout->addLayout(controls);
+
+    view_ = new WaveformView(this);
+    layout->addWidget(view_, 1);
+
+    statusLabel_ = new QLabel("Arm a trigger, then wait for it or press Trigger now. "
+                              "Wheel zooms, drag pans, click/right click place cursors A/B.", this);
+    statusLabel_->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(statusLabel_);
+
+    connect(triggerCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &IOCaptureDialog::onTriggerTypeChanged);
+    connect(armButton_, &QPushButton::clicked, this, &IOCaptureDialog::onArm);
+    connect(triggerButton_, &QPushButton::clicked, this, [this]() { send("trigger"); });
+    connect(disarmButton_, &QPushButton::clicked, this, [this]() { send("disarm"); });
+    connect(view_, &WaveformView::cursorsMoved, this, &IOCaptureDialog::updateStatus);
+    onTriggerTypeChanged(triggerCombo_->currentIndex());
+}
+
+void IOCaptureDialog::onTriggerTypeChanged(int index) {
+    channelCombo_->setEnabled(index == 0);
+    edgeCombo_->setEnabled(index == 0);
+    patternEdit_->setEnabled(index == 1);
+}
+
+void IOCaptureDialog::onArm() {
+    static const char* triggers[] = {"edge", "pattern", "software"};
+    static const char* edges[] = {"rising", "falling", "any"};
+    nlohmann::json settings = {{"trigger", triggers[triggerCombo_->currentIndex()]},
+                               {"pre", preSpin_->value()}, {"post", postSpin_->value()}};
+    if (triggerCombo_->currentIndex() == 0) {
+        settings["channel"] = channelCombo_->currentText().toStdString();
+        settings["edge"] = edges[edgeCombo_->currentIndex()];
+    } else if (triggerCombo_->currentIndex() == 1) {
+        nlohmann::json pattern = nlohmann::json::object();
+        for (const QString& term : patternEdit_->text().split(' ', Qt::SkipEmptyParts)) {
+            const QStringList parts = term.split('=');
+            if (parts.size() != 2) {
+                statusLabel_->setText(QString("Pattern terms are name=0 or name=1, not '%1'").arg(term));
+                return;
+            }
+            pattern[parts[0].trimmed().toStdString()] = parts[1].trimmed() == "1" ? 1 : 0;
+        }
+        settings["pattern"] = pattern;
+    }
+    send("arm", settings.dump());
+    statusLabel_->setText("Armed; waiting for the trigger...");
+}
+
+void IOCaptureDialog::send(const std::string& target, const std::string& data) {
+    GuiEvent event;
+    event.keyword = "IOCapture";
+    event.target = target;
+    event.data = data;
+    eventQueue_.push(event);
+}
+
+void IOCaptureDialog::setResult(const IOCapture::Result& result) {
+    view_->setResult(result);
+    summary_ = QString("Trigger: %1 | %2 samples over %3 | interval mean %4, max %5 | %6 transitions%7")
+                   .arg(QString::fromStdString(result.trigger))
+                   .arg(static_cast<qulonglong>(result.samples))
+                   .arg(formatDuration(static_cast<double>(result.endNs - result.startNs)))
+                   .arg(formatDuration(result.meanIntervalUs * 1e3))
+                   .arg(formatDuration(result.maxIntervalUs * 1e3))
+                   .arg(static_cast<qulonglong>(result.transitions.size()))
+                   .arg(result.truncated ? " (truncated)" : "");
+    updateStatus();
+}
+
+void IOCaptureDialog::updateStatus() {
+    QString text = summary_;
+    if (view_->hasCursors()) {
+        text += QString(" | A %1, B %2, B-A = %3")
+                    .arg(formatDuration(static_cast<double>(view_->cursorA())))
+                    .arg(formatDuration(static_cast<double>(view_->cursorB())))
+                    .arg(formatDuration(static_cast<double>(view_->cursorB() - view_->cursorA())));
+    }
+    if (!text.isEmpty()) statusLabel_->setText(text);
+}
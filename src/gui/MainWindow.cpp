@@ -1,10 +1,14 @@
 #include "gui/MainWindow.h"
 #include "ui_MainWindow.h"
 #include "gui/SettingsWindow.h"
+#include "gui/HistorySearchDialog.h"
+#include "gui/IOCaptureDialog.h"
 #include "Logger.h"
 #include "json.hpp"
 #include "communication/ArduinoProtocol.h"
+#include "machine/DataFileVerifier.h"
 #include <QFileDialog>
+#include <QProgressDialog>
 #include <QMessageBox>
 #include <QDateTime>
 #include <QTableWidget>
@@ -13,6 +17,8 @@
 #include <QHBoxLayout>
 #include <QWidget>
 #include <QLineEdit>
+#include <atomic>
+#include <thread>
 
 MainWindow::MainWindow(QWidget *parent, EventQueue<EventVariant>& eventQueue, const Config& config)
     : QMainWindow(parent),
@@ -282,7 +288,7 @@ void MainWindow::buildGlueTestTable() {
 
 void MainWindow::on_selectDataFileButton_clicked() {
     QString filePath = QFileDialog::getOpenFileName(this, "Select Data File", "", "Text Files (*.txt);;All Files (*)");
-    if (!filePath.isEmpty()) {
+    if (!filePath.isEmpty() && verifyDataFile(filePath)) {
         // Update label
         ui->dataFilePathLabel->setText(filePath);
 
@@ -317,6 +323,82 @@ void MainWindow::on_selectDataFileButton_clicked() {
     }
 }
 
+bool MainWindow::verifyDataFile(const QString& filePath) {
+    if (!config_) return true;
+    const nlohmann::json tests = config_->getTestsSettings();
+    if (!tests.value("verifyDataFile", true)) return true;
+
+    DataFileVerifier::Options options;
+    options.startIndex = tests.value("fileStartIndex", 0);
+    options.length = tests.value("fileLength", 0);
+    options.numeric = tests.value("fileMatch", std::string("exact")) == "numeric";
+    // A job checked for a master sequence expects its file in that sequence too
+    if (tests.value("masterSequenceEnabled", false)) {
+        options.sequence = tests.value("sequenceDirection", std::string("Ascending")) == "Descending"
+                               ? DataFileVerifier::Sequence::Descending
+                               : DataFileVerifier::Sequence::Ascending;
+    }
+
+    // Verify on worker threads; progress and completion come back as queued calls to the dialog
+    QProgressDialog progress("Verifying data file...", "Cancel", 0, 1000, this);
+    progress.setWindowTitle("Data File Check");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setAutoClose(false);
+    progress.setAutoReset(false);
+    progress.setMinimumDuration(0);
+    std::atomic<bool> cancel{false};
+    connect(&progress, &QProgressDialog::canceled, [&cancel] { cancel = true; });
+
+    DataFileVerifier::Report report;
+    const std::string path = filePath.toStdString();
+    std::thread worker([&] {
+        report = DataFileVerifier::verify(path, options, [&progress](const char* phase, double fraction) {
+            const QString label = QString("%1 data file... %2%").arg(phase).arg(static_cast<int>(fraction * 100));
+            const int value = static_cast<int>(fraction * 500) + (phase[0] == 'D' ? 500 : 0);
+            QMetaObject::invokeMethod(&progress, [&progress, label, value] {
+                progress.setLabelText(label);
+                progress.setValue(value);
+            }, Qt::QueuedConnection);
+        }, &cancel);
+        QMetaObject::invokeMethod(&progress, [&progress] { progress.done(QDialog::Accepted); }, Qt::QueuedConnection);
+    });
+    progress.exec();
+    worker.join();
+
+    const QString summary = QString::fromStdString(report.summary());
+    getLogger()->info("[MainWindow] Data file check of '{}': {}", path, report.summary());
+    if (!report.opened) {
+        addMessage(QString("Data file check: cannot open %1").arg(filePath), "error");
+        return false;
+    }
+    if (report.cancelled) {
+        addMessage(QString("Data file check cancelled; %1 selected unverified").arg(filePath), "warning");
+        return true;
+    }
+    if (report.ok()) {
+        addMessage(QString("Data file check: %1").arg(summary));
+        return true;
+    }
+
+    addMessage(QString("Data file check: %1").arg(summary), "warning");
+    QStringList details;
+    for (const auto& issue : report.examples) {
+        const QString line = QString("line %1, %2: %3")
+                                 .arg(static_cast<qulonglong>(issue.line))
+                                 .arg(DataFileVerifier::kindName(issue.kind))
+                                 .arg(QString::fromStdString(issue.text));
+        addMessage(line.toHtmlEscaped(), "warning");
+        getLogger()->warn("[MainWindow] Data file check: {}", line.toStdString());
+        details << line;
+    }
+    QMessageBox box(QMessageBox::Warning, "Data File Check",
+                    QString("%1\n\n%2\n\nUse this file anyway?").arg(filePath, summary),
+                    QMessageBox::Yes | QMessageBox::No, this);
+    box.setDetailedText(details.join("\n"));
+    box.setDefaultButton(QMessageBox::No);
+    return box.exec() == QMessageBox::Yes;
+}
+
 MainWindow::~MainWindow() {
     delete ui;
     delete settingsWindow_;
@@ -333,6 +415,34 @@ void MainWindow::on_clearMessageAreaButton_clicked() {
     ui->messageArea->clear();
 }
 
+void MainWindow::on_historySearchButton_clicked() {
+    // Created on first use; parented to the main window so Qt deletes it
+    if (!historySearchDialog_) {
+        historySearchDialog_ = new HistorySearchDialog(this, scanHistory_);
+    }
+    historySearchDialog_->show();
+    historySearchDialog_->raise();
+    historySearchDialog_->activateWindow();
+}
+
+void MainWindow::on_ioCaptureButton_clicked() {
+    if (!ioCaptureDialog_) {
+        ioCaptureDialog_ = new IOCaptureDialog(this, eventQueue_, *config_);
+    }
+    ioCaptureDialog_->show();
+    ioCaptureDialog_->raise();
+    ioCaptureDialog_->activateWindow();
+}
+
+void MainWindow::onIOCaptureReady(const IOCapture::Result& result) {
+    on_ioCaptureButton_clicked();
+    ioCaptureDialog_->setResult(result);
+    addMessage(QString("IO capture done: %1 samples, trigger %2")
+                   .arg(static_cast<qulonglong>(result.samples))
+                   .arg(QString::fromStdString(result.trigger)),
+               "info");
+}
+
 
 void MainWindow::on_testButton_clicked() {
     // Create a GuiEvent to toggle LED blinking
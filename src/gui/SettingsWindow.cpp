@@ -576,7 +576,7 @@ void SettingsWindow::fillCommunicationTabFields() {
     QComboBox* baudRateComboBox = commPage->findChild<QComboBox*>("baudRateComboBox");
     if (baudRateComboBox) {
         baudRateComboBox->clear();
-        baudRateComboBox->addItems({"9600", "19200", "38400", "57600", "115200"});
+        baudRateComboBox->addItems({"9600", "19200", "38400", "57600", "115200", "230400", "460800", "921600"});
     }
     
 
@@ -1650,6 +1650,19 @@ void SettingsWindow::onGlueControllerSelectorChanged(int index)
                 ui->glueDotSizeComboBox->setCurrentIndex(dotSizeIndex);
             }
             
+            // Set valve on/off delays (ms) used for speed compensation
+            double valveOnDelayMs = 0.0;
+            if (controller.contains("valveOnDelayMs") && controller["valveOnDelayMs"].is_number()) {
+                valveOnDelayMs = controller["valveOnDelayMs"].get<double>();
+            }
+            ui->glueValveOnDelaySpinBox->setValue(valveOnDelayMs);
+            
+            double valveOffDelayMs = 0.0;
+            if (controller.contains("valveOffDelayMs") && controller["valveOffDelayMs"].is_number()) {
+                valveOffDelayMs = controller["valveOffDelayMs"].get<double>();
+            }
+            ui->glueValveOffDelaySpinBox->setValue(valveOffDelayMs);
+            
             // Clear and populate plan selector
             ui->gluePlanSelectorComboBox->clear();
             
@@ -2192,6 +2205,8 @@ void SettingsWindow::on_addGlueControllerButton_clicked()
             {"startDurationMS", 0.5}, // Default start duration: 0.5ms
             {"holdCurrent", 0.5},   // Default hold current: 0.5A
             {"dotSize", "medium"},  // Default dot size: medium
+            {"valveOnDelayMs", 0.0},  // No valve delay compensation by default
+            {"valveOffDelayMs", 0.0},
             {"plans", nlohmann::json::object()}
         };
         
@@ -2810,6 +2825,54 @@ void SettingsWindow::on_glueHoldCurrentSpinBox_valueChanged(double value) {
     }
 }
 
+void SettingsWindow::on_glueValveOnDelaySpinBox_valueChanged(double value) {
+    if (isRefreshing_ || !config_ || currentGlueControllerName_.empty()) {
+        return;
+    }
+    
+    try {
+        nlohmann::json glueSettings = config_->getGlueSettings();
+        if (glueSettings.contains("controllers") && glueSettings["controllers"].contains(currentGlueControllerName_)) {
+            glueSettings["controllers"][currentGlueControllerName_]["valveOnDelayMs"] = value;
+            
+            Config* mutableConfig = const_cast<Config*>(config_);
+            mutableConfig->updateGlueSettings(glueSettings);
+            mutableConfig->saveToFile();
+            
+            getLogger()->debug("[on_glueValveOnDelaySpinBox_valueChanged] Updated valve on delay to {} ms for controller {}", 
+                             value, currentGlueControllerName_);
+            
+            sendControllerSetupToActiveController();
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("[on_glueValveOnDelaySpinBox_valueChanged] Error: {}", e.what());
+    }
+}
+
+void SettingsWindow::on_glueValveOffDelaySpinBox_valueChanged(double value) {
+    if (isRefreshing_ || !config_ || currentGlueControllerName_.empty()) {
+        return;
+    }
+    
+    try {
+        nlohmann::json glueSettings = config_->getGlueSettings();
+        if (glueSettings.contains("controllers") && glueSettings["controllers"].contains(currentGlueControllerName_)) {
+            glueSettings["controllers"][currentGlueControllerName_]["valveOffDelayMs"] = value;
+            
+            Config* mutableConfig = const_cast<Config*>(config_);
+            mutableConfig->updateGlueSettings(glueSettings);
+            mutableConfig->saveToFile();
+            
+            getLogger()->debug("[on_glueValveOffDelaySpinBox_valueChanged] Updated valve off delay to {} ms for controller {}", 
+                             value, currentGlueControllerName_);
+            
+            sendControllerSetupToActiveController();
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("[on_glueValveOffDelaySpinBox_valueChanged] Error: {}", e.what());
+    }
+}
+
 void SettingsWindow::on_glueDotSizeComboBox_currentIndexChanged(int index) {
     if (isRefreshing_ || !config_ || currentGlueControllerName_.empty()) {
         return;
@@ -2901,6 +2964,32 @@ void SettingsWindow::onGlueEncoderCalibrationResponse(int pulsesPerPage, const s
     }
 }
 
+// Store capabilities reported by a glue controller and resend its setup in the negotiated schema
+void SettingsWindow::onControllerCapabilities(const std::string& commName, const ArduinoProtocol::Capabilities& caps)
+{
+    controllerCaps_[commName] = caps;
+    getLogger()->info("[onControllerCapabilities] Controller on '{}' speaks schema v{} (firmware {})",
+                     commName, caps.schemaVersion, caps.firmwareVersion);
+    
+    if (!config_) {
+        return;
+    }
+    
+    try {
+        nlohmann::json glueSettings = config_->getGlueSettings();
+        if (!glueSettings.contains("controllers") || !glueSettings["controllers"].is_object()) {
+            return;
+        }
+        for (const auto& [controllerName, controller] : glueSettings["controllers"].items()) {
+            if (controller.value("communication", std::string()) == commName) {
+                sendControllerSetupToController(controllerName, controller);
+            }
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("[onControllerCapabilities] Exception: {}", e.what());
+    }
+}
+
 // Handle plan name text change
 void SettingsWindow::on_gluePlanNameLineEdit_textChanged(const QString& text)
 {
@@ -3672,6 +3761,17 @@ void SettingsWindow::saveCurrentCommunicationSettings() {
     // Get the current settings from the UI
     nlohmann::json commSettings;
     
+    // Keep link negotiation keys and the payload format, which have no widget on this page
+    nlohmann::json existingComm = config_ ? config_->getCommunicationSettings() : nlohmann::json::object();
+    if (existingComm.contains(currentCommunicationName_)) {
+        const auto& existing = existingComm[currentCommunicationName_];
+        for (const char* key : {"autoBaud", "maxBaudRate", "format"}) {
+            if (existing.contains(key)) {
+                commSettings[key] = existing[key];
+            }
+        }
+    }
+    
     // Get the communication type
     QComboBox* typeComboBox = currentPage->findChild<QComboBox*>("communicationTypeComboBox");
     if (typeComboBox) {
@@ -4221,11 +4321,27 @@ void SettingsWindow::sendControllerSetupToController(const std::string& controll
         double startDurationMS = controller.value("startDurationMS", 0.5);
         double holdCurrent = controller.value("holdCurrent", 0.5);
         std::string dotSize = controller.value("dotSize", "small");
+        double valveOnDelayMs = controller.value("valveOnDelayMs", 0.0);
+        double valveOffDelayMs = controller.value("valveOffDelayMs", 0.0);
+        
+        // Use the schema the controller reported; unknown controllers get the legacy layout
+        ArduinoProtocol::Capabilities caps;
+        auto capsIt = controllerCaps_.find(communicationPort);
+        if (capsIt != controllerCaps_.end()) {
+            caps = capsIt->second;
+        }
+        for (size_t i = 0; i < guns.size(); ++i) {
+            if (static_cast<int>(guns[i].second.size()) > caps.maxZones) {
+                getLogger()->warn("[sendControllerSetupToController] Gun {} of '{}' has {} rows, controller keeps at most {}",
+                                 i + 1, controllerName, guns[i].second.size(), caps.maxZones);
+            }
+        }
         
         // Create and send comprehensive controller setup message
         std::string setupMessage = ArduinoProtocol::createControllerSetupMessage(
             controllerType, encoderResolution, sensorOffset, enabled, guns,
-            startCurrent, startDurationMS, holdCurrent, dotSize);
+            startCurrent, startDurationMS, holdCurrent, dotSize,
+            valveOnDelayMs, valveOffDelayMs, caps.schemaVersion);
             
         if (!setupMessage.empty()) {
             ArduinoProtocol::sendMessage(eventQueue_, communicationPort, setupMessage);
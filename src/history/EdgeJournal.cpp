@@ -0,0 +1,411 @@
+#include "history/EdgeJournal.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kBlockMagic[4] = {'E', 'J', 'B', '1'};
+const std::string kFilePrefix = "edges-";
+const std::string kChannelsFile = "channels.txt";
+constexpr std::size_t kChannels = 32;
+
+constexpr std::int64_t kMsPerHour = 3600LL * 1000LL;
+constexpr auto kDrainInterval = std::chrono::milliseconds(20);
+
+// Block in the .dat file: this header, then per channel with edges
+// varint(channel), varint(count) and count varint time deltas in us
+// (the first from firstUs, the others from the channel's previous edge).
+struct BlockHeader {
+    char magic[4];
+    std::uint32_t edges;
+    std::int64_t firstUs;
+    std::int64_t lastUs;
+    std::uint32_t startWord;    // IO word before the first edge
+    std::uint32_t payloadBytes;
+};
+
+// One per block in the .idx file, written after the block
+struct IndexEntry {
+    std::int64_t firstUs;
+    std::int64_t lastUs;
+    std::uint64_t offset;
+    std::uint32_t bytes;        // header and payload
+    std::uint32_t edges;
+};
+
+static_assert(sizeof(BlockHeader) == 32, "BlockHeader layout is part of the file format");
+static_assert(sizeof(IndexEntry) == 32, "IndexEntry layout is part of the file format");
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool getVarint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const std::uint8_t byte = *p++;
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+std::int64_t wallClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string filePath(const std::string& directory, std::int64_t startMs, const char* extension) {
+    return (fs::path(directory) / (kFilePrefix + std::to_string(startMs) + extension)).string();
+}
+
+// Partition starts of the journal files, ascending
+std::vector<std::int64_t> listPartitions(const std::string& directory) {
+    std::vector<std::int64_t> starts;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path path = it->path();
+        const std::string name = path.filename().string();
+        if (path.extension() != ".idx" || name.rfind(kFilePrefix, 0) != 0) continue;
+        try {
+            starts.push_back(std::stoll(name.substr(kFilePrefix.size())));
+        } catch (...) {
+            // not a journal file
+        }
+    }
+    std::sort(starts.begin(), starts.end());
+    return starts;
+}
+
+std::vector<IndexEntry> readIndex(const std::string& path) {
+    std::vector<IndexEntry> entries;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return entries;
+    const auto size = static_cast<std::size_t>(file.tellg());
+    entries.resize(size / sizeof(IndexEntry)); // a torn last entry is ignored
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+    if (!file) entries.clear();
+    return entries;
+}
+
+} // namespace
+
+EdgeJournal::EdgeJournal(Options options) : options_(std::move(options)) {
+    if (options_.partitionHours < 1) options_.partitionHours = 1;
+    if (options_.blockEdges < 1) options_.blockEdges = 1;
+    std::size_t size = 1024;
+    while (size < options_.queueSamples) size <<= 1;
+    ring_.resize(size);
+    mask_ = size - 1;
+    blockTimes_.resize(kChannels);
+}
+
+EdgeJournal::~EdgeJournal() {
+    stop();
+}
+
+bool EdgeJournal::start(const std::vector<std::string>& channels) {
+    if (writer_.joinable()) return true;
+    try {
+        std::error_code ec;
+        fs::create_directories(options_.directory, ec);
+        if (ec) {
+            getLogger()->error("[EdgeJournal] Failed to create directory {}: {}", options_.directory, ec.message());
+            return false;
+        }
+        std::ofstream names((fs::path(options_.directory) / kChannelsFile).string(), std::ios::trunc);
+        for (std::size_t bit = 0; bit < kChannels; ++bit) {
+            names << (bit < channels.size() ? channels[bit] : std::string()) << '\n';
+        }
+        if (!names) {
+            getLogger()->warn("[EdgeJournal] Failed to write channel names to {}", options_.directory);
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = false;
+        }
+        writer_ = std::thread(&EdgeJournal::writerLoop, this);
+        getLogger()->info("[EdgeJournal] Recording IO edges to {} ({} h files, {} days retention)",
+                          options_.directory, options_.partitionHours, options_.retentionDays);
+        return true;
+    } catch (const std::exception& e) {
+        getLogger()->error("[EdgeJournal] Failed to start: {}", e.what());
+        return false;
+    }
+}
+
+void EdgeJournal::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wakeCv_.notify_all();
+    if (!writer_.joinable()) return;
+    writer_.join();
+    getLogger()->info("[EdgeJournal] Stopped: {} edges in {} bytes, {} word changes dropped",
+                      edges_.load(), bytes_.load(), dropped_.load());
+}
+
+void EdgeJournal::writerLoop() {
+    while (true) {
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCv_.wait_for(lock, kDrainInterval, [this]() { return stopping_; });
+            stopping = stopping_;
+        }
+        try {
+            drain();
+            const std::int64_t nowUs = wallClockUs();
+            if (blockCount_ > 0 && (stopping || nowUs - blockFirstUs_ >= options_.flushSeconds * 1000000LL)) {
+                writeBlock();
+            }
+            if (nowUs / 1000 - lastRetentionCheckMs_ >= kMsPerHour) {
+                applyRetention(nowUs / 1000);
+                lastRetentionCheckMs_ = nowUs / 1000;
+            }
+        } catch (const std::exception& e) {
+            getLogger()->error("[EdgeJournal] Writer error: {}", e.what());
+        }
+        if (stopping) break;
+    }
+    closePartition();
+}
+
+void EdgeJournal::drain() {
+    // Poll timestamps are steady_clock; the journal is wall clock
+    const auto offsetNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() -
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+        const Sample sample = ring_[tail & mask_];
+        addEdges((sample.steadyNs + offsetNs) / 1000, sample.word);
+    }
+    tail_.store(tail, std::memory_order_release);
+}
+
+void EdgeJournal::addEdges(std::int64_t timeUs, std::uint32_t word) {
+    if (!haveWord_) {
+        // First poll: the starting state, not an edge
+        word_ = word;
+        haveWord_ = true;
+        return;
+    }
+    std::uint32_t changed = word ^ word_;
+    if (changed == 0) return;
+
+    // Keep times monotonic when the wall clock is stepped back
+    timeUs = std::max(timeUs, blockLastUs_);
+    const std::int64_t partition = partitionStart(timeUs / 1000);
+    if (partition != partitionStartMs_) {
+        writeBlock();
+        if (!openPartition(partition)) {
+            word_ = word;
+            return;
+        }
+    }
+    if (blockCount_ == 0) {
+        blockStartWord_ = word_;
+        blockFirstUs_ = timeUs;
+    }
+    for (std::size_t bit = 0; changed != 0; ++bit, changed >>= 1) {
+        if (changed & 1u) {
+            blockTimes_[bit].push_back(timeUs);
+            ++blockCount_;
+        }
+    }
+    blockLastUs_ = timeUs;
+    word_ = word;
+    if (blockCount_ >= options_.blockEdges) writeBlock();
+}
+
+void EdgeJournal::writeBlock() {
+    if (blockCount_ == 0) return;
+
+    buffer_.assign(sizeof(BlockHeader), 0);
+    for (std::size_t channel = 0; channel < kChannels; ++channel) {
+        auto& times = blockTimes_[channel];
+        if (times.empty()) continue;
+        putVarint(buffer_, channel);
+        putVarint(buffer_, times.size());
+        std::int64_t previous = blockFirstUs_;
+        for (std::int64_t time : times) {
+            putVarint(buffer_, static_cast<std::uint64_t>(time - previous));
+            previous = time;
+        }
+        times.clear();
+    }
+
+    BlockHeader header;
+    std::memcpy(header.magic, kBlockMagic, sizeof(kBlockMagic));
+    header.edges = static_cast<std::uint32_t>(blockCount_);
+    header.firstUs = blockFirstUs_;
+    header.lastUs = blockLastUs_;
+    header.startWord = blockStartWord_;
+    header.payloadBytes = static_cast<std::uint32_t>(buffer_.size() - sizeof(BlockHeader));
+    std::memcpy(buffer_.data(), &header, sizeof(header));
+
+    const IndexEntry entry{blockFirstUs_, blockLastUs_, dataSize_, static_cast<std::uint32_t>(buffer_.size()),
+                           static_cast<std::uint32_t>(blockCount_)};
+    const std::size_t edges = blockCount_;
+    blockCount_ = 0;
+
+    // Block first, then its index entry: a reader never sees an entry for a missing block
+    if (!data_ || !index_ ||
+        std::fwrite(buffer_.data(), 1, buffer_.size(), data_) != buffer_.size() || std::fflush(data_) != 0 ||
+        std::fwrite(&entry, sizeof(entry), 1, index_) != 1 || std::fflush(index_) != 0) {
+        getLogger()->error("[EdgeJournal] Failed to write a block of {} edges", edges);
+        return;
+    }
+    dataSize_ += buffer_.size();
+    edges_ += edges;
+    bytes_ += buffer_.size() + sizeof(entry);
+}
+
+bool EdgeJournal::openPartition(std::int64_t startMs) {
+    closePartition();
+    partitionStartMs_ = startMs;
+    const std::string dataPath = filePath(options_.directory, startMs, ".dat");
+    const std::string indexPath = filePath(options_.directory, startMs, ".idx");
+
+    // Restarted within the partition: drop a torn index entry and any block without one
+    std::error_code ec;
+    const auto entries = readIndex(indexPath);
+    dataSize_ = entries.empty() ? 0 : entries.back().offset + entries.back().bytes;
+    if (fs::exists(indexPath, ec)) fs::resize_file(indexPath, entries.size() * sizeof(IndexEntry), ec);
+    if (fs::exists(dataPath, ec)) fs::resize_file(dataPath, dataSize_, ec);
+
+    data_ = std::fopen(dataPath.c_str(), "ab");
+    index_ = std::fopen(indexPath.c_str(), "ab");
+    if (!data_ || !index_) {
+        getLogger()->error("[EdgeJournal] Failed to open {}", dataPath);
+        closePartition();
+        partitionStartMs_ = startMs; // do not retry for every edge of this partition
+        return false;
+    }
+    return true;
+}
+
+void EdgeJournal::closePartition() {
+    if (data_) std::fclose(data_);
+    if (index_) std::fclose(index_);
+    data_ = nullptr;
+    index_ = nullptr;
+    partitionStartMs_ = -1;
+}
+
+void EdgeJournal::applyRetention(std::int64_t nowMs) {
+    if (options_.retentionDays <= 0) return;
+    const std::int64_t partitionMs = options_.partitionHours * kMsPerHour;
+    const std::int64_t cutoff = nowMs - static_cast<std::int64_t>(options_.retentionDays) * 24 * kMsPerHour;
+    for (std::int64_t start : listPartitions(options_.directory)) {
+        if (start + partitionMs > cutoff || start == partitionStartMs_) continue;
+        std::error_code ec;
+        fs::remove(filePath(options_.directory, start, ".idx"), ec);
+        fs::remove(filePath(options_.directory, start, ".dat"), ec);
+        if (ec) {
+            getLogger()->warn("[EdgeJournal] Failed to remove expired journal {}: {}", start, ec.message());
+        } else {
+            getLogger()->info("[EdgeJournal] Removed expired journal {}", filePath(options_.directory, start, ".dat"));
+        }
+    }
+}
+
+std::int64_t EdgeJournal::partitionStart(std::int64_t timeMs) const {
+    const std::int64_t partitionMs = options_.partitionHours * kMsPerHour;
+    return timeMs - (timeMs % partitionMs);
+}
+
+bool EdgeJournal::read(const std::string& directory, std::int64_t fromUs, std::int64_t toUs,
+                       std::vector<Edge>& edges, std::uint32_t* initialWord) {
+    edges.clear();
+    bool haveInitial = false;
+    std::vector<std::uint8_t> block;
+    std::vector<Edge> blockEdges;
+
+    for (std::int64_t start : listPartitions(directory)) {
+        if (start * 1000 >= toUs) break;
+        const auto entries = readIndex(filePath(directory, start, ".idx"));
+        if (entries.empty() || entries.back().lastUs < fromUs) continue;
+
+        std::ifstream data(filePath(directory, start, ".dat"), std::ios::binary);
+        if (!data) return false;
+        auto it = std::lower_bound(entries.begin(), entries.end(), fromUs,
+                                   [](const IndexEntry& e, std::int64_t t) { return e.lastUs < t; });
+        for (; it != entries.end() && it->firstUs < toUs; ++it) {
+            block.resize(it->bytes);
+            data.seekg(static_cast<std::streamoff>(it->offset));
+            if (it->bytes < sizeof(BlockHeader) || !data.read(reinterpret_cast<char*>(block.data()), it->bytes)) {
+                return false;
+            }
+            BlockHeader header;
+            std::memcpy(&header, block.data(), sizeof(header));
+            if (std::memcmp(header.magic, kBlockMagic, sizeof(kBlockMagic)) != 0 ||
+                header.payloadBytes != it->bytes - sizeof(BlockHeader)) {
+                return false;
+            }
+
+            // Per channel runs back to edges, toggling from the block's start word
+            blockEdges.clear();
+            const std::uint8_t* p = block.data() + sizeof(BlockHeader);
+            const std::uint8_t* end = block.data() + block.size();
+            while (p < end) {
+                std::uint64_t channel = 0, count = 0;
+                if (!getVarint(p, end, channel) || !getVarint(p, end, count) || channel >= kChannels) return false;
+                std::uint8_t state = (header.startWord >> channel) & 1u;
+                std::int64_t time = header.firstUs;
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    std::uint64_t delta = 0;
+                    if (!getVarint(p, end, delta)) return false;
+                    time += static_cast<std::int64_t>(delta);
+                    state ^= 1u;
+                    blockEdges.push_back({time, static_cast<std::uint8_t>(channel), state});
+                }
+            }
+            std::sort(blockEdges.begin(), blockEdges.end(), [](const Edge& a, const Edge& b) {
+                return a.timeUs != b.timeUs ? a.timeUs < b.timeUs : a.channel < b.channel;
+            });
+
+            std::uint32_t word = header.startWord;
+            for (const Edge& edge : blockEdges) {
+                if (edge.timeUs < fromUs) {
+                    word = edge.state ? (word | (1u << edge.channel)) : (word & ~(1u << edge.channel));
+                } else if (edge.timeUs < toUs) {
+                    edges.push_back(edge);
+                }
+            }
+            if (!haveInitial) {
+                if (initialWord) *initialWord = word;
+                haveInitial = true;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> EdgeJournal::readChannels(const std::string& directory) {
+    std::vector<std::string> channels;
+    std::ifstream file((fs::path(directory) / kChannelsFile).string());
+    std::string line;
+    while (std::getline(file, line) && channels.size() < kChannels) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        channels.push_back(line);
+    }
+    channels.resize(kChannels);
+    return channels;
+}
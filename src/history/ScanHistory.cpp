@@ -0,0 +1,587 @@
+#include "history/ScanHistory.h"
+#include "utils/MappedFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kSegmentMagic[8] = {'M', 'C', 'H', 'I', 'S', 'T', '1', '\0'};
+constexpr std::uint32_t kSegmentVersion = 1;
+const std::string kSegmentPrefix = "seg-";
+const std::string kPortsFile = "ports.txt";
+
+constexpr std::uint64_t kInitialRows = 4096;
+constexpr std::uint64_t kInitialDictBytes = 64 * 1024;
+constexpr std::uint64_t kInitialHashSlots = 4096; // power of two
+
+constexpr std::int64_t kMsPerHour = 3600LL * 1000LL;
+constexpr std::int64_t kRetentionCheckIntervalMs = kMsPerHour;
+
+// Fixed header of a segment. Counts are bumped before the index points at the
+// entries they cover, so an interrupted append never leaves a dangling link.
+struct SegmentMeta {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::int64_t startMs;
+    std::int64_t lastTimeMs;
+    std::uint64_t rows;
+    std::uint64_t dictCount;
+    std::uint64_t dictBytes;
+};
+
+std::uint64_t hashPayload(const char* data, std::size_t len) {
+    // FNV-1a
+    std::uint64_t h = 1469598103934665603ULL;
+    for (std::size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::uint64_t growTo(std::uint64_t current, std::uint64_t needed, std::uint64_t initial) {
+    std::uint64_t cap = current > 0 ? current : initial;
+    while (cap < needed) cap *= 2;
+    return cap;
+}
+
+std::int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// One time partition: column files, payload dictionary and hash index
+class ScanHistory::Segment {
+public:
+    struct RawHit {
+        std::int64_t timeMs;
+        std::uint16_t port;
+        std::int32_t cell;
+        std::uint32_t verdict;
+    };
+
+    ~Segment() { close(); }
+
+    bool open(const std::string& dir, std::int64_t startMs, bool writable) {
+        writable_ = writable;
+        startMs_ = startMs;
+        const fs::path base(dir);
+        if (writable) {
+            std::error_code ec;
+            fs::create_directories(base, ec);
+            if (ec) {
+                getLogger()->error("[ScanHistory] Failed to create segment {}: {}", dir, ec.message());
+                return false;
+            }
+        }
+        const std::uint64_t rows = writable ? kInitialRows : 0;
+        const bool ok =
+            meta_.open((base / "meta.bin").string(), writable, writable ? sizeof(SegmentMeta) : 0) &&
+            time_.open((base / "time.col").string(), writable, rows * sizeof(std::int64_t)) &&
+            port_.open((base / "port.col").string(), writable, rows * sizeof(std::uint16_t)) &&
+            cell_.open((base / "cell.col").string(), writable, rows * sizeof(std::int32_t)) &&
+            verdict_.open((base / "verdict.col").string(), writable, rows * sizeof(std::uint32_t)) &&
+            payload_.open((base / "payload.col").string(), writable, rows * sizeof(std::uint32_t)) &&
+            prev_.open((base / "prev.col").string(), writable, rows * sizeof(std::uint32_t)) &&
+            dictData_.open((base / "dict.dat").string(), writable, writable ? kInitialDictBytes : 0) &&
+            dictOffsets_.open((base / "dict.off").string(), writable, rows * sizeof(std::uint64_t)) &&
+            dictLast_.open((base / "dict.last").string(), writable, rows * sizeof(std::uint32_t)) &&
+            dictHash_.open((base / "dict.hash").string(), writable, writable ? kInitialHashSlots * sizeof(std::uint32_t) : 0);
+        if (!ok || meta_.size() < sizeof(SegmentMeta)) {
+            close();
+            return false;
+        }
+
+        SegmentMeta* m = meta();
+        if (std::memcmp(m->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0) {
+            if (!writable) {
+                close();
+                return false;
+            }
+            // New segment
+            std::memset(m, 0, sizeof(SegmentMeta));
+            m->version = kSegmentVersion;
+            m->startMs = startMs;
+            std::memcpy(m->magic, kSegmentMagic, sizeof(kSegmentMagic));
+        } else if (m->version != kSegmentVersion) {
+            getLogger()->warn("[ScanHistory] Segment {} has unsupported version {}", dir, m->version);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        for (MappedFile* f : files()) f->close();
+    }
+
+    bool flush() {
+        bool ok = true;
+        // Data first, header last
+        for (MappedFile* f : files()) {
+            if (f != &meta_ && f->isWritable()) ok = f->flush() && ok;
+        }
+        if (meta_.isWritable()) ok = meta_.flush() && ok;
+        return ok;
+    }
+
+    std::int64_t startMs() const { return startMs_; }
+    std::uint64_t rows() const { return meta_.data() ? meta()->rows : 0; }
+
+    bool append(std::int64_t timeMs, std::uint16_t port, std::int32_t cell, std::uint32_t verdict,
+                const std::string& payload) {
+        if (!writable_) return false;
+        SegmentMeta* m = meta();
+        const std::uint64_t row = m->rows;
+        if (row >= UINT32_MAX - 1) return false; // row links are 32-bit
+
+        std::uint32_t id = 0;
+        const std::uint64_t h = hashPayload(payload.data(), payload.size());
+        if (!lookup(payload, h, id)) {
+            if (!addDictEntry(payload, h, id)) return false;
+            m = meta();
+        }
+
+        if (!ensureRowCapacity(row + 1)) return false;
+        column<std::int64_t>(time_)[row] = timeMs;
+        column<std::uint16_t>(port_)[row] = port;
+        column<std::int32_t>(cell_)[row] = cell;
+        column<std::uint32_t>(verdict_)[row] = verdict;
+        column<std::uint32_t>(payload_)[row] = id;
+        column<std::uint32_t>(prev_)[row] = column<std::uint32_t>(dictLast_)[id];
+        m->rows = row + 1;
+        m->lastTimeMs = timeMs;
+        column<std::uint32_t>(dictLast_)[id] = static_cast<std::uint32_t>(row + 1);
+        return true;
+    }
+
+    // Rows with this payload, newest first
+    void find(const std::string& payload, std::size_t maxHits, std::vector<RawHit>& out) const {
+        if (!meta_.data()) return;
+        std::uint32_t id = 0;
+        if (!lookup(payload, hashPayload(payload.data(), payload.size()), id)) return;
+
+        const std::uint64_t rowCount = std::min<std::uint64_t>(meta()->rows, rowCapacity());
+        std::uint32_t link = column<std::uint32_t>(dictLast_)[id];
+        while (link != 0 && out.size() < maxHits) {
+            const std::uint64_t row = link - 1;
+            if (row >= rowCount) break;
+            out.push_back({column<std::int64_t>(time_)[row],
+                           column<std::uint16_t>(port_)[row],
+                           column<std::int32_t>(cell_)[row],
+                           column<std::uint32_t>(verdict_)[row]});
+            link = column<std::uint32_t>(prev_)[row];
+            if (link > row) break; // links always point backwards
+        }
+    }
+
+    // Rows in [fromMs, toMs) in row order, which is time order
+    void range(std::int64_t fromMs, std::int64_t toMs, std::size_t maxRows, std::vector<Row>& out,
+               const std::vector<std::string>& ports) const {
+        if (!meta_.data()) return;
+        const std::uint64_t rowCount = std::min<std::uint64_t>(meta()->rows, rowCapacity());
+        const std::int64_t* times = column<std::int64_t>(time_);
+        const std::uint64_t dictCount = meta()->dictCount;
+        const std::uint64_t* offsets = column<std::uint64_t>(dictOffsets_);
+        for (std::uint64_t row = std::lower_bound(times, times + rowCount, fromMs) - times;
+             row < rowCount && times[row] < toMs && out.size() < maxRows; ++row) {
+            Row r;
+            r.timeMs = times[row];
+            const std::uint16_t port = column<std::uint16_t>(port_)[row];
+            r.commName = port < ports.size() ? ports[port] : std::string("?");
+            r.cell = column<std::int32_t>(cell_)[row];
+            r.verdict = column<std::uint32_t>(verdict_)[row];
+            const std::uint32_t id = column<std::uint32_t>(payload_)[row];
+            if (id < dictCount) {
+                r.payload.assign(dictData_.data() + offsets[id], static_cast<std::size_t>(offsets[id + 1] - offsets[id]));
+            }
+            out.push_back(std::move(r));
+        }
+    }
+
+    std::int64_t lastTimeMs() const { return meta_.data() ? meta()->lastTimeMs : 0; }
+
+private:
+    SegmentMeta* meta() { return reinterpret_cast<SegmentMeta*>(meta_.data()); }
+    const SegmentMeta* meta() const { return reinterpret_cast<const SegmentMeta*>(meta_.data()); }
+
+    template <typename T>
+    static T* column(MappedFile& f) { return reinterpret_cast<T*>(f.data()); }
+    template <typename T>
+    static const T* column(const MappedFile& f) { return reinterpret_cast<const T*>(f.data()); }
+
+    std::vector<MappedFile*> files() {
+        return {&meta_, &time_, &port_, &cell_, &verdict_, &payload_, &prev_,
+                &dictData_, &dictOffsets_, &dictLast_, &dictHash_};
+    }
+
+    std::uint64_t rowCapacity() const { return time_.size() / sizeof(std::int64_t); }
+    std::uint64_t hashSlots() const { return dictHash_.size() / sizeof(std::uint32_t); }
+
+    bool ensureRowCapacity(std::uint64_t rows) {
+        const std::uint64_t cap = rowCapacity();
+        if (rows <= cap) return true;
+        const std::uint64_t newCap = growTo(cap, rows, kInitialRows);
+        return time_.resize(newCap * sizeof(std::int64_t)) &&
+               port_.resize(newCap * sizeof(std::uint16_t)) &&
+               cell_.resize(newCap * sizeof(std::int32_t)) &&
+               verdict_.resize(newCap * sizeof(std::uint32_t)) &&
+               payload_.resize(newCap * sizeof(std::uint32_t)) &&
+               prev_.resize(newCap * sizeof(std::uint32_t));
+    }
+
+    bool lookup(const std::string& payload, std::uint64_t h, std::uint32_t& id) const {
+        const std::uint64_t slots = hashSlots();
+        if (slots == 0 || !dictHash_.data() || !dictOffsets_.data()) return false;
+        const std::uint64_t count = meta()->dictCount;
+        const std::uint32_t* table = column<std::uint32_t>(dictHash_);
+        const std::uint64_t* offsets = column<std::uint64_t>(dictOffsets_);
+        const std::uint64_t mask = slots - 1;
+        for (std::uint64_t i = 0, slot = h & mask; i < slots; ++i, slot = (slot + 1) & mask) {
+            const std::uint32_t entry = table[slot];
+            if (entry == 0) return false;
+            const std::uint32_t candidate = entry - 1;
+            if (candidate >= count) continue;
+            const std::uint64_t begin = offsets[candidate];
+            const std::uint64_t len = offsets[candidate + 1] - begin;
+            if (len == payload.size() &&
+                std::memcmp(dictData_.data() + begin, payload.data(), payload.size()) == 0) {
+                id = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void insertHash(std::uint64_t h, std::uint32_t id) {
+        std::uint32_t* table = column<std::uint32_t>(dictHash_);
+        const std::uint64_t mask = hashSlots() - 1;
+        std::uint64_t slot = h & mask;
+        while (table[slot] != 0) slot = (slot + 1) & mask;
+        table[slot] = id + 1;
+    }
+
+    bool rebuildHash(std::uint64_t slots) {
+        if (!dictHash_.resize(slots * sizeof(std::uint32_t))) return false;
+        std::memset(dictHash_.data(), 0, dictHash_.size());
+        const std::uint64_t* offsets = column<std::uint64_t>(dictOffsets_);
+        const std::uint64_t count = meta()->dictCount;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            const char* p = dictData_.data() + offsets[i];
+            insertHash(hashPayload(p, static_cast<std::size_t>(offsets[i + 1] - offsets[i])),
+                       static_cast<std::uint32_t>(i));
+        }
+        return true;
+    }
+
+    bool addDictEntry(const std::string& payload, std::uint64_t h, std::uint32_t& id) {
+        SegmentMeta* m = meta();
+        const std::uint64_t count = m->dictCount;
+        const std::uint64_t bytes = m->dictBytes;
+
+        // Dictionary bytes, offsets (count + 2 entries) and per-entry last row
+        if (bytes + payload.size() > dictData_.size() &&
+            !dictData_.resize(growTo(dictData_.size(), bytes + payload.size(), kInitialDictBytes))) {
+            return false;
+        }
+        const std::uint64_t offsetEntries = dictOffsets_.size() / sizeof(std::uint64_t);
+        if (count + 2 > offsetEntries &&
+            !dictOffsets_.resize(growTo(offsetEntries, count + 2, kInitialRows) * sizeof(std::uint64_t))) {
+            return false;
+        }
+        const std::uint64_t lastEntries = dictLast_.size() / sizeof(std::uint32_t);
+        if (count + 1 > lastEntries &&
+            !dictLast_.resize(growTo(lastEntries, count + 1, kInitialRows) * sizeof(std::uint32_t))) {
+            return false;
+        }
+
+        if (!payload.empty()) std::memcpy(dictData_.data() + bytes, payload.data(), payload.size());
+        column<std::uint64_t>(dictOffsets_)[count] = bytes;
+        column<std::uint64_t>(dictOffsets_)[count + 1] = bytes + payload.size();
+        column<std::uint32_t>(dictLast_)[count] = 0;
+        m = meta();
+        m->dictBytes = bytes + payload.size();
+        m->dictCount = count + 1;
+        id = static_cast<std::uint32_t>(count);
+
+        // Keep the load factor at or below one half
+        if ((count + 1) * 2 > hashSlots()) {
+            return rebuildHash(growTo(hashSlots(), (count + 1) * 2, kInitialHashSlots));
+        }
+        insertHash(h, id);
+        return true;
+    }
+
+    bool writable_{false};
+    std::int64_t startMs_{0};
+    MappedFile meta_;
+    MappedFile time_;
+    MappedFile port_;
+    MappedFile cell_;
+    MappedFile verdict_;
+    MappedFile payload_;
+    MappedFile prev_;
+    MappedFile dictData_;
+    MappedFile dictOffsets_;
+    MappedFile dictLast_;
+    MappedFile dictHash_;
+};
+
+ScanHistory::ScanHistory(Options options) : options_(std::move(options)) {
+    if (options_.partitionHours < 1) options_.partitionHours = 1;
+    if (options_.maxOpenSegments < 1) options_.maxOpenSegments = 1;
+}
+
+ScanHistory::~ScanHistory() {
+    stop();
+}
+
+bool ScanHistory::start() {
+    if (writer_.joinable()) return true;
+    try {
+        std::error_code ec;
+        fs::create_directories(options_.directory, ec);
+        if (ec) {
+            getLogger()->error("[ScanHistory] Failed to create directory {}: {}", options_.directory, ec.message());
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(storeMutex_);
+            loadPortsLocked();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            stopping_ = false;
+        }
+        writer_ = std::thread(&ScanHistory::writerLoop, this);
+        getLogger()->info("[ScanHistory] Recording scans to {} ({} h segments, {} days retention)",
+                          options_.directory, options_.partitionHours, options_.retentionDays);
+        return true;
+    } catch (const std::exception& e) {
+        getLogger()->error("[ScanHistory] Failed to start: {}", e.what());
+        return false;
+    }
+}
+
+void ScanHistory::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueCv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+
+    std::lock_guard<std::mutex> lock(storeMutex_);
+    if (current_) {
+        current_->flush();
+        current_.reset();
+    }
+    readCache_.clear();
+}
+
+void ScanHistory::record(const ScanRecord& scan) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_ || queue_.size() >= options_.maxPending) {
+            dropped_++;
+            return;
+        }
+        queue_.push_back(Pending{nowMs(), scan});
+    }
+    queueCv_.notify_one();
+}
+
+void ScanHistory::writerLoop() {
+    while (true) {
+        std::deque<Pending> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty() && stopping_) break;
+            batch.swap(queue_);
+        }
+
+        try {
+            std::lock_guard<std::mutex> lock(storeMutex_);
+            for (const auto& p : batch) appendLocked(p);
+            const std::int64_t now = nowMs();
+            if (now - lastRetentionCheckMs_ >= kRetentionCheckIntervalMs) {
+                applyRetentionLocked(now);
+                lastRetentionCheckMs_ = now;
+            }
+        } catch (const std::exception& e) {
+            getLogger()->error("[ScanHistory] Writer error: {}", e.what());
+        }
+    }
+}
+
+void ScanHistory::appendLocked(const Pending& p) {
+    const std::int64_t part = partitionStart(p.timeMs);
+    if ((!current_ || current_->startMs() != part) && !rotateLocked(part)) {
+        dropped_++;
+        return;
+    }
+    const std::uint16_t port = portIdLocked(p.scan.commName);
+    if (current_->append(p.timeMs, port, p.scan.cell, p.scan.verdict, p.scan.payload)) {
+        written_++;
+    } else {
+        dropped_++;
+    }
+}
+
+bool ScanHistory::rotateLocked(std::int64_t partitionStartMs) {
+    if (current_) {
+        current_->flush();
+        current_.reset();
+    }
+    // A segment is mapped either for writing or in the read cache, never both
+    readCache_.remove_if([&](const std::unique_ptr<Segment>& s) { return s->startMs() == partitionStartMs; });
+
+    auto seg = std::make_unique<Segment>();
+    if (!seg->open(segmentPath(partitionStartMs), partitionStartMs, true)) {
+        getLogger()->error("[ScanHistory] Failed to open segment {}", segmentPath(partitionStartMs));
+        return false;
+    }
+    current_ = std::move(seg);
+    applyRetentionLocked(nowMs());
+    return true;
+}
+
+void ScanHistory::applyRetentionLocked(std::int64_t now) {
+    if (options_.retentionDays <= 0) return;
+    const std::int64_t partitionMs = options_.partitionHours * kMsPerHour;
+    const std::int64_t cutoff = now - static_cast<std::int64_t>(options_.retentionDays) * 24 * kMsPerHour;
+    for (std::int64_t start : listSegmentsLocked()) {
+        if (start + partitionMs > cutoff) continue;
+        if (current_ && current_->startMs() == start) continue;
+        readCache_.remove_if([&](const std::unique_ptr<Segment>& s) { return s->startMs() == start; });
+        std::error_code ec;
+        fs::remove_all(segmentPath(start), ec);
+        if (ec) {
+            getLogger()->warn("[ScanHistory] Failed to remove expired segment {}: {}", segmentPath(start), ec.message());
+        } else {
+            getLogger()->info("[ScanHistory] Removed expired segment {}", segmentPath(start));
+        }
+    }
+}
+
+std::uint16_t ScanHistory::portIdLocked(const std::string& commName) {
+    auto it = std::find(ports_.begin(), ports_.end(), commName);
+    if (it != ports_.end()) return static_cast<std::uint16_t>(it - ports_.begin());
+    if (ports_.size() >= UINT16_MAX) return UINT16_MAX;
+
+    ports_.push_back(commName);
+    std::ofstream f((fs::path(options_.directory) / kPortsFile).string(), std::ios::app);
+    if (f) {
+        f << commName << '\n';
+    } else {
+        getLogger()->warn("[ScanHistory] Failed to persist port name {}", commName);
+    }
+    return static_cast<std::uint16_t>(ports_.size() - 1);
+}
+
+void ScanHistory::loadPortsLocked() {
+    ports_.clear();
+    std::ifstream f((fs::path(options_.directory) / kPortsFile).string());
+    std::string line;
+    while (std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        ports_.push_back(line);
+    }
+}
+
+std::vector<std::int64_t> ScanHistory::listSegmentsLocked() const {
+    std::vector<std::int64_t> starts;
+    std::error_code ec;
+    for (fs::directory_iterator it(options_.directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_directory()) continue;
+        const std::string name = it->path().filename().string();
+        if (name.rfind(kSegmentPrefix, 0) != 0) continue;
+        try {
+            starts.push_back(std::stoll(name.substr(kSegmentPrefix.size())));
+        } catch (...) {
+            // not a segment directory
+        }
+    }
+    std::sort(starts.begin(), starts.end(), std::greater<std::int64_t>());
+    return starts;
+}
+
+ScanHistory::Segment* ScanHistory::readSegmentLocked(std::int64_t startMs) {
+    for (auto it = readCache_.begin(); it != readCache_.end(); ++it) {
+        if ((*it)->startMs() == startMs) {
+            readCache_.splice(readCache_.begin(), readCache_, it);
+            return readCache_.front().get();
+        }
+    }
+    auto seg = std::make_unique<Segment>();
+    if (!seg->open(segmentPath(startMs), startMs, false)) {
+        getLogger()->warn("[ScanHistory] Skipping unreadable segment {}", segmentPath(startMs));
+        return nullptr;
+    }
+    readCache_.push_front(std::move(seg));
+    while (readCache_.size() > options_.maxOpenSegments) readCache_.pop_back();
+    return readCache_.front().get();
+}
+
+std::vector<ScanHistory::Hit> ScanHistory::findPayload(const std::string& payload, std::size_t maxHits) {
+    std::vector<Hit> hits;
+    try {
+        std::lock_guard<std::mutex> lock(storeMutex_);
+        std::vector<Segment::RawHit> raw;
+        for (std::int64_t start : listSegmentsLocked()) {
+            if (raw.size() >= maxHits) break;
+            Segment* seg = (current_ && current_->startMs() == start) ? current_.get() : readSegmentLocked(start);
+            if (seg) seg->find(payload, maxHits, raw);
+        }
+        hits.reserve(raw.size());
+        for (const auto& r : raw) {
+            Hit h;
+            h.timeMs = r.timeMs;
+            h.commName = r.port < ports_.size() ? ports_[r.port] : std::string("?");
+            h.cell = r.cell;
+            h.verdict = r.verdict;
+            hits.push_back(std::move(h));
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("[ScanHistory] Lookup failed: {}", e.what());
+    }
+    return hits;
+}
+
+std::vector<ScanHistory::Row> ScanHistory::readRange(std::int64_t fromMs, std::int64_t toMs, std::size_t maxRows) {
+    std::vector<Row> rows;
+    try {
+        std::lock_guard<std::mutex> lock(storeMutex_);
+        if (!writer_.joinable()) loadPortsLocked(); // ports may have been added by the writing process
+        auto starts = listSegmentsLocked();
+        std::reverse(starts.begin(), starts.end());
+        for (std::int64_t start : starts) {
+            if (start >= toMs || rows.size() >= maxRows) break;
+            Segment* seg = (current_ && current_->startMs() == start) ? current_.get() : readSegmentLocked(start);
+            if (!seg || seg->lastTimeMs() < fromMs) continue;
+            seg->range(fromMs, toMs, maxRows, rows, ports_);
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("[ScanHistory] Range read failed: {}", e.what());
+    }
+    return rows;
+}
+
+std::string ScanHistory::segmentPath(std::int64_t startMs) const {
+    return (fs::path(options_.directory) / (kSegmentPrefix + std::to_string(startMs))).string();
+}
+
+std::int64_t ScanHistory::partitionStart(std::int64_t timeMs) const {
+    const std::int64_t partitionMs = options_.partitionHours * kMsPerHour;
+    return timeMs - (timeMs % partitionMs);
+}
@@ -0,0 +1,233 @@
+#include "io/IOCapture.h"
+#include <algorithm>
+
+namespace {
+
+int channelBit(const std::vector<std::string>& channels, const std::string& name) {
+    for (std::size_t bit = 0; bit < channels.size() && bit < 32; ++bit) {
+        if (channels[bit] == name) return static_cast<int>(bit);
+    }
+    return -1;
+}
+
+std::string channelName(const std::vector<std::string>& channels, int bit) {
+    if (bit >= 0 && static_cast<std::size_t>(bit) < channels.size() && !channels[bit].empty()) return channels[bit];
+    return "pin " + std::to_string(bit);
+}
+
+} // namespace
+
+IOCapture::IOCapture(std::size_t capacity) {
+    std::size_t size = 1024;
+    while (size < capacity) size <<= 1;
+    ring_.resize(size);
+    mask_ = size - 1;
+}
+
+void IOCapture::arm(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pending_ = settings;
+    // The trigger sample is kept too
+    pending_.post = std::min(pending_.post, ring_.size() - 1);
+    pending_.pre = std::min(pending_.pre, ring_.size() - 1 - pending_.post);
+    pendingCommands_ = CommandArm;
+    commandPending_.store(true, std::memory_order_release);
+}
+
+void IOCapture::trigger() {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pendingCommands_ |= CommandFire;
+    commandPending_.store(true, std::memory_order_release);
+}
+
+void IOCapture::disarm() {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pendingCommands_ = CommandStop;
+    commandPending_.store(true, std::memory_order_release);
+}
+
+void IOCapture::applyCommands(std::uint32_t word) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    const int commands = pendingCommands_;
+    pendingCommands_ = 0;
+    commandPending_.store(false, std::memory_order_relaxed);
+
+    if (commands & CommandStop) {
+        setPhase(State::Idle);
+    }
+    if (commands & CommandArm) {
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        settings_ = pending_;
+        active_ = pending_;
+        head_ = 0;
+        triggerIndex_ = 0;
+        remaining_ = 0;
+        previous_ = word;  // no edge on the first sample
+        softwareTrigger_ = false;
+        setPhase(State::Armed);
+    }
+    if (commands & CommandFire) {
+        softwareTrigger_ = phase_ == State::Armed;
+    }
+}
+
+bool IOCapture::collect(Result& result, const std::vector<std::string>& channels, std::size_t maxTransitions) const {
+    if (state() != State::Done) return false;
+    const std::uint64_t generation = generation_.load(std::memory_order_acquire);
+
+    Settings settings;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        settings = active_;
+    }
+
+    const std::uint64_t end = head_;
+    std::uint64_t start = triggerIndex_ > settings.pre ? triggerIndex_ - settings.pre : 0;
+    if (end > ring_.size()) start = std::max<std::uint64_t>(start, end - ring_.size());
+
+    result = Result();
+    result.channels = channels;
+    result.trigger = describe(settings, channels);
+    result.samples = end - start;
+    if (result.samples == 0) return false;
+
+    const Sample first = ring_[start & mask_];
+    result.startNs = first.timeNs;
+    result.triggerNs = ring_[triggerIndex_ & mask_].timeNs;
+    result.transitions.push_back(first);
+
+    std::int64_t previousTime = first.timeNs;
+    std::uint32_t previousWord = first.word;
+    std::int64_t maxInterval = 0;
+    for (std::uint64_t i = start + 1; i < end; ++i) {
+        const Sample sample = ring_[i & mask_];
+        maxInterval = std::max(maxInterval, sample.timeNs - previousTime);
+        previousTime = sample.timeNs;
+        if (sample.word == previousWord) continue;
+        previousWord = sample.word;
+        if (result.transitions.size() < maxTransitions) {
+            result.transitions.push_back(sample);
+        } else {
+            result.truncated = true;
+        }
+    }
+    result.endNs = previousTime;
+    if (result.samples > 1) {
+        result.meanIntervalUs = (result.endNs - result.startNs) / 1000.0 / static_cast<double>(result.samples - 1);
+    }
+    result.maxIntervalUs = maxInterval / 1000.0;
+
+    // Re-armed while copying: the ring may have been overwritten
+    return generation_.load(std::memory_order_acquire) == generation;
+}
+
+bool IOCapture::parseSettings(const nlohmann::json& json, const std::vector<std::string>& channels,
+                              Settings& settings, std::string& error) {
+    try {
+        settings = Settings();
+        const std::string trigger = json.value("trigger", std::string("software"));
+        if (trigger == "edge") {
+            settings.trigger = Trigger::Edge;
+            const std::string channel = json.value("channel", std::string());
+            settings.bit = channelBit(channels, channel);
+            if (settings.bit < 0) {
+                error = "unknown channel '" + channel + "'";
+                return false;
+            }
+            const std::string edge = json.value("edge", std::string("rising"));
+            if (edge == "rising") settings.edge = Edge::Rising;
+            else if (edge == "falling") settings.edge = Edge::Falling;
+            else if (edge == "any") settings.edge = Edge::Any;
+            else {
+                error = "unknown edge '" + edge + "'";
+                return false;
+            }
+        } else if (trigger == "pattern") {
+            settings.trigger = Trigger::Pattern;
+            const nlohmann::json pattern = json.value("pattern", nlohmann::json::object());
+            for (const auto& [name, state] : pattern.items()) {
+                const int bit = channelBit(channels, name);
+                if (bit < 0) {
+                    error = "unknown channel '" + name + "'";
+                    return false;
+                }
+                settings.mask |= std::uint32_t(1) << bit;
+                if (state.get<int>() != 0) settings.value |= std::uint32_t(1) << bit;
+            }
+            if (settings.mask == 0) {
+                error = "pattern has no channels";
+                return false;
+            }
+        } else if (trigger == "software") {
+            settings.trigger = Trigger::Software;
+        } else {
+            error = "unknown trigger '" + trigger + "'";
+            return false;
+        }
+        settings.pre = json.value("pre", settings.pre);
+        settings.post = json.value("post", settings.post);
+        return true;
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+}
+
+std::string IOCapture::describe(const Settings& settings, const std::vector<std::string>& channels) {
+    switch (settings.trigger) {
+    case Trigger::Edge: {
+        const char* edge = settings.edge == Edge::Rising ? "rising" : settings.edge == Edge::Falling ? "falling" : "any edge";
+        return std::string(edge) + " " + channelName(channels, settings.bit);
+    }
+    case Trigger::Pattern: {
+        std::string text = "pattern";
+        for (int bit = 0; bit < 32; ++bit) {
+            if (!(settings.mask & (std::uint32_t(1) << bit))) continue;
+            text += " " + channelName(channels, bit) + "=" + ((settings.value >> bit) & 1u ? "1" : "0");
+        }
+        return text;
+    }
+    case Trigger::Software:
+        break;
+    }
+    return "software";
+}
+
+nlohmann::json IOCapture::encodeResult(const Result& result) {
+    // Transitions as [time since start in ns, word] pairs to keep the message small
+    nlohmann::json transitions = nlohmann::json::array();
+    for (const auto& sample : result.transitions) {
+        transitions.push_back({sample.timeNs - result.startNs, sample.word});
+    }
+    return {{"channels", result.channels}, {"transitions", std::move(transitions)},
+            {"startNs", result.startNs}, {"endNs", result.endNs}, {"triggerNs", result.triggerNs},
+            {"samples", result.samples}, {"meanIntervalUs", result.meanIntervalUs},
+            {"maxIntervalUs", result.maxIntervalUs}, {"trigger", result.trigger}, {"truncated", result.truncated}};
+}
+
+IOCapture::Result IOCapture::decodeResult(const nlohmann::json& json) {
+    Result result;
+    result.channels = json.value("channels", std::vector<std::string>());
+    result.startNs = json.value("startNs", std::int64_t{0});
+    result.endNs = json.value("endNs", std::int64_t{0});
+    result.triggerNs = json.value("triggerNs", std::int64_t{0});
+    result.samples = json.value("samples", std::uint64_t{0});
+    result.meanIntervalUs = json.value("meanIntervalUs", 0.0);
+    result.maxIntervalUs = json.value("maxIntervalUs", 0.0);
+    result.trigger = json.value("trigger", std::string());
+    result.truncated = json.value("truncated", false);
+    for (const auto& pair : json.value("transitions", nlohmann::json::array())) {
+        result.transitions.push_back({result.startNs + pair.at(0).get<std::int64_t>(), pair.at(1).get<std::uint32_t>()});
+    }
+    return result;
+}
+
+const char* IOCapture::stateName(State state) {
+    switch (state) {
+    case State::Idle: return "idle";
+    case State::Armed: return "armed";
+    case State::Triggered: return "triggered";
+    case State::Done: return "done";
+    }
+    return "unknown";
+}
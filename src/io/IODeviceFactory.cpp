@@ -0,0 +1,15 @@
+#include "io/IODeviceFactory.h"
+#include "io/ModbusTcpIO.h" // before PCI7248IO.h: winsock2.h must precede windows.h
+#include "io/PCI7248IO.h"
+#include "Logger.h"
+
+std::unique_ptr<IOInterface> createIODevice(EventQueue<EventVariant>& eventQueue, const Config& config) {
+    const std::string device = config.getIODevice();
+    if (device == "ModbusTCP") {
+        return std::make_unique<ModbusTcpIO>(eventQueue, config);
+    }
+    if (device != "PCI7248") {
+        getLogger()->error("Unknown io.device '{}'; using the PCI7248", device);
+    }
+    return std::make_unique<PCI7248IO>(eventQueue, config);
+}
@@ -0,0 +1,530 @@
+#include "io/ModbusTcpIO.h"
+#include "io/ModbusProtocol.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+constexpr std::int64_t kNsPerMs = 1000000;
+constexpr std::int64_t kStatsIntervalNs = 10000 * kNsPerMs;
+constexpr int kShutdownFlushMs = 500; // time given to the output reset before the connection closes
+
+std::int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int sendFlags() {
+#ifdef MSG_NOSIGNAL
+    return MSG_NOSIGNAL;
+#else
+    return 0;
+#endif
+}
+
+} // namespace
+
+ModbusTcpIO::ModbusTcpIO(EventQueue<EventVariant>& eventQueue, const Config& config)
+    : eventQueue_(eventQueue),
+      config_(config),
+      capture_(config.getCaptureSettings().value("samples", std::size_t{262144}))
+{
+    inputChannels_ = config_.getInputs();
+    outputChannels_ = config_.getOutputs();
+
+    try {
+        const auto modbus = config_.getModbusIoSettings();
+        options_.host = modbus.value("host", options_.host);
+        options_.port = modbus.value("port", options_.port);
+        options_.unitId = modbus.value("unitId", options_.unitId);
+        options_.scanMs = std::max(1, modbus.value("scanMs", options_.scanMs));
+        options_.timeoutMs = std::max(10, modbus.value("timeoutMs", options_.timeoutMs));
+        options_.reconnectMs = std::max(100, modbus.value("reconnectMs", options_.reconnectMs));
+        options_.maxOutstanding = std::max(1, modbus.value("maxOutstanding", options_.maxOutstanding));
+        options_.maxGap = std::max(0, modbus.value("maxGap", options_.maxGap));
+        options_.inputTable = modbus.value("inputTable", options_.inputTable);
+    } catch (const std::exception& e) {
+        getLogger()->error("[ModbusTcpIO] Invalid io.modbus settings: {}", e.what());
+    }
+
+    try {
+        const auto journal = config_.getEdgeJournalSettings();
+        if (journal.value("enabled", true)) {
+            EdgeJournal::Options options;
+            options.directory = journal.value("directory", options.directory);
+            options.partitionHours = journal.value("partitionHours", options.partitionHours);
+            options.retentionDays = journal.value("retentionDays", options.retentionDays);
+            options.blockEdges = journal.value("blockEdges", options.blockEdges);
+            options.flushSeconds = journal.value("flushSeconds", options.flushSeconds);
+            journal_ = std::make_unique<EdgeJournal>(options);
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("Invalid edge journal settings: {}", e.what());
+    }
+}
+
+ModbusTcpIO::~ModbusTcpIO() {
+    getLogger()->debug("Shutting down ModbusTcpIO...");
+    stopPolling();
+
+    if (thread_.joinable()) {
+        // Outputs off, and give the IO thread a moment to deliver the write
+        resetConfiguredOutputPorts();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kShutdownFlushMs);
+        while (connected_ && (outputsDirty_ || writesPending_ > 0) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        stopping_ = true;
+        thread_.join();
+    }
+
+    if (journal_) journal_->stop();
+    getLogger()->flush();
+}
+
+// Sorted channels -> read/write ranges; sets each channel's range index
+std::vector<ModbusTcpIO::Range> ModbusTcpIO::buildRanges(std::vector<Mapped>& channels, int maxGap,
+                                                         std::uint16_t maxBits) {
+    std::sort(channels.begin(), channels.end(), [](const Mapped& a, const Mapped& b) { return a.address < b.address; });
+    std::vector<Range> ranges;
+    for (auto& channel : channels) {
+        if (!ranges.empty()) {
+            Range& last = ranges.back();
+            const int end = last.start + last.count; // exclusive
+            const int span = channel.address + 1 - last.start;
+            if (channel.address < end) {
+                channel.range = ranges.size() - 1; // same address mapped twice
+                continue;
+            }
+            if (channel.address - end <= maxGap && span <= maxBits) {
+                last.count = static_cast<std::uint16_t>(span);
+                channel.range = ranges.size() - 1;
+                continue;
+            }
+        }
+        ranges.push_back({channel.address, 1});
+        channel.range = ranges.size() - 1;
+    }
+    return ranges;
+}
+
+bool ModbusTcpIO::initialize() {
+    if (!runtime_.ok()) {
+        getLogger()->error("[ModbusTcpIO] Socket runtime initialization failed");
+        return false;
+    }
+    if (options_.inputTable != "discreteInputs" && options_.inputTable != "coils") {
+        getLogger()->error("[ModbusTcpIO] io.modbus.inputTable must be \"discreteInputs\" or \"coils\", not \"{}\"",
+                           options_.inputTable);
+        return false;
+    }
+
+    auto mapChannels = [](std::unordered_map<std::string, IOChannel>& channels, std::vector<Mapped>& mapped) {
+        bool valid = true;
+        for (auto& [name, channel] : channels) {
+            if (channel.pin < 0 || channel.pin > 0xFFFF) {
+                getLogger()->error("[ModbusTcpIO] Channel '{}' has an invalid Modbus address: {}", name, channel.pin);
+                valid = false;
+                continue;
+            }
+            channel.ioPort = "modbus";
+            mapped.push_back({name, static_cast<std::uint16_t>(channel.pin), 0});
+        }
+        return valid;
+    };
+    if (!mapChannels(inputChannels_, inputs_) || !mapChannels(outputChannels_, outputs_)) return false;
+
+    readRanges_ = buildRanges(inputs_, options_.maxGap, Modbus::kMaxReadBits);
+    writeRanges_ = buildRanges(outputs_, 0, Modbus::kMaxWriteBits); // never write unmapped coils
+    readBits_.clear();
+    for (const auto& range : readRanges_) readBits_.emplace_back(range.count, 0);
+    desiredCoils_.assign(outputs_.size(), 0);
+
+    for (auto& [name, channel] : inputChannels_) {
+        channel.state = 0;
+        channel.eventType = IOEventType::None;
+    }
+    if (inputs_.size() + outputs_.size() > 32) {
+        getLogger()->warn("[ModbusTcpIO] {} channels mapped; capture and edge journal cover the first 32",
+                          inputs_.size() + outputs_.size());
+    }
+    getLogger()->info("[ModbusTcpIO] {}:{} unit {}: {} inputs in {} read requests, {} outputs in {} write requests, scan every {} ms",
+                      options_.host, options_.port, options_.unitId, inputs_.size(), readRanges_.size(), outputs_.size(),
+                      writeRanges_.size(), options_.scanMs);
+
+    if (journal_ && !journal_->start(captureChannels())) {
+        getLogger()->error("Failed to start the IO edge journal; edges are not recorded.");
+        journal_.reset();
+    }
+
+    // The device may come up later; the IO thread keeps reconnecting
+    stopping_ = false;
+    scanning_ = true;
+    thread_ = std::thread([this]() { ioLoop(); });
+    return true;
+}
+
+void ModbusTcpIO::stopPolling() {
+    scanning_ = false;
+    getLogger()->debug("[ModbusTcpIO] {} scans, {} overruns, {} exceptions, {} reconnects", scans_.load(),
+                       overruns_.load(), exceptions_.load(), reconnects_.load());
+}
+
+void ModbusTcpIO::ioLoop() {
+    const std::int64_t scanNs = static_cast<std::int64_t>(options_.scanMs) * kNsPerMs;
+    const std::int64_t timeoutNs = static_cast<std::int64_t>(options_.timeoutMs) * kNsPerMs;
+    std::int64_t nextScanNs = steadyNs();
+    statsStartNs_ = nextScanNs;
+    bool everConnected = false;
+
+    while (!stopping_) {
+        if (!connected_) {
+            if (!connectSocket()) {
+                const auto retryAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.reconnectMs);
+                while (!stopping_ && std::chrono::steady_clock::now() < retryAt) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+                continue;
+            }
+            if (everConnected) ++reconnects_;
+            everConnected = true;
+            outputsDirty_ = true; // the device may have reset its coils
+            nextScanNs = steadyNs();
+        }
+
+        std::int64_t now = steadyNs();
+        if (outputsDirty_.exchange(false)) queueOutputs();
+
+        if (now >= nextScanNs) {
+            if (scanRemaining_ > 0) {
+                ++overruns_;
+            } else if (scanning_ && !readRanges_.empty()) {
+                if (lastScanStartNs_ != 0) scanInterval_.record(static_cast<std::uint64_t>((now - lastScanStartNs_) / 1000));
+                lastScanStartNs_ = now;
+                scanStartNs_ = now;
+                scanRemaining_ = readRanges_.size();
+                for (std::size_t i = 0; i < readRanges_.size(); ++i) queue_.push_back({false, i});
+            }
+            nextScanNs += scanNs;
+            if (nextScanNs <= now) nextScanNs = now + scanNs; // fell behind: skip, do not burst
+        }
+
+        sendRequests(now);
+        if (!flushSend()) continue;
+        if (!pending_.empty() && now - pending_.front().sentNs > timeoutNs) {
+            disconnect("request timed out after " + std::to_string(options_.timeoutMs) + " ms");
+            continue;
+        }
+
+        // Sleep until the next scan, but at most 1 ms so queued output writes go out promptly
+        const int waitMs = static_cast<int>(std::clamp<std::int64_t>((nextScanNs - now) / kNsPerMs, 0, 1));
+        pollfd pfd{};
+        pfd.fd = socket_;
+        pfd.events = static_cast<short>(POLLIN | (sendBuffer_.empty() ? 0 : POLLOUT));
+        if (pollSockets(&pfd, 1, waitMs) < 0) {
+            disconnect("poll failed: " + std::to_string(lastSocketError()));
+            continue;
+        }
+        now = steadyNs();
+        if ((pfd.revents & (POLLIN | POLLERR | POLLHUP)) && !receive(now)) continue;
+        logStats(now);
+    }
+    disconnect("shutting down");
+}
+
+bool ModbusTcpIO::connectSocket() {
+    const std::string address = options_.host == "localhost" ? "127.0.0.1" : options_.host;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<unsigned short>(options_.port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        if (!connectFailureLogged_) getLogger()->error("[ModbusTcpIO] Invalid IPv4 address '{}'", options_.host);
+        connectFailureLogged_ = true;
+        return false;
+    }
+
+    socket_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalidSocket) return false;
+    setNonBlocking(s);
+    int error = 0;
+    if (::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error = lastSocketError();
+        if (isConnectPending(error)) {
+            pollfd pfd{};
+            pfd.fd = s;
+            pfd.events = POLLOUT;
+            const int ready = pollSockets(&pfd, 1, options_.timeoutMs);
+            error = ready > 0 ? pendingSocketError(s) : (ready == 0 ? -1 : lastSocketError());
+        }
+    }
+    if (error != 0) {
+        closeSocket(s);
+        if (!connectFailureLogged_) {
+            getLogger()->warn("[ModbusTcpIO] Cannot connect to {}:{} ({}); retrying every {} ms", options_.host,
+                              options_.port, error == -1 ? "timeout" : std::to_string(error), options_.reconnectMs);
+            connectFailureLogged_ = true;
+        }
+        return false;
+    }
+
+    int noDelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    socket_ = s;
+    connected_ = true;
+    connectFailureLogged_ = false;
+    getLogger()->info("[ModbusTcpIO] Connected to {}:{}", options_.host, options_.port);
+    return true;
+}
+
+void ModbusTcpIO::disconnect(const std::string& reason) {
+    if (socket_ == kInvalidSocket) return;
+    closeSocket(socket_);
+    socket_ = kInvalidSocket;
+    connected_ = false;
+    queue_.clear();
+    pending_.clear();
+    receiveBuffer_.clear();
+    sendBuffer_.clear();
+    scanRemaining_ = 0;
+    writesPending_ = 0;
+    if (!stopping_) getLogger()->warn("[ModbusTcpIO] Disconnected from {}:{}: {}", options_.host, options_.port, reason);
+}
+
+// Writes go ahead of reads; a range already queued is sent with the latest coils anyway
+void ModbusTcpIO::queueOutputs() {
+    std::vector<Request> writes;
+    for (std::size_t i = 0; i < writeRanges_.size(); ++i) {
+        const bool queued = std::any_of(queue_.begin(), queue_.end(),
+                                        [&](const Request& r) { return r.write && r.range == i; });
+        if (!queued) writes.push_back({true, i});
+    }
+    writesPending_ += static_cast<int>(writes.size());
+    queue_.insert(queue_.begin(), writes.begin(), writes.end());
+}
+
+void ModbusTcpIO::sendRequests(std::int64_t nowNs) {
+    const std::uint8_t readFunction =
+        options_.inputTable == "coils" ? Modbus::ReadCoils : Modbus::ReadDiscreteInputs;
+    std::size_t sent = 0;
+    while (sent < queue_.size() && pending_.size() < static_cast<std::size_t>(options_.maxOutstanding)) {
+        const Request request = queue_[sent++];
+        const std::uint16_t transaction = nextTransaction_++;
+        if (request.write) {
+            const Range& range = writeRanges_[request.range];
+            std::vector<std::uint8_t> bits(range.count, 0);
+            {
+                std::lock_guard<std::mutex> lock(outputMutex_);
+                for (std::size_t i = 0; i < outputs_.size(); ++i) {
+                    if (outputs_[i].range == request.range) bits[outputs_[i].address - range.start] = desiredCoils_[i];
+                }
+            }
+            Modbus::appendFrame(sendBuffer_, transaction, static_cast<std::uint8_t>(options_.unitId),
+                                Modbus::WriteMultipleCoils, Modbus::writeCoilsBody(range.start, bits, 0, range.count));
+        } else {
+            const Range& range = readRanges_[request.range];
+            Modbus::appendFrame(sendBuffer_, transaction, static_cast<std::uint8_t>(options_.unitId), readFunction,
+                                Modbus::readBody(range.start, range.count));
+        }
+        pending_.push_back({transaction, request, nowNs});
+    }
+    queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(sent));
+}
+
+// Sends what the socket takes now; false if the connection was dropped
+bool ModbusTcpIO::flushSend() {
+    while (!sendBuffer_.empty()) {
+        const int n = ::send(socket_, sendBuffer_.data(), static_cast<int>(sendBuffer_.size()), sendFlags());
+        if (n > 0) {
+            sendBuffer_.erase(0, static_cast<std::size_t>(n));
+            continue;
+        }
+        const int error = lastSocketError();
+        if (n < 0 && isWouldBlock(error)) return true;
+        disconnect("send failed: " + std::to_string(error));
+        return false;
+    }
+    return true;
+}
+
+bool ModbusTcpIO::receive(std::int64_t nowNs) {
+    char chunk[4096];
+    for (;;) {
+        const int n = ::recv(socket_, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            receiveBuffer_.append(chunk, static_cast<std::size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            disconnect("closed by the device");
+            return false;
+        }
+        const int error = lastSocketError();
+        if (isWouldBlock(error)) break;
+        disconnect("receive failed: " + std::to_string(error));
+        return false;
+    }
+
+    std::size_t offset = 0;
+    for (;;) {
+        Modbus::Frame frame;
+        const long size = Modbus::parseFrame(receiveBuffer_.data() + offset, receiveBuffer_.size() - offset, frame);
+        if (size < 0) {
+            disconnect("invalid Modbus/TCP frame");
+            return false;
+        }
+        if (size == 0) break;
+        handleFrame(receiveBuffer_.data() + offset, static_cast<std::size_t>(size), nowNs);
+        offset += static_cast<std::size_t>(size);
+        if (!connected_) return false;
+    }
+    receiveBuffer_.erase(0, offset);
+    return true;
+}
+
+void ModbusTcpIO::handleFrame(const char* data, std::size_t size, std::int64_t nowNs) {
+    Modbus::Frame frame;
+    Modbus::parseFrame(data, size, frame);
+    auto it = std::find_if(pending_.begin(), pending_.end(),
+                           [&](const Pending& p) { return p.transaction == frame.transaction; });
+    if (it == pending_.end()) {
+        getLogger()->debug("[ModbusTcpIO] Response for unknown transaction {}", frame.transaction);
+        return;
+    }
+    const Pending done = *it;
+    pending_.erase(it);
+    roundTrip_.record(static_cast<std::uint64_t>((nowNs - done.sentNs) / 1000));
+
+    const Range& range = done.request.write ? writeRanges_[done.request.range] : readRanges_[done.request.range];
+    if (frame.function & 0x80) {
+        ++exceptions_;
+        const std::uint8_t code = frame.bodySize > 0 ? frame.body[0] : 0;
+        getLogger()->warn("[ModbusTcpIO] {} of {} bits at {} failed: {} ({})", done.request.write ? "Write" : "Read",
+                          range.count, range.start, Modbus::exceptionName(code), code);
+    } else if (!done.request.write) {
+        const std::size_t bytes = (range.count + 7u) / 8u;
+        if (frame.bodySize < 1 + bytes || frame.body[0] < bytes) {
+            getLogger()->warn("[ModbusTcpIO] Short read response for {} bits at {}", range.count, range.start);
+        } else {
+            auto& bits = readBits_[done.request.range];
+            for (std::size_t i = 0; i < range.count; ++i) bits[i] = Modbus::getBit(frame.body + 1, i) ? 1 : 0;
+        }
+    }
+
+    if (done.request.write) {
+        --writesPending_;
+    } else if (scanRemaining_ > 0 && --scanRemaining_ == 0) {
+        finishScan(nowNs);
+    }
+}
+
+// All reads of a scan answered: update the channels and report edges
+void ModbusTcpIO::finishScan(std::int64_t nowNs) {
+    scanTime_.record(static_cast<std::uint64_t>((nowNs - scanStartNs_) / 1000));
+    ++scans_;
+
+    bool anyChange = false;
+    std::uint32_t word = 0;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        for (std::size_t i = 0; i < inputs_.size(); ++i) {
+            const Mapped& mapped = inputs_[i];
+            const int newState = readBits_[mapped.range][mapped.address - readRanges_[mapped.range].start];
+            if (i < 32 && newState) word |= 1u << i;
+
+            IOChannel& channel = inputChannels_[mapped.name];
+            if (channel.state != newState) {
+                channel.eventType = !primed_ ? IOEventType::None
+                                             : (newState ? IOEventType::Rising : IOEventType::Falling);
+                if (primed_) {
+                    getLogger()->debug("Input state change: {} ({}) from {} to {}", channel.name,
+                                       newState ? "Rising" : "Falling", channel.state, newState);
+                }
+                channel.state = newState;
+                anyChange = true;
+            } else {
+                channel.eventType = IOEventType::None;
+            }
+        }
+    }
+    primed_ = true;
+    inputWord_ = word;
+    if (anyChange) pushStateEvent();
+
+    const std::uint32_t sample = inputWord_ | outputWord_.load(std::memory_order_relaxed);
+    if (journal_) journal_->record(nowNs, sample);
+    if (capture_.record(nowNs, sample)) {
+        GuiEvent captured;
+        captured.keyword = "IOCapture";
+        captured.target = "collect";
+        eventQueue_.push(captured);
+    }
+}
+
+void ModbusTcpIO::pushStateEvent() {
+    IOEvent event;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        event.channels = inputChannels_;
+    }
+    eventQueue_.push(event);
+}
+
+void ModbusTcpIO::logStats(std::int64_t nowNs) {
+    if (nowNs - statsStartNs_ < kStatsIntervalNs) return;
+    const auto scan = scanTime_.snapshot();
+    const auto rtt = roundTrip_.snapshot();
+    const auto scanWindow = scan.since(statsScanTime_);
+    const auto rttWindow = rtt.since(statsRoundTrip_);
+    getLogger()->debug(
+        "[Modbus Stats] Scans: {} | Scan avg {:.2f}ms p99 {:.2f}ms | Round trip avg {:.2f}ms p99 {:.2f}ms | Overruns: {} | Exceptions: {} | Reconnects: {}",
+        scanWindow.count, scanWindow.meanUs() / 1000.0, scanWindow.percentile(0.99) / 1000.0, rttWindow.meanUs() / 1000.0,
+        rttWindow.percentile(0.99) / 1000.0, overruns_.load(), exceptions_.load(), reconnects_.load());
+    statsScanTime_ = scan;
+    statsRoundTrip_ = rtt;
+    statsStartNs_ = nowNs;
+}
+
+// Same contract as PCI7248IO: channels in the map with a non-zero state are ON, all others OFF
+bool ModbusTcpIO::writeOutputs(const std::unordered_map<std::string, IOChannel>& desiredOnOutputs) {
+    {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        for (const auto& [name, channel] : desiredOnOutputs) {
+            if (!outputChannels_.count(name)) {
+                getLogger()->warn("Attempted to write to non-configured or non-output channel: {}", name);
+            }
+        }
+        std::uint32_t word = 0;
+        for (std::size_t i = 0; i < outputs_.size(); ++i) {
+            auto it = desiredOnOutputs.find(outputs_[i].name);
+            desiredCoils_[i] = it != desiredOnOutputs.end() && it->second.state != 0 ? 1 : 0;
+            const std::size_t bit = inputs_.size() + i;
+            if (bit < 32 && desiredCoils_[i]) word |= 1u << bit;
+        }
+        outputWord_.store(word, std::memory_order_relaxed);
+    }
+    outputsDirty_ = true;
+    return connected_.load();
+}
+
+bool ModbusTcpIO::resetConfiguredOutputPorts() {
+    getLogger()->debug("Resetting configured Modbus coils to OFF state.");
+    return writeOutputs({});
+}
+
+std::unordered_map<std::string, IOChannel> ModbusTcpIO::getInputChannelsSnapshot() const {
+    std::lock_guard<std::mutex> lock(inputMutex_);
+    return inputChannels_;
+}
+
+const std::unordered_map<std::string, IOChannel>& ModbusTcpIO::getOutputChannels() const {
+    return outputChannels_;
+}
+
+std::vector<std::string> ModbusTcpIO::captureChannels() const {
+    std::vector<std::string> channels;
+    for (const auto& mapped : inputs_) channels.push_back(mapped.name);
+    for (const auto& mapped : outputs_) channels.push_back(mapped.name);
+    channels.resize(std::min<std::size_t>(channels.size(), 32));
+    return channels;
+}
@@ -18,10 +18,26 @@ PCI7248IO::PCI7248IO(EventQueue<EventVariant>& eventQueue, const Config& config)
       minDuration(std::numeric_limits<long long>::max()),
       maxDuration(0),
       iterationCount(0),
-      delaysOver5ms(0)
+      delaysOver5ms(0),
+      capture_(config.getCaptureSettings().value("samples", std::size_t{262144}))
 {
     inputChannels_ = config_.getInputs();
     outputChannels_ = config_.getOutputs();
+
+    try {
+        const auto journal = config_.getEdgeJournalSettings();
+        if (journal.value("enabled", true)) {
+            EdgeJournal::Options options;
+            options.directory = journal.value("directory", options.directory);
+            options.partitionHours = journal.value("partitionHours", options.partitionHours);
+            options.retentionDays = journal.value("retentionDays", options.retentionDays);
+            options.blockEdges = journal.value("blockEdges", options.blockEdges);
+            options.flushSeconds = journal.value("flushSeconds", options.flushSeconds);
+            journal_ = std::make_unique<EdgeJournal>(options);
+        }
+    } catch (const std::exception& e) {
+        getLogger()->error("Invalid edge journal settings: {}", e.what());
+    }
 }
 
 PCI7248IO::~PCI7248IO() {
@@ -44,6 +60,9 @@ PCI7248IO::~PCI7248IO() {
     // Ensure outputs are in a safe state before releasing the card
     resetConfiguredOutputPorts();
 
+    // Write out the queued edges
+    if (journal_) journal_->stop();
+
     // Release the hardware card
     if (card_ >= 0) {
         Release_Card(card_);
@@ -103,6 +122,11 @@ bool PCI7248IO::initialize() {
     readInitialInputStates(portToChannel);
     logConfiguredChannels();
 
+    if (journal_ && !journal_->start(captureChannels())) {
+        getLogger()->error("Failed to start the IO edge journal; edges are not recorded.");
+        journal_.reset();
+    }
+
     // Reset outputs to a known state (off) after configuration
     if (!resetConfiguredOutputPorts()) {
         getLogger()->error("Failed to perform initial reset of configured output ports.");
@@ -274,10 +298,21 @@ void PCI7248IO::pollingIteration() {
         pushStateEvent();
     }
 
+    const auto nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    const std::uint32_t word = inputWord_ | outputWord_.load(std::memory_order_relaxed);
+    if (journal_) journal_->record(nowNs, word);
+    if (capture_.record(nowNs, word)) {
+        GuiEvent captured;
+        captured.keyword = "IOCapture";
+        captured.target = "collect";
+        eventQueue_.push(captured);
+    }
+
     {
         std::lock_guard<std::mutex> lock(this->statsMutex);
         if (this->lastCallbackTime != std::chrono::steady_clock::time_point()) {
             const auto interval = std::chrono::duration_cast<std::chrono::microseconds>(now - this->lastCallbackTime).count();
+            this->pollInterval_.record(static_cast<std::uint64_t>(interval));
             this->totalDuration += interval;
             this->minDuration = std::min(this->minDuration, interval);
             this->maxDuration = std::max(this->maxDuration, interval);
@@ -322,6 +357,7 @@ void PCI7248IO::pollingIteration() {
 // Reads input ports, checks for state changes, and updates `inputChannels_`.
 bool PCI7248IO::updateInputStates() {
     bool anyChange = false;
+    std::uint32_t word = 0;
     std::lock_guard<std::mutex> lock(inputMutex_); // Protect inputChannels_ during update
 
     for (const auto& [portName, portTypeStr] : portsConfig_) {
@@ -339,6 +375,7 @@ bool PCI7248IO::updateInputStates() {
         // Apply active-low logic (assumed)
         portValue = ~portValue;
         int baseOffset = getPortBaseOffset(portName);
+        word |= (portValue & (baseOffset >= 16 ? 0x0Fu : 0xFFu)) << baseOffset; // CL/CH are 4 bits wide
 
         for (auto& [chanName, channel] : inputChannels_) {
             if (channel.ioPort != portName) continue;
@@ -364,6 +401,7 @@ bool PCI7248IO::updateInputStates() {
             }
         }
     }
+    inputWord_ = word;
     return anyChange;
 }
 
@@ -433,6 +471,12 @@ bool PCI7248IO::writeOutputs(const std::unordered_map<std::string, IOChannel>& d
         }
     }
 
+    std::uint32_t outputWord = 0;
+    for (const auto& [portName, aggregateValue] : portAggregates) {
+        outputWord |= aggregateValue << getPortBaseOffset(portName);
+    }
+    outputWord_.store(outputWord, std::memory_order_relaxed);
+
     // Write the final aggregated value to each physical output port.
     bool overallSuccess = true;
     for (const auto& [portName, aggregateValue] : portAggregates) {
@@ -492,6 +536,21 @@ const std::unordered_map<std::string, IOChannel>& PCI7248IO::getOutputChannels()
     return outputChannels_;
 }
 
+// Name per capture bit: inputs and outputs by pin number.
+std::vector<std::string> PCI7248IO::captureChannels() const {
+    std::vector<std::string> channels(24);
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        for (const auto& [name, channel] : inputChannels_) {
+            if (channel.pin >= 0 && channel.pin < 24) channels[channel.pin] = name;
+        }
+    }
+    for (const auto& [name, channel] : outputChannels_) {
+        if (channel.pin >= 0 && channel.pin < 24) channels[channel.pin] = name;
+    }
+    return channels;
+}
+
 // Utility to map port name to the DASK channel constant.
 int PCI7248IO::getDaskChannel(const std::string& port) const {
     // Use static map for efficiency
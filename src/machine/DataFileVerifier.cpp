@@ -0,0 +1,446 @@
+#include "machine/DataFileVerifier.h"
+#include "utils/MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+using Issue = DataFileVerifier::Issue;
+using Options = DataFileVerifier::Options;
+
+constexpr std::size_t kProgressBytes = 1 << 20;
+constexpr auto kProgressInterval = std::chrono::milliseconds(50);
+constexpr unsigned kChunksPerThread = 4; // lets fast threads take over the tail
+
+// A key, found again from the offset of its line when duplicates are compared
+struct HashEntry {
+    std::uint64_t hash;
+    std::uint64_t lineOffset;
+};
+
+struct Chunk {
+    const char* begin{nullptr};
+    const char* end{nullptr};
+    std::uint64_t firstLine{0};    // physical lines before the chunk
+    std::uint64_t newlines{0};
+    std::uint64_t lines{0};
+    std::uint64_t shortLines{0};
+    std::uint64_t malformed{0};
+    std::uint64_t sequenceBreaks{0};
+    std::size_t minKeyLength{std::numeric_limits<std::size_t>::max()};
+    std::size_t maxKeyLength{0};
+    // Sequence state at the chunk edges, stitched once all chunks are read
+    bool hasKeys{false};
+    bool firstIsNumber{false};
+    bool lastIsNumber{false};
+    std::uint64_t firstNumber{0};
+    std::uint64_t lastNumber{0};
+    std::uint64_t firstKeyLine{0}; // chunk-local
+    std::vector<Issue> examples;   // chunk-local line numbers
+    std::vector<std::vector<HashEntry>> partitions;
+};
+
+std::uint64_t hashKey(std::string_view key) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    // FNV leaves the low bits weak; the partition is taken from them
+    hash ^= hash >> 29;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    return hash ^ (hash >> 32);
+}
+
+std::string_view lineFrom(const char* start, const char* fileEnd) {
+    const char* newline = static_cast<const char*>(std::memchr(start, '\n', static_cast<std::size_t>(fileEnd - start)));
+    std::string_view line(start, static_cast<std::size_t>((newline ? newline : fileEnd) - start));
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// false when the line has no complete key at the slice
+bool sliceKey(std::string_view line, const Options& options, std::string_view& key) {
+    const std::size_t start = static_cast<std::size_t>(std::max(0, options.startIndex));
+    if (start >= line.size()) return false;
+    if (options.length > 0) {
+        const std::size_t length = static_cast<std::size_t>(options.length);
+        if (line.size() - start < length) return false;
+        key = line.substr(start, length);
+    } else {
+        key = line.substr(start);
+    }
+    return true;
+}
+
+bool parseNumber(std::string_view text, std::uint64_t& value) {
+    if (text.empty() || text.size() > 19) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    return true;
+}
+
+bool hasControlBytes(std::string_view key) {
+    for (char c : key) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (byte < 0x20 || byte == 0x7F) return true;
+    }
+    return false;
+}
+
+std::string printable(std::string_view text) {
+    std::string out;
+    for (char c : text.substr(0, 64)) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (byte < 0x20 || byte == 0x7F) {
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "\\x%02X", byte);
+            out += hex;
+        } else {
+            out += c;
+        }
+    }
+    if (text.size() > 64) out += "...";
+    return out;
+}
+
+std::uint64_t nextInSequence(std::uint64_t previous, DataFileVerifier::Sequence sequence) {
+    return sequence == DataFileVerifier::Sequence::Ascending ? previous + 1 : previous - 1;
+}
+
+void addExample(std::vector<Issue>& examples, std::size_t& kept, std::size_t max, Issue::Kind kind,
+                std::uint64_t line, std::string text) {
+    if (kept >= max) return;
+    ++kept;
+    examples.push_back({kind, line, std::move(text)});
+}
+
+void readChunk(Chunk& chunk, const Options& options, std::size_t partitionCount, const std::atomic<bool>* cancel,
+               std::atomic<std::uint64_t>& bytesDone) {
+    chunk.partitions.resize(partitionCount);
+    std::size_t kept[4] = {0, 0, 0, 0};
+    auto note = [&](Issue::Kind kind, std::uint64_t line, std::string text) {
+        addExample(chunk.examples, kept[static_cast<int>(kind)], options.maxExamples, kind, line, std::move(text));
+    };
+    const bool wantNumber = options.numeric || options.sequence != DataFileVerifier::Sequence::None;
+    bool previousIsNumber = false;
+    std::uint64_t previous = 0;
+
+    const char* cursor = chunk.begin;
+    const char* reported = cursor;
+    while (cursor < chunk.end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(chunk.end - cursor)));
+        const char* lineEnd = newline ? newline : chunk.end;
+        std::string_view line(cursor, static_cast<std::size_t>(lineEnd - cursor));
+        const char* lineStart = cursor;
+        const std::uint64_t lineNumber = chunk.newlines + 1; // chunk-local, 1-based
+        cursor = newline ? newline + 1 : chunk.end;
+        if (newline) ++chunk.newlines;
+        if (cursor - reported >= static_cast<std::ptrdiff_t>(kProgressBytes)) {
+            bytesDone += static_cast<std::uint64_t>(cursor - reported);
+            reported = cursor;
+            if (cancel && *cancel) return;
+        }
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        ++chunk.lines;
+
+        std::string_view key;
+        if (!sliceKey(line, options, key)) {
+            ++chunk.shortLines;
+            note(Issue::Kind::ShortLine, lineNumber, printable(line));
+            previousIsNumber = false;
+            continue;
+        }
+        chunk.minKeyLength = std::min(chunk.minKeyLength, key.size());
+        chunk.maxKeyLength = std::max(chunk.maxKeyLength, key.size());
+
+        std::uint64_t number = 0;
+        const bool isNumber = wantNumber && parseNumber(key, number);
+        if (hasControlBytes(key) || (wantNumber && !isNumber)) {
+            ++chunk.malformed;
+            note(Issue::Kind::Malformed, lineNumber, printable(key));
+        }
+
+        if (!chunk.hasKeys) {
+            chunk.hasKeys = true;
+            chunk.firstIsNumber = isNumber;
+            chunk.firstNumber = number;
+            chunk.firstKeyLine = lineNumber;
+        }
+        if (options.sequence != DataFileVerifier::Sequence::None && isNumber && previousIsNumber &&
+            number != nextInSequence(previous, options.sequence)) {
+            ++chunk.sequenceBreaks;
+            note(Issue::Kind::SequenceBreak, lineNumber,
+                 "expected " + std::to_string(nextInSequence(previous, options.sequence)) + ", found " + std::string(key));
+        }
+        previousIsNumber = isNumber;
+        previous = number;
+
+        const std::uint64_t hash = hashKey(key);
+        chunk.partitions[hash % partitionCount].push_back({hash, static_cast<std::uint64_t>(lineStart - chunk.begin)});
+    }
+    chunk.lastIsNumber = previousIsNumber;
+    chunk.lastNumber = previous;
+    bytesDone += static_cast<std::uint64_t>(chunk.end - reported);
+}
+
+// Run 'work(index)' for every index on 'threads' threads, ticking about every 50 ms until all are done
+template <typename Work, typename Tick>
+void runParallel(std::size_t count, unsigned threads, Work work, Tick tick) {
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    unsigned finished = 0;
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (std::size_t i = next++; i < count; i = next++) work(i);
+            std::lock_guard<std::mutex> lock(mutex);
+            ++finished;
+            done.notify_one();
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!done.wait_for(lock, kProgressInterval, [&] { return finished == threads; })) {
+            lock.unlock();
+            tick();
+            lock.lock();
+        }
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+} // namespace
+
+const char* DataFileVerifier::kindName(Issue::Kind kind) {
+    switch (kind) {
+        case Issue::Kind::ShortLine: return "short line";
+        case Issue::Kind::Malformed: return "malformed";
+        case Issue::Kind::Duplicate: return "duplicate";
+        case Issue::Kind::SequenceBreak: return "sequence break";
+    }
+    return "issue";
+}
+
+std::string DataFileVerifier::Report::summary() const {
+    if (!opened) return "cannot open the file";
+    char text[256];
+    std::snprintf(text, sizeof(text), "%llu lines, %.1f MB in %.2f s", static_cast<unsigned long long>(lines),
+                  static_cast<double>(bytes) / 1e6, seconds);
+    std::string out = text;
+    if (cancelled) return out + ": cancelled";
+    if (ok()) return out + ": OK";
+    std::string issues;
+    auto add = [&](std::uint64_t count, const char* name) {
+        if (count == 0) return;
+        if (!issues.empty()) issues += ", ";
+        issues += std::to_string(count) + " " + name;
+    };
+    add(shortLines, "short lines");
+    add(malformed, "malformed keys");
+    add(duplicates, "duplicates");
+    add(sequenceBreaks, "sequence breaks");
+    return out + ": " + issues;
+}
+
+DataFileVerifier::Report DataFileVerifier::verify(const std::string& path, const Options& options,
+                                                  const Progress& progress, const std::atomic<bool>* cancel) {
+    const auto started = std::chrono::steady_clock::now();
+    Report report;
+    MappedFile file;
+    if (!file.open(path, false)) return report;
+    report.opened = true;
+    report.bytes = file.size();
+
+    const unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const char* fileBegin = file.data();
+    const char* fileEnd = fileBegin + file.size();
+
+    // Line-aligned chunks
+    std::vector<Chunk> chunks;
+    const std::size_t chunkCount = std::max<std::size_t>(1, std::min<std::size_t>(threads * kChunksPerThread,
+                                                                                  file.size() / kProgressBytes + 1));
+    const char* cursor = fileBegin;
+    for (std::size_t i = 1; i <= chunkCount && cursor < fileEnd; ++i) {
+        const char* end = i == chunkCount ? fileEnd : fileBegin + file.size() / chunkCount * i;
+        if (end < cursor) end = cursor;
+        const char* newline = static_cast<const char*>(std::memchr(end, '\n', static_cast<std::size_t>(fileEnd - end)));
+        end = newline ? newline + 1 : fileEnd;
+        chunks.emplace_back();
+        chunks.back().begin = cursor;
+        chunks.back().end = end;
+        cursor = end;
+    }
+
+    // Phase 1: read the chunks
+    const std::size_t partitionCount = threads;
+    std::atomic<std::uint64_t> bytesDone{0};
+    runParallel(chunks.size(), threads,
+                [&](std::size_t i) { readChunk(chunks[i], options, partitionCount, cancel, bytesDone); },
+                [&] {
+                    if (progress) progress("Reading", report.bytes ? static_cast<double>(bytesDone) / report.bytes : 1.0);
+                });
+    if (cancel && *cancel) {
+        report.cancelled = true;
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    // Stitch the chunks: line numbers, totals and the sequence across chunk edges
+    std::uint64_t firstLine = 0;
+    bool previousIsNumber = false;
+    std::uint64_t previous = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstLine = firstLine;
+        firstLine += chunk.newlines;
+        report.lines += chunk.lines;
+        report.shortLines += chunk.shortLines;
+        report.malformed += chunk.malformed;
+        report.sequenceBreaks += chunk.sequenceBreaks;
+        if (chunk.maxKeyLength > 0) {
+            report.minKeyLength = report.minKeyLength == 0 ? chunk.minKeyLength : std::min(report.minKeyLength, chunk.minKeyLength);
+            report.maxKeyLength = std::max(report.maxKeyLength, chunk.maxKeyLength);
+        }
+        for (auto& issue : chunk.examples) {
+            issue.line += chunk.firstLine;
+            report.examples.push_back(std::move(issue));
+        }
+        if (!chunk.hasKeys) continue;
+        if (options.sequence != Sequence::None && previousIsNumber && chunk.firstIsNumber &&
+            chunk.firstNumber != nextInSequence(previous, options.sequence)) {
+            ++report.sequenceBreaks;
+            report.examples.push_back({Issue::Kind::SequenceBreak, chunk.firstLine + chunk.firstKeyLine,
+                                       "expected " + std::to_string(nextInSequence(previous, options.sequence)) +
+                                           ", found " + std::to_string(chunk.firstNumber)});
+        }
+        previousIsNumber = chunk.lastIsNumber;
+        previous = chunk.lastNumber;
+    }
+
+    auto lineOf = [&](const char* address) {
+        auto it = std::upper_bound(chunks.begin(), chunks.end(), address,
+                                   [](const char* a, const Chunk& c) { return a < c.begin; });
+        const Chunk& chunk = *(it - 1);
+        return chunk.firstLine + 1 + static_cast<std::uint64_t>(std::count(chunk.begin, address, '\n'));
+    };
+
+    // Phase 2: duplicates, one partition per task
+    struct Repeat {
+        const char* line;
+        const char* first;
+    };
+    std::vector<std::uint64_t> duplicates(partitionCount, 0);
+    std::vector<std::vector<Repeat>> repeats(partitionCount);
+    std::atomic<std::size_t> partitionsDone{0};
+    runParallel(
+        partitionCount, threads,
+        [&](std::size_t p) {
+            if (cancel && *cancel) return;
+            // Counting sort on the top hash bits into buckets of about 32 entries,
+            // then a small cache-resident sort per bucket
+            std::size_t total = 0;
+            for (const auto& chunk : chunks) total += chunk.partitions[p].size();
+            unsigned bucketBits = 1;
+            while (bucketBits < 30 && (std::size_t(1) << bucketBits) * 32 < total) ++bucketBits;
+            const unsigned shift = 64 - bucketBits;
+            std::vector<std::size_t> bucketStart((std::size_t(1) << bucketBits) + 1, 0);
+            for (const auto& chunk : chunks) {
+                for (const auto& entry : chunk.partitions[p]) ++bucketStart[(entry.hash >> shift) + 1];
+            }
+            for (std::size_t b = 1; b < bucketStart.size(); ++b) bucketStart[b] += bucketStart[b - 1];
+            std::vector<HashEntry> entries(total);
+            std::vector<std::size_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+            for (auto& chunk : chunks) {
+                // Chunk-relative offsets become file offsets
+                const auto base = static_cast<std::uint64_t>(chunk.begin - fileBegin);
+                for (const auto& entry : chunk.partitions[p]) {
+                    entries[fill[entry.hash >> shift]++] = {entry.hash, base + entry.lineOffset};
+                }
+                std::vector<HashEntry>().swap(chunk.partitions[p]);
+            }
+            for (std::size_t b = 0; b + 1 < bucketStart.size(); ++b) {
+                std::sort(entries.begin() + static_cast<std::ptrdiff_t>(bucketStart[b]),
+                          entries.begin() + static_cast<std::ptrdiff_t>(bucketStart[b + 1]),
+                          [](const HashEntry& x, const HashEntry& y) {
+                              return x.hash != y.hash ? x.hash < y.hash : x.lineOffset < y.lineOffset;
+                          });
+            }
+            std::vector<std::pair<std::string_view, const char*>> run;
+            for (std::size_t i = 0; i < entries.size();) {
+                std::size_t j = i + 1;
+                while (j < entries.size() && entries[j].hash == entries[i].hash) ++j;
+                if (j - i > 1) {
+                    // Same hash: compare the keys themselves, in file order within equal keys
+                    run.clear();
+                    for (std::size_t k = i; k < j; ++k) {
+                        const char* line = fileBegin + entries[k].lineOffset;
+                        std::string_view key;
+                        sliceKey(lineFrom(line, fileEnd), options, key);
+                        run.emplace_back(key, line);
+                    }
+                    std::stable_sort(run.begin(), run.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+                    std::size_t first = 0;
+                    for (std::size_t k = 1; k < run.size(); ++k) {
+                        if (run[k].first != run[first].first) {
+                            first = k;
+                            continue;
+                        }
+                        ++duplicates[p];
+                        if (repeats[p].size() < options.maxExamples) repeats[p].push_back({run[k].second, run[first].second});
+                    }
+                }
+                i = j;
+            }
+            ++partitionsDone;
+        },
+        [&] {
+            if (progress) progress("Duplicates", static_cast<double>(partitionsDone) / partitionCount);
+        });
+
+    if (cancel && *cancel) {
+        report.cancelled = true;
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    std::vector<Issue> duplicateExamples;
+    for (std::size_t p = 0; p < partitionCount; ++p) {
+        report.duplicates += duplicates[p];
+        for (const auto& repeat : repeats[p]) {
+            std::string_view key;
+            sliceKey(lineFrom(repeat.line, fileEnd), options, key);
+            duplicateExamples.push_back({Issue::Kind::Duplicate, lineOf(repeat.line),
+                                         printable(key) + " (first on line " + std::to_string(lineOf(repeat.first)) + ")"});
+        }
+    }
+    std::sort(duplicateExamples.begin(), duplicateExamples.end(),
+              [](const Issue& a, const Issue& b) { return a.line < b.line; });
+    if (duplicateExamples.size() > options.maxExamples) duplicateExamples.resize(options.maxExamples);
+    report.examples.insert(report.examples.end(), duplicateExamples.begin(), duplicateExamples.end());
+
+    // Keep the first examples of each kind, in file order
+    std::stable_sort(report.examples.begin(), report.examples.end(),
+                     [](const Issue& a, const Issue& b) { return a.line < b.line; });
+    std::vector<Issue> examples;
+    std::size_t kept[4] = {0, 0, 0, 0};
+    for (auto& issue : report.examples) {
+        if (kept[static_cast<int>(issue.kind)]++ < options.maxExamples) examples.push_back(std::move(issue));
+    }
+    report.examples = std::move(examples);
+
+    if (progress) progress("Duplicates", 1.0);
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return report;
+}
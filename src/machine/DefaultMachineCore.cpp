@@ -1,16 +1,29 @@
 #include "machine/MachineCore.h"
+#include "machine/DuplicateDetector.h"
+#include "machine/FunctionBlocks.h"
+#include "machine/Sequence.h"
+#include "machine/ReferenceIndex.h"
+#include <algorithm>
 #include <cctype>
 #include <optional>
-#include <unordered_set>
 
 class DefaultMachineCore : public MachineCore {
   bool blinkLed0_ = false;
   bool lastLedState_ = false;
+  // PLC timers, edges, counters and flip-flops for machine logic; evaluated in step()
+  FunctionBlocks blocks_;
+  // Sequential programs (coroutines), resumed at the end of step()
+  SequenceScheduler sequences_;
   // Per-port message storage owned by the machine core
   std::unordered_map<std::string, std::vector<std::string>> store_;
   // Fixed capacity for per-port vectors (configured by Config via Logic)
   std::size_t capacity_{0};
 
+  // Port the master tests apply to (tests.masterReader)
+  std::string masterReader_{"communication1"};
+  // Port compared against the master by the match test (tests.reader2)
+  std::string matchReader_{"communication2"};
+
   // Sequence test config/state (from Tests tab)
   std::optional<int> lastSeqNumber_{};           // last extracted number
   int masterStartIndex_{0};                      // default aligns with GUI
@@ -30,7 +43,16 @@ class DefaultMachineCore : public MachineCore {
   bool masterInFileEnabled_{false};
   int masterInFileStartIndex_{0};
   int masterInFileLength_{1};
-  std::unordered_set<std::string> masterFileSet_;
+  std::shared_ptr<const ReferenceIndex> masterFile_;
+  std::vector<bool> masterFileSeen_; // by reference entry index
+  std::size_t masterFileSeenCount_{0};
+  bool masterFileSeenOnce_{false};
+
+  // Duplicate check (owned by Logic; nullptr when disabled)
+  DuplicateDetector* duplicates_{nullptr};
+
+  // Format fields used instead of the slices above (patterns owned by Logic)
+  TestFields fields_;
 
   // Ensure a given port's vector is sized to 'capacity_'
   void ensurePortCapacity(const std::string& port) {
@@ -50,15 +72,23 @@ class DefaultMachineCore : public MachineCore {
     return true;
   }
 
-  // Extract a number from text slice [startIndex, startIndex+length)
-  bool extractNumberAt(const std::string& text, int startIndex, int length, int& out) const {
-    if (startIndex < 0 || length <= 0) return false;
-    if (static_cast<size_t>(startIndex) >= text.size()) return false;
-    size_t len = static_cast<size_t>(length);
-    size_t avail = text.size() - static_cast<size_t>(startIndex);
-    if (len > avail) len = avail;
-    const std::string slice = text.substr(static_cast<size_t>(startIndex), len);
+  // Key a test reads from a scan: the format field when one is configured, else the slice.
+  // 'known' is the scan's match when Logic already ran the pattern. nullopt if there is no key.
+  std::optional<std::string> testKey(const PayloadPattern* pattern, const PatternMatch* known, const std::string& text,
+                                     int field, int startIndex, int length) const {
+    if (field >= 0 && pattern) {
+      const PatternMatch match = known ? *known : pattern->match(text);
+      std::string_view value;
+      if (!match.field(field, text, value) || value.empty()) return std::nullopt;
+      return std::string(value);
+    }
+    std::string slice;
+    if (!extractSliceAt(text, startIndex, length, slice)) return std::nullopt;
+    return slice;
+  }
 
+  // Extract a number from the digits of a key
+  bool numberFrom(const std::string& slice, int& out) const {
     std::string digits;
     digits.reserve(slice.size());
     for (unsigned char ch : slice) {
@@ -75,10 +105,11 @@ class DefaultMachineCore : public MachineCore {
 
   // Check master sequence based on current configuration.
   // Returns true if the sequence condition passes. Always stores the latest number if extracted.
-  bool checkMasterSequence(const std::string& text) {
+  bool checkMasterSequence(const std::string& text, const PatternMatch* match = nullptr) {
     if (!masterSequenceEnabled_) return true; // disabled => pass
     int current{};
-    if (!extractNumberAt(text, masterStartIndex_, masterLength_, current)) {
+    const auto key = testKey(fields_.master, match, text, fields_.sequence, masterStartIndex_, masterLength_);
+    if (!key || !numberFrom(*key, current)) {
       return false; // could not extract a number
     }
 
@@ -125,6 +156,9 @@ class DefaultMachineCore : public MachineCore {
 public:
   void setBlinkLed(bool v) override { blinkLed0_ = v; }
 
+  void setMasterReader(const std::string& commName) override { masterReader_ = commName; }
+  void setMatchReader(const std::string& commName) override { matchReader_ = commName; }
+
   // Configure Tests: master sequence options (can be wired from Logic/UI later)
   void setMasterSequenceEnabled(bool enabled) override { masterSequenceEnabled_ = enabled; }
   void setMasterSequenceConfig(int startIndex, int length, const std::string& direction) override {
@@ -156,15 +190,23 @@ public:
   }
 
   bool testMatchReaders(const std::string& masterText, const std::string& matchText) override {
+    return checkMatchReaders(masterText, matchText, nullptr);
+  }
+
+  bool checkMatchReaders(const std::string& masterText, const std::string& matchText, const PatternMatch* matchFormat) {
     if (!matchTestEnabled_) return true; // disabled => pass
 
     int masterValue{};
-    if (!extractNumberAt(masterText, matchMasterStartIndex_, matchLength_, masterValue)) {
+    const auto masterKey = testKey(fields_.master, nullptr, masterText, fields_.matchMaster,
+                                   matchMasterStartIndex_, matchLength_);
+    if (!masterKey || !numberFrom(*masterKey, masterValue)) {
       return false;
     }
 
     int matchValue{};
-    if (!extractNumberAt(matchText, matchReaderStartIndex_, matchLength_, matchValue)) {
+    const auto matchKey = testKey(fields_.reader, matchFormat, matchText, fields_.matchReader,
+                                  matchReaderStartIndex_, matchLength_);
+    if (!matchKey || !numberFrom(*matchKey, matchValue)) {
       return false;
     }
 
@@ -192,17 +234,38 @@ public:
     masterInFileStartIndex_ = startIndex;
     masterInFileLength_ = length;
   }
-  void setMasterFileReferenceSet(const std::unordered_set<std::string>& set) override {
-    masterFileSet_ = set;
+  void setMasterFileReference(std::shared_ptr<const ReferenceIndex> index) override {
+    masterFile_ = std::move(index);
+    resetMasterInFileSeen();
+  }
+  void setMasterInFileSeenOnce(bool enabled) override { masterFileSeenOnce_ = enabled; }
+  void resetMasterInFileSeen() override {
+    masterFileSeen_.assign(masterFile_ ? masterFile_->size() : 0, false);
+    masterFileSeenCount_ = 0;
+  }
+  std::pair<std::size_t, std::size_t> getMasterInFileProgress() const override {
+    return {masterFileSeenCount_, masterFileSeen_.size()};
   }
-  bool testMasterInFile(const std::string& text) override {
+  bool testMasterInFile(const std::string& text) override { return checkMasterInFile(text, nullptr); }
+
+  bool checkMasterInFile(const std::string& text, const PatternMatch* match) {
     if (!masterInFileEnabled_) return true;
-    if (masterFileSet_.empty()) return false; // enabled but no reference
-    std::string token;
-    if (!extractSliceAt(text, masterInFileStartIndex_, masterInFileLength_, token)) return false;
-    return masterFileSet_.find(token) != masterFileSet_.end();
+    if (!masterFile_ || masterFile_->empty()) return false; // enabled but no reference
+    const auto token = testKey(fields_.master, match, text, fields_.inFile, masterInFileStartIndex_, masterInFileLength_);
+    if (!token) return false;
+    const std::size_t entry = masterFile_->find(*token);
+    if (entry == ReferenceIndex::npos) return false;
+    if (masterFileSeen_[entry]) return !masterFileSeenOnce_; // already scanned in this job
+    masterFileSeen_[entry] = true;
+    ++masterFileSeenCount_;
+    return true;
   }
 
+  void setDuplicateDetector(DuplicateDetector* detector) override { duplicates_ = detector; }
+  void setTestFields(const TestFields& fields) override { fields_ = fields; }
+
+  const SequenceScheduler* getSequences() const override { return &sequences_; }
+
   std::unordered_map<std::string, std::vector<std::string>> getBarcodeStoreSnapshot() const override {
     // Ensure vectors are exactly capacity_ in the snapshot
     auto copy = store_;
@@ -215,13 +278,12 @@ public:
   CycleEffects step(const CycleInputs& in) override {
     CycleEffects fx;
 
-    // LED blink demo: toggle o0 on timer1 rising edge if enabled
+    // LED blink demo: toggle o0 on timer1 rising edge if enabled.
+    // timer1 runs periodically while blinking is on, so it is not restarted here.
     auto t = in.timerEdges.find("timer1");
     if (blinkLed0_ && t != in.timerEdges.end() && t->second.rising) {
-      // For demo we set to 1; Logic can compute toggle if needed with current state
       lastLedState_ = !lastLedState_;
       fx.outputChanges.emplace_back("o0", lastLedState_ ? 1 : 0);
-      fx.timerCmds.push_back({TimerCmd::Start, "timer1", std::nullopt});
     } else if (!blinkLed0_) {
       fx.outputChanges.emplace_back("o0", 0);
     }
@@ -254,6 +316,43 @@ public:
             store_[m.commName][idx] = m.raw;
             // Mark that barcode/message store changed this cycle
             fx.barcodeStoreChanged = true;
+
+            // Report the scan for the production history, with master test verdicts
+            ScanRecord scan{m.commName, m.offset, m.raw, 0, m.commName == masterReader_};
+            const PatternMatch* format = m.format ? &*m.format : nullptr;
+            if (scan.fromMasterReader) {
+              if (masterSequenceEnabled_) {
+                scan.verdict |= ScanSequenceChecked;
+                if (!checkMasterSequence(m.raw, format)) scan.verdict |= ScanSequenceFailed;
+              }
+              if (masterInFileEnabled_) {
+                scan.verdict |= ScanInFileChecked;
+                if (!checkMasterInFile(m.raw, format)) scan.verdict |= ScanInFileFailed;
+              }
+              if (duplicates_) {
+                const auto result = fields_.duplicate >= 0 && fields_.master
+                    ? duplicates_->checkAndInsertKey(
+                          testKey(fields_.master, format, m.raw, fields_.duplicate, 0, 0).value_or(std::string()))
+                    : duplicates_->checkAndInsert(m.raw);
+                if (result != DuplicateDetector::Result::NoKey) scan.verdict |= ScanDuplicateChecked;
+                if (result == DuplicateDetector::Result::Duplicate) scan.verdict |= ScanDuplicateFailed;
+              }
+            }
+            if (m.validation || m.format) {
+              scan.verdict |= ScanFormatChecked;
+              if ((m.validation && !m.validation->passed()) || (m.format && !m.format->matched)) {
+                scan.verdict |= ScanFormatFailed;
+              }
+            }
+            if (m.commName == matchReader_ && matchTestEnabled_) {
+              // Compare with the master scan of the same cell
+              auto master = store_.find(masterReader_);
+              if (master != store_.end() && idx < master->second.size() && !master->second[idx].empty()) {
+                scan.verdict |= ScanMatchChecked;
+                if (!checkMatchReaders(master->second[idx], m.raw, format)) scan.verdict |= ScanMatchFailed;
+              }
+            }
+            fx.scans.push_back(std::move(scan));
           }
           // else: offset beyond capacity; ignore or clamp (choosing ignore)
         }
@@ -268,6 +367,16 @@ public:
       fx.barcodeStoreChanged = true;
     }
 
+    // Sequences see this cycle's inputs, message and stored scans
+    sequences_.run(in, fx);
+
+    // Ask for a cycle when the earliest function block timer or sequence wait expires
+    const std::int64_t deadline = blocks_.nextDeadlineUs();
+    if (deadline != FunctionBlocks::kNoDeadline) fx.wakeupAtUs = deadline;
+    if (const auto wakeup = sequences_.wakeupAtUs()) {
+      fx.wakeupAtUs = fx.wakeupAtUs ? std::min(*fx.wakeupAtUs, *wakeup) : *wakeup;
+    }
+
     return fx;
   }
 };
@@ -0,0 +1,317 @@
+#include "machine/DuplicateDetector.h"
+#include "Logger.h"
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+
+constexpr std::uint32_t kFilterMagic = 0x4644434Du; // "MCDF"
+constexpr std::uint32_t kLogMagic = 0x4C44434Du;    // "MCDL"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint64_t kSlotsPerBucket = 4;
+constexpr std::uint64_t kBucketsPerChain = 8;
+constexpr int kMaxKicks = 500;
+constexpr std::size_t kInitialLogBytes = 1u << 20;
+
+// FNV-1a with a splitmix64 finalizer so every bit of the result is usable
+std::uint64_t hashKey(const std::string& key) {
+    std::uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+std::uint64_t bucketsFor(std::uint64_t capacity) {
+    // Cuckoo filters with 4-slot buckets fill to about 95%
+    const std::uint64_t needed = capacity * 100 / (kSlotsPerBucket * 95) + 1;
+    std::uint64_t buckets = 1024;
+    while (buckets < needed) buckets <<= 1;
+    return buckets;
+}
+
+std::uint64_t recordBytes(std::size_t keyLength) {
+    return (sizeof(std::uint64_t) * 2 + sizeof(std::uint32_t) + keyLength + 7) & ~std::uint64_t(7);
+}
+
+} // namespace
+
+struct DuplicateDetector::FilterHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t bucketCount;
+    std::uint64_t count;
+    std::uint32_t full;
+    std::uint32_t victimValid;  // a fingerprint evicted by the insert that filled the filter
+    std::uint64_t victimIndex;
+    std::uint16_t victimFingerprint;
+    std::uint8_t reserved[22];
+};
+
+struct DuplicateDetector::LogHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t used;    // bytes in use, header included
+    std::uint64_t records;
+    std::uint8_t reserved[40];
+};
+
+// Log record: [u64 previous record in chain (0 = none)][u64 hash][u32 length][key], padded to 8
+
+DuplicateDetector::~DuplicateDetector() {
+    close();
+}
+
+bool DuplicateDetector::open(const Options& options) {
+    close();
+    options_ = options;
+    std::error_code ec;
+    std::filesystem::create_directories(options_.directory, ec);
+    if (ec) {
+        getLogger()->error("[DuplicateDetector] Failed to create directory {}: {}", options_.directory, ec.message());
+        return false;
+    }
+    if (!openFiles(bucketsFor(options_.capacity))) {
+        close();
+        return false;
+    }
+    getLogger()->info("[DuplicateDetector] {} codes stored in {} ({} buckets){}", count(), options_.directory,
+                      filterHeader()->bucketCount, isFull() ? ", filter full" : "");
+    return true;
+}
+
+bool DuplicateDetector::openFiles(std::uint64_t bucketCount) {
+    static_assert(sizeof(FilterHeader) == 64 && sizeof(LogHeader) == 64, "on-disk headers are 64 bytes");
+    const std::string filterPath = (std::filesystem::path(options_.directory) / "filter.bin").string();
+    const std::string logPath = (std::filesystem::path(options_.directory) / "keys.log").string();
+
+    // Reuse the stored state when both files are intact
+    if (filter_.open(filterPath, true) && log_.open(logPath, true)) {
+        const bool filterValid = filter_.size() >= sizeof(FilterHeader) && filterHeader()->magic == kFilterMagic &&
+                                 filterHeader()->version == kVersion;
+        const bool logValid = log_.size() >= sizeof(LogHeader) && logHeader()->magic == kLogMagic &&
+                              logHeader()->version == kVersion && logHeader()->used <= log_.size();
+        if (filterValid && logValid) {
+            const std::uint64_t stored = filterHeader()->bucketCount;
+            const std::size_t expected = sizeof(FilterHeader) + stored * kSlotsPerBucket * sizeof(std::uint16_t) +
+                                         stored / kBucketsPerChain * sizeof(std::uint64_t);
+            if (filter_.size() == expected) {
+                if (stored != bucketCount) {
+                    getLogger()->warn("[DuplicateDetector] Keeping the stored filter size; a new capacity applies after the next job change");
+                }
+                bucketMask_ = stored - 1;
+                return true;
+            }
+        }
+        if (filter_.size() > 0 || log_.size() > 0) {
+            getLogger()->warn("[DuplicateDetector] Stored state in {} is invalid, starting empty", options_.directory);
+        }
+    }
+
+    // Start empty: new files are zero-filled, which is an empty filter and empty chains
+    filter_.close();
+    log_.close();
+    std::error_code ec;
+    std::filesystem::remove(filterPath, ec);
+    std::filesystem::remove(logPath, ec);
+    const std::size_t filterBytes = sizeof(FilterHeader) + bucketCount * kSlotsPerBucket * sizeof(std::uint16_t) +
+                                    bucketCount / kBucketsPerChain * sizeof(std::uint64_t);
+    if (!filter_.open(filterPath, true, filterBytes) || !log_.open(logPath, true, kInitialLogBytes)) {
+        getLogger()->error("[DuplicateDetector] Failed to create {} bytes of filter in {}", filterBytes, options_.directory);
+        return false;
+    }
+    FilterHeader* filter = filterHeader();
+    filter->magic = kFilterMagic;
+    filter->version = kVersion;
+    filter->bucketCount = bucketCount;
+    LogHeader* log = logHeader();
+    log->magic = kLogMagic;
+    log->version = kVersion;
+    log->used = sizeof(LogHeader);
+    bucketMask_ = bucketCount - 1;
+    return true;
+}
+
+void DuplicateDetector::close() {
+    if (filter_.isOpen()) flush();
+    filter_.close();
+    log_.close();
+    bucketMask_ = 0;
+}
+
+bool DuplicateDetector::clear() {
+    if (!isOpen()) return false;
+    const std::string directory = options_.directory;
+    filter_.close();
+    log_.close();
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::path(directory) / "filter.bin", ec);
+    std::filesystem::remove(std::filesystem::path(directory) / "keys.log", ec);
+    if (!openFiles(bucketsFor(options_.capacity))) {
+        close();
+        return false;
+    }
+    getLogger()->info("[DuplicateDetector] Cleared for a new job");
+    return true;
+}
+
+bool DuplicateDetector::flush() {
+    return filter_.flush() && log_.flush();
+}
+
+std::uint64_t DuplicateDetector::count() const {
+    return isOpen() ? filterHeader()->count : 0;
+}
+
+bool DuplicateDetector::isFull() const {
+    return isOpen() && filterHeader()->full != 0;
+}
+
+DuplicateDetector::FilterHeader* DuplicateDetector::filterHeader() {
+    return reinterpret_cast<FilterHeader*>(filter_.data());
+}
+
+const DuplicateDetector::FilterHeader* DuplicateDetector::filterHeader() const {
+    return reinterpret_cast<const FilterHeader*>(filter_.data());
+}
+
+std::uint16_t* DuplicateDetector::buckets() {
+    return reinterpret_cast<std::uint16_t*>(filter_.data() + sizeof(FilterHeader));
+}
+
+std::uint64_t* DuplicateDetector::chainHeads() {
+    return reinterpret_cast<std::uint64_t*>(buckets() + (bucketMask_ + 1) * kSlotsPerBucket);
+}
+
+DuplicateDetector::LogHeader* DuplicateDetector::logHeader() {
+    return reinterpret_cast<LogHeader*>(log_.data());
+}
+
+DuplicateDetector::Result DuplicateDetector::checkAndInsert(const std::string& scan) {
+    if (!isOpen()) return Result::NoKey;
+    if (options_.startIndex < 0 || static_cast<std::size_t>(options_.startIndex) >= scan.size()) return Result::NoKey;
+    const std::string key = options_.length > 0 ? scan.substr(static_cast<std::size_t>(options_.startIndex),
+                                                              static_cast<std::size_t>(options_.length))
+                                                : scan.substr(static_cast<std::size_t>(options_.startIndex));
+    return checkAndInsertKey(key);
+}
+
+DuplicateDetector::Result DuplicateDetector::checkAndInsertKey(const std::string& key) {
+    if (!isOpen() || key.empty()) return Result::NoKey;
+
+    const std::uint64_t hash = hashKey(key);
+    const std::uint64_t i1 = (hash >> 32) & bucketMask_;
+    std::uint16_t fingerprint = static_cast<std::uint16_t>(hash);
+    if (fingerprint == 0) fingerprint = 1; // 0 marks an empty slot
+    const std::uint64_t i2 = (i1 ^ (fingerprint * 0x5bd1e995ull)) & bucketMask_;
+    const std::uint64_t group = i1 / kBucketsPerChain;
+
+    if (containsFingerprint(fingerprint, i1, i2) && confirm(key, hash, group)) return Result::Duplicate;
+    if (isFull()) return Result::Full;
+
+    // Log first: the filter never points at a key the log does not have
+    if (!appendKey(key, hash, group)) return Result::Full;
+    if (!insertFingerprint(fingerprint, i1, i2)) {
+        getLogger()->error("[DuplicateDetector] Filter is full after {} codes; new codes are no longer recorded",
+                           filterHeader()->count);
+    }
+    ++filterHeader()->count;
+    return Result::New;
+}
+
+bool DuplicateDetector::containsFingerprint(std::uint16_t fingerprint, std::uint64_t i1, std::uint64_t i2) {
+    const std::uint16_t* a = buckets() + i1 * kSlotsPerBucket;
+    const std::uint16_t* b = buckets() + i2 * kSlotsPerBucket;
+    const bool hit = (a[0] == fingerprint) | (a[1] == fingerprint) | (a[2] == fingerprint) | (a[3] == fingerprint) |
+                     (b[0] == fingerprint) | (b[1] == fingerprint) | (b[2] == fingerprint) | (b[3] == fingerprint);
+    if (hit) return true;
+    const FilterHeader* header = filterHeader();
+    return header->victimValid && header->victimFingerprint == fingerprint &&
+           (header->victimIndex == i1 || header->victimIndex == i2);
+}
+
+bool DuplicateDetector::confirm(const std::string& key, std::uint64_t hash, std::uint64_t group) {
+    const char* base = log_.data();
+    std::uint64_t offset = chainHeads()[group];
+    const std::uint64_t used = logHeader()->used;
+    while (offset >= sizeof(LogHeader) && offset < used) {
+        std::uint64_t previous = 0;
+        std::uint64_t recordHash = 0;
+        std::uint32_t length = 0;
+        std::memcpy(&previous, base + offset, sizeof(previous));
+        std::memcpy(&recordHash, base + offset + 8, sizeof(recordHash));
+        std::memcpy(&length, base + offset + 16, sizeof(length));
+        if (recordHash == hash && length == key.size() && offset + recordBytes(length) <= used &&
+            std::memcmp(base + offset + 20, key.data(), length) == 0) {
+            return true;
+        }
+        if (previous >= offset) break; // chains only point backwards
+        offset = previous;
+    }
+    return false;
+}
+
+bool DuplicateDetector::appendKey(const std::string& key, std::uint64_t hash, std::uint64_t group) {
+    const std::uint64_t offset = logHeader()->used;
+    const std::uint64_t bytes = recordBytes(key.size());
+    if (offset + bytes > log_.size()) {
+        std::size_t newSize = log_.size() * 2;
+        while (newSize < offset + bytes) newSize *= 2;
+        if (!log_.resize(newSize)) {
+            getLogger()->error("[DuplicateDetector] Failed to grow the key log to {} bytes", newSize);
+            return false;
+        }
+    }
+    char* record = log_.data() + offset;
+    const std::uint64_t previous = chainHeads()[group];
+    const auto length = static_cast<std::uint32_t>(key.size());
+    std::memcpy(record, &previous, sizeof(previous));
+    std::memcpy(record + 8, &hash, sizeof(hash));
+    std::memcpy(record + 16, &length, sizeof(length));
+    std::memcpy(record + 20, key.data(), key.size());
+    logHeader()->used = offset + bytes;
+    ++logHeader()->records;
+    chainHeads()[group] = offset;
+    return true;
+}
+
+bool DuplicateDetector::insertFingerprint(std::uint16_t fingerprint, std::uint64_t i1, std::uint64_t i2) {
+    auto place = [this](std::uint64_t index, std::uint16_t fp) {
+        std::uint16_t* bucket = buckets() + index * kSlotsPerBucket;
+        for (std::uint64_t s = 0; s < kSlotsPerBucket; ++s) {
+            if (bucket[s] == 0) {
+                bucket[s] = fp;
+                return true;
+            }
+        }
+        return false;
+    };
+    if (place(i1, fingerprint) || place(i2, fingerprint)) return true;
+
+    // Evict a random resident to its alternate bucket until something fits
+    std::uint64_t state = (static_cast<std::uint64_t>(fingerprint) << 32) ^ i1 ^ filterHeader()->count;
+    std::uint64_t index = (state & 1) ? i1 : i2;
+    std::uint16_t fp = fingerprint;
+    for (int kick = 0; kick < kMaxKicks; ++kick) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::uint16_t& slot = buckets()[index * kSlotsPerBucket + (state & (kSlotsPerBucket - 1))];
+        std::swap(fp, slot);
+        index = (index ^ (fp * 0x5bd1e995ull)) & bucketMask_;
+        if (place(index, fp)) return true;
+    }
+    FilterHeader* header = filterHeader();
+    header->victimFingerprint = fp;
+    header->victimIndex = index;
+    header->victimValid = 1;
+    header->full = 1;
+    return false;
+}
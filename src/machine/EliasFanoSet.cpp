@@ -0,0 +1,132 @@
+#include "machine/EliasFanoSet.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr std::size_t kZeroSample = 256;
+
+inline unsigned popcount64(std::uint64_t word) {
+#ifdef _MSC_VER
+    return static_cast<unsigned>(__popcnt64(word));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#endif
+}
+
+inline unsigned lowestBit(std::uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+// Index of the set bit with this rank; 'rank' must be below popcount64(word)
+inline unsigned selectInWord(std::uint64_t word, unsigned rank) {
+    for (; rank > 0; --rank) word &= word - 1;
+    return lowestBit(word);
+}
+
+} // namespace
+
+void EliasFanoSet::build(const std::vector<std::uint64_t>& values) {
+    *this = EliasFanoSet();
+    count_ = values.size();
+    if (count_ == 0) return;
+    last_ = values.back();
+
+    // floor(log2(universe / count)) low bits leave about one value per bucket
+    const std::uint64_t ratio = last_ / count_;
+    while (lowWidth_ < 63 && (ratio >> (lowWidth_ + 1)) != 0) ++lowWidth_;
+    const std::uint64_t lowMask = lowWidth_ == 0 ? 0 : (std::uint64_t(1) << lowWidth_) - 1;
+
+    // One spare word so lowPart can read across a word boundary without a check
+    low_.assign((count_ * lowWidth_ + 63) / 64 + 1, 0);
+    const std::size_t highBits = count_ + static_cast<std::size_t>(last_ >> lowWidth_) + 1;
+    high_.assign((highBits + 63) / 64 + 1, 0);
+
+    for (std::size_t i = 0; i < count_; ++i) {
+        const std::uint64_t value = values[i];
+        if (lowWidth_ > 0) {
+            const std::size_t bit = i * lowWidth_;
+            const std::uint64_t low = value & lowMask;
+            low_[bit / 64] |= low << (bit % 64);
+            if (bit % 64 + lowWidth_ > 64) low_[bit / 64 + 1] |= low >> (64 - bit % 64);
+        }
+        const std::size_t position = static_cast<std::size_t>(value >> lowWidth_) + i;
+        high_[position / 64] |= std::uint64_t(1) << (position % 64);
+    }
+
+    std::size_t zeros = 0;
+    for (std::size_t w = 0; w < high_.size(); ++w) {
+        std::uint64_t word = ~high_[w];
+        const unsigned wordZeros = popcount64(word);
+        // Record every zero whose rank is a multiple of kZeroSample
+        std::size_t next = (zeros + kZeroSample - 1) / kZeroSample * kZeroSample;
+        while (next < zeros + wordZeros) {
+            zeroSamples_.push_back(w * 64 + selectInWord(word, static_cast<unsigned>(next - zeros)));
+            next += kZeroSample;
+        }
+        zeros += wordZeros;
+    }
+}
+
+std::uint64_t EliasFanoSet::lowPart(std::size_t rank) const {
+    if (lowWidth_ == 0) return 0;
+    const std::size_t bit = rank * lowWidth_;
+    std::uint64_t value = low_[bit / 64] >> (bit % 64);
+    if (bit % 64 + lowWidth_ > 64) value |= low_[bit / 64 + 1] << (64 - bit % 64);
+    return value & ((std::uint64_t(1) << lowWidth_) - 1);
+}
+
+std::size_t EliasFanoSet::selectZero(std::size_t rank) const {
+    const std::size_t sample = rank / kZeroSample;
+    std::size_t position = static_cast<std::size_t>(zeroSamples_[sample]);
+    std::size_t remaining = rank - sample * kZeroSample;
+    std::size_t w = position / 64;
+    std::uint64_t word = ~high_[w] & (~std::uint64_t(0) << (position % 64));
+    for (;;) {
+        const unsigned wordZeros = popcount64(word);
+        if (remaining < wordZeros) return w * 64 + selectInWord(word, static_cast<unsigned>(remaining));
+        remaining -= wordZeros;
+        word = ~high_[++w];
+    }
+}
+
+std::size_t EliasFanoSet::find(std::uint64_t value) const {
+    if (count_ == 0 || value > last_) return npos;
+    // Bucket h holds the values with high part h: its ones follow the h-th zero
+    const std::size_t bucket = static_cast<std::size_t>(value >> lowWidth_);
+    std::size_t position = bucket == 0 ? 0 : selectZero(bucket - 1) + 1;
+    std::size_t rank = position - bucket;
+    const std::uint64_t low = lowWidth_ == 0 ? 0 : value & ((std::uint64_t(1) << lowWidth_) - 1);
+    while (highBit(position)) {
+        const std::uint64_t candidate = lowPart(rank);
+        if (candidate == low) return rank;
+        if (candidate > low) return npos;
+        ++position;
+        ++rank;
+    }
+    return npos;
+}
+
+std::vector<std::uint64_t> EliasFanoSet::head(std::size_t count) const {
+    std::vector<std::uint64_t> values;
+    std::size_t rank = 0;
+    for (std::size_t w = 0; w < high_.size() && values.size() < count && rank < count_; ++w) {
+        for (std::uint64_t word = high_[w]; word != 0 && values.size() < count; word &= word - 1) {
+            const std::size_t position = w * 64 + lowestBit(word);
+            values.push_back((static_cast<std::uint64_t>(position - rank) << lowWidth_) | lowPart(rank));
+            ++rank;
+        }
+    }
+    return values;
+}
+
+std::size_t EliasFanoSet::memoryBytes() const {
+    return (low_.capacity() + high_.capacity() + zeroSamples_.capacity()) * sizeof(std::uint64_t);
+}
@@ -0,0 +1,193 @@
+#include "machine/FunctionBlocks.h"
+#include <algorithm>
+
+FunctionBlocks::Id FunctionBlocks::add(Kind kind, std::int64_t preset, const std::string& name) {
+  const Id id = static_cast<Id>(blocks_.size());
+  Block block;
+  block.kind = kind;
+  block.preset = std::max<std::int64_t>(preset, 0);
+  if (kind == Kind::Ctd) block.count = static_cast<std::int32_t>(preset);
+  blocks_.push_back(block);
+  deadlines_.push_back(kNoDeadline);
+  if (!name.empty()) names_[name] = id;
+  return id;
+}
+
+FunctionBlocks::Id FunctionBlocks::addTon(std::int64_t presetUs, const std::string& name) { return add(Kind::Ton, presetUs, name); }
+FunctionBlocks::Id FunctionBlocks::addTof(std::int64_t presetUs, const std::string& name) { return add(Kind::Tof, presetUs, name); }
+FunctionBlocks::Id FunctionBlocks::addTp(std::int64_t presetUs, const std::string& name) { return add(Kind::Tp, presetUs, name); }
+FunctionBlocks::Id FunctionBlocks::addRTrig(const std::string& name) { return add(Kind::RTrig, 0, name); }
+FunctionBlocks::Id FunctionBlocks::addFTrig(const std::string& name) { return add(Kind::FTrig, 0, name); }
+FunctionBlocks::Id FunctionBlocks::addCtu(std::int32_t preset, const std::string& name) { return add(Kind::Ctu, preset, name); }
+FunctionBlocks::Id FunctionBlocks::addCtd(std::int32_t preset, const std::string& name) { return add(Kind::Ctd, preset, name); }
+FunctionBlocks::Id FunctionBlocks::addSr(const std::string& name) { return add(Kind::Sr, 0, name); }
+FunctionBlocks::Id FunctionBlocks::addRs(const std::string& name) { return add(Kind::Rs, 0, name); }
+
+std::optional<FunctionBlocks::Id> FunctionBlocks::find(const std::string& name) const {
+  auto it = names_.find(name);
+  if (it == names_.end()) return std::nullopt;
+  return it->second;
+}
+
+bool FunctionBlocks::ton(Id id, bool in, std::int64_t nowUs) {
+  Block* b = get(id, Kind::Ton);
+  if (!b) return false;
+  if (!in) {
+    b->q = false;
+    b->last = false;
+    deadlines_[id] = kNoDeadline;
+    return false;
+  }
+  if (!b->last) {
+    b->last = true;
+    b->startUs = nowUs;
+    deadlines_[id] = nowUs + b->preset;
+  }
+  if (!b->q && nowUs >= deadlines_[id]) {
+    b->q = true;
+    deadlines_[id] = kNoDeadline;
+  }
+  return b->q;
+}
+
+bool FunctionBlocks::tof(Id id, bool in, std::int64_t nowUs) {
+  Block* b = get(id, Kind::Tof);
+  if (!b) return false;
+  if (in) {
+    b->q = true;
+    b->last = false;
+    deadlines_[id] = kNoDeadline;
+    return true;
+  }
+  if (b->q && !b->last) {
+    b->last = true;
+    b->startUs = nowUs;
+    deadlines_[id] = nowUs + b->preset;
+  }
+  if (b->q && nowUs >= deadlines_[id]) {
+    b->q = false;
+    deadlines_[id] = kNoDeadline;
+  }
+  return b->q;
+}
+
+bool FunctionBlocks::tp(Id id, bool in, std::int64_t nowUs) {
+  Block* b = get(id, Kind::Tp);
+  if (!b) return false;
+  // 'count' holds the previous IN; 'last' marks a running pulse
+  const bool rising = in && !b->count;
+  b->count = in ? 1 : 0;
+  if (rising && !b->last) {
+    b->last = true;
+    b->q = true;
+    b->startUs = nowUs;
+    deadlines_[id] = nowUs + b->preset;
+  }
+  if (b->q && nowUs >= deadlines_[id]) {
+    b->q = false;
+    deadlines_[id] = kNoDeadline;
+  }
+  // The pulse is over; a new one needs IN to drop first
+  if (!b->q && !in) b->last = false;
+  return b->q;
+}
+
+bool FunctionBlocks::rTrig(Id id, bool clk) {
+  Block* b = get(id, Kind::RTrig);
+  if (!b) return false;
+  b->q = clk && !b->last;
+  b->last = clk;
+  return b->q;
+}
+
+bool FunctionBlocks::fTrig(Id id, bool clk) {
+  Block* b = get(id, Kind::FTrig);
+  if (!b) return false;
+  b->q = !clk && b->last;
+  b->last = clk;
+  return b->q;
+}
+
+bool FunctionBlocks::ctu(Id id, bool cu, bool reset) {
+  Block* b = get(id, Kind::Ctu);
+  if (!b) return false;
+  if (reset) {
+    b->count = 0;
+  } else if (cu && !b->last && b->count < std::numeric_limits<std::int32_t>::max()) {
+    ++b->count;
+  }
+  b->last = cu;
+  b->q = b->count >= b->preset;
+  return b->q;
+}
+
+bool FunctionBlocks::ctd(Id id, bool cd, bool load) {
+  Block* b = get(id, Kind::Ctd);
+  if (!b) return false;
+  if (load) {
+    b->count = static_cast<std::int32_t>(b->preset);
+  } else if (cd && !b->last && b->count > std::numeric_limits<std::int32_t>::min()) {
+    --b->count;
+  }
+  b->last = cd;
+  b->q = b->count <= 0;
+  return b->q;
+}
+
+bool FunctionBlocks::sr(Id id, bool set, bool reset) {
+  Block* b = get(id, Kind::Sr);
+  if (!b) return false;
+  b->q = set || (b->q && !reset);
+  return b->q;
+}
+
+bool FunctionBlocks::rs(Id id, bool set, bool reset) {
+  Block* b = get(id, Kind::Rs);
+  if (!b) return false;
+  b->q = !reset && (set || b->q);
+  return b->q;
+}
+
+std::int64_t FunctionBlocks::elapsedUs(Id id, std::int64_t nowUs) const {
+  if (id >= blocks_.size()) return 0;
+  const Block& b = blocks_[id];
+  switch (b.kind) {
+  case Kind::Ton:
+    if (!b.last) return 0;
+    break;
+  case Kind::Tof:
+  case Kind::Tp:
+    if (!b.last) return 0;
+    if (!b.q) return b.preset;
+    break;
+  default:
+    return 0;
+  }
+  return std::clamp<std::int64_t>(nowUs - b.startUs, 0, b.preset);
+}
+
+// A linear scan of one flat array: a few microseconds for thousands of timers,
+// and no bookkeeping on the per-block evaluation path
+std::int64_t FunctionBlocks::nextDeadlineUs() const {
+  std::int64_t earliest = kNoDeadline;
+  for (const std::int64_t deadline : deadlines_) earliest = std::min(earliest, deadline);
+  return earliest;
+}
+
+void FunctionBlocks::setPreset(Id id, std::int64_t preset) {
+  if (id >= blocks_.size()) return;
+  Block& b = blocks_[id];
+  b.preset = std::max<std::int64_t>(preset, 0);
+  if (deadlines_[id] != kNoDeadline) deadlines_[id] = b.startUs + b.preset;
+}
+
+void FunctionBlocks::resetAll() {
+  for (std::size_t i = 0; i < blocks_.size(); ++i) {
+    Block& b = blocks_[i];
+    b.q = false;
+    b.last = false;
+    b.startUs = 0;
+    b.count = b.kind == Kind::Ctd ? static_cast<std::int32_t>(b.preset) : 0;
+    deadlines_[i] = kNoDeadline;
+  }
+}
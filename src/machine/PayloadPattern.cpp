@@ -0,0 +1,369 @@
+#include "machine/PayloadPattern.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+
+namespace {
+
+using ByteSet = std::array<std::uint64_t, 4>;
+
+constexpr int kMaxCount = 255;
+constexpr std::size_t kMaxPositions = 2048;
+constexpr std::uint32_t kUnset = std::numeric_limits<std::uint32_t>::max();
+
+struct Atom {
+    ByteSet set{};
+    int min{1};
+    int max{1}; // -1 = unbounded
+    int field{-1};
+};
+
+// One byte of the pattern (Glushkov position)
+struct Position {
+    int atom{0};
+    int field{-1};
+    bool optional{false};
+    bool loop{false};
+};
+
+void addByte(ByteSet& set, unsigned c) {
+    set[c >> 6] |= std::uint64_t(1) << (c & 63);
+}
+
+void addRange(ByteSet& set, unsigned low, unsigned high) {
+    for (unsigned c = low; c <= high; ++c) addByte(set, c);
+}
+
+bool contains(const ByteSet& set, unsigned c) {
+    return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+class Parser {
+public:
+    Parser(const std::string& text, std::vector<Atom>& atoms, std::vector<std::string>& fields)
+        : text_(text), atoms_(atoms), fields_(fields) {}
+
+    bool parse(std::string& error) {
+        while (skipSeparators(), pos_ < text_.size()) {
+            const char c = text_[pos_];
+            if (c == '{') {
+                if (field_ >= 0) return fail(error, "fields cannot be nested");
+                if (!parseFieldStart(error)) return false;
+            } else if (c == '}') {
+                if (field_ < 0) return fail(error, "'}' without a field");
+                field_ = -1;
+                ++pos_;
+            } else if (c == '\'') {
+                if (!parseLiteral(error)) return false;
+            } else {
+                Atom atom;
+                if (!parseClass(atom.set, error) || !parseCount(atom, error)) return false;
+                atom.field = field_;
+                atoms_.push_back(atom);
+            }
+        }
+        if (field_ >= 0) return fail(error, "field '" + fields_[field_] + "' is not closed");
+        return true;
+    }
+
+private:
+    bool fail(std::string& error, const std::string& message) const {
+        error = message + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    void skipSeparators() {
+        while (pos_ < text_.size() && (std::isspace(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == ',')) ++pos_;
+    }
+
+    bool parseFieldStart(std::string& error) {
+        ++pos_;
+        skipSeparators();
+        const std::size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) ++pos_;
+        const std::string name = text_.substr(start, pos_ - start);
+        skipSeparators();
+        if (name.empty() || pos_ >= text_.size() || text_[pos_] != ':') return fail(error, "expected '{name:'");
+        ++pos_;
+        if (std::find(fields_.begin(), fields_.end(), name) != fields_.end()) {
+            return fail(error, "field '" + name + "' appears twice");
+        }
+        if (fields_.size() >= static_cast<std::size_t>(PatternMatch::kMaxFields)) {
+            return fail(error, "more than " + std::to_string(PatternMatch::kMaxFields) + " fields");
+        }
+        field_ = static_cast<int>(fields_.size());
+        fields_.push_back(name);
+        return true;
+    }
+
+    bool parseLiteral(std::string& error) {
+        ++pos_;
+        bool closed = false;
+        while (pos_ < text_.size()) {
+            char c = text_[pos_++];
+            if (c == '\'') {
+                closed = true;
+                break;
+            }
+            if (c == '\\' && pos_ < text_.size()) c = text_[pos_++];
+            Atom atom;
+            addByte(atom.set, static_cast<unsigned char>(c));
+            atom.field = field_;
+            atoms_.push_back(atom);
+        }
+        if (!closed) return fail(error, "unterminated literal");
+        return true;
+    }
+
+    bool parseClass(ByteSet& set, std::string& error) {
+        const char c = text_[pos_++];
+        switch (c) {
+            case 'd': addRange(set, '0', '9'); return true;
+            case 'L': addRange(set, 'A', 'Z'); return true;
+            case 'l': addRange(set, 'a', 'z'); return true;
+            case 'A': addRange(set, 'A', 'Z'); addRange(set, 'a', 'z'); return true;
+            case 'a': addRange(set, '0', '9'); addRange(set, 'A', 'Z'); addRange(set, 'a', 'z'); return true;
+            case 'x': addRange(set, '0', '9'); addRange(set, 'A', 'F'); addRange(set, 'a', 'f'); return true;
+            case 'p': addRange(set, 0x20, 0x7E); return true;
+            case '.': addRange(set, 0, 255); return true;
+            case '[': return parseSet(set, error);
+            default:
+                --pos_;
+                return fail(error, std::string("unknown class '") + c + "'");
+        }
+    }
+
+    bool parseSet(ByteSet& set, std::string& error) {
+        const bool negate = pos_ < text_.size() && text_[pos_] == '^';
+        if (negate) ++pos_;
+        bool closed = false;
+        while (pos_ < text_.size()) {
+            unsigned low = static_cast<unsigned char>(text_[pos_++]);
+            if (low == ']') {
+                closed = true;
+                break;
+            }
+            if (low == '\\' && pos_ < text_.size()) low = static_cast<unsigned char>(text_[pos_++]);
+            if (pos_ + 1 < text_.size() && text_[pos_] == '-' && text_[pos_ + 1] != ']') {
+                unsigned high = static_cast<unsigned char>(text_[pos_ + 1]);
+                pos_ += 2;
+                if (high == '\\' && pos_ < text_.size()) high = static_cast<unsigned char>(text_[pos_++]);
+                if (high < low) return fail(error, "reversed range in set");
+                addRange(set, low, high);
+            } else {
+                addByte(set, low);
+            }
+        }
+        if (!closed) return fail(error, "unterminated set");
+        if (negate) {
+            for (auto& word : set) word = ~word;
+        }
+        if (set == ByteSet{}) return fail(error, "empty set");
+        return true;
+    }
+
+    bool readNumber(int& value) {
+        const std::size_t start = pos_;
+        value = 0;
+        while (pos_ < text_.size() && std::isdigit(static_cast<unsigned char>(text_[pos_])) && value <= kMaxCount) {
+            value = value * 10 + (text_[pos_++] - '0');
+        }
+        return pos_ > start;
+    }
+
+    bool parseCount(Atom& atom, std::string& error) {
+        if (pos_ >= text_.size()) return true;
+        const char c = text_[pos_];
+        if (c == '?' || c == '*' || c == '+') {
+            ++pos_;
+            atom.min = c == '+' ? 1 : 0;
+            atom.max = c == '?' ? 1 : -1;
+            return true;
+        }
+        if (!std::isdigit(static_cast<unsigned char>(c))) return true;
+        readNumber(atom.min);
+        atom.max = atom.min;
+        if (pos_ < text_.size() && text_[pos_] == '-') {
+            ++pos_;
+            if (!readNumber(atom.max)) return fail(error, "expected a count after '-'");
+        }
+        if (atom.min > kMaxCount || atom.max > kMaxCount) return fail(error, "count above " + std::to_string(kMaxCount));
+        if (atom.max < atom.min || atom.max == 0) return fail(error, "invalid count");
+        return true;
+    }
+
+    const std::string& text_;
+    std::vector<Atom>& atoms_;
+    std::vector<std::string>& fields_;
+    std::size_t pos_{0};
+    int field_{-1};
+};
+
+} // namespace
+
+bool PatternMatch::field(int index, std::string_view payload, std::string_view& out) const {
+    if (!matched || index < 0 || index >= kMaxFields) return false;
+    out = payload.substr(begin[index], end[index] - begin[index]);
+    return true;
+}
+
+bool PayloadPattern::compile(const std::string& pattern, std::string* error) {
+    *this = PayloadPattern();
+
+    std::vector<Atom> atoms;
+    std::vector<std::string> fields;
+    std::string reason;
+    Parser parser(pattern, atoms, fields);
+    if (!parser.parse(reason)) {
+        if (error) *error = reason;
+        return false;
+    }
+
+    // Expand counts: 'min' required bytes, then optional ones or one repeating byte
+    std::vector<Position> positions;
+    for (std::size_t a = 0; a < atoms.size(); ++a) {
+        const Atom& atom = atoms[a];
+        for (int k = 0; k < atom.min; ++k) positions.push_back({static_cast<int>(a), atom.field, false, false});
+        if (atom.max < 0) {
+            positions.push_back({static_cast<int>(a), atom.field, true, true});
+        } else {
+            for (int k = atom.min; k < atom.max; ++k) positions.push_back({static_cast<int>(a), atom.field, true, false});
+        }
+        if (positions.size() > kMaxPositions) {
+            if (error) *error = "pattern longer than " + std::to_string(kMaxPositions) + " bytes";
+            return false;
+        }
+    }
+    const int n = static_cast<int>(positions.size());
+    int lastRequired = -1;
+    for (int p = 0; p < n; ++p) {
+        if (!positions[p].optional) lastRequired = p;
+    }
+
+    // Positions that may match the byte after position p (p = -1 before the first byte)
+    std::vector<std::vector<int>> follow(static_cast<std::size_t>(n) + 1);
+    for (int p = -1; p < n; ++p) {
+        auto& next = follow[static_cast<std::size_t>(p + 1)];
+        if (p >= 0 && positions[p].loop) next.push_back(p);
+        for (int q = p + 1; q < n; ++q) {
+            next.push_back(q);
+            if (!positions[q].optional) break;
+        }
+    }
+
+    // Bytes no atom tells apart share a class
+    std::map<std::vector<bool>, std::uint8_t> classes;
+    std::vector<unsigned> representative;
+    for (unsigned b = 0; b < 256; ++b) {
+        std::vector<bool> signature(atoms.size());
+        for (std::size_t a = 0; a < atoms.size(); ++a) signature[a] = contains(atoms[a].set, b);
+        auto inserted = classes.emplace(signature, static_cast<std::uint8_t>(classes.size()));
+        if (inserted.second) representative.push_back(b);
+        byteClass_[b] = inserted.first->second;
+    }
+    classCount_ = static_cast<std::uint32_t>(representative.size());
+
+    // Subset construction; a state is the set of positions the last byte may have matched
+    std::vector<std::vector<int>> states{{}, {-1}};
+    std::map<std::vector<int>, std::uint16_t> ids{{{}, 0}, {{-1}, 1}};
+    transitions_.assign(2 * classCount_, 0);
+    accepting_ = {0, static_cast<std::uint8_t>(lastRequired < 0)};
+    stateField_ = {kNoField, kNoField};
+
+    for (std::size_t s = 1; s < states.size(); ++s) {
+        for (std::uint32_t c = 0; c < classCount_; ++c) {
+            std::vector<int> target;
+            for (int p : states[s]) {
+                for (int q : follow[static_cast<std::size_t>(p + 1)]) {
+                    if (contains(atoms[positions[q].atom].set, representative[c])) target.push_back(q);
+                }
+            }
+            std::sort(target.begin(), target.end());
+            target.erase(std::unique(target.begin(), target.end()), target.end());
+
+            auto found = ids.find(target);
+            if (found == ids.end()) {
+                if (states.size() >= kMaxStates) {
+                    if (error) *error = "pattern needs more than " + std::to_string(kMaxStates) + " states";
+                    return false;
+                }
+                const int field = positions[target.front()].field;
+                for (int q : target) {
+                    if (positions[q].field != field) {
+                        const std::string& name = fields[static_cast<std::size_t>(field >= 0 ? field : positions[q].field)];
+                        if (error) *error = "where field '" + name + "' starts or ends is ambiguous; use fixed counts or distinct classes next to it";
+                        return false;
+                    }
+                }
+                found = ids.emplace(target, static_cast<std::uint16_t>(states.size())).first;
+                states.push_back(target);
+                transitions_.resize(states.size() * classCount_, 0);
+                accepting_.push_back(static_cast<std::uint8_t>(target.back() >= lastRequired));
+                stateField_.push_back(field < 0 ? kNoField : static_cast<std::uint8_t>(field));
+            }
+            transitions_[s * classCount_ + c] = found->second;
+        }
+    }
+
+    // Store row offsets instead of state numbers so a step is one add and one load;
+    // per-state data moves to the first slot of its row
+    std::vector<std::uint8_t> accepting(transitions_.size(), 0);
+    std::vector<std::uint8_t> stateField(transitions_.size(), kNoField);
+    for (std::size_t s = 0; s < states.size(); ++s) {
+        accepting[s * classCount_] = accepting_[s];
+        stateField[s * classCount_] = stateField_[s];
+    }
+    for (auto& next : transitions_) next = next * classCount_;
+    accepting_ = std::move(accepting);
+    stateField_ = std::move(stateField);
+    stateCount_ = states.size();
+
+    fieldNames_ = std::move(fields);
+    source_ = pattern;
+    return true;
+}
+
+PatternMatch PayloadPattern::match(std::string_view payload) const {
+    PatternMatch result;
+    if (transitions_.empty()) return result;
+
+    // Slot kNoField collects bytes outside any field
+    std::uint32_t begin[PatternMatch::kMaxFields + 1];
+    std::uint32_t end[PatternMatch::kMaxFields + 1];
+    std::fill(std::begin(begin), std::end(begin), kUnset);
+    std::fill(std::begin(end), std::end(end), 0u);
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(payload.data());
+    const std::uint32_t size = static_cast<std::uint32_t>(payload.size());
+    std::uint32_t state = classCount_; // row of the start state
+    for (std::uint32_t i = 0; i < size; ++i) {
+        state = transitions_[state + byteClass_[bytes[i]]];
+        const std::uint8_t field = stateField_[state];
+        begin[field] = std::min(begin[field], i);
+        end[field] = i + 1;
+    }
+
+    result.matched = accepting_[state] != 0;
+    for (int f = 0; f < PatternMatch::kMaxFields; ++f) {
+        // A field that matched no bytes is empty
+        result.begin[f] = begin[f] == kUnset ? 0 : begin[f];
+        result.end[f] = begin[f] == kUnset ? 0 : end[f];
+    }
+    return result;
+}
+
+bool PayloadPattern::matches(std::string_view payload) const {
+    if (transitions_.empty()) return false;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(payload.data());
+    std::uint32_t state = classCount_;
+    for (std::size_t i = 0; i < payload.size(); ++i) {
+        state = transitions_[state + byteClass_[bytes[i]]];
+    }
+    return accepting_[state] != 0;
+}
+
+int PayloadPattern::fieldIndex(const std::string& name) const {
+    const auto it = std::find(fieldNames_.begin(), fieldNames_.end(), name);
+    return it == fieldNames_.end() ? -1 : static_cast<int>(it - fieldNames_.begin());
+}
@@ -0,0 +1,433 @@
+#include "machine/ReferenceIndex.h"
+#include "utils/MappedFile.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <thread>
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define MC_HAS_PREFETCH 1
+#endif
+
+namespace {
+
+constexpr std::size_t kStride = 32;    // keys per block of the sparse table
+constexpr std::size_t kTopStride = 16; // sparse entries per entry of the top table
+
+// First 8 bytes, big-endian and zero padded: orders like the keys themselves
+std::uint64_t prefix64(std::string_view key) {
+    std::uint64_t value = 0;
+    const std::size_t n = std::min<std::size_t>(key.size(), 8);
+    for (std::size_t i = 0; i < n; ++i) value |= std::uint64_t(static_cast<unsigned char>(key[i])) << (56 - 8 * i);
+    return value;
+}
+
+inline void prefetch(const char* address) {
+#ifdef MC_HAS_PREFETCH
+    _mm_prefetch(address, _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+bool parseNumber(std::string_view text, std::uint64_t& value) {
+    if (text.empty() || text.size() > 19) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+}
+
+// "n" or "low-high"
+bool parseRange(std::string_view line, std::uint64_t& low, std::uint64_t& high) {
+    const std::size_t dash = line.find('-');
+    if (dash == std::string_view::npos) {
+        if (!parseNumber(trim(line), low)) return false;
+        high = low;
+        return true;
+    }
+    return parseNumber(trim(line.substr(0, dash)), low) && parseNumber(trim(line.substr(dash + 1)), high) && low <= high;
+}
+
+// Key in the mapping with its prefix, so most sort comparisons stay out of the file
+struct SortKey {
+    std::uint64_t prefix;
+    std::string_view text;
+    bool operator<(const SortKey& other) const {
+        return prefix != other.prefix ? prefix < other.prefix : text < other.text;
+    }
+    bool operator==(const SortKey& other) const { return prefix == other.prefix && text == other.text; }
+};
+
+bool isDigits(std::string_view text) {
+    if (text.empty() || text.size() > 19) return false;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
+}
+
+// One data file: mapped and split, then sorted, on its own thread
+struct FileData {
+    MappedFile file;
+    std::vector<SortKey> keys; // point into the mapping
+    std::vector<std::uint64_t> numbers;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+    bool digitsOnly{true};       // every exact key so far is all digits ...
+    std::size_t digitLength{0};  // ... of this one length
+    ReferenceIndex::FileReport report;
+};
+
+void splitFile(FileData& data, const ReferenceIndex::Options& options) {
+    if (!data.file.open(data.report.path, false)) return;
+    data.report.ok = true;
+
+    const char* cursor = data.file.data();
+    const char* end = cursor + data.file.size();
+    const std::size_t start = static_cast<std::size_t>(std::max(0, options.startIndex));
+    while (cursor < end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        const char* lineEnd = newline ? newline : end;
+        std::string_view line(cursor, static_cast<std::size_t>(lineEnd - cursor));
+        cursor = newline ? newline + 1 : end;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        ++data.report.lines;
+
+        if (options.mode == ReferenceIndex::Mode::Range) {
+            std::uint64_t low = 0;
+            std::uint64_t high = 0;
+            if (parseRange(line, low, high)) data.ranges.emplace_back(low, high);
+            else ++data.report.skipped;
+            continue;
+        }
+        if (start >= line.size()) {
+            ++data.report.skipped;
+            continue;
+        }
+        const std::string_view key = line.substr(start, options.length > 0 ? static_cast<std::size_t>(options.length)
+                                                                           : std::string_view::npos);
+        if (options.mode == ReferenceIndex::Mode::Numeric) {
+            std::uint64_t value = 0;
+            if (parseNumber(trim(key), value)) data.numbers.push_back(value);
+            else ++data.report.skipped;
+            continue;
+        }
+        data.keys.push_back({prefix64(key), key});
+        if (options.mode == ReferenceIndex::Mode::Exact && data.digitsOnly) {
+            data.digitsOnly = isDigits(key) && (data.digitLength == 0 || key.size() == data.digitLength);
+            data.digitLength = key.size();
+        }
+    }
+}
+
+void sortFile(FileData& data, ReferenceIndex::Mode mode, bool asNumbers) {
+    if (asNumbers && !data.keys.empty()) {
+        data.numbers.reserve(data.keys.size());
+        for (const auto& key : data.keys) {
+            std::uint64_t value = 0;
+            parseNumber(key.text, value);
+            data.numbers.push_back(value);
+        }
+        std::vector<SortKey>().swap(data.keys);
+    }
+    std::sort(data.keys.begin(), data.keys.end());
+    data.keys.erase(std::unique(data.keys.begin(), data.keys.end()), data.keys.end());
+    std::sort(data.numbers.begin(), data.numbers.end());
+    data.numbers.erase(std::unique(data.numbers.begin(), data.numbers.end()), data.numbers.end());
+    std::sort(data.ranges.begin(), data.ranges.end());
+    data.report.entries = mode == ReferenceIndex::Mode::Range ? data.ranges.size()
+                          : asNumbers                         ? data.numbers.size()
+                                                              : data.keys.size();
+}
+
+} // namespace
+
+bool ReferenceIndex::parseMode(const std::string& text, Mode& mode) {
+    if (text == "exact") mode = Mode::Exact;
+    else if (text == "prefix") mode = Mode::Prefix;
+    else if (text == "range") mode = Mode::Range;
+    else if (text == "numeric") mode = Mode::Numeric;
+    else return false;
+    return true;
+}
+
+const char* ReferenceIndex::modeName(Mode mode) {
+    switch (mode) {
+        case Mode::Exact: return "exact";
+        case Mode::Prefix: return "prefix";
+        case Mode::Range: return "range";
+        case Mode::Numeric: return "numeric";
+    }
+    return "exact";
+}
+
+bool ReferenceIndex::load(const std::vector<std::string>& paths, const Options& options, std::vector<FileReport>* reports) {
+    *this = ReferenceIndex();
+    mode_ = options.mode;
+
+    std::vector<std::unique_ptr<FileData>> files;
+    for (const auto& path : paths) {
+        files.push_back(std::make_unique<FileData>());
+        files.back()->report.path = path;
+    }
+    {
+        std::vector<std::thread> loaders;
+        for (auto& file : files) loaders.emplace_back(splitFile, std::ref(*file), std::cref(options));
+        for (auto& loader : loaders) loader.join();
+    }
+
+    bool ok = true;
+    for (const auto& file : files) {
+        if (!file->report.ok) {
+            getLogger()->error("[ReferenceIndex] Cannot read reference file '{}'", file->report.path);
+            ok = false;
+        }
+    }
+    if (!ok) {
+        if (reports) {
+            for (const auto& file : files) reports->push_back(file->report);
+        }
+        *this = ReferenceIndex();
+        return false;
+    }
+
+    // Exact keys that are all digits of one length compare the same as numbers
+    numeric_ = mode_ == Mode::Numeric;
+    if (mode_ == Mode::Exact) {
+        bool digitsOnly = true;
+        std::size_t length = 0;
+        for (const auto& file : files) {
+            if (file->keys.empty()) continue;
+            if (!file->digitsOnly || (length != 0 && file->digitLength != length)) digitsOnly = false;
+            length = file->digitLength;
+        }
+        numeric_ = digitsOnly && length > 0;
+        numericLength_ = numeric_ ? length : 0;
+    }
+    {
+        std::vector<std::thread> sorters;
+        for (auto& file : files) sorters.emplace_back(sortFile, std::ref(*file), mode_, numeric_);
+        for (auto& sorter : sorters) sorter.join();
+    }
+    if (reports) {
+        for (const auto& file : files) reports->push_back(file->report);
+    }
+
+    if (mode_ == Mode::Range) {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> all;
+        for (const auto& file : files) all.insert(all.end(), file->ranges.begin(), file->ranges.end());
+        std::sort(all.begin(), all.end());
+        for (const auto& range : all) {
+            // Merge overlapping and adjacent ranges so a lookup checks a single candidate
+            if (!ranges_.empty() && (range.first <= ranges_.back().second ||
+                                     range.first - 1 == ranges_.back().second)) {
+                ranges_.back().second = std::max(ranges_.back().second, range.second);
+            } else {
+                ranges_.push_back(range);
+            }
+        }
+        ranges_.shrink_to_fit();
+        return true;
+    }
+
+    if (numeric_) {
+        std::vector<std::uint64_t> all;
+        std::size_t total = 0;
+        for (const auto& file : files) total += file->numbers.size();
+        all.reserve(total);
+        for (const auto& file : files) {
+            const std::size_t merged = all.size();
+            all.insert(all.end(), file->numbers.begin(), file->numbers.end());
+            std::vector<std::uint64_t>().swap(file->numbers);
+            std::inplace_merge(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(merged), all.end());
+        }
+        all.erase(std::unique(all.begin(), all.end()), all.end());
+        numbers_.build(all);
+        return true;
+    }
+
+    // k-way merge of the sorted files, dropping keys found in more than one
+    std::size_t total = 0;
+    std::size_t totalBytes = 0;
+    for (const auto& file : files) {
+        total += file->keys.size();
+        for (const auto& key : file->keys) totalBytes += key.text.size();
+    }
+    if (totalBytes > std::numeric_limits<std::uint32_t>::max()) {
+        getLogger()->error("[ReferenceIndex] Reference keys exceed 4 GB");
+        *this = ReferenceIndex();
+        return false;
+    }
+    keys_.reserve(totalBytes);
+    offsets_.reserve(total + 1);
+    offsets_.push_back(0);
+
+    using Cursor = std::pair<std::string_view, std::size_t>; // key, file
+    auto greater = [](const Cursor& a, const Cursor& b) { return a.first > b.first; };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heads(greater);
+    std::vector<std::size_t> next(files.size(), 0);
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        if (!files[f]->keys.empty()) heads.emplace(files[f]->keys[next[f]++].text, f);
+    }
+    std::vector<bool> seenLength;
+    while (!heads.empty()) {
+        const auto [key, f] = heads.top();
+        heads.pop();
+        if (offsets_.size() == 1 || this->key(offsets_.size() - 2) != key) {
+            keys_.append(key.data(), key.size());
+            offsets_.push_back(static_cast<std::uint32_t>(keys_.size()));
+            if (key.size() >= seenLength.size()) seenLength.resize(key.size() + 1, false);
+            seenLength[key.size()] = true;
+        }
+        if (next[f] < files[f]->keys.size()) heads.emplace(files[f]->keys[next[f]++].text, f);
+    }
+    keys_.shrink_to_fit();
+    offsets_.shrink_to_fit();
+
+    for (std::size_t length = 1; length < seenLength.size(); ++length) {
+        if (seenLength[length]) lengths_.push_back(length);
+    }
+    const std::size_t count = keyCount();
+    const std::size_t blocks = (count + kStride - 1) / kStride;
+    sparse_.reserve(blocks + 1);
+    for (std::size_t i = 0; i < count; i += kStride) sparse_.push_back({prefix64(key(i)), offsets_[i]});
+    sparse_.push_back({std::numeric_limits<std::uint64_t>::max(), offsets_.back()});
+    top_.reserve((blocks + kTopStride - 1) / kTopStride);
+    for (std::size_t i = 0; i < blocks; i += kTopStride) top_.push_back(sparse_[i].prefix);
+    return true;
+}
+
+std::size_t ReferenceIndex::lowerBound(std::string_view target) const {
+    const std::size_t count = keyCount();
+    if (count == 0) return 0;
+    // Blocks whose first key has a smaller prefix end before the target; those with a larger one start after it
+    const std::uint64_t prefix = prefix64(target);
+    // The top table narrows the sparse search to one window of kTopStride entries
+    const std::size_t topNotLess = static_cast<std::size_t>(std::lower_bound(top_.begin(), top_.end(), prefix) - top_.begin());
+    const std::size_t windowBegin = topNotLess == 0 ? 0 : (topNotLess - 1) * kTopStride;
+    const std::size_t blocks = sparse_.size() - 1;
+    const std::size_t windowEnd = std::min(blocks, topNotLess * kTopStride + 1);
+    for (std::size_t i = windowBegin; i < windowEnd; i += 64 / sizeof(Block)) prefetch(reinterpret_cast<const char*>(sparse_.data() + i));
+    const std::size_t firstNotLess = static_cast<std::size_t>(
+        std::lower_bound(sparse_.begin() + static_cast<std::ptrdiff_t>(windowBegin),
+                         sparse_.begin() + static_cast<std::ptrdiff_t>(windowEnd), prefix,
+                         [](const Block& block, std::uint64_t value) { return block.prefix < value; }) -
+        sparse_.begin());
+    // Blocks starting with the same 8 bytes are rare; step over them (the end marker stops the scan)
+    std::size_t firstGreater = firstNotLess;
+    while (firstGreater < blocks && sparse_[firstGreater].prefix == prefix) ++firstGreater;
+    const std::size_t firstBlock = firstNotLess == 0 ? 0 : firstNotLess - 1;
+    std::size_t low = firstBlock * kStride;
+    std::size_t high = std::min(count, firstGreater * kStride);
+    // The candidate keys and their offsets are contiguous and known from the
+    // sparse entries: pull them in with parallel loads rather than one dependent
+    // miss per binary search step
+    for (std::size_t byte = sparse_[firstBlock].keyByte; byte < sparse_[firstGreater].keyByte; byte += 64) {
+        prefetch(keys_.data() + byte);
+    }
+    for (std::size_t i = low; i < high; i += 64 / sizeof(std::uint32_t)) prefetch(reinterpret_cast<const char*>(offsets_.data() + i));
+    while (low < high) {
+        const std::size_t mid = low + (high - low) / 2;
+        if (key(mid) < target) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+std::size_t ReferenceIndex::findExact(std::string_view target) const {
+    const std::size_t i = lowerBound(target);
+    return i < keyCount() && key(i) == target ? i : npos;
+}
+
+std::size_t ReferenceIndex::findPrefixOf(std::string_view target) const {
+    for (std::size_t length : lengths_) {
+        if (length > target.size()) break;
+        const std::size_t i = findExact(target.substr(0, length));
+        if (i != npos) return i;
+    }
+    return npos;
+}
+
+std::size_t ReferenceIndex::findRange(std::uint64_t value) const {
+    auto it = std::upper_bound(ranges_.begin(), ranges_.end(), value,
+                               [](std::uint64_t v, const std::pair<std::uint64_t, std::uint64_t>& r) { return v < r.first; });
+    if (it == ranges_.begin()) return npos;
+    --it;
+    return value <= it->second ? static_cast<std::size_t>(it - ranges_.begin()) : npos;
+}
+
+std::size_t ReferenceIndex::findNumber(std::string_view key) const {
+    std::uint64_t value = 0;
+    if (numericLength_ != 0) {
+        // Exact data: same digits, not just the same number
+        if (key.size() != numericLength_ || !parseNumber(key, value)) return npos;
+    } else if (!parseNumber(trim(key), value)) {
+        return npos;
+    }
+    return numbers_.find(value);
+}
+
+std::size_t ReferenceIndex::find(std::string_view key) const {
+    if (numeric_) return findNumber(key);
+    switch (mode_) {
+        case Mode::Exact: return findExact(key);
+        case Mode::Prefix: return findPrefixOf(key);
+        case Mode::Range: {
+            std::uint64_t value = 0;
+            return parseNumber(trim(key), value) ? findRange(value) : npos;
+        }
+        case Mode::Numeric: return findNumber(key);
+    }
+    return npos;
+}
+
+ReferenceIndex::MemoryReport ReferenceIndex::memory() const {
+    MemoryReport report;
+    report.entries = size();
+    report.keyBytes = keys_.capacity();
+    report.offsetBytes = offsets_.capacity() * sizeof(std::uint32_t);
+    report.sparseBytes = sparse_.capacity() * sizeof(Block) + top_.capacity() * sizeof(std::uint64_t) +
+                         lengths_.capacity() * sizeof(std::size_t);
+    report.rangeBytes = ranges_.capacity() * sizeof(ranges_[0]);
+    report.numericBytes = numbers_.memoryBytes();
+    return report;
+}
+
+std::string ReferenceIndex::sample(std::size_t count) const {
+    std::string text;
+    if (mode_ == Mode::Range) {
+        for (std::size_t i = 0; i < std::min(count, ranges_.size()); ++i) {
+            if (!text.empty()) text += ", ";
+            text += std::to_string(ranges_[i].first) + "-" + std::to_string(ranges_[i].second);
+        }
+        return text;
+    }
+    if (numeric_) {
+        for (std::uint64_t value : numbers_.head(count)) {
+            if (!text.empty()) text += ", ";
+            const std::string digits = std::to_string(value);
+            if (digits.size() < numericLength_) text.append(numericLength_ - digits.size(), '0');
+            text += digits;
+        }
+        return text;
+    }
+    for (std::size_t i = 0; i < std::min(count, keyCount()); ++i) {
+        if (!text.empty()) text += ", ";
+        const std::string_view k = key(i);
+        // Truncate long keys for log readability
+        text += k.size() > 32 ? std::string(k.substr(0, 32)) + "..." : std::string(k);
+    }
+    return text;
+}
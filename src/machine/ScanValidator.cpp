@@ -0,0 +1,382 @@
+#include "machine/ScanValidator.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MC_VALIDATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using Step = ScanValidator::Step;
+
+constexpr char kGroupSeparator = '\x1D'; // FNC1 as transmitted by scanners
+
+// Sum of weighted digits including the check digit; a valid number sums to a multiple of 10.
+// Positions are counted from the right (check digit = 0) and taken in pairs: the even one
+// has weight 1, the odd one weight 3 (mod-10) or is doubled with its digits added (Luhn).
+template <bool Luhn>
+bool checkDigitValid(std::string_view digits) {
+    const std::size_t n = digits.size();
+    std::uint32_t sum = 0;
+    std::uint32_t bad = 0;
+    std::size_t i = n;
+    for (; i >= 2; i -= 2) {
+        const std::uint32_t even = static_cast<std::uint8_t>(digits[i - 1]) - std::uint32_t('0');
+        const std::uint32_t odd = static_cast<std::uint8_t>(digits[i - 2]) - std::uint32_t('0');
+        bad |= (even > 9) | (odd > 9);
+        sum += even + (Luhn ? 2 * odd - 9 * (odd > 4) : 3 * odd);
+    }
+    if (i == 1) {
+        const std::uint32_t even = static_cast<std::uint8_t>(digits[0]) - std::uint32_t('0');
+        bad |= even > 9;
+        sum += even;
+    }
+    return (n >= 2) & (bad == 0) & (sum % 10 == 0);
+}
+
+bool allDigits(std::string_view text) {
+    std::uint32_t bad = 0;
+    for (char c : text) bad |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(c) - std::uint32_t('0') > 9);
+    return bad == 0;
+}
+
+void addRange(std::array<std::uint64_t, 4>& bits, unsigned low, unsigned high) {
+    for (unsigned c = low; c <= high; ++c) bits[c >> 6] |= std::uint64_t(1) << (c & 63);
+}
+
+bool inCharset(const std::array<std::uint64_t, 4>& bits, char c) {
+    const auto u = static_cast<std::uint8_t>(c);
+    return (bits[u >> 6] >> (u & 63)) & 1;
+}
+
+// GS1 "invariant" character set 82, allowed in alphanumeric AI data
+std::array<std::uint64_t, 4> gs1Charset() {
+    std::array<std::uint64_t, 4> bits{};
+    addRange(bits, '!', '"');
+    addRange(bits, '%', '?');
+    addRange(bits, 'A', 'Z');
+    addRange(bits, '_', '_');
+    addRange(bits, 'a', 'z');
+    return bits;
+}
+
+bool parseCharset(const std::string& spec, std::array<std::uint64_t, 4>& bits, std::string* error) {
+    if (spec == "digits") {
+        addRange(bits, '0', '9');
+    } else if (spec == "alphanumeric") {
+        addRange(bits, '0', '9');
+        addRange(bits, 'A', 'Z');
+        addRange(bits, 'a', 'z');
+    } else if (spec == "gs1") {
+        bits = gs1Charset();
+    } else {
+        // Literal characters and "a-z" ranges; a '-' first or last is literal
+        for (std::size_t i = 0; i < spec.size(); ++i) {
+            const auto low = static_cast<std::uint8_t>(spec[i]);
+            if (i + 2 < spec.size() && spec[i + 1] == '-') {
+                const auto high = static_cast<std::uint8_t>(spec[i + 2]);
+                if (high < low) {
+                    if (error) *error = "charset range '" + spec.substr(i, 3) + "' is reversed";
+                    return false;
+                }
+                addRange(bits, low, high);
+                i += 2;
+            } else {
+                addRange(bits, low, low);
+            }
+        }
+    }
+    if (bits == std::array<std::uint64_t, 4>{}) {
+        if (error) *error = "charset is empty";
+        return false;
+    }
+    return true;
+}
+
+// Split the bitmap into byte ranges for the SIMD test
+void compileRanges(Step& step) {
+    step.rangeCount = 0;
+    unsigned c = 0;
+    while (c < 256) {
+        if (!inCharset(step.charset, static_cast<char>(c))) {
+            ++c;
+            continue;
+        }
+        unsigned high = c;
+        while (high + 1 < 256 && inCharset(step.charset, static_cast<char>(high + 1))) ++high;
+        if (step.rangeCount < ScanValidator::kMaxSimdRanges) {
+            step.rangeLow[step.rangeCount] = static_cast<std::uint8_t>(c);
+            step.rangeSpan[step.rangeCount] = static_cast<std::uint8_t>(high - c);
+        }
+        ++step.rangeCount;
+        c = high + 1;
+    }
+}
+
+bool runLength(const Step& step, std::string_view slice) {
+    return slice.size() >= step.minLength && slice.size() <= step.maxLength;
+}
+
+bool runCharsetBitmap(const Step& step, std::string_view slice) {
+    std::uint64_t ok = 1;
+    for (char c : slice) {
+        const auto u = static_cast<std::uint8_t>(c);
+        ok &= step.charset[u >> 6] >> (u & 63);
+    }
+    return ok & 1;
+}
+
+#ifdef MC_VALIDATOR_SSE2
+// A byte is in [low, low + span] when (byte - low) wraps to at most span
+bool runCharsetSimd(const Step& step, std::string_view slice) {
+    __m128i low[ScanValidator::kMaxSimdRanges];
+    __m128i span[ScanValidator::kMaxSimdRanges];
+    for (int r = 0; r < step.rangeCount; ++r) {
+        low[r] = _mm_set1_epi8(static_cast<char>(step.rangeLow[r]));
+        span[r] = _mm_set1_epi8(static_cast<char>(step.rangeSpan[r]));
+    }
+    std::size_t i = 0;
+    for (; i + 16 <= slice.size(); i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slice.data() + i));
+        __m128i ok = _mm_setzero_si128();
+        for (int r = 0; r < step.rangeCount; ++r) {
+            const __m128i offset = _mm_sub_epi8(bytes, low[r]);
+            ok = _mm_or_si128(ok, _mm_cmpeq_epi8(_mm_min_epu8(offset, span[r]), offset));
+        }
+        if (_mm_movemask_epi8(ok) != 0xFFFF) return false;
+    }
+    return runCharsetBitmap(step, slice.substr(i));
+}
+#endif
+
+bool runMod10(const Step&, std::string_view slice) {
+    return checkDigitValid<false>(slice);
+}
+
+bool runLuhn(const Step&, std::string_view slice) {
+    return checkDigitValid<true>(slice);
+}
+
+bool runGs1(const Step&, std::string_view slice) {
+    return ScanValidator::parseGs1(slice);
+}
+
+// GS1 application identifiers: the AI is 'aiLength' digits starting with 'prefix'
+struct AiDefinition {
+    const char* prefix;
+    std::uint8_t aiLength;
+    std::uint8_t minData;
+    std::uint8_t maxData;
+    bool numeric;
+    bool checkDigit;
+};
+
+// Common AIs of the GS1 General Specifications, sorted by prefix
+constexpr AiDefinition kAiTable[] = {
+    {"00", 2, 18, 18, true, true},    // SSCC
+    {"01", 2, 14, 14, true, true},    // GTIN
+    {"02", 2, 14, 14, true, true},    // GTIN of contained items
+    {"10", 2, 1, 20, false, false},   // batch/lot
+    {"11", 2, 6, 6, true, false},     // production date
+    {"12", 2, 6, 6, true, false},     // due date
+    {"13", 2, 6, 6, true, false},     // packaging date
+    {"15", 2, 6, 6, true, false},     // best before
+    {"16", 2, 6, 6, true, false},     // sell by
+    {"17", 2, 6, 6, true, false},     // expiry
+    {"20", 2, 2, 2, true, false},     // variant
+    {"21", 2, 1, 20, false, false},   // serial
+    {"22", 2, 1, 20, false, false},   // consumer product variant
+    {"240", 3, 1, 30, false, false},  // additional product id
+    {"241", 3, 1, 30, false, false},  // customer part number
+    {"250", 3, 1, 30, false, false},  // secondary serial
+    {"251", 3, 1, 30, false, false},  // reference to source entity
+    {"30", 2, 1, 8, true, false},     // variable count
+    {"31", 4, 6, 6, true, false},     // trade measures (31nn-36nn)
+    {"32", 4, 6, 6, true, false},
+    {"33", 4, 6, 6, true, false},
+    {"34", 4, 6, 6, true, false},
+    {"35", 4, 6, 6, true, false},
+    {"36", 4, 6, 6, true, false},
+    {"37", 2, 1, 8, true, false},     // count of trade items
+    {"390", 4, 1, 15, true, false},   // amount payable
+    {"391", 4, 4, 18, true, false},   // amount payable with ISO currency
+    {"392", 4, 1, 15, true, false},
+    {"393", 4, 4, 18, true, false},
+    {"400", 3, 1, 30, false, false},  // customer order number
+    {"401", 3, 1, 30, false, false},  // GINC
+    {"402", 3, 17, 17, true, true},   // GSIN
+    {"403", 3, 1, 30, false, false},  // routing code
+    {"41", 3, 13, 13, true, true},    // GLNs (410-417)
+    {"420", 3, 1, 20, false, false},  // ship-to postal code
+    {"421", 3, 4, 12, false, false},  // ship-to postal code with ISO country
+    {"422", 3, 3, 3, true, false},    // country of origin
+    {"7003", 4, 10, 10, true, false}, // expiration date and time
+    {"8004", 4, 1, 30, false, false}, // GIAI
+    {"8005", 4, 6, 6, true, false},   // price per unit
+    {"8008", 4, 8, 12, true, false},  // production date and time
+    {"8018", 4, 18, 18, true, true},  // GSRN
+    {"8020", 4, 1, 25, false, false}, // payment slip reference
+    {"90", 2, 1, 30, false, false},   // internal
+    {"91", 2, 1, 90, false, false},
+    {"92", 2, 1, 90, false, false},
+    {"93", 2, 1, 90, false, false},
+    {"94", 2, 1, 90, false, false},
+    {"95", 2, 1, 90, false, false},
+    {"96", 2, 1, 90, false, false},
+    {"97", 2, 1, 90, false, false},
+    {"98", 2, 1, 90, false, false},
+    {"99", 2, 1, 90, false, false},
+};
+
+// First two AI digits -> [begin, end) of the definitions sharing them
+struct AiIndex {
+    std::array<std::uint8_t, 101> begin{};
+    AiIndex() {
+        std::size_t entry = 0;
+        constexpr std::size_t count = sizeof(kAiTable) / sizeof(kAiTable[0]);
+        for (int prefix = 0; prefix < 100; ++prefix) {
+            begin[prefix] = static_cast<std::uint8_t>(entry);
+            while (entry < count &&
+                   (kAiTable[entry].prefix[0] - '0') * 10 + (kAiTable[entry].prefix[1] - '0') == prefix) {
+                ++entry;
+            }
+        }
+        begin[100] = static_cast<std::uint8_t>(entry);
+    }
+};
+
+const AiDefinition* findAi(std::string_view text) {
+    static const AiIndex index;
+    if (text.size() < 2 || !allDigits(text.substr(0, 2))) return nullptr;
+    const int prefix = (text[0] - '0') * 10 + (text[1] - '0');
+    for (int i = index.begin[prefix]; i < index.begin[prefix + 1]; ++i) {
+        const std::string_view definition(kAiTable[i].prefix);
+        if (text.size() >= definition.size() && text.compare(0, definition.size(), definition) == 0) {
+            return &kAiTable[i];
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool ScanValidator::parseGs1(std::string_view text, std::vector<Gs1Element>* elements) {
+    static const std::array<std::uint64_t, 4> alphanumeric = gs1Charset();
+
+    // Symbology identifier (]C1 GS1-128, ]d2 DataMatrix, ]Q3 QR, ]e0 DataBar) and a leading FNC1
+    if (text.size() >= 3 && text[0] == ']') text.remove_prefix(3);
+    if (!text.empty() && text[0] == kGroupSeparator) text.remove_prefix(1);
+    if (text.empty()) return false;
+
+    while (!text.empty()) {
+        const AiDefinition* ai = findAi(text);
+        if (!ai || text.size() < ai->aiLength || !allDigits(text.substr(0, ai->aiLength))) return false;
+        const std::string_view aiDigits = text.substr(0, ai->aiLength);
+        text.remove_prefix(ai->aiLength);
+
+        std::size_t dataLength;
+        if (ai->minData == ai->maxData) {
+            dataLength = ai->minData;
+            if (text.size() < dataLength) return false;
+        } else {
+            dataLength = std::min(text.find(kGroupSeparator), text.size());
+        }
+        const std::string_view data = text.substr(0, dataLength);
+        if (data.size() < ai->minData || data.size() > ai->maxData) return false;
+
+        bool valid;
+        if (ai->numeric) {
+            valid = allDigits(data) && (!ai->checkDigit || checkDigitValid<false>(data));
+        } else {
+            Step step;
+            step.charset = alphanumeric;
+            valid = runCharsetBitmap(step, data);
+        }
+        if (!valid) return false;
+        if (elements) elements->push_back({aiDigits, data});
+
+        text.remove_prefix(dataLength);
+        if (!text.empty() && text[0] == kGroupSeparator) text.remove_prefix(1);
+    }
+    return true;
+}
+
+bool ScanValidator::compile(const nlohmann::json& rules, std::string* error) {
+    steps_.clear();
+    if (!rules.is_array()) {
+        if (error) *error = "validators must be a list of rules";
+        return false;
+    }
+
+    std::vector<Step> steps;
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+        const auto& rule = rules[i];
+        const std::string type = rule.is_object() ? rule.value("type", std::string()) : std::string();
+        const int start = rule.is_object() ? rule.value("startIndex", 0) : 0;
+        const int length = rule.is_object() ? rule.value("length", 0) : 0;
+        if (start < 0 || length < 0) {
+            if (error) *error = "rule " + std::to_string(i) + ": negative startIndex or length";
+            return false;
+        }
+
+        Step step;
+        step.start = static_cast<std::size_t>(start);
+        step.length = static_cast<std::size_t>(length);
+        if (type == "length") {
+            const int minLength = rule.value("min", 0);
+            const int maxLength = rule.value("max", minLength);
+            if (minLength < 0 || maxLength < minLength) {
+                if (error) *error = "rule " + std::to_string(i) + ": length needs 0 <= min <= max";
+                return false;
+            }
+            step.check = ValidateLength;
+            step.minLength = static_cast<std::size_t>(minLength);
+            step.maxLength = static_cast<std::size_t>(maxLength);
+            step.run = runLength;
+        } else if (type == "charset") {
+            std::string reason;
+            if (!parseCharset(rule.value("chars", std::string()), step.charset, &reason)) {
+                if (error) *error = "rule " + std::to_string(i) + ": " + reason;
+                return false;
+            }
+            step.check = ValidateCharset;
+            compileRanges(step);
+            step.run = runCharsetBitmap;
+#ifdef MC_VALIDATOR_SSE2
+            if (step.rangeCount <= kMaxSimdRanges) step.run = runCharsetSimd;
+#endif
+        } else if (type == "mod10") {
+            step.check = ValidateMod10;
+            step.run = runMod10;
+        } else if (type == "luhn") {
+            step.check = ValidateLuhn;
+            step.run = runLuhn;
+        } else if (type == "gs1") {
+            step.check = ValidateGs1;
+            step.run = runGs1;
+        } else {
+            if (error) *error = "rule " + std::to_string(i) + ": unknown type '" + type + "'";
+            return false;
+        }
+        steps.push_back(step);
+    }
+    steps_ = std::move(steps);
+    return true;
+}
+
+ScanValidation ScanValidator::validate(std::string_view scan) const {
+    ScanValidation result;
+    for (std::size_t i = 0; i < steps_.size(); ++i) {
+        const Step& step = steps_[i];
+        result.checked |= step.check;
+        // A scan too short for the slice fails the rule
+        const bool ok = step.start <= scan.size() &&
+                        step.run(step, scan.substr(step.start, step.length ? step.length : std::string_view::npos));
+        if (!ok) {
+            if (result.failedRule < 0) result.failedRule = static_cast<int>(i);
+            result.failed |= step.check;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,241 @@
+#include "machine/Sequence.h"
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+namespace {
+
+constexpr std::size_t kSmallestClass = 128;
+
+struct FrameNode {
+  FrameNode* next;
+};
+
+struct FramePoolState {
+  FrameNode* free[SequenceFramePool::kClasses]{};
+  std::vector<void*> chunks;
+  SequenceFramePool::Stats stats;
+
+  ~FramePoolState() {
+    for (void* chunk : chunks) ::operator delete(chunk);
+  }
+};
+
+FramePoolState& poolState() {
+  thread_local FramePoolState state;
+  return state;
+}
+
+// Size class index, kClasses if too large
+std::size_t classOf(std::size_t bytes) {
+  std::size_t index = 0;
+  for (std::size_t size = kSmallestClass; index < SequenceFramePool::kClasses; ++index, size *= 2) {
+    if (bytes <= size) break;
+  }
+  return index;
+}
+
+const char* waitName(Sequence::WaitKind kind) {
+  switch (kind) {
+  case Sequence::WaitKind::Start: return "start";
+  case Sequence::WaitKind::Rising: return "rising";
+  case Sequence::WaitKind::Falling: return "falling";
+  case Sequence::WaitKind::Message: return "message";
+  case Sequence::WaitKind::Scan: return "scan";
+  case Sequence::WaitKind::Delay: return "delay";
+  }
+  return "?";
+}
+
+constexpr std::int64_t kNoDeadline = std::numeric_limits<std::int64_t>::max();
+
+} // namespace
+
+void* SequenceFramePool::allocate(std::size_t bytes) {
+  FramePoolState& pool = poolState();
+  const std::size_t index = classOf(bytes);
+  if (index == kClasses) {
+    ++pool.stats.heapFallbacks;
+    ++pool.stats.framesInUse;
+    return ::operator new(bytes);
+  }
+  if (!pool.free[index]) {
+    // Grow this class by one chunk
+    const std::size_t size = kSmallestClass << index;
+    auto* chunk = static_cast<unsigned char*>(::operator new(size * kChunkFrames));
+    pool.chunks.push_back(chunk);
+    pool.stats.pooledBytes += size * kChunkFrames;
+    for (std::size_t i = 0; i < kChunkFrames; ++i) {
+      auto* node = reinterpret_cast<FrameNode*>(chunk + i * size);
+      node->next = pool.free[index];
+      pool.free[index] = node;
+    }
+  }
+  FrameNode* node = pool.free[index];
+  pool.free[index] = node->next;
+  ++pool.stats.framesInUse;
+  return node;
+}
+
+void SequenceFramePool::release(void* frame, std::size_t bytes) {
+  if (!frame) return;
+  FramePoolState& pool = poolState();
+  --pool.stats.framesInUse;
+  const std::size_t index = classOf(bytes);
+  if (index == kClasses) {
+    ::operator delete(frame);
+    return;
+  }
+  auto* node = static_cast<FrameNode*>(frame);
+  node->next = pool.free[index];
+  pool.free[index] = node;
+}
+
+SequenceFramePool::Stats SequenceFramePool::stats() { return poolState().stats; }
+
+void SequenceScheduler::setOutput(const std::string& name, int state) {
+  if (fx_) fx_->outputChanges.emplace_back(name, state);
+}
+
+void SequenceScheduler::send(const std::string& commName, const std::string& data) {
+  if (fx_) fx_->commSends.push_back({commName, data});
+}
+
+int SequenceScheduler::input(const std::string& name) const {
+  if (!in_) return 0;
+  auto it = in_->inputs.find(name);
+  return it == in_->inputs.end() ? 0 : it->second.state;
+}
+
+void SequenceScheduler::spawn(const std::string& name, Sequence sequence) {
+  if (!sequence.handle()) return;
+  entries_.push_back({name, std::move(sequence)});
+}
+
+bool SequenceScheduler::cancel(const std::string& name) {
+  auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) { return e.name == name; });
+  if (it == entries_.end()) return false;
+  if (fx_) {
+    it->cancelled = true; // a sequence is running; removed when run() finishes
+  } else {
+    entries_.erase(it);
+  }
+  return true;
+}
+
+void SequenceScheduler::cancelAll() {
+  if (fx_) {
+    for (auto& e : entries_) e.cancelled = true;
+  } else {
+    entries_.clear();
+  }
+}
+
+bool SequenceScheduler::ready(Sequence::promise_type& p, const CycleInputs& in, const CycleEffects& fx) const {
+  switch (p.wait) {
+  case Sequence::WaitKind::Start:
+    return true;
+  case Sequence::WaitKind::Rising:
+  case Sequence::WaitKind::Falling: {
+    auto it = in.inputs.find(p.channel);
+    const IOEventType edge = p.wait == Sequence::WaitKind::Rising ? IOEventType::Rising : IOEventType::Falling;
+    if (it != in.inputs.end() && it->second.eventType == edge) return true;
+    break;
+  }
+  case Sequence::WaitKind::Message:
+    if (in.newCommMsg && (p.channel.empty() || in.newCommMsg->commName == p.channel)) {
+      p.message = *in.newCommMsg;
+      return true;
+    }
+    break;
+  case Sequence::WaitKind::Scan:
+    for (const auto& scan : fx.scans) {
+      if (p.channel.empty() || scan.commName == p.channel) {
+        p.scan = scan;
+        return true;
+      }
+    }
+    break;
+  case Sequence::WaitKind::Delay:
+    return in.nowUs >= p.deadlineUs;
+  }
+  if (in.nowUs >= p.deadlineUs) {
+    p.timedOut = true;
+    return true;
+  }
+  return false;
+}
+
+void SequenceScheduler::run(const CycleInputs& in, CycleEffects& fx) {
+  in_ = &in;
+  fx_ = &fx;
+  // Sequences spawned while this runs wait for the next cycle
+  const std::size_t count = entries_.size();
+  for (std::size_t i = 0; i < count; ++i) {
+    Entry& entry = entries_[i];
+    if (entry.cancelled) continue;
+    const Sequence::Handle handle = entry.sequence.handle();
+    Sequence::promise_type& p = handle.promise();
+    if (!ready(p, in, fx)) continue;
+
+    const auto started = std::chrono::steady_clock::now();
+    handle.resume();
+    const auto ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+    ++stats_.resumes;
+    stats_.resumeNsTotal += ns;
+    stats_.resumeNsMax = std::max(stats_.resumeNsMax, ns);
+
+    // entries_ may have grown during the resume
+    Entry& current = entries_[i];
+    if (handle.done()) {
+      if (p.error) {
+        ++stats_.failed;
+        try {
+          std::rethrow_exception(p.error);
+        } catch (const std::exception& e) {
+          stats_.lastError = current.name + ": " + e.what();
+        } catch (...) {
+          stats_.lastError = current.name + ": unknown exception";
+        }
+      } else {
+        ++stats_.finished;
+      }
+      current.cancelled = true;
+      continue;
+    }
+    // The sequence is waiting again; its timeout counts from this cycle
+    p.deadlineUs = p.wait == Sequence::WaitKind::Delay || p.timeoutUs >= 0 ? in.nowUs + p.timeoutUs : kNoDeadline;
+  }
+  in_ = nullptr;
+  fx_ = nullptr;
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [](const Entry& e) { return e.cancelled; }),
+                 entries_.end());
+}
+
+std::optional<std::int64_t> SequenceScheduler::wakeupAtUs() const {
+  std::int64_t earliest = kNoDeadline;
+  for (const auto& e : entries_) {
+    const auto& p = e.sequence.handle().promise();
+    // A new sequence runs to its first co_await in the next cycle
+    earliest = std::min(earliest, p.wait == Sequence::WaitKind::Start ? std::int64_t{0} : p.deadlineUs);
+  }
+  if (earliest == kNoDeadline) return std::nullopt;
+  return earliest;
+}
+
+SequenceScheduler::Stats SequenceScheduler::stats() const {
+  Stats s = stats_;
+  s.live = entries_.size();
+  return s;
+}
+
+std::string SequenceScheduler::describe() const {
+  std::string text;
+  for (const auto& e : entries_) {
+    const auto& p = e.sequence.handle().promise();
+    if (!text.empty()) text += ", ";
+    text += e.name + " (" + waitName(p.wait) + (p.channel.empty() ? "" : " " + p.channel) + ")";
+  }
+  return text;
+}
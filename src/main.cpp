@@ -6,7 +6,9 @@
 #include "Logger.h"
 #include "utils/CompilerMacros.h" // Add cross-platform function name macro
 #include "gui/MainWindow.h"
+#include "gui/EngineLink.h"
 #include <QApplication>
+#include <cstring>
 #include <thread>
 
 // Global pointer to Logic instance for emergency shutdown handling.
@@ -70,32 +72,67 @@ int main(int argc, char* argv[]) {
     QObject::connect(&mainWindow, &MainWindow::windowReady,
                      mainWindow.getSettingsWindow(), &SettingsWindow::onInitialLoadComplete);
 
-    // 3. Logic Setup
-    Logic logic(eventQueue, config);
-    g_Logic = &logic;
+    // 3. Backend Setup: Logic in this process, or a link to a running machineControllerEngine (--attach)
+    bool attach = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--attach") == 0) attach = true;
+    }
+    std::unique_ptr<Logic> logic;
+    std::unique_ptr<EngineLink> engineLink;
+    if (attach) {
+        getLogger()->info("[{}] Attaching to the engine process", FUNCTION_NAME);
+        engineLink = std::make_unique<EngineLink>(eventQueue, config);
+    } else {
+        logic = std::make_unique<Logic>(eventQueue, config);
+        g_Logic = logic.get();
+    }
 
-    // Connect Logic signals to MainWindow slots
-    QObject::connect(&logic, &Logic::guiMessage, &mainWindow, &MainWindow::addMessage);
-    QObject::connect(&logic, &Logic::barcodeStoreUpdated, &mainWindow, &MainWindow::onBarcodeStoreUpdated);
-    
-    // Connect Logic's inputStatesChanged signal to SettingsWindow's updateInputStates slot
-    QObject::connect(&logic, SIGNAL(inputStatesChanged(const std::unordered_map<std::string, IOChannel>&)), 
-                     mainWindow.getSettingsWindow(), SLOT(updateInputStates(const std::unordered_map<std::string, IOChannel>&)));
-    
-    // Connect SettingsWindow's output override signals to Logic's slots
-    QObject::connect(mainWindow.getSettingsWindow(), SIGNAL(outputOverrideStateChanged(bool)), 
-                     &logic, SLOT(handleOutputOverrideStateChanged(bool)));
-    QObject::connect(mainWindow.getSettingsWindow(), SIGNAL(outputStateChanged(const std::unordered_map<std::string, IOChannel>&)), 
-                     &logic, SLOT(handleOutputStateChanged(const std::unordered_map<std::string, IOChannel>&)));
-                     
-    // Connect Logic's calibration response signal to SettingsWindow's handler
-    QObject::connect(&logic, SIGNAL(calibrationResponse(int, const std::string&)),
-                     mainWindow.getSettingsWindow(), SLOT(onGlueEncoderCalibrationResponse(int, const std::string&)));
-                     
-    // 3. Start Logic in a separate thread
-    std::thread logicThread([&logic]() {
-        logic.run();
-    });
+    // Give the History dialog access to the scan history owned by Logic (not shared with an engine process)
+    mainWindow.setScanHistory(logic ? logic->getScanHistory() : nullptr);
+
+    qRegisterMetaType<ArduinoProtocol::Capabilities>();
+    qRegisterMetaType<IOCapture::Result>();
+    // Logic and EngineLink have the same GUI signals and slots
+    auto connectBackend = [&mainWindow](auto* backend) {
+        using Backend = std::remove_pointer_t<decltype(backend)>;
+
+        // Connect backend signals to MainWindow slots
+        QObject::connect(backend, &Backend::guiMessage, &mainWindow, &MainWindow::addMessage);
+        QObject::connect(backend, &Backend::barcodeStoreUpdated, &mainWindow, &MainWindow::onBarcodeStoreUpdated);
+
+        // Connect the inputStatesChanged signal to SettingsWindow's updateInputStates slot
+        QObject::connect(backend, SIGNAL(inputStatesChanged(const std::unordered_map<std::string, IOChannel>&)), 
+                         mainWindow.getSettingsWindow(), SLOT(updateInputStates(const std::unordered_map<std::string, IOChannel>&)));
+
+        // Connect SettingsWindow's output override signals to the backend's slots
+        QObject::connect(mainWindow.getSettingsWindow(), SIGNAL(outputOverrideStateChanged(bool)), 
+                         backend, SLOT(handleOutputOverrideStateChanged(bool)));
+        QObject::connect(mainWindow.getSettingsWindow(), SIGNAL(outputStateChanged(const std::unordered_map<std::string, IOChannel>&)), 
+                         backend, SLOT(handleOutputStateChanged(const std::unordered_map<std::string, IOChannel>&)));
+
+        // Connect the calibration response signal to SettingsWindow's handler
+        QObject::connect(backend, SIGNAL(calibrationResponse(int, const std::string&)),
+                         mainWindow.getSettingsWindow(), SLOT(onGlueEncoderCalibrationResponse(int, const std::string&)));
+
+        // Connect the controller capabilities signal so setups use the negotiated schema
+        QObject::connect(backend, &Backend::controllerCapabilitiesChanged,
+                         mainWindow.getSettingsWindow(), &SettingsWindow::onControllerCapabilities);
+
+        // Finished IO captures go to the waveform viewer
+        QObject::connect(backend, &Backend::ioCaptureReady, &mainWindow, &MainWindow::onIOCaptureReady);
+    };
+
+    // 4. Start Logic in a separate thread, or the engine link's threads
+    std::thread logicThread;
+    if (logic) {
+        connectBackend(logic.get());
+        logicThread = std::thread([&logic]() {
+            logic->run();
+        });
+    } else {
+        connectBackend(engineLink.get());
+        engineLink->start();
+    }
 
     // 5. Show MainWindow and Start Event Loop
     getLogger()->debug("[{}] Showing MainWindow...", FUNCTION_NAME);
@@ -109,11 +146,15 @@ int main(int argc, char* argv[]) {
     // 6. Cleanup
     getLogger()->debug("Application closing");
 
-    // 5. Shutdown Sequence
-    logic.stop();
-    if (logicThread.joinable())
-        logicThread.join();
-    g_Logic = nullptr;
+    // 5. Shutdown Sequence (an engine process keeps running)
+    if (logic) {
+        logic->stop();
+        if (logicThread.joinable())
+            logicThread.join();
+        g_Logic = nullptr;
+    } else {
+        engineLink->stop();
+    }
 
     timeEndPeriod(1);
     return result;
@@ -0,0 +1,275 @@
+#include "shm/IpcChannel.h"
+#include "Logger.h"
+#include <chrono>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <ctime>
+    #include <fcntl.h>
+    #include <semaphore.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::uint32_t kMagic = 0x4350494Du; // "MIPC"
+constexpr std::uint32_t kVersion = 1;
+
+std::int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::uint32_t currentPid() {
+#ifdef _WIN32
+    return static_cast<std::uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(getpid());
+#endif
+}
+
+bool processAlive(std::uint32_t pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return false;
+    DWORD code = 0;
+    const bool alive = GetExitCodeProcess(process, &code) && code == STILL_ACTIVE;
+    CloseHandle(process);
+    return alive;
+#else
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+} // namespace
+
+struct IpcChannel::Segment {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::int64_t> engineStartMs;
+    std::atomic<std::int64_t> engineHeartbeatMs;
+    std::atomic<std::uint32_t> enginePid;
+    std::atomic<std::uint32_t> guiPid;
+    SpscRingHeader commands; // GUI -> engine
+    SpscRingHeader events;   // engine -> GUI
+    // Ring data follows: kRingBytes of commands, then kRingBytes of events
+
+    unsigned char* commandData() { return reinterpret_cast<unsigned char*>(this + 1); }
+    unsigned char* eventData() { return commandData() + kRingBytes; }
+};
+
+struct IpcChannel::Platform {
+#ifdef _WIN32
+    HANDLE mapping{nullptr};
+    HANDLE sendSignal{nullptr};
+    HANDLE receiveSignal{nullptr};
+#else
+    sem_t* sendSignal{SEM_FAILED};
+    sem_t* receiveSignal{SEM_FAILED};
+#endif
+};
+
+IpcChannel::IpcChannel(Role role, std::string name) : role_(role), name_(std::move(name)) {}
+
+IpcChannel::~IpcChannel() {
+    close();
+}
+
+std::string IpcChannel::objectName(const char* suffix) const {
+#ifdef _WIN32
+    return "Local\\" + name_ + suffix;
+#else
+    return "/" + name_ + suffix;
+#endif
+}
+
+bool IpcChannel::open() {
+    static_assert(sizeof(Segment) % 64 == 0, "ring data must start cache-line aligned");
+    if (segment_) return true;
+    const bool engine = role_ == Role::Engine;
+    const std::size_t size = sizeof(Segment) + 2 * kRingBytes;
+    const std::string mappingName = objectName("");
+    // Engine sends on ".evt" and waits on ".cmd"; the GUI the other way round
+    const std::string sendName = objectName(engine ? ".evt" : ".cmd");
+    const std::string receiveName = objectName(engine ? ".cmd" : ".evt");
+    auto platform = std::make_unique<Platform>();
+    void* base = nullptr;
+
+#ifdef _WIN32
+    if (engine) {
+        platform->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                               static_cast<DWORD>(size), mappingName.c_str());
+    } else {
+        platform->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str());
+    }
+    if (!platform->mapping) {
+        // A GUI retries until the engine is up
+        getLogger()->log(engine ? spdlog::level::err : spdlog::level::debug, "[IpcChannel] Cannot {} '{}' (error {})",
+                         engine ? "create" : "open", mappingName, GetLastError());
+        return false;
+    }
+    base = MapViewOfFile(platform->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    // Auto-reset events, created by whichever side comes first
+    platform->sendSignal = CreateEventA(nullptr, FALSE, FALSE, sendName.c_str());
+    platform->receiveSignal = CreateEventA(nullptr, FALSE, FALSE, receiveName.c_str());
+    if (!base || !platform->sendSignal || !platform->receiveSignal) {
+        getLogger()->error("[IpcChannel] Cannot map '{}' (error {})", mappingName, GetLastError());
+        if (base) UnmapViewOfFile(base);
+        if (platform->sendSignal) CloseHandle(platform->sendSignal);
+        if (platform->receiveSignal) CloseHandle(platform->receiveSignal);
+        CloseHandle(platform->mapping);
+        return false;
+    }
+#else
+    const int fd = engine ? shm_open(mappingName.c_str(), O_CREAT | O_RDWR, 0600)
+                          : shm_open(mappingName.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        getLogger()->log(engine ? spdlog::level::err : spdlog::level::debug, "[IpcChannel] Cannot {} '{}' (errno {})",
+                         engine ? "create" : "open", mappingName, errno);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || (static_cast<std::size_t>(st.st_size) < size &&
+                                (!engine || ftruncate(fd, static_cast<off_t>(size)) != 0))) {
+        getLogger()->error("[IpcChannel] Segment '{}' has the wrong size", mappingName);
+        ::close(fd);
+        return false;
+    }
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        getLogger()->error("[IpcChannel] mmap('{}') failed (errno {})", mappingName, errno);
+        return false;
+    }
+    platform->sendSignal = sem_open(sendName.c_str(), O_CREAT, 0600, 0);
+    platform->receiveSignal = sem_open(receiveName.c_str(), O_CREAT, 0600, 0);
+    if (platform->sendSignal == SEM_FAILED || platform->receiveSignal == SEM_FAILED) {
+        getLogger()->error("[IpcChannel] sem_open for '{}' failed (errno {})", mappingName, errno);
+        if (platform->sendSignal != SEM_FAILED) sem_close(platform->sendSignal);
+        if (platform->receiveSignal != SEM_FAILED) sem_close(platform->receiveSignal);
+        munmap(base, size);
+        return false;
+    }
+#endif
+
+    Segment* segment = static_cast<Segment*>(base);
+    if (engine) {
+        // A restarted engine starts with empty rings; an attached GUI notices engineStartMs change
+        segment->magic = kMagic;
+        segment->version = kVersion;
+        SpscByteRing::initialize(&segment->commands, kRingBytes);
+        SpscByteRing::initialize(&segment->events, kRingBytes);
+        segment->enginePid.store(currentPid(), std::memory_order_relaxed);
+        segment->engineHeartbeatMs.store(wallClockMs(), std::memory_order_relaxed);
+        segment->engineStartMs.store(wallClockMs(), std::memory_order_release);
+    } else {
+        bool ok = segment->magic == kMagic && segment->version == kVersion;
+        if (!ok) {
+            getLogger()->error("[IpcChannel] '{}' is not a compatible engine channel", mappingName);
+        } else {
+            // Only one GUI may produce commands; take over from one that died
+            const std::uint32_t self = currentPid();
+            std::uint32_t owner = segment->guiPid.load(std::memory_order_acquire);
+            if (owner != 0 && owner != self && processAlive(owner)) {
+                getLogger()->error("[IpcChannel] Another GUI (pid {}) is attached to the engine", owner);
+                ok = false;
+            } else if (!segment->guiPid.compare_exchange_strong(owner, self)) {
+                ok = false;
+            }
+        }
+        if (!ok) {
+            platform_ = std::move(platform);
+            segment_ = segment;
+            close();
+            return false;
+        }
+    }
+
+    platform_ = std::move(platform);
+    segment_ = segment;
+    if (engine) {
+        outbox_ = SpscByteRing(&segment_->events, segment_->eventData());
+        inbox_ = SpscByteRing(&segment_->commands, segment_->commandData());
+    } else {
+        outbox_ = SpscByteRing(&segment_->commands, segment_->commandData());
+        inbox_ = SpscByteRing(&segment_->events, segment_->eventData());
+        inbox_.clear(); // whatever a previous GUI left unread
+    }
+    return true;
+}
+
+void IpcChannel::close() {
+    if (!segment_) return;
+    const std::size_t size = sizeof(Segment) + 2 * kRingBytes;
+    if (role_ == Role::Gui) {
+        std::uint32_t self = currentPid();
+        segment_->guiPid.compare_exchange_strong(self, 0);
+    } else {
+        segment_->enginePid.store(0, std::memory_order_release);
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(segment_);
+    CloseHandle(platform_->sendSignal);
+    CloseHandle(platform_->receiveSignal);
+    CloseHandle(platform_->mapping);
+#else
+    munmap(segment_, size);
+    sem_close(platform_->sendSignal);
+    sem_close(platform_->receiveSignal);
+    if (role_ == Role::Engine) {
+        shm_unlink(objectName("").c_str());
+        sem_unlink(objectName(".cmd").c_str());
+        sem_unlink(objectName(".evt").c_str());
+    }
+#endif
+    (void)size;
+    segment_ = nullptr;
+    platform_.reset();
+}
+
+bool IpcChannel::send(const std::string& message) {
+    if (!segment_ || !outbox_.tryPush(message.data(), message.size())) return false;
+#ifdef _WIN32
+    SetEvent(platform_->sendSignal);
+#else
+    sem_post(platform_->sendSignal);
+#endif
+    return true;
+}
+
+bool IpcChannel::receive(std::string& message, int timeoutMs) {
+    if (!segment_) return false;
+    if (inbox_.tryPop(message)) return true;
+#ifdef _WIN32
+    WaitForSingleObject(platform_->receiveSignal, static_cast<DWORD>(timeoutMs));
+#else
+    timespec deadline{};
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += static_cast<long>(timeoutMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (sem_timedwait(platform_->receiveSignal, &deadline) != 0 && errno == EINTR) {
+    }
+#endif
+    return inbox_.tryPop(message);
+}
+
+void IpcChannel::heartbeat() {
+    if (segment_) segment_->engineHeartbeatMs.store(wallClockMs(), std::memory_order_release);
+}
+
+std::int64_t IpcChannel::engineHeartbeatMs() const {
+    return segment_ ? segment_->engineHeartbeatMs.load(std::memory_order_acquire) : 0;
+}
+
+std::int64_t IpcChannel::engineStartMs() const {
+    return segment_ ? segment_->engineStartMs.load(std::memory_order_acquire) : 0;
+}
@@ -0,0 +1,260 @@
+#include "shm/SharedStateWriter.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+static_assert(offsetof(mc_state_segment, outputWord) == offsetof(mc_state_segment, inputWord) + sizeof(std::uint64_t),
+              "mc_state_read_io copies both IO words at once");
+static_assert(offsetof(mc_state_segment, sequence) % 8 == 0, "sequence must be naturally aligned");
+static_assert(ProductionStats::kTestCount <= MC_STATE_MAX_TESTS, "mc_state_counters has too few test slots");
+
+namespace {
+
+template <std::size_t N>
+void copyName(char (&dst)[N], const std::string& src) {
+    const std::size_t n = std::min(src.size(), N - 1);
+    std::memcpy(dst, src.data(), n);
+    std::memset(dst + n, 0, N - n);
+}
+
+// Slot tables are sorted; a change in the set of names means new slots
+template <typename Map>
+bool sameNames(const std::vector<std::string>& slots, const Map& map) {
+    if (slots.size() != map.size()) return false;
+    for (const auto& entry : map) {
+        if (!std::binary_search(slots.begin(), slots.end(), entry.first)) return false;
+    }
+    return true;
+}
+
+template <typename Map>
+std::vector<std::string> sortedNames(const Map& map) {
+    std::vector<std::string> names;
+    names.reserve(map.size());
+    for (const auto& entry : map) names.push_back(entry.first);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+} // namespace
+
+struct SharedStateWriter::Mapping {
+#ifdef _WIN32
+    HANDLE handle{nullptr};
+#else
+    bool unlinkOnClose{false};
+#endif
+};
+
+SharedStateWriter::SharedStateWriter(std::string name)
+    : name_(name.empty() ? std::string(MC_STATE_DEFAULT_NAME) : std::move(name)) {}
+
+SharedStateWriter::~SharedStateWriter() {
+    close();
+}
+
+bool SharedStateWriter::open() {
+    if (segment_) return true;
+    const std::size_t size = sizeof(mc_state_segment);
+    auto mapping = std::make_unique<Mapping>();
+    void* base = nullptr;
+
+#ifdef _WIN32
+    mapping->handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                         static_cast<DWORD>(size), name_.c_str());
+    if (!mapping->handle) {
+        getLogger()->error("[SharedStateWriter] CreateFileMapping('{}') failed (error {})", name_, GetLastError());
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Left over while readers still hold it, or a second producer is running
+        getLogger()->warn("[SharedStateWriter] Shared state '{}' already exists; taking it over", name_);
+    }
+    base = MapViewOfFile(mapping->handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!base) {
+        getLogger()->error("[SharedStateWriter] MapViewOfFile('{}') failed (error {})", name_, GetLastError());
+        CloseHandle(mapping->handle);
+        return false;
+    }
+#else
+    const int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        getLogger()->error("[SharedStateWriter] shm_open('{}') failed (errno {})", name_, errno);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || (static_cast<std::size_t>(st.st_size) != size && ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+        getLogger()->error("[SharedStateWriter] Cannot size shared state '{}' (errno {})", name_, errno);
+        ::close(fd);
+        return false;
+    }
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        getLogger()->error("[SharedStateWriter] mmap('{}') failed (errno {})", name_, errno);
+        return false;
+    }
+    mapping->unlinkOnClose = true;
+#endif
+
+    mapping_ = std::move(mapping);
+    segment_ = static_cast<mc_state_segment*>(base);
+
+    // Continue the sequence of a previous producer so readers never see it go back
+    sequence_ = mc_state_load_sequence(&segment_->sequence);
+    if (sequence_ & 1u) ++sequence_; // that producer stopped in the middle of an update
+
+    beginWrite();
+    std::memset(reinterpret_cast<unsigned char*>(segment_) + offsetof(mc_state_segment, publishCount), 0,
+                size - offsetof(mc_state_segment, publishCount));
+    segment_->magic = MC_STATE_MAGIC;
+    segment_->versionMajor = MC_STATE_VERSION_MAJOR;
+    segment_->versionMinor = MC_STATE_VERSION_MINOR;
+    segment_->segmentSize = static_cast<std::uint32_t>(size);
+    segment_->producerState = MC_STATE_PRODUCER_RUNNING;
+    endWrite();
+
+    inputSlots_.clear();
+    outputSlots_.clear();
+    timerSlots_.clear();
+    portSlots_.clear();
+    barcodesPublished_ = false;
+    getLogger()->info("[SharedStateWriter] Publishing machine state in shared memory '{}' ({} bytes)", name_, size);
+    return true;
+}
+
+void SharedStateWriter::close() {
+    if (!segment_) return;
+    beginWrite();
+    segment_->producerState = MC_STATE_PRODUCER_STOPPED;
+    endWrite();
+#ifdef _WIN32
+    UnmapViewOfFile(segment_);
+    CloseHandle(mapping_->handle);
+#else
+    munmap(segment_, sizeof(mc_state_segment));
+    // Readers keep their mapping; new readers find no producer
+    if (mapping_->unlinkOnClose) shm_unlink(name_.c_str());
+#endif
+    segment_ = nullptr;
+    mapping_.reset();
+}
+
+void SharedStateWriter::beginWrite() {
+    mc_state_store_sequence(&segment_->sequence, ++sequence_); // odd: update in progress
+    mc_state_release_fence();                                  // ...visible before any field changes
+}
+
+void SharedStateWriter::endWrite() {
+    mc_state_store_sequence(&segment_->sequence, ++sequence_);
+}
+
+void SharedStateWriter::publish(const Update& update) {
+    if (!segment_) return;
+    try {
+        beginWrite();
+        bool layoutChanged = false;
+        if (update.inputs) {
+            layoutChanged |= writeChannels(*update.inputs, inputSlots_, segment_->inputNames,
+                                           segment_->inputCount, segment_->inputWord);
+        }
+        if (update.outputs) {
+            layoutChanged |= writeChannels(*update.outputs, outputSlots_, segment_->outputNames,
+                                           segment_->outputCount, segment_->outputWord);
+        }
+        if (update.timers) layoutChanged |= writeTimers(*update.timers);
+        if (update.barcodes) layoutChanged |= writeBarcodes(*update.barcodes);
+        if (update.counters) {
+            mc_state_counters& c = segment_->counters;
+            c.cycles = update.counters->cycles;
+            c.scans = update.counters->scans;
+            c.products = update.counters->products;
+            c.rejects = update.counters->rejects;
+            for (std::size_t t = 0; t < ProductionStats::kTestCount; ++t) {
+                c.tests[t].passed = update.counters->tests[t].passed;
+                c.tests[t].failed = update.counters->tests[t].failed;
+            }
+        }
+        if (layoutChanged) ++segment_->layoutVersion;
+        ++segment_->publishCount;
+        segment_->updatedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        endWrite();
+    } catch (const std::exception& e) {
+        // Never leave the sequence odd: readers would spin until the next update
+        if (sequence_ & 1u) endWrite();
+        getLogger()->error("[SharedStateWriter] Publish failed: {}", e.what());
+    }
+}
+
+bool SharedStateWriter::writeChannels(const ChannelMap& channels, std::vector<std::string>& slots,
+                                      char (*names)[MC_STATE_NAME_BYTES], std::uint32_t& count, std::uint64_t& word) {
+    bool changed = false;
+    if (!sameNames(slots, channels)) {
+        slots = sortedNames(channels);
+        count = static_cast<std::uint32_t>(std::min<std::size_t>(slots.size(), MC_STATE_MAX_CHANNELS));
+        for (std::size_t i = 0; i < MC_STATE_MAX_CHANNELS; ++i) {
+            copyName(names[i], i < count ? slots[i] : std::string());
+        }
+        changed = true;
+    }
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto it = channels.find(slots[i]);
+        if (it != channels.end() && it->second.state) bits |= (1ULL << i);
+    }
+    word = bits;
+    return changed;
+}
+
+bool SharedStateWriter::writeTimers(const TimerMap& timers) {
+    bool changed = false;
+    if (!sameNames(timerSlots_, timers)) {
+        timerSlots_ = sortedNames(timers);
+        segment_->timerCount = static_cast<std::uint32_t>(std::min<std::size_t>(timerSlots_.size(), MC_STATE_MAX_TIMERS));
+        for (std::size_t i = 0; i < MC_STATE_MAX_TIMERS; ++i) {
+            copyName(segment_->timers[i].name, i < segment_->timerCount ? timerSlots_[i] : std::string());
+        }
+        changed = true;
+    }
+    for (std::size_t i = 0; i < segment_->timerCount; ++i) {
+        const TimerSnapshot& t = timers.at(timerSlots_[i]);
+        segment_->timers[i].state = t.state;
+        segment_->timers[i].durationMs = t.durationMs;
+    }
+    return changed;
+}
+
+bool SharedStateWriter::writeBarcodes(const BarcodeMap& barcodes) {
+    bool changed = false;
+    if (!sameNames(portSlots_, barcodes)) {
+        portSlots_ = sortedNames(barcodes);
+        segment_->portCount = static_cast<std::uint32_t>(std::min<std::size_t>(portSlots_.size(), MC_STATE_MAX_PORTS));
+        for (std::size_t p = 0; p < MC_STATE_MAX_PORTS; ++p) {
+            copyName(segment_->ports[p].name, p < segment_->portCount ? portSlots_[p] : std::string());
+        }
+        changed = true;
+    }
+    for (std::size_t p = 0; p < segment_->portCount; ++p) {
+        const std::vector<std::string>& cells = barcodes.at(portSlots_[p]);
+        mc_state_port& port = segment_->ports[p];
+        port.cellCount = static_cast<std::uint32_t>(std::min<std::size_t>(cells.size(), MC_STATE_MAX_CELLS));
+        port.truncatedCells = 0;
+        for (std::size_t c = 0; c < port.cellCount; ++c) {
+            if (cells[c].size() >= MC_STATE_CELL_BYTES) ++port.truncatedCells;
+            copyName(segment_->cells[p][c], cells[c]);
+        }
+    }
+    barcodesPublished_ = true;
+    return changed;
+}
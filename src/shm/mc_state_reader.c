@@ -0,0 +1,162 @@
+/* Reader side of the MachineController shared state segment (see mc_state.h). */
+
+#include "shm/mc_state.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Retries before a read gives up with MC_STATE_BUSY; an update takes microseconds */
+#define MC_STATE_READ_RETRIES 1000
+
+struct mc_state_reader {
+    const unsigned char* base;
+    size_t mappedSize;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+};
+
+static const volatile uint64_t* sequence_ptr(const mc_state_reader* reader) {
+    return (const volatile uint64_t*)(reader->base + offsetof(mc_state_segment, sequence));
+}
+
+mc_state_reader* mc_state_open(const char* name, int* error) {
+    mc_state_reader* reader;
+    const mc_state_segment* segment;
+    int dummy;
+    if (!error) error = &dummy;
+    if (!name) name = MC_STATE_DEFAULT_NAME;
+
+    reader = (mc_state_reader*)calloc(1, sizeof(*reader));
+    if (!reader) {
+        *error = MC_STATE_INVALID;
+        return NULL;
+    }
+
+#ifdef _WIN32
+    {
+        MEMORY_BASIC_INFORMATION info;
+        reader->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+        if (!reader->mapping) {
+            free(reader);
+            *error = MC_STATE_NOT_FOUND;
+            return NULL;
+        }
+        reader->base = (const unsigned char*)MapViewOfFile(reader->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!reader->base || VirtualQuery(reader->base, &info, sizeof(info)) == 0) {
+            if (reader->base) UnmapViewOfFile(reader->base);
+            CloseHandle(reader->mapping);
+            free(reader);
+            *error = MC_STATE_NOT_FOUND;
+            return NULL;
+        }
+        reader->mappedSize = info.RegionSize;
+    }
+#else
+    {
+        struct stat st;
+        void* base;
+        const int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            free(reader);
+            *error = MC_STATE_NOT_FOUND;
+            return NULL;
+        }
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            free(reader);
+            *error = MC_STATE_NOT_FOUND;
+            return NULL;
+        }
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            free(reader);
+            *error = MC_STATE_NOT_FOUND;
+            return NULL;
+        }
+        reader->base = (const unsigned char*)base;
+        reader->mappedSize = (size_t)st.st_size;
+    }
+#endif
+
+    segment = (const mc_state_segment*)reader->base;
+    if (reader->mappedSize < offsetof(mc_state_segment, publishCount) || segment->magic != MC_STATE_MAGIC ||
+        segment->versionMajor != MC_STATE_VERSION_MAJOR || segment->segmentSize > reader->mappedSize) {
+        mc_state_close(reader);
+        *error = MC_STATE_INCOMPATIBLE;
+        return NULL;
+    }
+    /* Only what the producer wrote is valid; an older producer has a shorter segment */
+    reader->mappedSize = segment->segmentSize;
+    *error = MC_STATE_OK;
+    return reader;
+}
+
+void mc_state_close(mc_state_reader* reader) {
+    if (!reader) return;
+#ifdef _WIN32
+    if (reader->base) UnmapViewOfFile(reader->base);
+    if (reader->mapping) CloseHandle(reader->mapping);
+#else
+    if (reader->base) munmap((void*)reader->base, reader->mappedSize);
+#endif
+    free(reader);
+}
+
+uint64_t mc_state_sequence(const mc_state_reader* reader) {
+    return reader ? mc_state_load_sequence(sequence_ptr(reader)) : 0;
+}
+
+int mc_state_read_range(const mc_state_reader* reader, size_t offset, size_t size, void* out, uint64_t* sequence) {
+    size_t available;
+    int attempt;
+    if (!reader || !out || offset > sizeof(mc_state_segment) || size > sizeof(mc_state_segment) - offset) {
+        return MC_STATE_INVALID;
+    }
+    /* Fields the producer does not have (older minor version) read as zero */
+    available = offset < reader->mappedSize ? reader->mappedSize - offset : 0;
+    if (available > size) available = size;
+    if (available < size) memset((unsigned char*)out + available, 0, size - available);
+
+    for (attempt = 0; attempt < MC_STATE_READ_RETRIES; ++attempt) {
+        const uint64_t before = mc_state_load_sequence(sequence_ptr(reader));
+        uint64_t after;
+        if (before & 1u) continue; /* update in progress */
+        memcpy(out, reader->base + offset, available);
+        mc_state_acquire_fence();
+        after = mc_state_load_sequence(sequence_ptr(reader));
+        if (before == after) {
+            if (sequence) *sequence = before;
+            return MC_STATE_OK;
+        }
+    }
+    return MC_STATE_BUSY;
+}
+
+int mc_state_read(const mc_state_reader* reader, mc_state_segment* out) {
+    return mc_state_read_range(reader, 0, sizeof(*out), out, NULL);
+}
+
+int mc_state_read_io(const mc_state_reader* reader, uint64_t* inputWord, uint64_t* outputWord, uint64_t* sequence) {
+    uint64_t words[2];
+    int rc;
+    /* inputWord and outputWord are adjacent: one consistent copy */
+    rc = mc_state_read_range(reader, offsetof(mc_state_segment, inputWord), sizeof(words), words, sequence);
+    if (rc != MC_STATE_OK) return rc;
+    if (inputWord) *inputWord = words[0];
+    if (outputWord) *outputWord = words[1];
+    return MC_STATE_OK;
+}
@@ -0,0 +1,197 @@
+#include "utils/SocketCompat.h" // must precede headers that include windows.h
+#include "stats/MetricsHttpServer.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr int kAcceptPollMs = 200;            // how often the accept loop checks for stop
+constexpr int kClientTimeoutMs = 2000;        // whole request must arrive within this
+constexpr std::size_t kMaxRequestBytes = 4096;
+
+int sendFlags() {
+#ifdef MSG_NOSIGNAL
+    return MSG_NOSIGNAL; // a client that went away must not raise SIGPIPE
+#else
+    return 0;
+#endif
+}
+
+// Closes the socket when it goes out of scope
+struct ScopedSocket {
+    socket_t fd{kInvalidSocket};
+    ~ScopedSocket() {
+        if (fd != kInvalidSocket) closeSocket(fd);
+    }
+};
+
+bool sendAll(socket_t s, const std::string& data) {
+    std::size_t sent = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kClientTimeoutMs);
+    while (sent < data.size()) {
+        const int n = ::send(s, data.data() + sent, static_cast<int>(data.size() - sent), sendFlags());
+        if (n > 0) {
+            sent += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        pollfd pfd{};
+        pfd.fd = s;
+        pfd.events = POLLOUT;
+        if (pollSockets(&pfd, 1, 100) < 0) return false;
+    }
+    return true;
+}
+
+std::string response(const char* status, const char* contentType, const std::string& body) {
+    std::string r = std::string("HTTP/1.0 ") + status + "\r\n";
+    r += std::string("Content-Type: ") + contentType + "\r\n";
+    r += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    r += "Connection: close\r\n\r\n";
+    r += body;
+    return r;
+}
+
+} // namespace
+
+struct MetricsHttpServer::Listener {
+    SocketRuntime runtime; // keeps Winsock initialized while the server socket lives
+    ScopedSocket socket;
+};
+
+MetricsHttpServer::MetricsHttpServer(const MetricsRegistry& registry, Options options)
+    : registry_(registry), options_(std::move(options)) {}
+
+MetricsHttpServer::~MetricsHttpServer() {
+    stop();
+}
+
+bool MetricsHttpServer::start() {
+    if (thread_.joinable()) return true;
+
+    auto listener = std::make_unique<Listener>();
+    if (!listener->runtime.ok()) {
+        getLogger()->error("[MetricsHttpServer] Socket runtime initialization failed");
+        return false;
+    }
+
+    const std::string address = options_.bindAddress == "localhost" ? "127.0.0.1" : options_.bindAddress;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<unsigned short>(options_.port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        getLogger()->error("[MetricsHttpServer] Invalid bind address '{}'", options_.bindAddress);
+        return false;
+    }
+    if (!isLoopbackAddress(options_.bindAddress)) {
+        getLogger()->warn("[MetricsHttpServer] Binding to non-loopback address {}; metrics are reachable from the network",
+                          options_.bindAddress);
+    }
+
+    listener->socket.fd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener->socket.fd == kInvalidSocket) {
+        getLogger()->error("[MetricsHttpServer] socket() failed (error {})", lastSocketError());
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listener->socket.fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (::bind(listener->socket.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener->socket.fd, 8) != 0) {
+        getLogger()->error("[MetricsHttpServer] Failed to listen on {}:{} (error {})",
+                           options_.bindAddress, options_.port, lastSocketError());
+        return false;
+    }
+    setNonBlocking(listener->socket.fd);
+
+    sockaddr_in bound{};
+    socklen_t boundLen = sizeof(bound);
+    if (getsockname(listener->socket.fd, reinterpret_cast<sockaddr*>(&bound), &boundLen) == 0) {
+        boundPort_ = ntohs(bound.sin_port);
+    }
+
+    listener_ = std::move(listener);
+    stopping_ = false;
+    thread_ = std::thread(&MetricsHttpServer::run, this);
+    getLogger()->info("[MetricsHttpServer] Serving metrics on http://{}:{}/metrics", options_.bindAddress, boundPort_);
+    return true;
+}
+
+void MetricsHttpServer::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+    listener_.reset();
+}
+
+void MetricsHttpServer::run() {
+    while (!stopping_) {
+        pollfd pfd{};
+        pfd.fd = listener_->socket.fd;
+        pfd.events = POLLIN;
+        const int ready = pollSockets(&pfd, 1, kAcceptPollMs);
+        if (ready <= 0 || !(pfd.revents & POLLIN)) continue;
+
+        ScopedSocket client;
+        client.fd = ::accept(listener_->socket.fd, nullptr, nullptr);
+        if (client.fd == kInvalidSocket) continue;
+        setNonBlocking(client.fd);
+        try {
+            serveClient(static_cast<std::intptr_t>(client.fd));
+        } catch (const std::exception& e) {
+            getLogger()->warn("[MetricsHttpServer] Request failed: {}", e.what());
+        }
+    }
+}
+
+void MetricsHttpServer::serveClient(std::intptr_t clientFd) {
+    const socket_t fd = static_cast<socket_t>(clientFd);
+    // Read the request head (bounded size and time)
+    std::string request;
+    char buf[1024];
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kClientTimeoutMs);
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos) {
+        if (request.size() >= kMaxRequestBytes) {
+            sendAll(fd, response("431 Request Header Fields Too Large", "text/plain", "request too large\n"));
+            return;
+        }
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0 || stopping_) return;
+        pollfd pfd{};
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        if (pollSockets(&pfd, 1, static_cast<int>(remaining)) <= 0) return;
+        const int n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        request.append(buf, static_cast<std::size_t>(n));
+    }
+
+    // Request line: METHOD SP PATH SP VERSION
+    const std::size_t lineEnd = request.find_first_of("\r\n");
+    const std::string requestLine = request.substr(0, lineEnd);
+    const std::size_t sp1 = requestLine.find(' ');
+    const std::size_t sp2 = sp1 == std::string::npos ? std::string::npos : requestLine.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos) {
+        sendAll(fd, response("400 Bad Request", "text/plain", "bad request\n"));
+        return;
+    }
+    const std::string method = requestLine.substr(0, sp1);
+    std::string path = requestLine.substr(sp1 + 1, sp2 == std::string::npos ? std::string::npos : sp2 - sp1 - 1);
+    const std::size_t query = path.find('?');
+    if (query != std::string::npos) path.resize(query);
+
+    if (method != "GET" && method != "HEAD") {
+        sendAll(fd, response("405 Method Not Allowed", "text/plain", "only GET is supported\n"));
+        return;
+    }
+    if (path == "/metrics") {
+        std::string body = registry_.render(options_.maxResponseBytes);
+        std::string r = response("200 OK", "text/plain; version=0.0.4; charset=utf-8", body);
+        if (method == "HEAD") r.resize(r.size() - body.size());
+        sendAll(fd, r);
+    } else if (path == "/") {
+        sendAll(fd, response("200 OK", "text/plain", "MachineController metrics: /metrics\n"));
+    } else {
+        sendAll(fd, response("404 Not Found", "text/plain", "not found\n"));
+    }
+}
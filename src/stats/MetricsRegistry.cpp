@@ -0,0 +1,191 @@
+#include "stats/MetricsRegistry.h"
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace {
+
+// Histogram buckets exposed to Prometheus: 2^k microseconds, 16 us .. ~67 s
+constexpr unsigned kFirstBoundLog2 = 4;
+constexpr unsigned kLastBoundLog2 = 26;
+
+std::string formatDouble(double v) {
+    if (std::isnan(v)) return "NaN";
+    if (std::isinf(v)) return v > 0 ? "+Inf" : "-Inf";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    return buf;
+}
+
+std::string escapeLabelValue(const std::string& v) {
+    std::string out;
+    out.reserve(v.size());
+    for (char c : v) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::string escapeHelp(const std::string& v) {
+    std::string out;
+    out.reserve(v.size());
+    for (char c : v) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+MetricsWriter::MetricsWriter(std::size_t maxBytes) : maxBytes_(maxBytes) {
+    out_.reserve(maxBytes < 64 * 1024 ? maxBytes : 64 * 1024);
+}
+
+void MetricsWriter::line(const std::string& text) {
+    if (truncated_) return;
+    if (out_.size() + text.size() + 1 > maxBytes_) {
+        truncated_ = true;
+        return;
+    }
+    out_ += text;
+    out_ += '\n';
+}
+
+std::string MetricsWriter::formatLabels(const Labels& labels, const char* extraKey, const std::string& extraValue) {
+    if (labels.empty() && !extraKey) return {};
+    std::string s = "{";
+    bool first = true;
+    for (const auto& [k, v] : labels) {
+        if (!first) s += ',';
+        first = false;
+        s += k + "=\"" + escapeLabelValue(v) + "\"";
+    }
+    if (extraKey) {
+        if (!first) s += ',';
+        s += std::string(extraKey) + "=\"" + extraValue + "\"";
+    }
+    s += '}';
+    return s;
+}
+
+void MetricsWriter::family(const std::string& name, const std::string& help, const char* type) {
+    line("# HELP " + name + " " + escapeHelp(help));
+    line("# TYPE " + name + " " + type);
+}
+
+void MetricsWriter::sample(const std::string& name, const Labels& labels, double value) {
+    line(name + formatLabels(labels) + " " + formatDouble(value));
+}
+
+void MetricsWriter::sample(const std::string& name, const Labels& labels, std::uint64_t value) {
+    line(name + formatLabels(labels) + " " + std::to_string(value));
+}
+
+void MetricsWriter::histogram(const std::string& name, const Labels& labels, const LatencyHistogram::Snapshot& snapshot) {
+    std::uint64_t cumulative = 0;
+    std::size_t bucket = 0;
+    for (unsigned k = kFirstBoundLog2; k <= kLastBoundLog2; ++k) {
+        const std::uint64_t boundUs = 1ULL << k;
+        // Source buckets are exclusive at their upper bound, so all of them fit under 'le'
+        while (bucket < LatencyHistogram::kBuckets && LatencyHistogram::bucketUpperBound(bucket) <= boundUs) {
+            cumulative += snapshot.counts[bucket++];
+        }
+        line(name + "_bucket" + formatLabels(labels, "le", formatDouble(static_cast<double>(boundUs) / 1e6)) +
+             " " + std::to_string(cumulative));
+    }
+    line(name + "_bucket" + formatLabels(labels, "le", "+Inf") + " " + std::to_string(snapshot.count));
+    line(name + "_sum" + formatLabels(labels) + " " + formatDouble(static_cast<double>(snapshot.sumUs) / 1e6));
+    line(name + "_count" + formatLabels(labels) + " " + std::to_string(snapshot.count));
+}
+
+std::string MetricsWriter::take() {
+    if (truncated_) {
+        // Always room for the marker: it replaces the tail if needed
+        const std::string marker = "# truncated: response size limit reached\n";
+        if (out_.size() + marker.size() > maxBytes_ && maxBytes_ >= marker.size()) {
+            std::size_t cut = out_.rfind('\n', maxBytes_ - marker.size());
+            out_.resize(cut == std::string::npos ? 0 : cut + 1);
+        }
+        out_ += marker;
+    }
+    return std::move(out_);
+}
+
+MetricsRegistry::Series& MetricsRegistry::seriesFor(const std::string& name, const std::string& help, Kind kind,
+                                                    const Labels& labels) {
+    Family* family = nullptr;
+    for (auto& f : families_) {
+        if (f.name == name) {
+            family = &f;
+            break;
+        }
+    }
+    if (!family) {
+        families_.push_back(Family{name, help, kind, {}});
+        family = &families_.back();
+    } else if (family->kind != kind) {
+        throw std::invalid_argument("metric " + name + " registered with a different type");
+    }
+    for (auto& s : family->series) {
+        if (s.labels == labels) return s;
+    }
+    family->series.push_back(Series{labels, nullptr, nullptr, nullptr});
+    return family->series.back();
+}
+
+MetricsRegistry::Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = seriesFor(name, help, Kind::Counter, labels);
+    if (!s.counter) s.counter = std::make_unique<Counter>();
+    return *s.counter;
+}
+
+MetricsRegistry::Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = seriesFor(name, help, Kind::Gauge, labels);
+    if (!s.gauge) s.gauge = std::make_unique<Gauge>();
+    return *s.gauge;
+}
+
+void MetricsRegistry::histogram(const std::string& name, const std::string& help, const LatencyHistogram& source,
+                                const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    seriesFor(name, help, Kind::Histogram, labels).histogram = &source;
+}
+
+void MetricsRegistry::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.push_back(std::move(collector));
+}
+
+std::string MetricsRegistry::render(std::size_t maxBytes) const {
+    MetricsWriter w(maxBytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& f : families_) {
+        switch (f.kind) {
+            case Kind::Counter:
+                w.family(f.name, f.help, "counter");
+                for (const auto& s : f.series) w.sample(f.name, s.labels, s.counter->value());
+                break;
+            case Kind::Gauge:
+                w.family(f.name, f.help, "gauge");
+                for (const auto& s : f.series) w.sample(f.name, s.labels, s.gauge->value());
+                break;
+            case Kind::Histogram:
+                w.family(f.name, f.help, "histogram");
+                for (const auto& s : f.series) w.histogram(f.name, s.labels, s.histogram->snapshot());
+                break;
+        }
+        if (w.truncated()) break;
+    }
+    for (const auto& collect : collectors_) {
+        if (w.truncated()) break;
+        collect(w);
+    }
+    return w.take();
+}
@@ -0,0 +1,182 @@
+#include "stats/ProductionStats.h"
+#include <chrono>
+
+namespace {
+constexpr std::int64_t kMsPerMinute = 60 * 1000;
+}
+
+const char* ProductionStats::testName(std::size_t test) {
+    switch (test) {
+        case TestSequence: return "sequence";
+        case TestMatch: return "match";
+        case TestInFile: return "masterInFile";
+        case TestDuplicate: return "duplicate";
+        case TestFormat: return "format";
+        default: return "unknown";
+    }
+}
+
+ProductionStats::ProductionStats(int bucketMinutes)
+    : bucketMs_((bucketMinutes > 0 ? bucketMinutes : 15) * kMsPerMinute) {}
+
+void ProductionStats::recordCycle(std::uint64_t durationUs) {
+    cycles_.fetch_add(1, std::memory_order_relaxed);
+    cycleTime_.record(durationUs);
+}
+
+void ProductionStats::recordScan(const ScanRecord& scan, std::int64_t nowMs) {
+    const bool reject = (scan.verdict & kScanFailedMask) != 0;
+    TimeBucket& bucket = bucketFor(nowMs);
+
+    scans_.fetch_add(1, std::memory_order_relaxed);
+    bucket.scans.fetch_add(1, std::memory_order_relaxed);
+    if (PortCounters* port = portFor(scan.commName)) {
+        port->scans.fetch_add(1, std::memory_order_relaxed);
+        if (reject) port->rejects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (scan.fromMasterReader) {
+        products_.fetch_add(1, std::memory_order_relaxed);
+        bucket.products.fetch_add(1, std::memory_order_relaxed);
+        if (lastProductMs_ >= 0 && nowMs >= lastProductMs_) {
+            productInterval_.record(static_cast<std::uint64_t>(nowMs - lastProductMs_) * 1000u);
+        }
+        lastProductMs_ = nowMs;
+    }
+    if (reject) {
+        rejects_.fetch_add(1, std::memory_order_relaxed);
+        bucket.rejects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    countTest(TestSequence, scan.verdict, ScanSequenceChecked, ScanSequenceFailed);
+    countTest(TestMatch, scan.verdict, ScanMatchChecked, ScanMatchFailed);
+    countTest(TestInFile, scan.verdict, ScanInFileChecked, ScanInFileFailed);
+    countTest(TestDuplicate, scan.verdict, ScanDuplicateChecked, ScanDuplicateFailed);
+    countTest(TestFormat, scan.verdict, ScanFormatChecked, ScanFormatFailed);
+}
+
+void ProductionStats::countTest(Test test, std::uint32_t verdict, std::uint32_t checked, std::uint32_t failed) {
+    if (!(verdict & checked)) return;
+    auto& counters = tests_[test];
+    if (verdict & failed) {
+        counters.failed.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        counters.passed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+ProductionStats::PortCounters* ProductionStats::portFor(const std::string& name) {
+    // Single writer: only the logic thread publishes new slots
+    const std::size_t count = portCount_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (ports_[i].name == name) return &ports_[i];
+    }
+    if (count >= kMaxPorts) return nullptr;
+    ports_[count].name = name;
+    portCount_.store(count + 1, std::memory_order_release);
+    return &ports_[count];
+}
+
+ProductionStats::TimeBucket& ProductionStats::bucketFor(std::int64_t nowMs) {
+    const std::int64_t epoch = nowMs / bucketMs_;
+    TimeBucket& bucket = buckets_[static_cast<std::size_t>(epoch % static_cast<std::int64_t>(kTimeBuckets))];
+    if (bucket.epoch.load(std::memory_order_relaxed) != epoch) {
+        bucket.epoch.store(-1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bucket.products.store(0, std::memory_order_relaxed);
+        bucket.rejects.store(0, std::memory_order_relaxed);
+        bucket.scans.store(0, std::memory_order_relaxed);
+        bucket.epoch.store(epoch, std::memory_order_release);
+    }
+    return bucket;
+}
+
+ProductionStats::Totals ProductionStats::totals() const {
+    Totals t;
+    t.cycles = cycles_.load(std::memory_order_relaxed);
+    t.scans = scans_.load(std::memory_order_relaxed);
+    t.products = products_.load(std::memory_order_relaxed);
+    t.rejects = rejects_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < kTestCount; ++i) {
+        t.tests[i].passed = tests_[i].passed.load(std::memory_order_relaxed);
+        t.tests[i].failed = tests_[i].failed.load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+ProductionStats::Snapshot ProductionStats::snapshot() const {
+    Snapshot s;
+    s.takenMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    s.bucketMs = bucketMs_;
+    s.cycles = cycles_.load(std::memory_order_relaxed);
+    s.scans = scans_.load(std::memory_order_relaxed);
+    s.products = products_.load(std::memory_order_relaxed);
+    s.rejects = rejects_.load(std::memory_order_relaxed);
+
+    const std::size_t count = portCount_.load(std::memory_order_acquire);
+    s.ports.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        PortSnapshot p;
+        p.name = ports_[i].name;
+        p.scans = ports_[i].scans.load(std::memory_order_relaxed);
+        p.rejects = ports_[i].rejects.load(std::memory_order_relaxed);
+        s.ports.push_back(std::move(p));
+    }
+
+    for (std::size_t t = 0; t < kTestCount; ++t) {
+        s.tests[t].passed = tests_[t].passed.load(std::memory_order_relaxed);
+        s.tests[t].failed = tests_[t].failed.load(std::memory_order_relaxed);
+    }
+
+    s.cycleTime = cycleTime_.snapshot();
+    s.productInterval = productInterval_.snapshot();
+
+    // Buckets in the ring that are still current, oldest first; skip any being reset
+    const std::int64_t newest = s.takenMs / bucketMs_;
+    for (std::int64_t epoch = newest - static_cast<std::int64_t>(kTimeBuckets) + 1; epoch <= newest; ++epoch) {
+        if (epoch < 0) continue;
+        const TimeBucket& bucket = buckets_[static_cast<std::size_t>(epoch % static_cast<std::int64_t>(kTimeBuckets))];
+        if (bucket.epoch.load(std::memory_order_acquire) != epoch) continue;
+        BucketSnapshot b;
+        b.startMs = epoch * bucketMs_;
+        b.products = bucket.products.load(std::memory_order_relaxed);
+        b.rejects = bucket.rejects.load(std::memory_order_relaxed);
+        b.scans = bucket.scans.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (bucket.epoch.load(std::memory_order_relaxed) != epoch) continue;
+        s.buckets.push_back(b);
+    }
+    return s;
+}
+
+ProductionStats::Snapshot ProductionStats::Snapshot::since(const Snapshot& earlier) const {
+    Snapshot d = *this;
+    d.cycles -= earlier.cycles;
+    d.scans -= earlier.scans;
+    d.products -= earlier.products;
+    d.rejects -= earlier.rejects;
+    for (auto& port : d.ports) {
+        for (const auto& old : earlier.ports) {
+            if (old.name == port.name) {
+                port.scans -= old.scans;
+                port.rejects -= old.rejects;
+                break;
+            }
+        }
+    }
+    for (std::size_t t = 0; t < kTestCount; ++t) {
+        d.tests[t].passed -= earlier.tests[t].passed;
+        d.tests[t].failed -= earlier.tests[t].failed;
+    }
+    d.cycleTime = cycleTime.since(earlier.cycleTime);
+    d.productInterval = productInterval.since(earlier.productInterval);
+
+    // Keep buckets that overlap the interval
+    std::vector<BucketSnapshot> kept;
+    for (const auto& b : d.buckets) {
+        if (b.startMs + bucketMs > earlier.takenMs) kept.push_back(b);
+    }
+    d.buckets = std::move(kept);
+    return d;
+}
@@ -0,0 +1,249 @@
+#include "stats/ShiftReportExporter.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string kRollingFile = "current_shift.json";
+const std::string kCsvFile = "shifts.csv";
+
+std::int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::tm localTime(std::int64_t ms) {
+    const std::time_t t = static_cast<std::time_t>(ms / 1000);
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    return tm;
+}
+
+std::string formatLocal(std::int64_t ms, const char* format) {
+    const std::tm tm = localTime(ms);
+    char buf[64];
+    const std::size_t n = std::strftime(buf, sizeof(buf), format, &tm);
+    return std::string(buf, n);
+}
+
+// Write to a temporary file and rename so readers never see a partial report
+bool writeFileReplace(const fs::path& path, const std::string& content) {
+    const fs::path tmp = path.string() + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        f << content;
+        if (!f) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+} // namespace
+
+ShiftReportExporter::ShiftReportExporter(const ProductionStats& stats, Options options)
+    : stats_(stats), options_(std::move(options)) {
+    if (options_.rollingIntervalSeconds < 1) options_.rollingIntervalSeconds = 1;
+    std::sort(options_.shiftStartMinutes.begin(), options_.shiftStartMinutes.end());
+}
+
+ShiftReportExporter::~ShiftReportExporter() {
+    stop();
+}
+
+bool ShiftReportExporter::start() {
+    if (thread_.joinable()) return true;
+    std::error_code ec;
+    fs::create_directories(options_.directory, ec);
+    if (ec) {
+        getLogger()->error("[ShiftReportExporter] Failed to create directory {}: {}", options_.directory, ec.message());
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    thread_ = std::thread(&ShiftReportExporter::run, this);
+    getLogger()->info("[ShiftReportExporter] Writing shift reports to {}", options_.directory);
+    return true;
+}
+
+void ShiftReportExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+int ShiftReportExporter::parseShiftStart(const std::string& text) {
+    int h = 0, m = 0;
+    char colon = 0;
+    std::istringstream in(text);
+    if (!(in >> h >> colon >> m) || colon != ':') return -1;
+    if (h < 0 || h > 23 || m < 0 || m > 59) return -1;
+    return h * 60 + m;
+}
+
+std::int64_t ShiftReportExporter::nextBoundaryMs(std::int64_t now) const {
+    std::int64_t best = std::numeric_limits<std::int64_t>::max();
+    const std::tm today = localTime(now);
+    for (int day = 0; day <= 1; ++day) {
+        for (int minutes : options_.shiftStartMinutes) {
+            std::tm tm = today;
+            tm.tm_mday += day;
+            tm.tm_hour = minutes / 60;
+            tm.tm_min = minutes % 60;
+            tm.tm_sec = 0;
+            tm.tm_isdst = -1;
+            const std::time_t t = std::mktime(&tm);
+            if (t == static_cast<std::time_t>(-1)) continue;
+            const std::int64_t ms = static_cast<std::int64_t>(t) * 1000;
+            if (ms > now && ms < best) best = ms;
+        }
+    }
+    return best;
+}
+
+void ShiftReportExporter::run() {
+    std::int64_t shiftStartMs = nowMs();
+    ProductionStats::Snapshot base = stats_.snapshot();
+    std::int64_t boundary = nextBoundaryMs(shiftStartMs);
+    std::int64_t nextRolling = shiftStartMs + options_.rollingIntervalSeconds * 1000LL;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            const std::int64_t wakeMs = std::min(boundary, nextRolling);
+            const auto wakeAt = std::chrono::system_clock::time_point(std::chrono::milliseconds(wakeMs));
+            cv_.wait_until(lock, wakeAt, [this]() { return stopping_; });
+            if (stopping_) break;
+        }
+
+        try {
+            const std::int64_t now = nowMs();
+            ProductionStats::Snapshot snap = stats_.snapshot();
+            if (now >= boundary) {
+                writeShift(snap.since(base), shiftStartMs, boundary);
+                base = snap;
+                shiftStartMs = boundary;
+                boundary = nextBoundaryMs(now);
+                nextRolling = now; // start the new rolling file right away
+            }
+            if (now >= nextRolling) {
+                writeRolling(snap.since(base), shiftStartMs, now);
+                nextRolling = now + options_.rollingIntervalSeconds * 1000LL;
+            }
+        } catch (const std::exception& e) {
+            getLogger()->error("[ShiftReportExporter] Failed to export report: {}", e.what());
+        }
+    }
+
+    try {
+        const std::int64_t now = nowMs();
+        writeRolling(stats_.snapshot().since(base), shiftStartMs, now);
+    } catch (const std::exception& e) {
+        getLogger()->error("[ShiftReportExporter] Failed to export final report: {}", e.what());
+    }
+}
+
+nlohmann::json ShiftReportExporter::toJson(const ProductionStats::Snapshot& shift, std::int64_t startMs, std::int64_t endMs) {
+    nlohmann::json j;
+    j["shiftStart"] = formatLocal(startMs, "%Y-%m-%d %H:%M:%S");
+    j["shiftEnd"] = formatLocal(endMs, "%Y-%m-%d %H:%M:%S");
+    j["products"] = shift.products;
+    j["rejects"] = shift.rejects;
+    j["scans"] = shift.scans;
+    j["logicCycles"] = shift.cycles;
+
+    nlohmann::json ports = nlohmann::json::array();
+    for (const auto& p : shift.ports) {
+        ports.push_back({{"port", p.name}, {"scans", p.scans}, {"rejects", p.rejects}});
+    }
+    j["ports"] = ports;
+
+    nlohmann::json tests = nlohmann::json::object();
+    for (std::size_t t = 0; t < ProductionStats::kTestCount; ++t) {
+        tests[ProductionStats::testName(t)] = {{"passed", shift.tests[t].passed}, {"failed", shift.tests[t].failed}};
+    }
+    j["tests"] = tests;
+
+    j["cycleTimeUs"] = {{"p50", shift.cycleTime.percentile(0.50)},
+                        {"p90", shift.cycleTime.percentile(0.90)},
+                        {"p99", shift.cycleTime.percentile(0.99)},
+                        {"mean", shift.cycleTime.meanUs()}};
+    j["productIntervalMs"] = {{"p50", shift.productInterval.percentile(0.50) / 1000},
+                              {"p90", shift.productInterval.percentile(0.90) / 1000},
+                              {"p99", shift.productInterval.percentile(0.99) / 1000}};
+
+    nlohmann::json buckets = nlohmann::json::array();
+    for (const auto& b : shift.buckets) {
+        buckets.push_back({{"start", formatLocal(b.startMs, "%Y-%m-%d %H:%M")},
+                           {"products", b.products}, {"rejects", b.rejects}, {"scans", b.scans}});
+    }
+    j["buckets"] = buckets;
+    return j;
+}
+
+void ShiftReportExporter::writeRolling(const ProductionStats::Snapshot& shift, std::int64_t startMs, std::int64_t now) {
+    const fs::path path = fs::path(options_.directory) / kRollingFile;
+    if (!writeFileReplace(path, toJson(shift, startMs, now).dump(2))) {
+        getLogger()->warn("[ShiftReportExporter] Failed to write {}", path.string());
+    }
+}
+
+void ShiftReportExporter::writeShift(const ProductionStats::Snapshot& shift, std::int64_t startMs, std::int64_t endMs) {
+    const fs::path dir(options_.directory);
+    const fs::path jsonPath = dir / ("shift-" + formatLocal(startMs, "%Y%m%d-%H%M") + ".json");
+    if (!writeFileReplace(jsonPath, toJson(shift, startMs, endMs).dump(2))) {
+        getLogger()->warn("[ShiftReportExporter] Failed to write {}", jsonPath.string());
+    }
+
+    const fs::path csvPath = dir / kCsvFile;
+    const bool newFile = !fs::exists(csvPath);
+    std::ofstream csv(csvPath, std::ios::app);
+    if (!csv) {
+        getLogger()->warn("[ShiftReportExporter] Failed to open {}", csvPath.string());
+        return;
+    }
+    if (newFile) {
+        csv << "shift_start,shift_end,products,rejects,scans";
+        for (std::size_t t = 0; t < ProductionStats::kTestCount; ++t) {
+            csv << ',' << ProductionStats::testName(t) << "_passed," << ProductionStats::testName(t) << "_failed";
+        }
+        csv << ",cycle_p50_us,cycle_p90_us,cycle_p99_us,interval_p50_ms,interval_p90_ms,ports\n";
+    }
+    csv << formatLocal(startMs, "%Y-%m-%d %H:%M:%S") << ','
+        << formatLocal(endMs, "%Y-%m-%d %H:%M:%S") << ','
+        << shift.products << ',' << shift.rejects << ',' << shift.scans;
+    for (std::size_t t = 0; t < ProductionStats::kTestCount; ++t) {
+        csv << ',' << shift.tests[t].passed << ',' << shift.tests[t].failed;
+    }
+    csv << ',' << shift.cycleTime.percentile(0.50)
+        << ',' << shift.cycleTime.percentile(0.90)
+        << ',' << shift.cycleTime.percentile(0.99)
+        << ',' << shift.productInterval.percentile(0.50) / 1000
+        << ',' << shift.productInterval.percentile(0.90) / 1000
+        << ',';
+    // Per-port scans as port=scans/rejects separated by ';'
+    for (std::size_t i = 0; i < shift.ports.size(); ++i) {
+        if (i) csv << ';';
+        csv << shift.ports[i].name << '=' << shift.ports[i].scans << '/' << shift.ports[i].rejects;
+    }
+    csv << '\n';
+    getLogger()->info("[ShiftReportExporter] Shift report written: {}", jsonPath.string());
+}
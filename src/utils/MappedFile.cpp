@@ -0,0 +1,193 @@
+#include "utils/MappedFile.h"
+#include "Logger.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, bool writable, std::size_t minSize) {
+    close();
+    path_ = path;
+    writable_ = writable;
+
+    file_ = CreateFileA(path.c_str(),
+                        writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        nullptr,
+                        writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL,
+                        nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        getLogger()->error("[MappedFile] Failed to open {} (error {})", path, GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file_, &fileSize)) {
+        getLogger()->error("[MappedFile] Failed to read size of {} (error {})", path, GetLastError());
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    open_ = true;
+
+    if (writable && size_ < minSize) {
+        return resize(minSize);
+    }
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map() {
+    if (size_ == 0) return true; // an empty file cannot be mapped; data() stays null
+    mapping_ = CreateFileMappingA(file_, nullptr, writable_ ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+        getLogger()->error("[MappedFile] CreateFileMapping failed for {} (error {})", path_, GetLastError());
+        return false;
+    }
+    void* view = MapViewOfFile(mapping_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        getLogger()->error("[MappedFile] MapViewOfFile failed for {} (error {})", path_, GetLastError());
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+        return false;
+    }
+    data_ = static_cast<char*>(view);
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+}
+
+bool MappedFile::resize(std::size_t newSize) {
+    if (!open_ || !writable_) return false;
+    if (newSize <= size_ && data_) return true;
+    unmap();
+    LARGE_INTEGER pos{};
+    pos.QuadPart = static_cast<LONGLONG>(newSize > size_ ? newSize : size_);
+    if (!SetFilePointerEx(file_, pos, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) {
+        getLogger()->error("[MappedFile] Failed to extend {} to {} bytes (error {})", path_, newSize, GetLastError());
+        map(); // keep the previous view usable
+        return false;
+    }
+    size_ = static_cast<std::size_t>(pos.QuadPart);
+    return map();
+}
+
+bool MappedFile::flush() {
+    if (!data_) return true;
+    if (!FlushViewOfFile(data_, 0)) return false;
+    return FlushFileBuffers(file_) != 0;
+}
+
+void MappedFile::close() {
+    unmap();
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    open_ = false;
+    size_ = 0;
+}
+
+#else // POSIX
+
+bool MappedFile::open(const std::string& path, bool writable, std::size_t minSize) {
+    close();
+    path_ = path;
+    writable_ = writable;
+
+    fd_ = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (fd_ < 0) {
+        getLogger()->error("[MappedFile] Failed to open {}", path);
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd_, &st) != 0) {
+        getLogger()->error("[MappedFile] Failed to read size of {}", path);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    open_ = true;
+
+    if (writable && size_ < minSize) {
+        return resize(minSize);
+    }
+    if (!map()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map() {
+    if (size_ == 0) return true;
+    void* p = mmap(nullptr, size_, writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        getLogger()->error("[MappedFile] mmap failed for {}", path_);
+        return false;
+    }
+    data_ = static_cast<char*>(p);
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (data_) {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+}
+
+bool MappedFile::resize(std::size_t newSize) {
+    if (!open_ || !writable_) return false;
+    if (newSize <= size_ && data_) return true;
+    unmap();
+    const std::size_t target = newSize > size_ ? newSize : size_;
+    if (ftruncate(fd_, static_cast<off_t>(target)) != 0) {
+        getLogger()->error("[MappedFile] Failed to extend {} to {} bytes", path_, newSize);
+        map();
+        return false;
+    }
+    size_ = target;
+    return map();
+}
+
+bool MappedFile::flush() {
+    if (!data_) return true;
+    return msync(data_, size_, MS_SYNC) == 0;
+}
+
+void MappedFile::close() {
+    unmap();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    open_ = false;
+    size_ = 0;
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef APICONNECTION_H
+#define APICONNECTION_H
+
+#include "utils/SocketCompat.h"
+#include "api/ApiFraming.h"
+#include <chrono>
+#include <string>
+
+// Blocking client connection to the control API, shared by the reference tools
+class ApiConnection {
+public:
+    explicit ApiConnection(ApiFraming::Mode mode) : mode_(mode), decoder_(mode) {}
+    ~ApiConnection() { close(); }
+
+    ApiConnection(const ApiConnection&) = delete;
+    ApiConnection& operator=(const ApiConnection&) = delete;
+
+    bool connect(const std::string& host, int port) {
+        if (!runtime_.ok()) return false;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<unsigned short>(port));
+        const std::string address = host == "localhost" ? "127.0.0.1" : host;
+        if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) return false;
+        fd_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (fd_ == kInvalidSocket) return false;
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close();
+            return false;
+        }
+        int noDelay = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        return true;
+    }
+
+    void close() {
+        if (fd_ != kInvalidSocket) closeSocket(fd_);
+        fd_ = kInvalidSocket;
+    }
+
+    // Frames and sends one JSON message
+    bool send(const std::string& json) {
+        std::string frame;
+        ApiFraming::appendFrame(frame, mode_, json);
+        return sendRaw(frame);
+    }
+
+    bool sendRaw(const std::string& bytes) {
+        std::size_t sent = 0;
+        while (sent < bytes.size()) {
+            const int n = ::send(fd_, bytes.data() + sent, static_cast<int>(bytes.size() - sent), 0);
+            if (n <= 0) return false;
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // Next complete message; false on timeout, disconnect or protocol error
+    bool receive(std::string& json, int timeoutMs) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        char buf[16 * 1024];
+        while (!decoder_.next(json)) {
+            if (decoder_.error()) return false;
+            // Poll at least once so that data already waiting is read even when the time is up
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            pollfd pfd{};
+            pfd.fd = fd_;
+            pfd.events = POLLIN;
+            if (pollSockets(&pfd, 1, remaining > 0 ? static_cast<int>(remaining) : 0) <= 0) return false;
+            const int n = ::recv(fd_, buf, static_cast<int>(sizeof(buf)), 0);
+            if (n <= 0) return false;
+            decoder_.feed(buf, static_cast<std::size_t>(n));
+        }
+        return true;
+    }
+
+private:
+    SocketRuntime runtime_;
+    ApiFraming::Mode mode_;
+    ApiFraming::Decoder decoder_;
+    socket_t fd_{kInvalidSocket};
+};
+
+#endif // APICONNECTION_H
@@ -0,0 +1,93 @@
+// Reference client for the MachineController control API.
+//
+//   mc_api_client [--host 127.0.0.1] [--port 5020] [--framing json-lines|length-prefixed]
+//                 [--subscribe] [request ...]
+//
+// Each request is a JSON object, or a bare command name as shorthand for {"cmd":"<name>"}:
+//   mc_api_client getCounters '{"cmd":"setJob","job":"A123","referenceFile":"C:/jobs/A123.txt"}'
+// Responses are printed one per line. With --subscribe the client then prints
+// result frames until the connection closes.
+
+#include "ApiConnection.h"
+#include "json.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int usage() {
+    std::cerr << "usage: mc_api_client [--host H] [--port P] [--framing json-lines|length-prefixed] "
+                 "[--subscribe] [request ...]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string host = "127.0.0.1";
+    int port = 5020;
+    ApiFraming::Mode mode = ApiFraming::Mode::JsonLines;
+    bool subscribe = false;
+    std::vector<nlohmann::json> requests;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--host" && i + 1 < argc) {
+            host = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--framing" && i + 1 < argc) {
+            if (!ApiFraming::parseMode(argv[++i], mode)) return usage();
+        } else if (arg == "--subscribe") {
+            subscribe = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return usage();
+        } else {
+            try {
+                requests.push_back(arg[0] == '{' ? nlohmann::json::parse(arg) : nlohmann::json{{"cmd", arg}});
+            } catch (const std::exception& e) {
+                std::cerr << "invalid request '" << arg << "': " << e.what() << "\n";
+                return 2;
+            }
+        }
+    }
+    if (requests.empty() && !subscribe) return usage();
+
+    ApiConnection connection(mode);
+    if (!connection.connect(host, port)) {
+        std::cerr << "cannot connect to " << host << ":" << port << "\n";
+        return 1;
+    }
+
+    int nextId = 1;
+    if (subscribe) requests.push_back({{"cmd", "subscribe"}});
+    for (auto& request : requests) {
+        if (!request.contains("id")) request["id"] = nextId++;
+        if (!connection.send(request.dump())) {
+            std::cerr << "send failed\n";
+            return 1;
+        }
+        // Responses come back in order for requests sent one at a time
+        std::string response;
+        if (!connection.receive(response, 10000)) {
+            std::cerr << "no response\n";
+            return 1;
+        }
+        std::cout << response << std::endl;
+    }
+
+    if (subscribe) {
+        std::string frame;
+        while (true) {
+            if (connection.receive(frame, 60 * 60 * 1000)) {
+                std::cout << frame << std::endl;
+            } else {
+                std::cerr << "connection closed\n";
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
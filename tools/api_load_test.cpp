@@ -0,0 +1,258 @@
+// Load test for the MachineController control API over loopback.
+//
+//   mc_api_load_test [--host 127.0.0.1] [--port 5020] [--framing json-lines|length-prefixed]
+//                    [--clients 4] [--requests 20000] [--window 32] [--cmd ping]
+//                    [--subscribers 2] [--inject-rate 0] [--seconds 5] [--inject-port communication1]
+//
+// Phase 1: every client pipelines up to 'window' requests of 'cmd' and reports
+// request latency and throughput.
+// Phase 2 (needs api.allowInjectScan): one connection injects scans at the given
+// rate while the subscribers count result items and frames. Items per frame grows
+// with the rate while the frame rate stays at 1000 / batchIntervalMs.
+
+#include "ApiConnection.h"
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings {
+    std::string host{"127.0.0.1"};
+    int port{5020};
+    ApiFraming::Mode mode{ApiFraming::Mode::JsonLines};
+    int clients{4};
+    int requests{20000};
+    int window{32};
+    std::string cmd{"ping"};
+    int subscribers{2};
+    int injectRate{0};
+    int seconds{5};
+    std::string injectPort{"communication1"};
+};
+
+std::int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+double percentile(std::vector<double>& values, double q) {
+    if (values.empty()) return 0.0;
+    const std::size_t i = std::min(values.size() - 1, static_cast<std::size_t>(q * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(i), values.end());
+    return values[i];
+}
+
+// Pipelines 'count' requests keeping at most 'window' outstanding; latencies in microseconds
+bool runRequests(const Settings& s, int count, std::vector<double>& latencies, std::string& error) {
+    ApiConnection connection(s.mode);
+    if (!connection.connect(s.host, s.port)) {
+        error = "connect failed";
+        return false;
+    }
+    std::vector<Clock::time_point> sentAt(static_cast<std::size_t>(count));
+    int sent = 0;
+    int received = 0;
+    std::string batch;
+    std::string response;
+    while (received < count) {
+        batch.clear();
+        while (sent < count && sent - received < s.window) {
+            ApiFraming::appendFrame(batch, s.mode, nlohmann::json{{"id", sent}, {"cmd", s.cmd}}.dump());
+            sentAt[static_cast<std::size_t>(sent++)] = Clock::now();
+        }
+        if (!batch.empty() && !connection.sendRaw(batch)) {
+            error = "send failed";
+            return false;
+        }
+        if (!connection.receive(response, 10000)) {
+            error = "response timeout";
+            return false;
+        }
+        const auto j = nlohmann::json::parse(response);
+        if (!j.value("ok", false)) {
+            error = "request failed: " + response;
+            return false;
+        }
+        const int id = j.at("id").get<int>();
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sentAt[static_cast<std::size_t>(id)]).count());
+        ++received;
+    }
+    return true;
+}
+
+void requestPhase(const Settings& s) {
+    std::vector<std::vector<double>> latencies(static_cast<std::size_t>(s.clients));
+    std::vector<std::string> errors(static_cast<std::size_t>(s.clients));
+    std::vector<std::thread> threads;
+    const auto start = Clock::now();
+    for (int c = 0; c < s.clients; ++c) {
+        threads.emplace_back([&, c] {
+            runRequests(s, s.requests, latencies[static_cast<std::size_t>(c)], errors[static_cast<std::size_t>(c)]);
+        });
+    }
+    for (auto& t : threads) t.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for (std::size_t c = 0; c < latencies.size(); ++c) {
+        if (!errors[c].empty()) std::cerr << "client " << c << ": " << errors[c] << "\n";
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    }
+    const double total = static_cast<double>(all.size());
+    std::printf("requests: %zu x '%s' over %d connections (window %d) in %.2f s -> %.0f req/s\n", all.size(),
+                s.cmd.c_str(), s.clients, s.window, seconds, total / seconds);
+    std::printf("latency us: p50 %.0f  p99 %.0f  max %.0f\n", percentile(all, 0.50), percentile(all, 0.99),
+                all.empty() ? 0.0 : *std::max_element(all.begin(), all.end()));
+}
+
+void streamPhase(const Settings& s) {
+    std::atomic<bool> injecting{true};
+    std::atomic<bool> draining{true};
+    std::atomic<std::uint64_t> items{0};
+    std::atomic<std::uint64_t> frames{0};
+    std::atomic<std::uint64_t> droppedFrames{0};
+    std::atomic<int> ready{0};
+    std::mutex latencyMutex;
+    std::vector<double> delivery; // ms from logic thread to subscriber
+
+    std::vector<std::thread> subscribers;
+    for (int c = 0; c < s.subscribers; ++c) {
+        subscribers.emplace_back([&] {
+            ApiConnection connection(s.mode);
+            std::string frame;
+            if (!connection.connect(s.host, s.port) || !connection.send(R"({"id":0,"cmd":"subscribe"})") ||
+                !connection.receive(frame, 5000)) {
+                std::cerr << "subscriber failed to subscribe\n";
+                ++ready;
+                return;
+            }
+            ++ready;
+            std::vector<double> local;
+            while (draining) {
+                if (!connection.receive(frame, 200)) continue;
+                const auto j = nlohmann::json::parse(frame);
+                const std::string type = j.value("type", std::string());
+                if (type == "dropped") {
+                    droppedFrames += j.value("frames", 0ULL);
+                    continue;
+                }
+                if (type != "results") continue;
+                ++frames;
+                const std::int64_t now = wallClockMs();
+                for (const auto& item : j["items"]) {
+                    local.push_back(static_cast<double>(now - item.value("t", now)));
+                }
+                items += j["items"].size();
+            }
+            std::lock_guard<std::mutex> lock(latencyMutex);
+            delivery.insert(delivery.end(), local.begin(), local.end());
+        });
+    }
+    while (ready < s.subscribers) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::uint64_t injected = 0;
+    std::string error;
+    std::thread injector([&] {
+        ApiConnection connection(s.mode);
+        if (!connection.connect(s.host, s.port)) {
+            error = "injector connect failed";
+            return;
+        }
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::seconds(s.seconds);
+        std::uint64_t answered = 0;
+        std::string batch;
+        std::string response;
+        char payload[32];
+        while (Clock::now() < end) {
+            // Send everything that is due by now, then collect the answers
+            const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            const auto due = static_cast<std::uint64_t>(elapsed * s.injectRate);
+            batch.clear();
+            while (injected < due && injected - answered < 256) {
+                std::snprintf(payload, sizeof(payload), "LT%012llu", static_cast<unsigned long long>(injected));
+                ApiFraming::appendFrame(batch, s.mode,
+                                        nlohmann::json{{"id", injected}, {"cmd", "injectScan"},
+                                                       {"port", s.injectPort}, {"message", payload}}.dump());
+                ++injected;
+            }
+            if (!batch.empty() && !connection.sendRaw(batch)) {
+                error = "injector send failed";
+                return;
+            }
+            while (answered < injected && connection.receive(response, 1)) {
+                if (!nlohmann::json::parse(response).value("ok", false)) {
+                    error = "injectScan rejected: " + response;
+                    return;
+                }
+                ++answered;
+            }
+        }
+        while (answered < injected && connection.receive(response, 5000)) ++answered;
+    });
+    injector.join();
+    injecting = false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(500)); // let the last batches arrive
+    draining = false;
+    for (auto& t : subscribers) t.join();
+
+    if (!error.empty()) std::cerr << error << "\n";
+    const double perSubscriberFrames = s.subscribers ? static_cast<double>(frames) / s.subscribers : 0.0;
+    std::printf("stream: injected %llu scans in %d s (%d/s) to %d subscribers\n",
+                static_cast<unsigned long long>(injected), s.seconds, s.injectRate, s.subscribers);
+    std::printf("received %llu items in %.0f frames per subscriber (%.1f items/frame, %.1f frames/s), %llu frames dropped\n",
+                static_cast<unsigned long long>(items.load()), perSubscriberFrames,
+                frames ? static_cast<double>(items) / static_cast<double>(frames) : 0.0,
+                perSubscriberFrames / s.seconds, static_cast<unsigned long long>(droppedFrames.load()));
+    std::printf("delivery ms: p50 %.0f  p99 %.0f\n", percentile(delivery, 0.50), percentile(delivery, 0.99));
+}
+
+int usage() {
+    std::cerr << "usage: mc_api_load_test [--host H] [--port P] [--framing json-lines|length-prefixed] "
+                 "[--clients N] [--requests N] [--window N] [--cmd name] [--subscribers N] "
+                 "[--inject-rate scans/s] [--seconds N] [--inject-port name]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Settings s;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) return usage();
+        const std::string value = argv[++i];
+        if (arg == "--host") s.host = value;
+        else if (arg == "--port") s.port = std::atoi(value.c_str());
+        else if (arg == "--framing") { if (!ApiFraming::parseMode(value, s.mode)) return usage(); }
+        else if (arg == "--clients") s.clients = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--requests") s.requests = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--window") s.window = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--cmd") s.cmd = value;
+        else if (arg == "--subscribers") s.subscribers = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--inject-rate") s.injectRate = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--seconds") s.seconds = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--inject-port") s.injectPort = value;
+        else return usage();
+    }
+
+    try {
+        if (s.requests > 0) requestPhase(s);
+        if (s.injectRate > 0) streamPhase(s);
+    } catch (const std::exception& e) {
+        std::cerr << "load test failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+// Stand-in Modbus/TCP device for trying the ModbusTCP IO backend without hardware.
+//
+//   mc_modbus_sim [--port 1502] [--delay-us 0] [--toggle ADDR:PERIOD_MS]... [--mirror OFFSET] [--quiet]
+//
+// Serves coils, discrete inputs, holding and input registers (65536 each) to any
+// number of clients on one poll loop, with functions 1-6, 15 and 16.
+//   --delay-us   answer every request this late (emulates a slow or distant device;
+//                requests are still served in parallel, so pipelining shows)
+//   --toggle     flip discrete input ADDR every PERIOD_MS (a simulated sensor)
+//   --mirror     a coil write also sets discrete input (coil + OFFSET), so outputs
+//                wired back to inputs can be tested
+// Coil writes are printed unless --quiet. Point io.modbus.port at --port and set
+// io.device to "ModbusTCP".
+
+#include "utils/SocketCompat.h"
+#include "io/ModbusProtocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Toggle {
+    std::uint16_t address;
+    Clock::duration period;
+    Clock::time_point next;
+};
+
+struct Client {
+    socket_t fd;
+    std::string input;
+};
+
+struct Reply {
+    Clock::time_point due;
+    socket_t fd;
+    std::string bytes;
+};
+
+struct Tables {
+    std::vector<std::uint8_t> coils = std::vector<std::uint8_t>(65536, 0);
+    std::vector<std::uint8_t> inputs = std::vector<std::uint8_t>(65536, 0);
+    std::vector<std::uint16_t> holding = std::vector<std::uint16_t>(65536, 0);
+    std::vector<std::uint16_t> inputRegisters = std::vector<std::uint16_t>(65536, 0);
+};
+
+int usage() {
+    std::cerr << "usage: mc_modbus_sim [--port 1502] [--delay-us 0] [--toggle ADDR:PERIOD_MS]... [--mirror OFFSET] [--quiet]\n";
+    return 2;
+}
+
+// Response PDU body for one request; sets 'function' to the exception form on error
+std::string serve(Tables& t, std::uint8_t& function, const unsigned char* body, std::size_t size, int mirror, bool quiet) {
+    auto fail = [&](std::uint8_t code) {
+        function = static_cast<std::uint8_t>(function | 0x80);
+        return Modbus::exceptionBody(code);
+    };
+    if (size < 4) return fail(Modbus::IllegalDataValue);
+    const std::uint16_t start = Modbus::get16(body);
+    const std::uint16_t value = Modbus::get16(body + 2);
+    std::string out;
+    switch (function) {
+    case Modbus::ReadCoils:
+    case Modbus::ReadDiscreteInputs: {
+        if (value < 1 || value > Modbus::kMaxReadBits) return fail(Modbus::IllegalDataValue);
+        if (start + value > 65536) return fail(Modbus::IllegalDataAddress);
+        const auto& table = function == Modbus::ReadCoils ? t.coils : t.inputs;
+        const std::string packed = Modbus::packBits(table, start, value);
+        out += static_cast<char>(packed.size());
+        out += packed;
+        return out;
+    }
+    case Modbus::ReadHoldingRegisters:
+    case Modbus::ReadInputRegisters: {
+        if (value < 1 || value > Modbus::kMaxReadRegisters) return fail(Modbus::IllegalDataValue);
+        if (start + value > 65536) return fail(Modbus::IllegalDataAddress);
+        const auto& table = function == Modbus::ReadHoldingRegisters ? t.holding : t.inputRegisters;
+        out += static_cast<char>(value * 2);
+        for (std::uint16_t i = 0; i < value; ++i) Modbus::put16(out, table[start + i]);
+        return out;
+    }
+    case Modbus::WriteSingleCoil:
+        if (value != 0xFF00 && value != 0) return fail(Modbus::IllegalDataValue);
+        t.coils[start] = value ? 1 : 0;
+        if (mirror >= 0 && start + mirror < 65536) t.inputs[start + mirror] = t.coils[start];
+        if (!quiet) std::cout << "coil " << start << " = " << int(t.coils[start]) << "\n";
+        return std::string(reinterpret_cast<const char*>(body), 4);
+    case Modbus::WriteSingleRegister:
+        t.holding[start] = value;
+        return std::string(reinterpret_cast<const char*>(body), 4);
+    case Modbus::WriteMultipleCoils: {
+        if (value < 1 || value > Modbus::kMaxWriteBits || size < 5 || body[4] != (value + 7) / 8 ||
+            size < 5u + body[4]) {
+            return fail(Modbus::IllegalDataValue);
+        }
+        if (start + value > 65536) return fail(Modbus::IllegalDataAddress);
+        std::string changes;
+        for (std::uint16_t i = 0; i < value; ++i) {
+            const std::uint8_t bit = Modbus::getBit(body + 5, i) ? 1 : 0;
+            if (t.coils[start + i] != bit) changes += " " + std::to_string(start + i) + "=" + std::to_string(bit);
+            t.coils[start + i] = bit;
+            if (mirror >= 0 && start + i + mirror < 65536) t.inputs[start + i + mirror] = bit;
+        }
+        if (!quiet && !changes.empty()) std::cout << "coils" << changes << "\n";
+        return std::string(reinterpret_cast<const char*>(body), 4);
+    }
+    case Modbus::WriteMultipleRegisters: {
+        if (value < 1 || value > Modbus::kMaxWriteRegisters || size < 5 || body[4] != value * 2 ||
+            size < 5u + body[4]) {
+            return fail(Modbus::IllegalDataValue);
+        }
+        if (start + value > 65536) return fail(Modbus::IllegalDataAddress);
+        for (std::uint16_t i = 0; i < value; ++i) t.holding[start + i] = Modbus::get16(body + 5 + 2 * i);
+        return std::string(reinterpret_cast<const char*>(body), 4);
+    }
+    default:
+        return fail(Modbus::IllegalFunction);
+    }
+}
+
+void sendAll(socket_t fd, const std::string& bytes) {
+    std::size_t sent = 0;
+    while (sent < bytes.size()) {
+        const int n = ::send(fd, bytes.data() + sent, static_cast<int>(bytes.size() - sent), 0);
+        if (n > 0) {
+            sent += static_cast<std::size_t>(n);
+        } else if (n < 0 && isWouldBlock(lastSocketError())) {
+            pollfd pfd{};
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            pollSockets(&pfd, 1, 100);
+        } else {
+            return;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int port = 1502;
+    long delayUs = 0;
+    int mirror = -1;
+    bool quiet = false;
+    std::vector<Toggle> toggles;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--delay-us" && i + 1 < argc) {
+            delayUs = std::atol(argv[++i]);
+        } else if (arg == "--mirror" && i + 1 < argc) {
+            mirror = std::atoi(argv[++i]);
+        } else if (arg == "--toggle" && i + 1 < argc) {
+            const std::string spec = argv[++i];
+            const auto colon = spec.find(':');
+            if (colon == std::string::npos) return usage();
+            const int ms = std::atoi(spec.c_str() + colon + 1);
+            if (ms <= 0) return usage();
+            toggles.push_back({static_cast<std::uint16_t>(std::atoi(spec.substr(0, colon).c_str())),
+                               std::chrono::milliseconds(ms), Clock::now() + std::chrono::milliseconds(ms)});
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else {
+            return usage();
+        }
+    }
+
+    SocketRuntime runtime;
+    if (!runtime.ok()) return 1;
+    socket_t listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<unsigned short>(port));
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, 16) != 0) {
+        std::cerr << "cannot listen on 127.0.0.1:" << port << "\n";
+        return 1;
+    }
+    setNonBlocking(listener);
+    std::cerr << "Modbus/TCP stand-in on 127.0.0.1:" << port << "\n";
+
+    Tables tables;
+    std::vector<Client> clients;
+    std::vector<Reply> replies; // delayed, in due order
+    std::uint64_t requests = 0;
+    auto statsAt = Clock::now() + std::chrono::seconds(10);
+
+    for (;;) {
+        auto now = Clock::now();
+        for (auto& toggle : toggles) {
+            if (now >= toggle.next) {
+                tables.inputs[toggle.address] ^= 1;
+                toggle.next += toggle.period;
+                if (toggle.next <= now) toggle.next = now + toggle.period;
+            }
+        }
+        while (!replies.empty() && replies.front().due <= now) {
+            sendAll(replies.front().fd, replies.front().bytes);
+            replies.erase(replies.begin());
+        }
+        if (now >= statsAt) {
+            if (!quiet) std::cerr << requests / 10 << " requests/s, " << clients.size() << " clients\n";
+            requests = 0;
+            statsAt = now + std::chrono::seconds(10);
+        }
+
+        // Wake for the next delayed reply or toggle
+        Clock::time_point wake = now + std::chrono::milliseconds(100);
+        if (!replies.empty()) wake = std::min(wake, replies.front().due);
+        for (const auto& toggle : toggles) wake = std::min(wake, toggle.next);
+        const int timeoutMs = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count());
+
+        std::vector<pollfd> fds(clients.size() + 1);
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = POLLIN;
+        }
+        if (pollSockets(fds.data(), fds.size(), timeoutMs < 0 ? 0 : timeoutMs) < 0) return 1;
+
+        if (fds[0].revents & POLLIN) {
+            socket_t fd = ::accept(listener, nullptr, nullptr);
+            if (fd != kInvalidSocket) {
+                setNonBlocking(fd);
+                int noDelay = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+                clients.push_back({fd, std::string()});
+                if (!quiet) std::cerr << "client connected (" << clients.size() << ")\n";
+            }
+        }
+
+        for (std::size_t i = clients.size(); i-- > 0;) {
+            if (!(fds[i + 1].revents & (POLLIN | POLLERR | POLLHUP))) continue;
+            Client& client = clients[i];
+            char chunk[4096];
+            bool closed = false;
+            for (;;) {
+                const int n = ::recv(client.fd, chunk, sizeof(chunk), 0);
+                if (n > 0) {
+                    client.input.append(chunk, static_cast<std::size_t>(n));
+                    continue;
+                }
+                closed = n == 0 || !isWouldBlock(lastSocketError());
+                break;
+            }
+
+            std::string out;
+            std::size_t offset = 0;
+            for (;;) {
+                Modbus::Frame frame;
+                const long size = Modbus::parseFrame(client.input.data() + offset, client.input.size() - offset, frame);
+                if (size < 0) closed = true;
+                if (size <= 0) break;
+                std::uint8_t function = frame.function;
+                const std::string body = serve(tables, function, frame.body, frame.bodySize, mirror, quiet);
+                Modbus::appendFrame(out, frame.transaction, frame.unit, function, body);
+                offset += static_cast<std::size_t>(size);
+                ++requests;
+            }
+            client.input.erase(0, offset);
+            if (!out.empty()) {
+                if (delayUs > 0) {
+                    replies.push_back({Clock::now() + std::chrono::microseconds(delayUs), client.fd, out});
+                } else {
+                    sendAll(client.fd, out);
+                }
+            }
+            if (closed) {
+                replies.erase(std::remove_if(replies.begin(), replies.end(),
+                                             [&](const Reply& r) { return r.fd == client.fd; }),
+                              replies.end());
+                closeSocket(client.fd);
+                clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+                if (!quiet) std::cerr << "client disconnected (" << clients.size() << ")\n";
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Example consumer of the shared state segment: prints IO words and counters
+ * whenever they change.
+ *
+ *   mc_state_monitor [segment-name] [--grid]
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L /* nanosleep */
+#endif
+
+#include "shm/mc_state.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+static void sleep_ms(unsigned ms) { Sleep(ms); }
+#else
+#include <time.h>
+static void sleep_ms(unsigned ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+#endif
+
+static void print_channels(const char* label, const char (*names)[MC_STATE_NAME_BYTES], uint32_t count, uint64_t word) {
+    uint32_t i;
+    printf("%s:", label);
+    for (i = 0; i < count; ++i) printf(" %s=%d", names[i], (int)((word >> i) & 1u));
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    const char* name = NULL;
+    int grid = 0;
+    int error = 0;
+    int i;
+    uint64_t lastSequence = 0;
+    uint32_t lastLayout = 0xFFFFFFFFu;
+    mc_state_reader* reader;
+    mc_state_segment* state;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--grid") == 0) grid = 1;
+        else name = argv[i];
+    }
+
+    reader = mc_state_open(name, &error);
+    if (!reader) {
+        fprintf(stderr, "cannot open shared state '%s' (error %d)\n", name ? name : MC_STATE_DEFAULT_NAME, error);
+        return 1;
+    }
+    state = (mc_state_segment*)malloc(sizeof(*state));
+    if (!state) return 1;
+
+    for (;;) {
+        /* One load of the sequence number; nothing is copied while the machine is idle */
+        if (mc_state_sequence(reader) == lastSequence) {
+            sleep_ms(20);
+            continue;
+        }
+        if (mc_state_read(reader, state) != MC_STATE_OK) continue;
+        lastSequence = state->sequence;
+
+        if (state->layoutVersion != lastLayout) {
+            lastLayout = state->layoutVersion;
+            printf("layout %u: %u inputs, %u outputs, %u timers, %u ports\n", (unsigned)state->layoutVersion,
+                   (unsigned)state->inputCount, (unsigned)state->outputCount, (unsigned)state->timerCount,
+                   (unsigned)state->portCount);
+        }
+        printf("#%llu at %lld ms  products=%llu rejects=%llu scans=%llu cycles=%llu%s\n",
+               (unsigned long long)state->publishCount, (long long)state->updatedMs,
+               (unsigned long long)state->counters.products, (unsigned long long)state->counters.rejects,
+               (unsigned long long)state->counters.scans, (unsigned long long)state->counters.cycles,
+               state->producerState == MC_STATE_PRODUCER_RUNNING ? "" : "  (producer stopped)");
+        print_channels("  inputs ", (const char (*)[MC_STATE_NAME_BYTES])state->inputNames, state->inputCount, state->inputWord);
+        print_channels("  outputs", (const char (*)[MC_STATE_NAME_BYTES])state->outputNames, state->outputCount, state->outputWord);
+        if (grid) {
+            uint32_t p, c;
+            for (p = 0; p < state->portCount; ++p) {
+                printf("  %s:", state->ports[p].name);
+                for (c = 0; c < state->ports[p].cellCount; ++c) printf(" [%s]", state->cells[p][c]);
+                printf("\n");
+            }
+        }
+        fflush(stdout);
+    }
+}
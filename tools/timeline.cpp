@@ -0,0 +1,189 @@
+// Merges the IO edge journal and the production scan history into one timeline.
+//
+//   mc_timeline --from "2026-10-18 06:00:00" --to "2026-10-18 06:05:00"
+//               [--edges edges] [--history history] [--channels Sensor1,Valve2] [--csv]
+//
+// Times are local ("YYYY-MM-DD HH:MM:SS[.ffffff]") or ms since epoch. Every IO
+// edge and every stored scan in the window is printed in time order, starting
+// with the IO states at --from, so which sensor fired when and which outputs
+// and scans followed can be read top to bottom.
+
+#include "history/EdgeJournal.h"
+#include "history/ScanHistory.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int usage() {
+    std::cerr << "usage: mc_timeline --from TIME --to TIME [--edges DIR] [--history DIR] "
+                 "[--channels NAME,...] [--csv]\n"
+                 "  TIME is \"YYYY-MM-DD HH:MM:SS[.ffffff]\" (local) or ms since epoch\n";
+    return 2;
+}
+
+// Local time or ms since epoch to us since epoch; -1 if malformed
+std::int64_t parseTime(const std::string& text) {
+    if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos) {
+        return std::stoll(text) * 1000;
+    }
+    std::tm tm{};
+    std::istringstream in(text);
+    in >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (in.fail()) return -1;
+    tm.tm_isdst = -1;
+    const std::time_t seconds = std::mktime(&tm);
+    if (seconds == static_cast<std::time_t>(-1)) return -1;
+    std::int64_t micros = 0;
+    if (in.peek() == '.') {
+        in.get();
+        std::string digits;
+        std::getline(in, digits);
+        digits = digits.substr(0, 6);
+        digits.resize(6, '0');
+        if (digits.find_first_not_of("0123456789") != std::string::npos) return -1;
+        micros = std::stoll(digits);
+    }
+    return static_cast<std::int64_t>(seconds) * 1000000 + micros;
+}
+
+std::string formatTime(std::int64_t us) {
+    const std::time_t t = static_cast<std::time_t>(us / 1000000);
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm);
+    char text[48];
+    std::snprintf(text, sizeof(text), "%s.%06lld", date, static_cast<long long>(us % 1000000));
+    return text;
+}
+
+std::string verdictText(std::uint32_t verdict) {
+    constexpr std::uint32_t checked = ScanSequenceChecked | ScanInFileChecked | ScanMatchChecked |
+                                      ScanDuplicateChecked | ScanFormatChecked;
+    if (!(verdict & checked)) return "-";
+    return (verdict & kScanFailedMask) ? "FAIL" : "OK";
+}
+
+std::string csvField(const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) return text;
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+struct Line {
+    std::int64_t timeUs;
+    bool scan;
+    std::size_t index; // into the edges or the scan rows
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string edgesDir = "edges";
+    std::string historyDir = "history";
+    std::int64_t fromUs = -1, toUs = -1;
+    std::vector<std::string> only;
+    bool csv = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            fromUs = parseTime(argv[++i]);
+        } else if (arg == "--to" && i + 1 < argc) {
+            toUs = parseTime(argv[++i]);
+        } else if (arg == "--edges" && i + 1 < argc) {
+            edgesDir = argv[++i];
+        } else if (arg == "--history" && i + 1 < argc) {
+            historyDir = argv[++i];
+        } else if (arg == "--channels" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            for (std::string name; std::getline(list, name, ',');) {
+                if (!name.empty()) only.push_back(name);
+            }
+        } else if (arg == "--csv") {
+            csv = true;
+        } else {
+            return usage();
+        }
+    }
+    if (fromUs < 0 || toUs <= fromUs) return usage();
+
+    const auto channels = EdgeJournal::readChannels(edgesDir);
+    auto wanted = [&](std::size_t channel) {
+        if (channel >= channels.size() || channels[channel].empty()) return only.empty();
+        return only.empty() || std::find(only.begin(), only.end(), channels[channel]) != only.end();
+    };
+    auto channelName = [&](std::size_t channel) {
+        return channel < channels.size() && !channels[channel].empty() ? channels[channel]
+                                                                       : "pin " + std::to_string(channel);
+    };
+
+    std::vector<EdgeJournal::Edge> edges;
+    std::uint32_t initialWord = 0;
+    if (!EdgeJournal::read(edgesDir, fromUs, toUs, edges, &initialWord)) {
+        std::cerr << "warning: edge journal in '" << edgesDir << "' is damaged; showing what was read\n";
+    }
+
+    ScanHistory::Options options;
+    options.directory = historyDir;
+    ScanHistory history(options);
+    const auto scans = history.readRange(fromUs / 1000, (toUs + 999) / 1000);
+
+    // Both sources are already in time order; merge them, scans after edges of the same ms
+    std::vector<Line> lines;
+    lines.reserve(edges.size() + scans.size());
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        if (wanted(edges[i].channel)) lines.push_back({edges[i].timeUs, false, i});
+    }
+    const std::size_t edgeLines = lines.size();
+    for (std::size_t i = 0; i < scans.size(); ++i) lines.push_back({scans[i].timeMs * 1000, true, i});
+    std::inplace_merge(lines.begin(), lines.begin() + static_cast<std::ptrdiff_t>(edgeLines), lines.end(),
+                       [](const Line& a, const Line& b) { return a.timeUs < b.timeUs; });
+
+    if (csv) std::cout << "time,source,name,value,detail\n";
+    auto print = [&](std::int64_t timeUs, const char* source, const std::string& name, const std::string& value,
+                     const std::string& detail) {
+        if (csv) {
+            std::cout << formatTime(timeUs) << ',' << source << ',' << csvField(name) << ',' << csvField(value) << ','
+                      << csvField(detail) << '\n';
+        } else {
+            std::cout << formatTime(timeUs) << "  " << std::left << std::setw(5) << source << ' ' << std::setw(20)
+                      << name << ' ' << std::setw(5) << value << ' ' << detail << '\n';
+        }
+    };
+
+    for (std::size_t channel = 0; channel < channels.size(); ++channel) {
+        if (channels[channel].empty() || !wanted(channel)) continue;
+        print(fromUs, "START", channelName(channel), std::to_string((initialWord >> channel) & 1u), "");
+    }
+    for (const Line& line : lines) {
+        if (line.scan) {
+            const auto& row = scans[line.index];
+            print(line.timeUs, "SCAN", row.commName, verdictText(row.verdict),
+                  "cell " + std::to_string(row.cell) + " " + row.payload);
+        } else {
+            const auto& edge = edges[line.index];
+            print(line.timeUs, "IO", channelName(edge.channel), std::to_string(edge.state),
+                  edge.state ? "rising" : "falling");
+        }
+    }
+    std::cerr << edgeLines << " IO edges and " << scans.size() << " scans\n";
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Cost of the per-port scan validators (tests.validators) and format patterns
+// (communication.<port>.format) at typical payload sizes.
+//
+//   mc_validator_bench [--iterations 2000000] [--variants 1024]
+//
+// Every case validates 'variants' different payloads in turn, all of which must
+// pass, so the figures include realistic branch and cache behaviour rather than
+// one payload replayed from the predictor.
+
+#include "machine/ScanValidator.h"
+#include "machine/PayloadPattern.h"
+#include "json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings {
+    long long iterations{2000000};
+    int variants{1024};
+};
+
+std::uint64_t nextRandom(std::uint64_t& state) {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return state >> 33;
+}
+
+std::string randomDigits(std::uint64_t& state, std::size_t count) {
+    std::string digits;
+    for (std::size_t i = 0; i < count; ++i) digits.push_back(static_cast<char>('0' + nextRandom(state) % 10));
+    return digits;
+}
+
+std::string randomText(std::uint64_t& state, std::size_t count, const std::string& alphabet) {
+    std::string text;
+    for (std::size_t i = 0; i < count; ++i) text.push_back(alphabet[nextRandom(state) % alphabet.size()]);
+    return text;
+}
+
+// Append the check digit that makes 'body' valid (weights 3,1 for mod-10; doubling for Luhn)
+std::string withCheckDigit(const std::string& body, bool luhn) {
+    int sum = 0;
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        int d = body[body.size() - 1 - i] - '0';
+        if (i % 2 == 0) {
+            if (luhn) {
+                d *= 2;
+                if (d > 9) d -= 9;
+            } else {
+                d *= 3;
+            }
+        }
+        sum += d;
+    }
+    return body + static_cast<char>('0' + (10 - sum % 10) % 10);
+}
+
+struct Case {
+    const char* name;
+    nlohmann::json rules;
+    std::vector<std::string> payloads;
+};
+
+std::vector<Case> buildCases(int variants) {
+    const std::string alphanumeric = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    const std::string gs1Text = alphanumeric + "!\"%&'()*+,-./:;<=>?_";
+    std::uint64_t state = 42;
+    std::vector<Case> cases;
+
+    Case ean{"EAN-13: length, digits, mod10",
+             nlohmann::json::array({{{"type", "length"}, {"min", 13}, {"max", 13}},
+                                    {{"type", "charset"}, {"chars", "digits"}},
+                                    {{"type", "mod10"}}}),
+             {}};
+    Case card{"16-digit id: length, digits, luhn",
+              nlohmann::json::array({{{"type", "length"}, {"min", 16}, {"max", 16}},
+                                     {{"type", "charset"}, {"chars", "digits"}},
+                                     {{"type", "luhn"}}}),
+              {}};
+    Case gs1{"GS1-128: ]C1 01+17+10+21",
+             nlohmann::json::array({{{"type", "length"}, {"min", 20}, {"max", 80}},
+                                    {{"type", "gs1"}}}),
+             {}};
+    Case serial{"64-byte serial: length, alphanumeric",
+                nlohmann::json::array({{{"type", "length"}, {"min", 64}, {"max", 64}},
+                                       {{"type", "charset"}, {"chars", "alphanumeric"}}}),
+                {}};
+    Case matrix{"256-byte DataMatrix: gs1 charset",
+                nlohmann::json::array({{{"type", "charset"}, {"chars", "gs1"}}}),
+                {}};
+
+    for (int i = 0; i < variants; ++i) {
+        ean.payloads.push_back(withCheckDigit(randomDigits(state, 12), false));
+        card.payloads.push_back(withCheckDigit(randomDigits(state, 15), true));
+        gs1.payloads.push_back("]C101" + withCheckDigit(randomDigits(state, 13), false) + "17" + "261231" + "10" +
+                               randomText(state, 8, alphanumeric) + '\x1D' + "21" + randomText(state, 12, alphanumeric));
+        serial.payloads.push_back(randomText(state, 64, alphanumeric));
+        matrix.payloads.push_back(randomText(state, 256, gs1Text));
+    }
+    cases.push_back(std::move(ean));
+    cases.push_back(std::move(card));
+    cases.push_back(std::move(gs1));
+    cases.push_back(std::move(serial));
+    cases.push_back(std::move(matrix));
+    return cases;
+}
+
+bool runCase(const Case& c, const Settings& s) {
+    ScanValidator validator;
+    std::string error;
+    if (!validator.compile(c.rules, &error)) {
+        std::cerr << c.name << ": " << error << "\n";
+        return false;
+    }
+    for (const auto& payload : c.payloads) {
+        const ScanValidation verdict = validator.validate(payload);
+        if (!verdict.passed()) {
+            std::cerr << c.name << ": payload failed rule " << verdict.failedRule << ": " << payload << "\n";
+            return false;
+        }
+    }
+
+    std::size_t averageBytes = 0;
+    for (const auto& payload : c.payloads) averageBytes += payload.size();
+    averageBytes /= c.payloads.size();
+
+    std::uint32_t failed = 0; // keeps the loop from being optimized away
+    const auto started = Clock::now();
+    std::size_t next = 0;
+    for (long long i = 0; i < s.iterations; ++i) {
+        failed |= validator.validate(c.payloads[next]).failed;
+        if (++next == c.payloads.size()) next = 0;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - started).count();
+    std::printf("%-38s %4zu bytes  %7.1f ns/scan  %6.2f ns/byte%s\n", c.name, averageBytes,
+                ns / static_cast<double>(s.iterations),
+                ns / static_cast<double>(s.iterations) / static_cast<double>(averageBytes),
+                failed ? "  (unexpected failures)" : "");
+    return failed == 0;
+}
+
+// Format pattern with field extraction, on payloads of 'AB' + 10 digits + 2 letters + padding
+bool runPatternCase(const char* name, const std::string& pattern, std::size_t padding, const Settings& s) {
+    PayloadPattern compiled;
+    std::string error;
+    if (!compiled.compile(pattern, &error)) {
+        std::cerr << name << ": " << error << "\n";
+        return false;
+    }
+    std::uint64_t state = 7;
+    std::vector<std::string> payloads;
+    for (int i = 0; i < s.variants; ++i) {
+        payloads.push_back("AB" + randomDigits(state, 10) + randomText(state, 2, "ABCDEFGHIJKLMNOPQRSTUVWXYZ") +
+                           randomText(state, padding, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"));
+    }
+
+    const int serial = compiled.fieldIndex("serial");
+    std::uint64_t checksum = 0; // keeps the loop from being optimized away
+    std::uint64_t matched = 0;
+    const auto started = Clock::now();
+    std::size_t next = 0;
+    for (long long i = 0; i < s.iterations; ++i) {
+        const PatternMatch match = compiled.match(payloads[next]);
+        matched += match.matched;
+        checksum += match.end[static_cast<std::size_t>(serial)];
+        if (++next == payloads.size()) next = 0;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - started).count();
+    const std::size_t bytes = payloads.front().size();
+    std::printf("%-38s %4zu bytes  %7.1f ns/scan  %6.2f ns/byte  (%zu states)%s\n", name, bytes,
+                ns / static_cast<double>(s.iterations),
+                ns / static_cast<double>(s.iterations) / static_cast<double>(bytes), compiled.stateCount(),
+                matched == static_cast<std::uint64_t>(s.iterations) && checksum ? "" : "  (unexpected mismatches)");
+    return matched == static_cast<std::uint64_t>(s.iterations);
+}
+
+int usage() {
+    std::cerr << "usage: mc_validator_bench [--iterations N] [--variants N]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Settings s;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) return usage();
+        const std::string value = argv[++i];
+        if (arg == "--iterations") s.iterations = std::max(1LL, std::atoll(value.c_str()));
+        else if (arg == "--variants") s.variants = std::max(1, std::atoi(value.c_str()));
+        else return usage();
+    }
+
+    bool ok = true;
+    for (const auto& c : buildCases(s.variants)) ok = runCase(c, s) && ok;
+    ok = runPatternCase("pattern: 'AB' {serial: d10} {lot: L2}", "'AB' {serial: d10} {lot: L2}", 0, s) && ok;
+    ok = runPatternCase("pattern: same + a50", "'AB' {serial: d10} {lot: L2} a50", 50, s) && ok;
+    ok = runPatternCase("pattern: same + a*", "'AB' {serial: d10} {lot: L2} a*", 200, s) && ok;
+    return ok ? 0 : 1;
+}